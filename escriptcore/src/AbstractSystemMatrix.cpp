@@ -19,6 +19,8 @@
 #include "DataException.h"
 #include "DataTypes.h"
 
+#include <boost/python/extract.hpp>
+
 namespace escript {
 
 AbstractSystemMatrix::AbstractSystemMatrix(int row_blocksize,
@@ -103,12 +105,51 @@ Data AbstractSystemMatrix::solve(const Data& in,
     setToSolution(out, *const_cast<Data*>(&in), options);
     return out;
 }
+
+boost::python::list AbstractSystemMatrix::solveMultiple(
+                                        const boost::python::list& in,
+                                        boost::python::object& options) const
+{
+    if (isEmpty())
+        throw SystemMatrixException("Matrix is empty.");
+    const int numRHS = boost::python::len(in);
+    std::vector<Data> rhs, sol;
+    DataTypes::ShapeType shape;
+    if (getRowBlockSize() > 1)
+        shape.push_back(getColumnBlockSize());
+    for (int i = 0; i < numRHS; i++) {
+        const Data& d = boost::python::extract<const Data&>(in[i]);
+        if (d.getFunctionSpace() != getRowFunctionSpace())
+            throw SystemMatrixException("row function space and function space of right hand side do not match.");
+        if (d.getDataPointSize() != getRowBlockSize())
+            throw SystemMatrixException("row block size and right hand side size do not match.");
+        rhs.push_back(d);
+        sol.push_back(d.isComplex() ?
+            Data(DataTypes::cplx_t(0), shape, getColumnFunctionSpace(), true) :
+            Data(0., shape, getColumnFunctionSpace(), true));
+    }
+    if (numRHS > 0)
+        setToSolutions(sol, rhs, options);
+    boost::python::list out;
+    for (int i = 0; i < numRHS; i++)
+        out.append(sol[i]);
+    return out;
+}
+
 void AbstractSystemMatrix::setToSolution(Data& out, Data& in,
                                          boost::python::object& options) const
 {
     throw SystemMatrixException("setToSolution() is not implemented");
 }
 
+void AbstractSystemMatrix::setToSolutions(std::vector<Data>& out,
+                                          std::vector<Data>& in,
+                                          boost::python::object& options) const
+{
+    for (size_t i = 0; i < in.size(); i++)
+        setToSolution(out[i], in[i], options);
+}
+
 void AbstractSystemMatrix::nullifyRowsAndCols(Data& row_q,
                                               Data& col_q,
                                               double mdv)
@@ -22,8 +22,11 @@
 #include "Pointers.h"
 #include "SystemMatrixException.h"
 
+#include <boost/python/list.hpp>
 #include <boost/python/object.hpp>
 
+#include <vector>
+
 namespace escript {
 
 //
@@ -133,6 +136,15 @@ public:
         returns the solution u of the linear system this*u=in
     */
     Data solve(const Data& in, boost::python::object& options) const;
+
+    /**
+        \brief
+        returns the solutions u_i of the linear systems this*u_i=in_i for
+        a list of right hand sides. Implementations may solve the systems
+        together so that each pass over the matrix serves all of them.
+    */
+    boost::python::list solveMultiple(const boost::python::list& in,
+                                      boost::python::object& options) const;
   
     /**
         \brief
@@ -168,6 +180,14 @@ private:
     virtual void setToSolution(Data& out, Data& in,
                                boost::python::object& options) const;
 
+    /**
+        \brief
+        solves the linear systems this*out[i]=in[i]. The default
+        implementation calls setToSolution for each right hand side.
+    */
+    virtual void setToSolutions(std::vector<Data>& out, std::vector<Data>& in,
+                                boost::python::object& options) const;
+
     /**
         \brief
         performs y+=this*x
@@ -28,7 +28,7 @@ namespace escript
 {
 
 template <class ResSCALAR, class LSCALAR, class RSCALAR>
-inline void binaryOpDataReadyHelperCCC(DataConstant& res, const DataConstant& left, const DataConstant& right, 
+inline void binaryOpDataReadyHelper(DataConstant& res, const DataConstant& left, const DataConstant& right, 
 		     escript::ES_optype operation)
 {
   ResSCALAR resdummy=0;
@@ -62,6 +62,63 @@ inline void binaryOpDataReadyHelperCCC(DataConstant& res, const DataConstant& le
 }
 
 
+// Runs the helper for the given combination of DataReady types with the
+// scalar types that match the precision of the arguments.
+// The precision of the result is set by the caller (see
+// C_TensorBinaryOperation): single op single and single op constant give
+// single precision, single op tagged or expanded double data gives double.
+// In-place updates keep the precision of the object being updated.
+// Returns false if none of the arguments is stored in single precision.
+template <class ResDATA, class LDATA, class RDATA>
+bool binaryOpDataSingle(ResDATA& result, const LDATA& left, const RDATA& right,
+                        escript::ES_optype operation)
+{
+  typedef DataTypes::real32_t s_t;
+  typedef DataTypes::real_t d_t;
+  const bool lsingle=left.isSinglePrecision();
+  const bool rsingle=right.isSinglePrecision();
+  if (!result.isSinglePrecision() && !lsingle && !rsingle)
+  {
+      return false;
+  }
+  if (left.isComplex() || right.isComplex() || result.isComplex())
+  {
+      throw DataException("Error - single precision data can not be combined with complex data. Use toDoublePrecision() first.");
+  }
+  if (result.isSinglePrecision())
+  {
+      if (lsingle && rsingle)
+      {
+	  binaryOpDataReadyHelper<s_t, s_t, s_t>(result, left, right, operation);
+      }
+      else if (lsingle)
+      {
+	  binaryOpDataReadyHelper<s_t, s_t, d_t>(result, left, right, operation);
+      }
+      else if (rsingle)
+      {
+	  binaryOpDataReadyHelper<s_t, d_t, s_t>(result, left, right, operation);
+      }
+      else
+      {
+	  throw DataException("Programming error: single precision result for double precision arguments.");
+      }
+  }
+  else if (lsingle && rsingle)
+  {
+      throw DataException("Programming error: double precision result for single precision arguments.");
+  }
+  else if (lsingle)
+  {
+      binaryOpDataReadyHelper<d_t, s_t, d_t>(result, left, right, operation);
+  }
+  else
+  {
+      binaryOpDataReadyHelper<d_t, d_t, s_t>(result, left, right, operation);
+  }
+  return true;
+}
+
 void binaryOpDataCCC(DataConstant& result, const DataConstant& left, const DataConstant& right, 
 		     escript::ES_optype operation)
 {
@@ -75,32 +132,36 @@ void binaryOpDataCCC(DataConstant& result, const DataConstant& left, const DataC
       throw DataException(oss.str());
   }
   
+  if (binaryOpDataSingle(result, left, right, operation))
+  {
+      return;
+  }
   if (left.isComplex())
   {
       if (right.isComplex())
       {
-	  binaryOpDataReadyHelperCCC<DataTypes::cplx_t, DataTypes::cplx_t, DataTypes::cplx_t>(result, left, right, operation);
+	  binaryOpDataReadyHelper<DataTypes::cplx_t, DataTypes::cplx_t, DataTypes::cplx_t>(result, left, right, operation);
       }
       else
       {
-	  binaryOpDataReadyHelperCCC<DataTypes::cplx_t, DataTypes::cplx_t, DataTypes::real_t>(result, left, right, operation);	
+	  binaryOpDataReadyHelper<DataTypes::cplx_t, DataTypes::cplx_t, DataTypes::real_t>(result, left, right, operation);	
       }    
   }
   else	// left is real
   {
       if (right.isComplex())
       {
-	  binaryOpDataReadyHelperCCC<DataTypes::cplx_t, DataTypes::real_t, DataTypes::cplx_t>(result, left, right, operation);	
+	  binaryOpDataReadyHelper<DataTypes::cplx_t, DataTypes::real_t, DataTypes::cplx_t>(result, left, right, operation);	
       }
       else	// right is real
       {
-	  binaryOpDataReadyHelperCCC<DataTypes::real_t, DataTypes::real_t, DataTypes::real_t>(result, left, right, operation);	
+	  binaryOpDataReadyHelper<DataTypes::real_t, DataTypes::real_t, DataTypes::real_t>(result, left, right, operation);	
       }        
   }    
 }
 
 template <class ResSCALAR, class LSCALAR, class RSCALAR>
-inline void binaryOpDataReadyHelperTCT(DataTagged& res, const DataConstant& left, const DataTagged& right, 
+inline void binaryOpDataReadyHelper(DataTagged& res, const DataConstant& left, const DataTagged& right, 
 		     escript::ES_optype operation)
 {
   ResSCALAR resdummy=0;
@@ -200,33 +261,37 @@ void binaryOpDataTCT(DataTagged& result, const DataConstant& left, const DataTag
       throw DataException(oss.str());
   }
   
+  if (binaryOpDataSingle(result, left, right, operation))
+  {
+      return;
+  }
   if (left.isComplex())
   {
       if (right.isComplex())
       {
-	  binaryOpDataReadyHelperTCT<DataTypes::cplx_t, DataTypes::cplx_t, DataTypes::cplx_t>(result, left, right, operation);
+	  binaryOpDataReadyHelper<DataTypes::cplx_t, DataTypes::cplx_t, DataTypes::cplx_t>(result, left, right, operation);
       }
       else
       {
-	  binaryOpDataReadyHelperTCT<DataTypes::cplx_t, DataTypes::cplx_t, DataTypes::real_t>(result, left, right, operation);	
+	  binaryOpDataReadyHelper<DataTypes::cplx_t, DataTypes::cplx_t, DataTypes::real_t>(result, left, right, operation);	
       }    
   }
   else	// left is real
   {
       if (right.isComplex())
       {
-	  binaryOpDataReadyHelperTCT<DataTypes::cplx_t, DataTypes::real_t, DataTypes::cplx_t>(result, left, right, operation);
+	  binaryOpDataReadyHelper<DataTypes::cplx_t, DataTypes::real_t, DataTypes::cplx_t>(result, left, right, operation);
       }
       else	// right is real
       {
-	  binaryOpDataReadyHelperTCT<DataTypes::real_t, DataTypes::real_t, DataTypes::real_t>(result, left, right, operation);	
+	  binaryOpDataReadyHelper<DataTypes::real_t, DataTypes::real_t, DataTypes::real_t>(result, left, right, operation);	
       }        
   }    
 }
 
 
 template <class ResSCALAR, class LSCALAR, class RSCALAR>
-inline void binaryOpDataReadyHelperECE(DataExpanded& res, const DataConstant& left, const DataExpanded& right, 
+inline void binaryOpDataReadyHelper(DataExpanded& res, const DataConstant& left, const DataExpanded& right, 
 		     escript::ES_optype operation)
 {
   ResSCALAR resdummy=0;
@@ -280,32 +345,36 @@ void binaryOpDataECE(DataExpanded& result, const DataConstant& left, const DataE
       throw DataException(oss.str());
   }
   
+  if (binaryOpDataSingle(result, left, right, operation))
+  {
+      return;
+  }
   if (left.isComplex())
   {
       if (right.isComplex())
       {
-	  binaryOpDataReadyHelperECE<DataTypes::cplx_t, DataTypes::cplx_t, DataTypes::cplx_t>(result, left, right, operation);
+	  binaryOpDataReadyHelper<DataTypes::cplx_t, DataTypes::cplx_t, DataTypes::cplx_t>(result, left, right, operation);
       }
       else
       {
-	  binaryOpDataReadyHelperECE<DataTypes::cplx_t, DataTypes::cplx_t, DataTypes::real_t>(result, left, right, operation);	
+	  binaryOpDataReadyHelper<DataTypes::cplx_t, DataTypes::cplx_t, DataTypes::real_t>(result, left, right, operation);	
       }    
   }
   else	// left is real
   {
       if (right.isComplex())
       {
-	  binaryOpDataReadyHelperECE<DataTypes::cplx_t, DataTypes::real_t, DataTypes::cplx_t>(result, left, right, operation);
+	  binaryOpDataReadyHelper<DataTypes::cplx_t, DataTypes::real_t, DataTypes::cplx_t>(result, left, right, operation);
       }
       else	// right is real
       {
-	  binaryOpDataReadyHelperECE<DataTypes::real_t, DataTypes::real_t, DataTypes::real_t>(result, left, right, operation);	
+	  binaryOpDataReadyHelper<DataTypes::real_t, DataTypes::real_t, DataTypes::real_t>(result, left, right, operation);	
       }        
   }    
 }
 
 template <class ResSCALAR, class LSCALAR, class RSCALAR>
-inline void binaryOpDataReadyHelperEET(DataExpanded& res, const DataExpanded& left, const DataTagged& right, 
+inline void binaryOpDataReadyHelper(DataExpanded& res, const DataExpanded& left, const DataTagged& right, 
 		     escript::ES_optype operation)
 {
   ResSCALAR resdummy=0;
@@ -336,33 +405,37 @@ void binaryOpDataEET(DataExpanded& result, const DataExpanded& left, const DataT
       throw DataException(oss.str());
   }
   
+  if (binaryOpDataSingle(result, left, right, operation))
+  {
+      return;
+  }
   if (left.isComplex())
   {
       if (right.isComplex())
       {
-	  binaryOpDataReadyHelperEET<DataTypes::cplx_t, DataTypes::cplx_t, DataTypes::cplx_t>(result, left, right, operation);
+	  binaryOpDataReadyHelper<DataTypes::cplx_t, DataTypes::cplx_t, DataTypes::cplx_t>(result, left, right, operation);
       }
       else
       {
-	  binaryOpDataReadyHelperEET<DataTypes::cplx_t, DataTypes::cplx_t, DataTypes::real_t>(result, left, right, operation);	
+	  binaryOpDataReadyHelper<DataTypes::cplx_t, DataTypes::cplx_t, DataTypes::real_t>(result, left, right, operation);	
       }    
   }
   else	// left is real
   {
       if (right.isComplex())
       {
-	  binaryOpDataReadyHelperEET<DataTypes::cplx_t, DataTypes::real_t, DataTypes::cplx_t>(result, left, right, operation);	
+	  binaryOpDataReadyHelper<DataTypes::cplx_t, DataTypes::real_t, DataTypes::cplx_t>(result, left, right, operation);	
       }
       else	// right is real
       {
-	  binaryOpDataReadyHelperEET<DataTypes::real_t, DataTypes::real_t, DataTypes::real_t>(result, left, right, operation);	
+	  binaryOpDataReadyHelper<DataTypes::real_t, DataTypes::real_t, DataTypes::real_t>(result, left, right, operation);	
       }        
   }    
 }
 
 
 template <class ResSCALAR, class LSCALAR, class RSCALAR>
-inline void binaryOpDataReadyHelperETE(DataExpanded& res, const DataTagged& left, const DataExpanded& right, 
+inline void binaryOpDataReadyHelper(DataExpanded& res, const DataTagged& left, const DataExpanded& right, 
 		     escript::ES_optype operation)
 {
   ResSCALAR resdummy=0;
@@ -392,26 +465,30 @@ void binaryOpDataETE(DataExpanded& result, const DataTagged& left, const DataExp
       throw DataException(oss.str());
   }
   
+  if (binaryOpDataSingle(result, left, right, operation))
+  {
+      return;
+  }
   if (left.isComplex())
   {
       if (right.isComplex())
       {
-	  binaryOpDataReadyHelperETE<DataTypes::cplx_t, DataTypes::cplx_t, DataTypes::cplx_t>(result, left, right, operation);
+	  binaryOpDataReadyHelper<DataTypes::cplx_t, DataTypes::cplx_t, DataTypes::cplx_t>(result, left, right, operation);
       }
       else
       {
-	  binaryOpDataReadyHelperETE<DataTypes::cplx_t, DataTypes::cplx_t, DataTypes::real_t>(result, left, right, operation);	
+	  binaryOpDataReadyHelper<DataTypes::cplx_t, DataTypes::cplx_t, DataTypes::real_t>(result, left, right, operation);	
       }    
   }
   else	// left is real
   {
       if (right.isComplex())
       {
-	  binaryOpDataReadyHelperETE<DataTypes::cplx_t, DataTypes::real_t, DataTypes::cplx_t>(result, left, right, operation);	
+	  binaryOpDataReadyHelper<DataTypes::cplx_t, DataTypes::real_t, DataTypes::cplx_t>(result, left, right, operation);	
       }
       else	// right is real
       {
-	  binaryOpDataReadyHelperETE<DataTypes::real_t, DataTypes::real_t, DataTypes::real_t>(result, left, right, operation);	
+	  binaryOpDataReadyHelper<DataTypes::real_t, DataTypes::real_t, DataTypes::real_t>(result, left, right, operation);	
       }        
   }    
 }
@@ -420,7 +497,7 @@ void binaryOpDataETE(DataExpanded& result, const DataTagged& left, const DataExp
 
 
 template <class ResSCALAR, class LSCALAR, class RSCALAR>
-inline void binaryOpDataReadyHelperTTC(DataTagged& res, const DataTagged& left, const DataConstant& right, 
+inline void binaryOpDataReadyHelper(DataTagged& res, const DataTagged& left, const DataConstant& right, 
 		     escript::ES_optype operation)
 {
   ResSCALAR resdummy=0;
@@ -529,33 +606,37 @@ void binaryOpDataTTC(DataTagged& result, const DataTagged& left, const DataConst
       throw DataException(oss.str());
   }
   
+  if (binaryOpDataSingle(result, left, right, operation))
+  {
+      return;
+  }
   if (left.isComplex())
   {
       if (right.isComplex())
       {
-	  binaryOpDataReadyHelperTTC<DataTypes::cplx_t, DataTypes::cplx_t, DataTypes::cplx_t>(result, left, right, operation);
+	  binaryOpDataReadyHelper<DataTypes::cplx_t, DataTypes::cplx_t, DataTypes::cplx_t>(result, left, right, operation);
       }
       else
       {
-	  binaryOpDataReadyHelperTTC<DataTypes::cplx_t, DataTypes::cplx_t, DataTypes::real_t>(result, left, right, operation);	
+	  binaryOpDataReadyHelper<DataTypes::cplx_t, DataTypes::cplx_t, DataTypes::real_t>(result, left, right, operation);	
       }    
   }
   else	// left is real
   {
       if (right.isComplex())
       {
-	  binaryOpDataReadyHelperTTC<DataTypes::cplx_t, DataTypes::real_t, DataTypes::cplx_t>(result, left, right, operation);	
+	  binaryOpDataReadyHelper<DataTypes::cplx_t, DataTypes::real_t, DataTypes::cplx_t>(result, left, right, operation);	
       }
       else	// right is real
       {
-	  binaryOpDataReadyHelperTTC<DataTypes::real_t, DataTypes::real_t, DataTypes::real_t>(result, left, right, operation);	
+	  binaryOpDataReadyHelper<DataTypes::real_t, DataTypes::real_t, DataTypes::real_t>(result, left, right, operation);	
       }        
   }    
 }
 
 
 template <class ResSCALAR, class LSCALAR, class RSCALAR>
-inline void binaryOpDataReadyHelperTTT(DataTagged& res, const DataTagged& left, const DataTagged& right, 
+inline void binaryOpDataReadyHelper(DataTagged& res, const DataTagged& left, const DataTagged& right, 
 		     escript::ES_optype operation)
 {
   ResSCALAR resdummy=0;
@@ -681,32 +762,36 @@ void binaryOpDataTTT(DataTagged& result, const DataTagged& left, const DataTagge
       throw DataException(oss.str());
   }
   
+  if (binaryOpDataSingle(result, left, right, operation))
+  {
+      return;
+  }
   if (left.isComplex())
   {
       if (right.isComplex())
       {
-	  binaryOpDataReadyHelperTTT<DataTypes::cplx_t, DataTypes::cplx_t, DataTypes::cplx_t>(result, left, right, operation);
+	  binaryOpDataReadyHelper<DataTypes::cplx_t, DataTypes::cplx_t, DataTypes::cplx_t>(result, left, right, operation);
       }
       else
       {
-	  binaryOpDataReadyHelperTTT<DataTypes::cplx_t, DataTypes::cplx_t, DataTypes::real_t>(result, left, right, operation);	
+	  binaryOpDataReadyHelper<DataTypes::cplx_t, DataTypes::cplx_t, DataTypes::real_t>(result, left, right, operation);	
       }    
   }
   else	// left is real
   {
       if (right.isComplex())
       {
-	  binaryOpDataReadyHelperTTT<DataTypes::cplx_t, DataTypes::real_t, DataTypes::cplx_t>(result, left, right, operation);		
+	  binaryOpDataReadyHelper<DataTypes::cplx_t, DataTypes::real_t, DataTypes::cplx_t>(result, left, right, operation);		
       }
       else	// right is real
       {
-	  binaryOpDataReadyHelperTTT<DataTypes::real_t, DataTypes::real_t, DataTypes::real_t>(result, left, right, operation);	
+	  binaryOpDataReadyHelper<DataTypes::real_t, DataTypes::real_t, DataTypes::real_t>(result, left, right, operation);	
       }        
   }    
 }
 
 template <class ResSCALAR, class LSCALAR, class RSCALAR>
-inline void binaryOpDataReadyHelperEEC(DataExpanded& res, const DataExpanded& left, const DataConstant& right, 
+inline void binaryOpDataReadyHelper(DataExpanded& res, const DataExpanded& left, const DataConstant& right, 
 		     escript::ES_optype operation)
 {
   ResSCALAR resdummy=0;
@@ -761,33 +846,37 @@ void binaryOpDataEEC(DataExpanded& result, const DataExpanded& left, const DataC
       throw DataException(oss.str());
   }
   
+  if (binaryOpDataSingle(result, left, right, operation))
+  {
+      return;
+  }
   if (left.isComplex())
   {
       if (right.isComplex())
       {
-	  binaryOpDataReadyHelperEEC<DataTypes::cplx_t, DataTypes::cplx_t, DataTypes::cplx_t>(result, left, right, operation);
+	  binaryOpDataReadyHelper<DataTypes::cplx_t, DataTypes::cplx_t, DataTypes::cplx_t>(result, left, right, operation);
       }
       else
       {
-	  binaryOpDataReadyHelperEEC<DataTypes::cplx_t, DataTypes::cplx_t, DataTypes::real_t>(result, left, right, operation);	
+	  binaryOpDataReadyHelper<DataTypes::cplx_t, DataTypes::cplx_t, DataTypes::real_t>(result, left, right, operation);	
       }    
   }
   else	// left is real
   {
       if (right.isComplex())
       {
-	  binaryOpDataReadyHelperEEC<DataTypes::cplx_t, DataTypes::real_t, DataTypes::cplx_t>(result, left, right, operation);	
+	  binaryOpDataReadyHelper<DataTypes::cplx_t, DataTypes::real_t, DataTypes::cplx_t>(result, left, right, operation);	
       }
       else	// right is real
       {
-	  binaryOpDataReadyHelperEEC<DataTypes::real_t, DataTypes::real_t, DataTypes::real_t>(result, left, right, operation);	
+	  binaryOpDataReadyHelper<DataTypes::real_t, DataTypes::real_t, DataTypes::real_t>(result, left, right, operation);	
       }        
   }    
 }
 
 
 template <class ResSCALAR, class LSCALAR, class RSCALAR>
-inline void binaryOpDataReadyHelperEEE(DataExpanded& res, const DataExpanded& left, const DataExpanded& right, 
+inline void binaryOpDataReadyHelper(DataExpanded& res, const DataExpanded& left, const DataExpanded& right, 
 		     escript::ES_optype operation)
 {
   ResSCALAR resdummy=0;
@@ -843,26 +932,30 @@ void binaryOpDataEEE(DataExpanded& result, const DataExpanded& left, const DataE
       throw DataException(oss.str());
   }
   
+  if (binaryOpDataSingle(result, left, right, operation))
+  {
+      return;
+  }
   if (left.isComplex())
   {
       if (right.isComplex())
       {
-	  binaryOpDataReadyHelperEEE<DataTypes::cplx_t, DataTypes::cplx_t, DataTypes::cplx_t>(result, left, right, operation);
+	  binaryOpDataReadyHelper<DataTypes::cplx_t, DataTypes::cplx_t, DataTypes::cplx_t>(result, left, right, operation);
       }
       else
       {
-	  binaryOpDataReadyHelperEEE<DataTypes::cplx_t, DataTypes::cplx_t, DataTypes::real_t>(result, left, right, operation);	
+	  binaryOpDataReadyHelper<DataTypes::cplx_t, DataTypes::cplx_t, DataTypes::real_t>(result, left, right, operation);	
       }    
   }
   else	// left is real
   {
       if (right.isComplex())
       {
-	  binaryOpDataReadyHelperEEE<DataTypes::cplx_t, DataTypes::real_t, DataTypes::cplx_t>(result, left, right, operation);	
+	  binaryOpDataReadyHelper<DataTypes::cplx_t, DataTypes::real_t, DataTypes::cplx_t>(result, left, right, operation);	
       }
       else	// right is real
       {
-	  binaryOpDataReadyHelperEEE<DataTypes::real_t, DataTypes::real_t, DataTypes::real_t>(result, left, right, operation);	
+	  binaryOpDataReadyHelper<DataTypes::real_t, DataTypes::real_t, DataTypes::real_t>(result, left, right, operation);	
       }        
   }    
 }
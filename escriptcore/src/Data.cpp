@@ -53,6 +53,8 @@ using DataTypes::cplx_t;
 
 #define THROWONCOMPLEX if (m_data->isComplex()){throw DataException("Operation does not support complex objects");}
 #define THROWONCOMPLEXA(Z) if (Z.isComplex()){throw DataException("Operation does not support complex objects");}
+#define THROWONSINGLE if (m_data->isSinglePrecision()){throw DataException("Operation does not support single precision objects, use toDoublePrecision() first");}
+#define THROWONSINGLEA(Z) if (Z.isSinglePrecision()){throw DataException("Operation does not support single precision objects, use toDoublePrecision() first");}
 
 // ensure the current object is not a DataLazy
 // The idea was that we could add an optional warning whenever a resolve is forced
@@ -60,7 +62,7 @@ using DataTypes::cplx_t;
 
 #define AUTOLAZYON escriptParams.getAutoLazy()
 #define MAKELAZYOP(X) do {\
-  if (isLazy() || (AUTOLAZYON && m_data->isExpanded())) \
+  if (isLazy() || (AUTOLAZYON && m_data->isExpanded() && !m_data->isSinglePrecision())) \
   {\
         DataLazy* c=new DataLazy(borrowDataPtr(),X);\
         return Data(c);\
@@ -68,7 +70,7 @@ using DataTypes::cplx_t;
 }while(0)
 
 #define MAKELAZYOPOFF(X,Y) do {\
-  if (isLazy() || (AUTOLAZYON && m_data->isExpanded())) \
+  if (isLazy() || (AUTOLAZYON && m_data->isExpanded() && !m_data->isSinglePrecision())) \
   {\
         DataLazy* c=new DataLazy(borrowDataPtr(),X,Y);\
         return Data(c);\
@@ -76,7 +78,7 @@ using DataTypes::cplx_t;
 }while(0)
 
 #define MAKELAZYOP2(X,Y,Z) do {\
-  if (isLazy() || (AUTOLAZYON && m_data->isExpanded())) \
+  if (isLazy() || (AUTOLAZYON && m_data->isExpanded() && !m_data->isSinglePrecision())) \
   {\
         DataLazy* c=new DataLazy(borrowDataPtr(),X,Y,Z);\
         return Data(c);\
@@ -84,7 +86,8 @@ using DataTypes::cplx_t;
 }while(0)
 
 #define MAKELAZYBINSELF(R,X) do {\
-  if (isLazy() || R.isLazy() || (AUTOLAZYON && (isExpanded() || R.isExpanded()))) \
+  if (isLazy() || R.isLazy() || (AUTOLAZYON && (isExpanded() || R.isExpanded())\
+                && !isSinglePrecision() && !R.isSinglePrecision())) \
   {\
         DataLazy* c=new DataLazy(m_data,R.borrowDataPtr(),X);\
 /*         m_data=c->getPtr();*/     set_m_data(c->getPtr());\
@@ -94,7 +97,8 @@ using DataTypes::cplx_t;
 
 // like the above but returns a new data rather than *this
 #define MAKELAZYBIN(R,X) do {\
-  if (isLazy() || R.isLazy() || (AUTOLAZYON && (isExpanded() || R.isExpanded()))) \
+  if (isLazy() || R.isLazy() || (AUTOLAZYON && (isExpanded() || R.isExpanded())\
+                && !isSinglePrecision() && !R.isSinglePrecision())) \
   {\
         DataLazy* c=new DataLazy(m_data,R.borrowDataPtr(),X);\
         return Data(c);\
@@ -102,7 +106,8 @@ using DataTypes::cplx_t;
 }while(0)
 
 #define MAKELAZYBIN2(L,R,X) do {\
-  if (L.isLazy() || R.isLazy() || (AUTOLAZYON && (L.isExpanded() || R.isExpanded()))) \
+  if (L.isLazy() || R.isLazy() || (AUTOLAZYON && (L.isExpanded() || R.isExpanded())\
+                && !L.isSinglePrecision() && !R.isSinglePrecision())) \
   {\
 /*  if (L.isComplex() || R.isComplex()) \
   {\
@@ -244,6 +249,29 @@ pointToTuple( const DataTypes::ShapeType& shape,ARR v)
         throw DataException("Unknown rank in pointToTuple.");
 }
 
+// Returns a Data object filled with zeros. Single precision objects are
+// allocated in single precision rather than converted after creation.
+Data zeroData(const DataTypes::ShapeType& shape, const FunctionSpace& what,
+              bool expanded, bool single)
+{
+    if (!single)
+        return Data(0.0, shape, what, expanded);
+    const DataTypes::real32_t zero=0;
+    if (expanded)
+        return Data(new DataExpanded(what, shape, zero));
+    return Data(new DataConstant(what, shape, zero));
+}
+
+// Streams the samples of a lazy expression while it exists
+class SampleStream
+{
+public:
+    explicit SampleStream(DataLazy* dl) : m_dl(dl) { m_dl->beginSampleStream(); }
+    ~SampleStream() { m_dl->endSampleStream(); }
+private:
+    DataLazy* m_dl;
+};
+
 }  // anonymous namespace
 
 Data::Data()
@@ -817,6 +845,7 @@ Data::delaySelf()
 void
 Data::setToZero()
 {
+    THROWONSINGLE
     if (isEmpty())
     {
         throw DataException("Error - Operations (setToZero)  permitted on instances of DataEmpty.");
@@ -1165,6 +1194,44 @@ Data::isComplex() const
     return m_data->isComplex();
 }
 
+bool
+Data::isSinglePrecision() const
+{
+    return m_data->isSinglePrecision();
+}
+
+void
+Data::toSinglePrecision()
+{
+    if (isProtected()) {
+        throw DataException("Error - attempt to update protected Data object.");
+    }
+    if (isComplex()) {
+        throw DataException("Error - complex data can not be stored in single precision.");
+    }
+    if (isEmpty()) {
+        throw DataException("Error - Operations (toSinglePrecision) not permitted on instances of DataEmpty.");
+    }
+    if (isSinglePrecision()) {
+        return;
+    }
+    resolve();
+    exclusiveWrite();
+    m_data->toSinglePrecision();
+}
+
+void
+Data::toDoublePrecision()
+{
+    if (isProtected()) {
+        throw DataException("Error - attempt to update protected Data object.");
+    }
+    if (isSinglePrecision()) {
+        exclusiveWrite();
+        m_data->toDoublePrecision();
+    }
+}
+
 void
 Data::setProtection()
 {
@@ -1614,6 +1681,7 @@ Data::setTupleForGlobalDataPoint(int id, int proc, bp::object v)
 void
 Data::setValueOfDataPointToArray(int dataPointNo, const bp::object& obj)
 {
+    THROWONSINGLE
     if (isProtected()) {
         throw DataException("Error - attempt to update protected Data object.");
     }
@@ -1657,6 +1725,7 @@ Data::setValueOfDataPointToArray(int dataPointNo, const bp::object& obj)
 void
 Data::setValueOfDataPoint(int dataPointNo, const real_t value)
 {
+    THROWONSINGLE
     if (isProtected()) {
         throw DataException("Error - attempt to update protected Data object.");
     }
@@ -1678,6 +1747,7 @@ Data::setValueOfDataPoint(int dataPointNo, const real_t value)
 void
 Data::setValueOfDataPointC(int dataPointNo, const cplx_t value)
 {
+    THROWONSINGLE
     if (isProtected()) {
         throw DataException("Error - attempt to update protected Data object.");
     }
@@ -1788,8 +1858,15 @@ Data::integrateToTuple()
 {
     if (isLazy())
     {
-        expand();       // Can't do a non-resolving version of this without changing the domain object
-    }                     // see the dom->setToIntegrals call. Not saying it can't be done, just not doing it yet.
+        // The domains integrate cell oriented data sample by sample so
+        // those samples are streamed (see integrateWorker). Everything else
+        // needs to be interpolated first.
+        if (isComplex() || !actsExpanded() || CHECK_DO_CRES
+                || !getDomain()->isCellOriented(getFunctionSpace().getTypeCode()))
+        {
+            expand();
+        }
+    }
     if (isComplex()) {
         return integrateWorker<cplx_t>();
     } else {
@@ -1821,6 +1898,11 @@ Data::integrateWorker() const
         temp.resolve();
         dom->setToIntegrals(integrals_local, temp);
     }
+    else if (isLazy())
+    {
+        SampleStream stream(dynamic_cast<DataLazy*>(m_data.get()));
+        dom->setToIntegrals(integrals_local, *this);
+    }
     else
     {
         dom->setToIntegrals(integrals_local, *this);
@@ -1846,6 +1928,11 @@ Data::integrateWorker() const
         temp.resolve();
         dom->setToIntegrals(integrals, temp);
     }
+    else if (isLazy())
+    {
+        SampleStream stream(dynamic_cast<DataLazy*>(m_data.get()));
+        dom->setToIntegrals(integrals, *this);
+    }
     else
     {
         dom->setToIntegrals(integrals, *this);
@@ -2347,6 +2434,8 @@ Data::lazyAlgWorker(real_t init)
     const size_t samplesize=getNoValues()*getNumDataPointsPerSample();
     BinaryOp operation;
     real_t localValue=0, globalValue;    
+    // the samples are folded into the result as they are evaluated
+    SampleStream stream(dl);
     #pragma omp parallel private(i)
     {
         real_t localtot=init;
@@ -2391,6 +2480,7 @@ Data::lazyAlgWorker(real_t init)
 bool
 Data::hasNaN()
 {
+    THROWONSINGLE
     if (isLazy())
     {
         resolve();
@@ -2402,6 +2492,7 @@ Data::hasNaN()
 void
 Data::replaceNaN(real_t value)
 {
+    THROWONSINGLE
     if (isLazy())
     {
         resolve();
@@ -2412,6 +2503,7 @@ Data::replaceNaN(real_t value)
 void
 Data::replaceNaN(cplx_t value)
 {
+    THROWONSINGLE
     if (isLazy())
     {
         resolve();
@@ -2436,6 +2528,7 @@ Data::replaceNaNPython(boost::python::object obj)
 bool
 Data::hasInf()
 {
+    THROWONSINGLE
     if (isLazy())
     {
         resolve();
@@ -2447,6 +2540,7 @@ Data::hasInf()
 void
 Data::replaceInf(real_t value)
 {
+    THROWONSINGLE
     if (isLazy())
     {
         resolve();
@@ -2457,6 +2551,7 @@ Data::replaceInf(real_t value)
 void
 Data::replaceInf(cplx_t value)
 {
+    THROWONSINGLE
     if (isLazy())
     {
         resolve();
@@ -2482,6 +2577,7 @@ Data::replaceInfPython(boost::python::object obj)
 real_t
 Data::LsupWorker() const
 {
+    THROWONSINGLE
     bool haveNaN=getReady()->hasNaN();
 
   
@@ -2539,6 +2635,7 @@ Data::LsupWorker() const
 real_t
 Data::supWorker() const
 {
+    THROWONSINGLE
     bool haveNaN=getReady()->hasNaN();
     real_t localValue=0;
 
@@ -2582,6 +2679,7 @@ Data::supWorker() const
 real_t
 Data::infWorker() const
 {
+    THROWONSINGLE
     bool haveNaN=getReady()->hasNaN();
     real_t localValue=0;
 
@@ -2667,6 +2765,7 @@ Data::minval() const
 Data
 Data::swapaxes(const int axis0, const int axis1) const
 {
+    THROWONSINGLE
     int axis0_tmp,axis1_tmp;
     DataTypes::ShapeType s=getDataPointShape();
     DataTypes::ShapeType ev_shape;
@@ -2724,6 +2823,7 @@ Data::swapaxes(const int axis0, const int axis1) const
 Data
 Data::symmetric() const
 {
+    THROWONSINGLE
     // check input
     DataTypes::ShapeType s=getDataPointShape();
     if (getDataPointRank()==2) {
@@ -2747,6 +2847,7 @@ Data::symmetric() const
 Data
 Data::antisymmetric() const
 {
+    THROWONSINGLE
     // check input
     DataTypes::ShapeType s=getDataPointShape();
     if (getDataPointRank()==2) {
@@ -2783,6 +2884,7 @@ Data::antisymmetric() const
 Data
 Data::hermitian() const
 {
+    THROWONSINGLE
     if (!isComplex())
     {
         return symmetric();
@@ -2810,6 +2912,7 @@ Data::hermitian() const
 Data
 Data::antihermitian() const
 {
+    THROWONSINGLE
     if (!isComplex())
     {
         return antisymmetric();
@@ -2850,6 +2953,7 @@ Data::antihermitian() const
 Data
 Data::trace(int axis_offset) const
 {
+    THROWONSINGLE
     MAKELAZYOPOFF(TRACE,axis_offset);
     if ((axis_offset<0) || (axis_offset>getDataPointRank()))
     {
@@ -2905,6 +3009,7 @@ Data::trace(int axis_offset) const
 Data
 Data::transpose(int axis_offset) const
 {   
+    THROWONSINGLE
     MAKELAZYOPOFF(TRANS,axis_offset);
     DataTypes::ShapeType s=getDataPointShape();
     DataTypes::ShapeType ev_shape;
@@ -2929,6 +3034,7 @@ Data::transpose(int axis_offset) const
 Data
 Data::eigenvalues() const
 {
+    THROWONSINGLE
     if (isLazy())
     {
         Data temp(*this);       // to get around the fact that you can't resolve a const Data
@@ -2956,6 +3062,7 @@ Data::eigenvalues() const
 const bp::tuple
 Data::eigenvalues_and_eigenvectors(const real_t tol) const
 {
+    THROWONSINGLE
     THROWONCOMPLEX
     if (isLazy())
     {
@@ -3297,6 +3404,7 @@ Changing this would mean that any resolve call would need to use MPI (to check f
 Data
 Data::matrixInverse() const
 {
+    THROWONSINGLE
     if (isLazy())       // Cannot use lazy for this because individual inversions could throw.
     {
         Data d(*this);
@@ -3517,6 +3625,7 @@ void
 Data::setSlice(const Data& value,
                const DataTypes::RegionType& region)
 {
+    THROWONSINGLE
     if (isProtected()) {
         throw DataException("Error - attempt to update protected Data object.");
     }
@@ -3597,6 +3706,7 @@ void
 Data::setTaggedValue(int tagKey,
                      const bp::object& value)
 {
+    THROWONSINGLE
     if (isProtected()) {
         throw DataException("Error - attempt to update protected Data object.");
     }
@@ -3639,6 +3749,7 @@ Data::setTaggedValueFromCPP(int tagKey,
                             const DataTypes::RealVectorType& value,
                             int dataOffset)
 {
+    THROWONSINGLE
     if (isProtected()) {
         throw DataException("Error - attempt to update protected Data object.");
     }
@@ -3658,6 +3769,7 @@ Data::setTaggedValueFromCPP(int tagKey,
                             const DataTypes::CplxVectorType& value,
                             int dataOffset)
 {
+    THROWONSINGLE
     if (isProtected()) {
         throw DataException("Error - attempt to update protected Data object.");
     }
@@ -4645,6 +4757,13 @@ Data::borrowReadyPtr() const
 std::string
 Data::toString() const
 {
+    if (isSinglePrecision())
+    {
+        // show the values as they would be after toDoublePrecision()
+        Data temp(copySelf());
+        temp.toDoublePrecision();
+        return temp.toString();
+    }
     int localNeedSummary=0;
 #ifdef ESYS_MPI
     int globalNeedSummary=0;
@@ -5419,6 +5538,7 @@ Data::print()
 void
 Data::dump(const std::string fileName) const
 {
+    THROWONSINGLE
     try
     {
         if (isLazy())
@@ -6091,6 +6211,7 @@ escript::C_TensorUnaryOperation(Data const &arg_0,
   {
      throw DataException("Error - Operations not permitted on lazy data.");
   }
+  THROWONSINGLEA(arg_0)
   
   if (arg_0.isComplex() && !supports_cplx(operation))
   {
@@ -6402,11 +6523,17 @@ escript::C_TensorBinaryOperation(Data const &arg_0,
   DataTypes::ShapeType resultshape=((arg_0_Z.getDataPointRank()!=0)?shape0:shape1);
 
   bool emptyResult=((arg_0_Z.getNumSamples()==0) || (arg_1_Z.getNumSamples()==0));
+  // single op single and single op constant give single precision,
+  // single op (tagged or expanded) double gives double precision
+  bool singleResult=!arg_0_Z.isComplex() && !arg_1_Z.isComplex()
+        && (arg_0_Z.isSinglePrecision() || arg_0_Z.isConstant())
+        && (arg_1_Z.isSinglePrecision() || arg_1_Z.isConstant())
+        && (arg_0_Z.isSinglePrecision() || arg_1_Z.isSinglePrecision());
   if ((shape0==shape1) || (arg_0_Z.getDataPointRank()==0) || (arg_1_Z.getDataPointRank()==0))
   {
     if (arg_0_Z.isConstant()   && arg_1_Z.isConstant())
     {
-      Data res(0.0, resultshape, arg_1_Z.getFunctionSpace(),false);      // DataConstant output
+      Data res=zeroData(resultshape, arg_1_Z.getFunctionSpace(), false, singleResult);      // DataConstant output
       if (arg_0_Z.isComplex() || arg_1_Z.isComplex())
       {
         res.complicate();
@@ -6419,7 +6546,7 @@ escript::C_TensorBinaryOperation(Data const &arg_0,
     }
     else if (arg_0_Z.isConstant()   && arg_1_Z.isTagged())
     {
-      Data res(0.0, resultshape, arg_1_Z.getFunctionSpace(), false);      // DataTagged output
+      Data res=zeroData(resultshape, arg_1_Z.getFunctionSpace(), false, singleResult);      // DataTagged output
       if (arg_0_Z.isComplex() || arg_1_Z.isComplex())
       {
         res.complicate();
@@ -6433,7 +6560,7 @@ escript::C_TensorBinaryOperation(Data const &arg_0,
     }
     else if (arg_0_Z.isConstant()   && arg_1_Z.isExpanded())
     {
-      Data res(0.0, resultshape, arg_1_Z.getFunctionSpace(),true); // DataExpanded output
+      Data res=zeroData(resultshape, arg_1_Z.getFunctionSpace(), true, singleResult); // DataExpanded output
       if (arg_0_Z.isComplex() || arg_1_Z.isComplex())
       {
         res.complicate();
@@ -6446,7 +6573,7 @@ escript::C_TensorBinaryOperation(Data const &arg_0,
     }
     else if (arg_0_Z.isTagged()     && arg_1_Z.isConstant())
     {
-      Data res(0.0, resultshape, arg_0_Z.getFunctionSpace(),false);      // DataTagged output
+      Data res=zeroData(resultshape, arg_0_Z.getFunctionSpace(), false, singleResult);      // DataTagged output
       if (arg_0_Z.isComplex() || arg_1_Z.isComplex())
       {
         res.complicate();
@@ -6460,7 +6587,7 @@ escript::C_TensorBinaryOperation(Data const &arg_0,
     }
     else if (arg_0_Z.isTagged()     && arg_1_Z.isTagged())
     {
-      Data res(0.0, resultshape, arg_1_Z.getFunctionSpace(), false);
+      Data res=zeroData(resultshape, arg_1_Z.getFunctionSpace(), false, singleResult);
       if (arg_0_Z.isComplex() || arg_1_Z.isComplex())
       {
         res.complicate();
@@ -6474,7 +6601,7 @@ escript::C_TensorBinaryOperation(Data const &arg_0,
     }
     else if (arg_0_Z.isTagged()     && arg_1_Z.isExpanded())
     {
-      Data res(0.0, resultshape, arg_1_Z.getFunctionSpace(),true); // DataExpanded output
+      Data res=zeroData(resultshape, arg_1_Z.getFunctionSpace(), true, singleResult); // DataExpanded output
       if (arg_0_Z.isComplex() || arg_1_Z.isComplex())
       {
         res.complicate();
@@ -6486,7 +6613,7 @@ escript::C_TensorBinaryOperation(Data const &arg_0,
       return res;
     }
     else if (arg_0_Z.isExpanded()   && arg_1_Z.isConstant()) {
-      Data res(0.0, resultshape, arg_1_Z.getFunctionSpace(),true); // DataExpanded output
+      Data res=zeroData(resultshape, arg_1_Z.getFunctionSpace(), true, singleResult); // DataExpanded output
       if (arg_0_Z.isComplex() || arg_1_Z.isComplex())
       {
         res.complicate();
@@ -6498,7 +6625,7 @@ escript::C_TensorBinaryOperation(Data const &arg_0,
       return res;
     }
     else if (arg_0_Z.isExpanded()   && arg_1_Z.isTagged()) {
-      Data res(0.0, resultshape, arg_1_Z.getFunctionSpace(),true); // DataExpanded output
+      Data res=zeroData(resultshape, arg_1_Z.getFunctionSpace(), true, singleResult); // DataExpanded output
       if (arg_0_Z.isComplex() || arg_1_Z.isComplex())
       {
         res.complicate();
@@ -6510,7 +6637,7 @@ escript::C_TensorBinaryOperation(Data const &arg_0,
       return res;
     }
     else if (arg_0_Z.isExpanded()   && arg_1_Z.isExpanded()) {
-      Data res(0.0, resultshape, arg_1_Z.getFunctionSpace(),true); // DataExpanded output
+      Data res=zeroData(resultshape, arg_1_Z.getFunctionSpace(), true, singleResult); // DataExpanded output
       if (arg_0_Z.isComplex() || arg_1_Z.isComplex())
       {
         res.complicate();
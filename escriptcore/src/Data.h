@@ -453,6 +453,13 @@ contains datapoints.
   bool
   isComplex() const;
 
+  /**
+    \brief
+    True if components of this data are stored in single precision
+  */
+  bool
+  isSinglePrecision() const;
+
   /**
      \brief
      Return the function space.
@@ -1623,6 +1630,23 @@ instead of manually manipulating process and point IDs.
   * \brief make the data complex
   */
   void complicate();
+
+  /**
+     \brief
+     Store the values of this (real) Data in single precision. This halves
+     the memory used. Arithmetic (+,-,*,/,**) between single precision Data
+     and constants gives single precision results, arithmetic with double
+     precision Data gives double precision results. Other operations throw
+     until toDoublePrecision() is called. Single precision Data can not be
+     lazy.
+  */
+  void toSinglePrecision();
+
+  /**
+     \brief
+     Store the values of this Data in double precision.
+  */
+  void toDoublePrecision();
  
  protected:
 
@@ -2012,7 +2036,7 @@ Data::getDataRO(DataTypes::real_t dummy) const
     }
     else
     {
-        return &(getReady()->getTypedVectorRO(0)[0]);
+        return &(getReady()->getTypedVectorRO(0.0)[0]);
     }
 }
 
@@ -71,11 +71,18 @@ DataAbstract::isComplex() const
     return m_iscompl;
 }
 
+bool
+DataAbstract::isSinglePrecision() const
+{
+    return m_issingle;
+}
+
 
 DataAbstract::DataAbstract(const FunctionSpace& what, const ShapeType& shape, bool isDataEmpty, bool isCplx):
     m_noSamples(what.getNumSamples()),
     m_noDataPointsPerSample(what.getNumDPPSample()),
     m_iscompl(isCplx),
+    m_issingle(false),
     m_functionSpace(what),
     m_shape(shape),
     m_novalues(DataTypes::noValues(shape)),
@@ -282,6 +289,16 @@ void DataAbstract::complicate()
     throw DataException("This type does not support converting to complex.");
 }
 
+void DataAbstract::toSinglePrecision()
+{
+    throw DataException("This type does not support single precision storage.");
+}
+
+void DataAbstract::toDoublePrecision()
+{
+    throw DataException("This type does not support single precision storage.");
+}
+
 
 }  // end of namespace
 
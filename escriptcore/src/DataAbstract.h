@@ -506,6 +506,11 @@ class ESCRIPT_DLL_API DataAbstract : public REFCOUNT_BASE_CLASS(DataAbstract)
   */
   bool isComplex() const;
 
+  /**
+   \brief true if the values of datapoints are stored in single precision
+  */
+  bool isSinglePrecision() const;
+
 #ifdef SLOWSHARECHECK   
   
   // For this to be threadsafe, we need to be sure that this is the
@@ -545,6 +550,16 @@ class ESCRIPT_DLL_API DataAbstract : public REFCOUNT_BASE_CLASS(DataAbstract)
 */
  virtual void complicate();
 
+/*
+ * Store the (real) values of the object in single precision
+*/
+ virtual void toSinglePrecision();
+
+/*
+ * Store the values of the object in double precision
+*/
+ virtual void toDoublePrecision();
+
 protected:
     friend class DataLazy;
 
@@ -561,6 +576,10 @@ protected:
   //
   // is the data made of complex components
   bool m_iscompl;
+
+  //
+  // are the values stored in single precision
+  bool m_issingle;
 private:
 
   //
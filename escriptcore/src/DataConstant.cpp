@@ -80,10 +80,15 @@ DataConstant::DataConstant(const DataConstant& other)
   : parent(other.getFunctionSpace(),other.getShape())
 {
   this->m_iscompl=other.m_iscompl;
+  this->m_issingle=other.m_issingle;
   if (other.isComplex()) 
   {
       m_data_c=other.m_data_c;
   }
+  else if (other.isSinglePrecision())
+  {
+      m_data_f=other.m_data_f;
+  }
   else
   {
       m_data_r=other.m_data_r;
@@ -149,6 +154,14 @@ DataConstant::DataConstant(const FunctionSpace& what,
     m_iscompl=true;
 }
 
+DataConstant::DataConstant(const FunctionSpace& what,
+                           const DataTypes::ShapeType &shape,
+                           const DataTypes::real32_t v)
+  : parent(what,shape), m_data_f(DataTypes::noValues(shape),v)
+{
+    m_issingle=true;
+}
+
 bool DataConstant::hasNaN() const
 {
     bool haveNaN=false;
@@ -382,7 +395,7 @@ DataConstant::getPointOffset(int sampleNo,
 DataTypes::RealVectorType::size_type
 DataConstant::getLength() const
 {
-    return std::max(m_data_c.size(), m_data_r.size());  
+    return std::max(std::max(m_data_c.size(), m_data_r.size()), m_data_f.size());
 }
 
 DataAbstract*
@@ -838,12 +851,14 @@ DataTypes::RealVectorType&
 DataConstant::getVectorRW()
 {
     CHECK_FOR_EX_WRITE
+    checkDoublePrecision();
     return m_data_r;
 }
 
 const DataTypes::RealVectorType&
 DataConstant::getVectorRO() const
 {
+    checkDoublePrecision();
     return m_data_r;
 }
 
@@ -864,12 +879,14 @@ DataTypes::RealVectorType&
 DataConstant::getTypedVectorRW(DataTypes::real_t dummy)
 {
     CHECK_FOR_EX_WRITE
+    checkDoublePrecision();
     return m_data_r;
 }
 
 const DataTypes::RealVectorType&
 DataConstant::getTypedVectorRO(DataTypes::real_t dummy) const
 {
+    checkDoublePrecision();
     return m_data_r;
 }
 
@@ -886,8 +903,25 @@ DataConstant::getTypedVectorRO(DataTypes::cplx_t dummy) const
     return m_data_c;
 }
 
+DataTypes::Real32VectorType&
+DataConstant::getTypedVectorRW(DataTypes::real32_t dummy)
+{
+    CHECK_FOR_EX_WRITE
+    return m_data_f;
+}
+
+const DataTypes::Real32VectorType&
+DataConstant::getTypedVectorRO(DataTypes::real32_t dummy) const
+{
+    return m_data_f;
+}
+
 void DataConstant::complicate()
 {
+    if (isSinglePrecision())
+    {
+        throw DataException("Error - single precision data can not be made complex. Use toDoublePrecision() first.");
+    }
     if (!isComplex())
     {
         fillComplexFromReal(m_data_r, m_data_c);
@@ -896,5 +930,29 @@ void DataConstant::complicate()
     }
 }
 
+void DataConstant::toSinglePrecision()
+{
+    if (isComplex())
+    {
+        throw DataException("Error - single precision storage is not supported for complex data.");
+    }
+    if (!isSinglePrecision())
+    {
+        fillReal32FromReal(m_data_r, m_data_f);
+        this->m_issingle=true;
+        m_data_r.resize(0,0,1);
+    }
+}
+
+void DataConstant::toDoublePrecision()
+{
+    if (isSinglePrecision())
+    {
+        fillRealFromReal32(m_data_f, m_data_r);
+        this->m_issingle=false;
+        m_data_f.resize(0,0,1);
+    }
+}
+
 }  // end of namespace
 
@@ -101,6 +101,14 @@ typedef DataReady parent;
   explicit DataConstant(const FunctionSpace& what,
                            const DataTypes::ShapeType &shape,
                            const DataTypes::cplx_t v);
+
+  /**
+     \brief
+     Constructs a DataConstant which holds the value v in single precision.
+  */
+  explicit DataConstant(const FunctionSpace& what,
+                           const DataTypes::ShapeType &shape,
+                           const DataTypes::real32_t v);
                
   ESCRIPT_DLL_API
   bool
@@ -405,6 +413,14 @@ typedef DataReady parent;
   virtual const DataTypes::CplxVectorType&
   getTypedVectorRO(DataTypes::cplx_t dummy) const;  
 
+  ESCRIPT_DLL_API
+  virtual DataTypes::Real32VectorType&
+  getTypedVectorRW(DataTypes::real32_t dummy);
+
+  ESCRIPT_DLL_API
+  virtual const DataTypes::Real32VectorType&
+  getTypedVectorRO(DataTypes::real32_t dummy) const;
+
 
 
   
@@ -414,6 +430,18 @@ typedef DataReady parent;
   ESCRIPT_DLL_API
   void complicate();
 
+  /**
+   * \brief Store the (real) value in single precision.
+  */
+  ESCRIPT_DLL_API
+  void toSinglePrecision();
+
+  /**
+   * \brief Store the value in double precision.
+  */
+  ESCRIPT_DLL_API
+  void toDoublePrecision();
+
  protected:
 
  private:
@@ -421,6 +449,7 @@ typedef DataReady parent;
   // the actual data
   DataTypes::RealVectorType m_data_r;
   DataTypes::CplxVectorType m_data_c;
+  DataTypes::Real32VectorType m_data_f;
 
 };
 
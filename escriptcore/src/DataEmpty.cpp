@@ -29,6 +29,7 @@ namespace {
 
   escript::DataTypes::RealVectorType dummy;	
   escript::DataTypes::CplxVectorType dummyc;	
+  escript::DataTypes::Real32VectorType dummyf;
 }
 
 namespace escript {
@@ -165,6 +166,20 @@ DataEmpty::getTypedVectorRO(DataTypes::cplx_t dummypar) const
   return dummyc;			// dead code to stop the compiler complaining
 }
 
+DataTypes::Real32VectorType&
+DataEmpty::getTypedVectorRW(DataTypes::real32_t dummypar)
+{
+  throwStandardException("getVector");	// always throws but the compiler doesn't know that.
+  return dummyf;			// dead code to stop the compiler complaining
+}
+
+const DataTypes::Real32VectorType&
+DataEmpty::getTypedVectorRO(DataTypes::real32_t dummypar) const
+{
+  throwStandardException("getVector");	// always throws but the compiler doesn't know that.
+  return dummyf;			// dead code to stop the compiler complaining
+}
+
 
 
 void
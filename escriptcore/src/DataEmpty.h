@@ -233,6 +233,12 @@ typedef DataReady parent;
   
   virtual const DataTypes::CplxVectorType&
   getTypedVectorRO(DataTypes::cplx_t dummy) const;      
+
+  virtual DataTypes::Real32VectorType&
+  getTypedVectorRW(DataTypes::real32_t dummy);
+
+  virtual const DataTypes::Real32VectorType&
+  getTypedVectorRO(DataTypes::real32_t dummy) const;
   
   
  private:
@@ -72,14 +72,29 @@ DataExpanded::DataExpanded(const WrappedArray& value,
 
 DataExpanded::DataExpanded(const DataExpanded& other)
   : parent(other.getFunctionSpace(), other.getShape()),
-    m_data_r(other.m_data_r), m_data_c(other.m_data_c)
+    m_data_r(other.m_data_r), m_data_c(other.m_data_c), m_data_f(other.m_data_f)
 {
     m_iscompl=other.m_iscompl;
+    m_issingle=other.m_issingle;
 }
 
 DataExpanded::DataExpanded(const DataConstant& other)
   : parent(other.getFunctionSpace(), other.getShape())
 {
+    if (other.isSinglePrecision())
+    {
+	// the values stay in single precision
+	initialiseSingle(other.getNumSamples(),other.getNumDPPSample());
+	DataTypes::real32_t dummy=0;
+	#pragma omp parallel for
+	for (int i=0; i<m_noSamples; i++) {
+	    for (int j=0; j<m_noDataPointsPerSample; j++) {
+		DataTypes::copyPoint(m_data_f, getPointOffset(i,j),
+				    getNoValues(), other.getTypedVectorRO(dummy), 0);
+	    }
+	}
+	return;
+    }
     // initialise the data array for this object
     initialise(other.getNumSamples(),other.getNumDPPSample(), other.isComplex());
     // DataConstant only has one value, copy this to every data point
@@ -89,6 +104,21 @@ DataExpanded::DataExpanded(const DataConstant& other)
 DataExpanded::DataExpanded(const DataTagged& other)
   : parent(other.getFunctionSpace(), other.getShape())
 {
+    if (other.isSinglePrecision())
+    {
+	// the values stay in single precision
+	initialiseSingle(other.getNumSamples(),other.getNumDPPSample());
+	DataTypes::real32_t dummy=0;
+	#pragma omp parallel for
+	for (int i=0; i<m_noSamples; i++) {
+	    for (int j=0; j<m_noDataPointsPerSample; j++) {
+		DataTypes::copyPoint(m_data_f, getPointOffset(i,j),
+				    getNoValues(), other.getTypedVectorRO(dummy),
+				    other.getPointOffset(i,j));
+	    }
+	}
+	return;
+    }
     // initialise the data array for this object
     initialise(other.getNumSamples(),other.getNumDPPSample(), other.isComplex());
     // for each data point in this object, extract and copy the corresponding
@@ -256,6 +286,21 @@ DataExpanded::DataExpanded(const FunctionSpace& what,
     }
 }
 
+DataExpanded::DataExpanded(const FunctionSpace& what,
+                           const DataTypes::ShapeType &shape,
+                           const DataTypes::real32_t v)
+  : parent(what,shape)
+{
+    initialiseSingle(what.getNumSamples(),what.getNumDPPSample());
+    DataTypes::Real32VectorType& vec=m_data_f;
+    // now we copy this value to all elements
+    const int L=getLength();
+#pragma omp parallel for
+    for (int i=0; i<L; ++i) {
+        vec[i]=v;
+    }
+}
+
 
 DataExpanded::~DataExpanded()
 {
@@ -419,6 +464,16 @@ void DataExpanded::initialise(int noSamples, int noDataPointsPerSample, bool cpl
     }
 }
 
+void DataExpanded::initialiseSingle(int noSamples, int noDataPointsPerSample)
+{
+    this->m_iscompl=false;
+    this->m_issingle=true;
+    if (noSamples==0) //retain the default empty object
+        return;
+
+    m_data_f.resize(noSamples*noDataPointsPerSample*getNoValues(), 0.0, noDataPointsPerSample*getNoValues());
+}
+
 bool
 DataExpanded::hasNaN() const
 {
@@ -622,16 +677,10 @@ DataTypes::RealVectorType::size_type DataExpanded::getPointOffset(int sampleNo,
                                                         int dataPointNo) const
 {
     DataTypes::RealVectorType::size_type blockSize=getNoValues();
-    ESYS_ASSERT((isComplex()?
-		  ((sampleNo >= 0) && (dataPointNo >= 0) && (m_data_c.size() > 0))
-		:
-		  ((sampleNo >= 0) && (dataPointNo >= 0) && (m_data_r.size() > 0))), 
+    ESYS_ASSERT(((sampleNo >= 0) && (dataPointNo >= 0) && (getLength() > 0)),
 	       "(DataBlocks2D) Index value out of range.");
     DataTypes::RealVectorType::size_type temp=(sampleNo*m_noDataPointsPerSample+dataPointNo)*blockSize;
-    ESYS_ASSERT((isComplex()?
-		  (temp <= (m_data_c.size()-blockSize))
-		:
-		  (temp <= (m_data_r.size()-blockSize))), "Index value out of range.");
+    ESYS_ASSERT((temp <= (getLength()-blockSize)), "Index value out of range.");
 
     return temp;
 }
@@ -639,6 +688,10 @@ DataTypes::RealVectorType::size_type DataExpanded::getPointOffset(int sampleNo,
 
 void DataExpanded::complicate()
 {
+    if (isSinglePrecision())
+    {
+        throw DataException("Error - single precision data can not be made complex. Use toDoublePrecision() first.");
+    }
     if (!isComplex())
     {
         fillComplexFromReal(m_data_r, m_data_c);
@@ -647,10 +700,34 @@ void DataExpanded::complicate()
     }
 }
 
+void DataExpanded::toSinglePrecision()
+{
+    if (isComplex())
+    {
+        throw DataException("Error - single precision storage is not supported for complex data.");
+    }
+    if (!isSinglePrecision())
+    {
+        fillReal32FromReal(m_data_r, m_data_f);
+        this->m_issingle=true;
+        m_data_r.resize(0,0,1);
+    }
+}
+
+void DataExpanded::toDoublePrecision()
+{
+    if (isSinglePrecision())
+    {
+        fillRealFromReal32(m_data_f, m_data_r);
+        this->m_issingle=false;
+        m_data_f.resize(0,0,1);
+    }
+}
+
 
 DataTypes::RealVectorType::size_type DataExpanded::getLength() const
 {
-    return std::max(m_data_c.size(), m_data_r.size());  
+    return std::max(std::max(m_data_c.size(), m_data_r.size()), m_data_f.size());
 }
 
 void DataExpanded::copyToDataPoint(int sampleNo, int dataPointNo, const DataTypes::cplx_t value)
@@ -1503,11 +1580,13 @@ void DataExpanded::reorderByReferenceIDs(dim_t *reference_ids)
 DataTypes::RealVectorType& DataExpanded::getVectorRW()
 {
     CHECK_FOR_EX_WRITE;
+    checkDoublePrecision();
     return m_data_r;
 }
 
 const DataTypes::RealVectorType& DataExpanded::getVectorRO() const
 {
+    checkDoublePrecision();
     return m_data_r;
 }
 
@@ -1525,11 +1604,13 @@ const DataTypes::CplxVectorType& DataExpanded::getVectorROC() const
 DataTypes::RealVectorType& DataExpanded::getTypedVectorRW(DataTypes::real_t dummypar)
 {
     CHECK_FOR_EX_WRITE;
+    checkDoublePrecision();
     return m_data_r;
 }
 
 const DataTypes::RealVectorType& DataExpanded::getTypedVectorRO(DataTypes::real_t dummypar) const
 {
+    checkDoublePrecision();
     return m_data_r;
 }
 
@@ -1544,6 +1625,17 @@ const DataTypes::CplxVectorType& DataExpanded::getTypedVectorRO(DataTypes::cplx_
     return m_data_c;
 }
 
+DataTypes::Real32VectorType& DataExpanded::getTypedVectorRW(DataTypes::real32_t dummypar)
+{
+    CHECK_FOR_EX_WRITE;
+    return m_data_f;
+}
+
+const DataTypes::Real32VectorType& DataExpanded::getTypedVectorRO(DataTypes::real32_t dummypar) const
+{
+    return m_data_f;
+}
+
 
 //void DataExpanded::randomFill(long seed)
 //{
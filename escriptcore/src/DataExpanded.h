@@ -110,6 +110,16 @@ TODO Note that this constructor will also copy data to all points if it only con
   explicit DataExpanded(const FunctionSpace& what,
                const DataTypes::ShapeType &shape,
                const DataTypes::cplx_t data);	       
+
+  /**
+     \brief
+     Constructs a DataExpanded which holds the value data at every data
+     point in single precision.
+  */
+  ESCRIPT_DLL_API
+  explicit DataExpanded(const FunctionSpace& what,
+               const DataTypes::ShapeType &shape,
+               const DataTypes::real32_t data);
   
 	       
   /**
@@ -307,6 +317,12 @@ TODO Note that this constructor will also copy data to all points if it only con
   virtual const DataTypes::CplxVectorType&
   getTypedVectorRO(DataTypes::cplx_t dummy) const;    
 
+  virtual DataTypes::Real32VectorType&
+  getTypedVectorRW(DataTypes::real32_t dummy);
+
+  virtual const DataTypes::Real32VectorType&
+  getTypedVectorRO(DataTypes::real32_t dummy) const;
+
   /**
      \brief
      Return the number of doubles stored for the Data.
@@ -486,6 +502,20 @@ TODO Note that this constructor will also copy data to all points if it only con
   ESCRIPT_DLL_API
   void
   complicate();
+
+  /**
+     \brief Store the (real) values in single precision.
+  */
+  ESCRIPT_DLL_API
+  void
+  toSinglePrecision();
+
+  /**
+     \brief Store the values in double precision.
+  */
+  ESCRIPT_DLL_API
+  void
+  toDoublePrecision();
  protected:
 
  private:
@@ -511,6 +541,17 @@ TODO Note that this constructor will also copy data to all points if it only con
 	     bool cplx
 	    );
 
+  /**
+     \brief
+     As initialise but the storage holds single precision values.
+
+     \param noSamples - Input - number of samples.
+     \param noDataPointsPerSample - Input - number of data points per sample.
+  */
+  void
+  initialiseSingle(int noSamples,
+                   int noDataPointsPerSample);
+
   /**
      \brief
      Copy the given data point value to all data points in this object.
@@ -573,6 +614,7 @@ TODO Note that this constructor will also copy data to all points if it only con
   // noSamples * noDataPointsPerSample
   DataTypes::RealVectorType m_data_r;
   DataTypes::CplxVectorType m_data_c;
+  DataTypes::Real32VectorType m_data_f;
 };
 
 } // end of namespace
@@ -21,6 +21,7 @@
 #include "FunctionSpace.h"
 #include "Utils.h"
 #include "DataVectorOps.h"
+#include "LazyKernel.h"
 
 #include <iomanip> // for some fancy formatting in debug
 
@@ -90,6 +91,14 @@ Normally, this would be v, but for identity nodes their internal vector is retur
 
 The convention that I use, is that the resolve methods should store their results starting at the offset they are passed.
 
+Before resolving, identical subexpressions (same operation and parameters on the same children) are replaced by a
+single node (see shareSubExpressions). Since each node keeps the last sample it evaluated, a shared node is only
+evaluated once per sample, no matter how often it appears in the expression.
+
+Real valued expanded expressions are not resolved sample by sample. They are compiled into a LazyKernel which
+evaluates each operation for a whole block of samples at once, so only the inputs of the kernel which it cannot
+handle itself (see LazyKernel::canCompile) go through resolveNodeSample.
+
 For expressions which evaluate to Constant or Tagged, there is a different evaluation method.
 The collapse method invokes the (non-lazy) operations on the Data class to evaluate the expression.
 
@@ -442,7 +451,8 @@ DataLazy::DataLazy(DataAbstract_ptr p)
         ,m_sampleids(0),
         m_samples_r(1),
         m_op(IDENTITY),
-        m_opgroup(getOpgroup(m_op))
+        m_opgroup(getOpgroup(m_op)),
+        m_sampleblocks(0)
 {
    if (p->isLazy())
    {
@@ -465,6 +475,7 @@ DataLazy::DataLazy(DataAbstract_ptr left, ES_optype op)
         : parent(left->getFunctionSpace(),(getOpgroup(op)!=G_REDUCTION)?left->getShape():DataTypes::scalarShape),
         m_op(op),
         m_opgroup(getOpgroup(m_op)),                  
+        m_sampleblocks(0),
         m_axis_offset(0),
         m_transpose(0),
         m_SL(0), m_SM(0), m_SR(0)
@@ -514,6 +525,7 @@ DataLazy::DataLazy(DataAbstract_ptr left, DataAbstract_ptr right, ES_optype op)
         : parent(resultFS(left,right,op), resultShape(left,right,op)),
         m_op(op),
         m_opgroup(getOpgroup(m_op)),                  
+        m_sampleblocks(0),
         m_SL(0), m_SM(0), m_SR(0)
 {
 LAZYDEBUG(cout << "Forming operator with " << left.get() << " " << right.get() << endl;)
@@ -610,6 +622,7 @@ DataLazy::DataLazy(DataAbstract_ptr left, DataAbstract_ptr right, ES_optype op,
         : parent(resultFS(left,right,op), GTPShape(left,right, axis_offset, transpose, m_SL,m_SM, m_SR)),
         m_op(op),
         m_opgroup(getOpgroup(m_op)),                  
+        m_sampleblocks(0),
         m_axis_offset(axis_offset),
         m_transpose(transpose)
 {
@@ -704,6 +717,7 @@ DataLazy::DataLazy(DataAbstract_ptr left, ES_optype op, int axis_offset)
         : parent(left->getFunctionSpace(), resultShape(left,op, axis_offset)),
         m_op(op),
         m_opgroup(getOpgroup(m_op)),                  
+        m_sampleblocks(0),
         m_axis_offset(axis_offset),
         m_transpose(0),
         m_tol(0)
@@ -745,6 +759,7 @@ DataLazy::DataLazy(DataAbstract_ptr left, ES_optype op, double tol)
         : parent(left->getFunctionSpace(), left->getShape()),
         m_op(op),
         m_opgroup(getOpgroup(m_op)),                  
+        m_sampleblocks(0),
         m_axis_offset(0),
         m_transpose(0),
         m_tol(tol)
@@ -793,6 +808,7 @@ DataLazy::DataLazy(DataAbstract_ptr left, ES_optype op, const int axis0, const i
         : parent(left->getFunctionSpace(), SwapShape(left,axis0,axis1)),
         m_op(op),
         m_opgroup(getOpgroup(m_op)),                  
+        m_sampleblocks(0),
         m_axis_offset(axis0),
         m_transpose(axis1),
         m_tol(0)
@@ -836,6 +852,7 @@ DataLazy::DataLazy(DataAbstract_ptr mask, DataAbstract_ptr left, DataAbstract_pt
         : parent(left->getFunctionSpace(), left->getShape()),
         m_op(CONDEVAL),
         m_opgroup(getOpgroup(m_op)),                  
+        m_sampleblocks(0),
         m_axis_offset(0),
         m_transpose(0),
         m_tol(0)
@@ -918,6 +935,7 @@ LAZYDEBUG(cout << "(8)Lazy created with " << m_samplesize << endl;)
 DataLazy::~DataLazy()
 {
    delete[] m_sampleids;
+   delete m_sampleblocks;
 }
 
 
@@ -2339,6 +2357,10 @@ DataLazy::resolveSample(int sampleNo, size_t& roffset) const
 #else
         int tid=0;
 #endif 
+        if (m_sampleblocks)
+        {
+                return m_sampleblocks->getSample(tid, sampleNo, roffset);
+        }
 
 #ifdef LAZY_STACK_PROF
         stackstart[tid]=&tid;
@@ -2366,6 +2388,10 @@ DataLazy::resolveTypedSample(int sampleNo, size_t& roffset, DataTypes::real_t du
 #else
         int tid=0;
 #endif 
+        if (m_sampleblocks)
+        {
+                return m_sampleblocks->getSample(tid, sampleNo, roffset);
+        }
 
 #ifdef LAZY_STACK_PROF
         stackstart[tid]=&tid;
@@ -2432,6 +2458,11 @@ DataLazy::resolveToIdentity()
 
 void DataLazy::makeIdentity(const DataReady_ptr& p)
 {
+   if (p->isSinglePrecision())
+   {
+        throw DataException("Error - single precision data can not be used in lazy expressions. Use toDoublePrecision() first.");
+   }
+   endSampleStream();
    m_axis_offset=0;
    m_transpose=0;
    m_SL=m_SM=m_SR=0;
@@ -2458,6 +2489,147 @@ DataLazy::resolve()
 }
 
 
+bool
+DataLazy::NodeKey::operator<(const NodeKey& other) const
+{
+  if (op!=other.op) return op<other.op;
+  if (id!=other.id) return id<other.id;
+  if (left!=other.left) return left<other.left;
+  if (right!=other.right) return right<other.right;
+  if (mask!=other.mask) return mask<other.mask;
+  if (axis_offset!=other.axis_offset) return axis_offset<other.axis_offset;
+  if (transpose!=other.transpose) return transpose<other.transpose;
+  return tol<other.tol;
+}
+
+// Only the parameters used by the operation are part of the key, the others
+// are not initialised by all constructors
+DataLazy::NodeKey
+DataLazy::getNodeKey() const
+{
+  NodeKey key;
+  key.op=m_op;
+  key.id=m_id.get();
+  key.left=m_left.get();
+  key.right=m_right.get();
+  key.mask=m_mask.get();
+  key.axis_offset=0;
+  key.transpose=0;
+  key.tol=0;
+  switch (m_opgroup)
+  {
+  case G_UNARY_P:
+  case G_UNARY_PR:
+        key.tol=m_tol;
+        break;
+  case G_NP1OUT_P:
+        key.axis_offset=m_axis_offset;
+        break;
+  case G_TENSORPROD:
+  case G_NP1OUT_2P:
+        key.axis_offset=m_axis_offset;
+        key.transpose=m_transpose;
+        break;
+  default:
+        break;
+  }
+  if (m_op==IDENTITY)
+  {
+        key.left=key.right=key.mask=0;
+  }
+  else
+  {
+        key.id=0;
+  }
+  return key;
+}
+
+DataLazy_ptr
+DataLazy::shareNode(const DataLazy_ptr& p, NodeTable& table)
+{
+  map<const DataLazy*, DataLazy_ptr>::const_iterator it=table.canonical.find(p.get());
+  if (it!=table.canonical.end())
+  {
+        return it->second;
+  }
+  p->shareSubExpressions(table);
+  DataLazy_ptr res=p;
+  map<NodeKey, DataLazy_ptr>::iterator found=table.nodes.find(p->getNodeKey());
+  if (found==table.nodes.end())
+  {
+        table.nodes[p->getNodeKey()]=p;
+  }
+  else if (found->second!=p)
+  {
+        res=found->second;
+        table.shared++;
+  }
+  table.canonical[p.get()]=res;
+  return res;
+}
+
+// The children are already DataLazy (identities wrap the values) so
+// identical subexpressions have identical keys once their children have
+// been replaced.
+void
+DataLazy::shareSubExpressions(NodeTable& table)
+{
+  if (m_op==IDENTITY)
+  {
+        return;
+  }
+  if (m_left.get()!=0)
+  {
+        m_left=shareNode(m_left, table);
+  }
+  if (m_right.get()!=0)
+  {
+        m_right=shareNode(m_right, table);
+  }
+  if (m_mask.get()!=0)
+  {
+        m_mask=shareNode(m_mask, table);
+  }
+}
+
+void
+DataLazy::reportShared(const NodeTable& table)
+{
+  if (escriptParams.getLazyVerbose())
+  {
+        cerr << "Lazy common subexpressions: " << table.canonical.size()
+             << " nodes, " << table.shared << " shared" << endl;
+  }
+}
+
+void
+DataLazy::beginSampleStream()
+{
+  endSampleStream();
+  if (m_readytype!='E' || m_op==IDENTITY)
+  {
+        return;         // samples are read directly
+  }
+  NodeTable table;
+  shareSubExpressions(table);
+  reportShared(table);
+  if (escriptParams.getLazyKernels() && LazyKernel::canCompile(this))
+  {
+        m_sampleblocks=new LazySampleBlocks(this);
+        if (escriptParams.getLazyVerbose())
+        {
+                cerr << m_sampleblocks->toString() << endl;
+        }
+  }
+}
+
+void
+DataLazy::endSampleStream()
+{
+  delete m_sampleblocks;
+  m_sampleblocks=0;
+}
+
 /* This is really a static method but I think that caused problems in windows */
 void
 DataLazy::resolveGroupWorker(std::vector<DataLazy*>& dats)
@@ -2491,6 +2663,15 @@ DataLazy::resolveGroupWorker(std::vector<DataLazy*>& dats)
   if (match)    // all functionspaces match.  Yes I realise this is overly strict
   {             // it is possible that dats[0] is one of the objects which we discarded and
                 // all the other functionspaces match.
+        // subexpressions common to several of the objects are shared too
+        NodeTable table;
+        for (int i=0;i<work.size();++i)
+        {
+                work[i]->shareSubExpressions(table);
+                table.nodes.insert(make_pair(work[i]->getNodeKey(),
+                        REFCOUNTNS::dynamic_pointer_cast<DataLazy>(work[i]->getPtr())));
+        }
+        reportShared(table);
         vector<DataExpanded*> dep;
         vector<RealVectorType*> vecs;
         for (int i=0;i<work.size();++i)
@@ -2551,10 +2732,18 @@ DataLazy::resolveNodeWorker()
     return m_id;
   }
         // from this point on we must have m_op!=IDENTITY and m_readytype=='E'
+  NodeTable table;
+  shareSubExpressions(table);
+  reportShared(table);
   DataExpanded* result=new DataExpanded(getFunctionSpace(),getShape(),  RealVectorType(getNoValues()));
   RealVectorType& resvec=result->getVectorRW();
   DataReady_ptr resptr=DataReady_ptr(result);
 
+  if (escriptParams.getLazyKernels() && LazyKernel::canCompile(this))
+  {
+        resolveKernel(*result);
+        return resptr;
+  }
   int sample;
   int totalsamples=getNumSamples();
   const RealVectorType* res=0;       // Storage for answer
@@ -2596,6 +2785,38 @@ LAZYDEBUG(cout << "Final res[" << roffset<< "]=" << (*res)[roffset] << (*res)[ro
   return resptr;
 }
 
+// Evaluates the expression with a compiled kernel, blocks of samples are
+// distributed over the threads
+void
+DataLazy::resolveKernel(DataExpanded& result) const
+{
+  LazyKernel kernel(this);
+  if (escriptParams.getLazyVerbose())
+  {
+        cerr << kernel.toString() << endl;
+  }
+  RealVectorType& resvec=result.getVectorRW();
+  const int totalsamples=getNumSamples();
+  const int blocksize=kernel.getBlockSize();
+  const int numblocks=(totalsamples+blocksize-1)/blocksize;
+  #pragma omp parallel
+  {
+        RealVectorType work(kernel.getWorkSize());
+#ifdef _OPENMP
+        const int tid=omp_get_thread_num();
+#else
+        const int tid=0;
+#endif
+        #pragma omp for schedule(static)
+        for (int block=0;block<numblocks;++block)
+        {
+                const int first=block*blocksize;
+                const int num=min(blocksize, totalsamples-first);
+                kernel.run(tid, first, num, resvec, result.getPointOffset(first,0), work);
+        }
+  }
+}
+
 // This version should only be called on complex lazy nodes
 DataReady_ptr
 DataLazy::resolveNodeWorkerCplx()
@@ -2609,6 +2830,9 @@ DataLazy::resolveNodeWorkerCplx()
     return m_id;
   }
         // from this point on we must have m_op!=IDENTITY and m_readytype=='E'
+  NodeTable table;
+  shareSubExpressions(table);
+  reportShared(table);
   DataExpanded* result=new DataExpanded(getFunctionSpace(),getShape(),  CplxVectorType(getNoValues()));
   CplxVectorType& resvec=result->getVectorRWC();
   DataReady_ptr resptr=DataReady_ptr(result);
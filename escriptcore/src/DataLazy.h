@@ -23,6 +23,7 @@
 #include "DataVector.h"		// for ElementType
 #include "ES_optype.h"
 
+#include <map>
 #include <string>
 
 //#define LAZY_NODE_STORAGE
@@ -39,7 +40,9 @@ The data will be evaluated when required.
 NOTE: This class assumes that the Data being pointed at are immutable.
 */
 
+class DataExpanded;
 class DataLazy;
+class LazySampleBlocks;
 
 typedef POINTER_WRAPPER_CLASS(DataLazy) DataLazy_ptr;
 typedef POINTER_WRAPPER_CLASS(const DataLazy) const_DataLazy_ptr;
@@ -50,6 +53,9 @@ class DataLazy : public DataAbstract
 typedef DataAbstract parent;
 typedef DataTypes::ShapeType ShapeType;
 
+friend class LazyKernel;
+friend class LazySampleBlocks;
+
 public:
   /**
   \brief Create an IDENTITY DataLazy for the given DataAbstract.
@@ -229,6 +235,77 @@ public:
   void
   resolveGroupWorker(std::vector<DataLazy*>& dats);
 
+  /**
+  \brief Starts streaming the samples of an expanded expression. Until
+  endSampleStream is called, resolveSample evaluates blocks of consecutive
+  samples with a compiled kernel (if the expression can be compiled) and
+  returns them one at a time.
+  This is intended for callers which visit all samples in order without
+  storing them, e.g. reductions. Other access patterns still work but fall
+  back to evaluating single samples.
+  */
+  ESCRIPT_DLL_API
+  void
+  beginSampleStream();
+
+  /**
+  \brief Ends streaming started by beginSampleStream.
+  */
+  ESCRIPT_DLL_API
+  void
+  endSampleStream();
+
+  /**
+  Identifies the operation of a node, nodes with equal keys compute the same
+  values.
+  */
+  struct NodeKey
+  {
+    ES_optype op;
+    const DataAbstract* id;
+    const DataLazy* left;
+    const DataLazy* right;
+    const DataLazy* mask;
+    int axis_offset;
+    int transpose;
+    double tol;
+
+    bool operator<(const NodeKey& other) const;
+  };
+
+  /**
+  Nodes seen while looking for common subexpressions.
+  */
+  struct NodeTable
+  {
+    std::map<NodeKey, DataLazy_ptr> nodes;              // first node with each key
+    std::map<const DataLazy*, DataLazy_ptr> canonical;  // node -> node replacing it
+    size_t shared;
+    NodeTable() : shared(0) {}
+  };
+
+  ESCRIPT_DLL_API
+  NodeKey getNodeKey() const;
+
+  /**
+  Returns the first node in the table computing the same values as p.
+  The children of p are replaced in the same way.
+  */
+  ESCRIPT_DLL_API
+  static DataLazy_ptr shareNode(const DataLazy_ptr& p, NodeTable& table);
+
+  /**
+  Replaces identical subexpressions below this node by a single node so they
+  are only evaluated once per sample.
+  */
+  ESCRIPT_DLL_API
+  void shareSubExpressions(NodeTable& table);
+
+  /**
+  Prints the statistics of shareSubExpressions if lazy verbose is enabled.
+  */
+  ESCRIPT_DLL_API
+  static void reportShared(const NodeTable& table);
 
 private:
   int* m_sampleids;		// may be NULL
@@ -239,6 +316,7 @@ private:
   mutable DataLazy_ptr m_left, m_right, m_mask;	// operands for operation.
   mutable ES_optype m_op;	// operation to perform.
   mutable ES_opgroup m_opgroup; // type of operation to perform
+  LazySampleBlocks* m_sampleblocks;	// set while streaming samples
 
   size_t m_samplesize;	// number of values required to store a sample
 
@@ -261,6 +339,11 @@ private:
   */
   void LazyNodeSetup();
 
+  /**
+  Evaluates this expression with a compiled LazyKernel into result.
+  */
+  void resolveKernel(DataExpanded& result) const;
+
 
   const DataTypes::RealVectorType*
   resolveNodeUnary(int tid, int sampleNo, size_t& roffset) const;
@@ -31,6 +31,14 @@ DataReady_ptr DataReady::resolve()
     return REFCOUNTNS::dynamic_pointer_cast<DataReady>(this->getPtr());
 }
 
+void DataReady::checkDoublePrecision() const
+{
+    if (isSinglePrecision())
+    {
+        throw DataException("Error - values are stored in single precision. Use toDoublePrecision() first.");
+    }
+}
+
 
 
 }
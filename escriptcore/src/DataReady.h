@@ -102,6 +102,14 @@ public:
   ESCRIPT_DLL_API
   virtual const DataTypes::CplxVectorType&
   getTypedVectorRO(DataTypes::cplx_t dummy) const=0;  
+
+  ESCRIPT_DLL_API
+  virtual DataTypes::Real32VectorType&
+  getTypedVectorRW(DataTypes::real32_t dummy)=0;
+
+  ESCRIPT_DLL_API
+  virtual const DataTypes::Real32VectorType&
+  getTypedVectorRO(DataTypes::real32_t dummy) const=0;
   
 
   
@@ -195,6 +203,16 @@ public:
   DataReady_ptr 
   resolve();
 
+protected:
+  /**
+     \brief
+     Throws if the values are stored in single precision.
+     Used by the accessors which return double precision values.
+  */
+  ESCRIPT_DLL_API
+  void
+  checkDoublePrecision() const;
+
 };
 
 
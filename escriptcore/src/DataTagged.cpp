@@ -185,10 +185,11 @@ DataTagged::DataTagged(const FunctionSpace& what,
 DataTagged::DataTagged(const DataTagged& other)
   : parent(other.getFunctionSpace(),other.getShape()),
   m_offsetLookup(other.m_offsetLookup),
-  m_data_r(other.m_data_r), m_data_c(other.m_data_c)
+  m_data_r(other.m_data_r), m_data_c(other.m_data_c), m_data_f(other.m_data_f)
 {
   // copy constructor
     m_iscompl=other.m_iscompl;
+    m_issingle=other.m_issingle;
 }
 
 DataTagged::DataTagged(const DataConstant& other)
@@ -203,7 +204,16 @@ DataTagged::DataTagged(const DataConstant& other)
 
   // fill the default value with the constant value item from "other"
   int len = other.getNoValues();
-  if (m_iscompl)
+  if (other.isSinglePrecision())
+  {
+      DataTypes::real32_t dummy=0;
+      m_issingle=true;
+      m_data_f.resize(len,0.,len);
+      for (int i=0; i<len; i++) {
+        m_data_f[i]=other.getTypedVectorRO(dummy)[i];
+      }
+  }
+  else if (m_iscompl)
   {
       DataTypes::cplx_t dummy=0;
       m_data_c.resize(len,0.,len);
@@ -704,6 +714,21 @@ DataTagged::addTag(int tagKey)
 	  m_data_c[oldSize+i]=m_data_c[m_defaultValueOffset+i];
 	}
     }
+    else if (isSinglePrecision())
+    {
+	// as above but for the single precision values in m_data_f
+	m_offsetLookup.insert(DataMapType::value_type(tagKey,m_data_f.size()));
+	DataTypes::Real32VectorType m_data_f_temp(m_data_f);
+	int oldSize=m_data_f.size();
+	int newSize=m_data_f.size()+getNoValues();
+	m_data_f.resize(newSize,0.,newSize);
+	for (int i=0;i<oldSize;i++) {
+	  m_data_f[i]=m_data_f_temp[i];
+	}
+	for (unsigned int i=0;i<getNoValues();i++) {
+	  m_data_f[oldSize+i]=m_data_f[m_defaultValueOffset+i];
+	}
+    }
     else
     {
 	// save the key and the location of its data in the lookup tab
@@ -1642,12 +1667,14 @@ DataTypes::RealVectorType&
 DataTagged::getVectorRW()
 {
     CHECK_FOR_EX_WRITE
+    checkDoublePrecision();
     return m_data_r;
 }
 
 const DataTypes::RealVectorType&
 DataTagged::getVectorRO() const
 {
+        checkDoublePrecision();
         return m_data_r;
 }
 
@@ -1668,12 +1695,14 @@ DataTypes::RealVectorType&
 DataTagged::getTypedVectorRW(DataTypes::real_t dummy)
 {
   CHECK_FOR_EX_WRITE
+  checkDoublePrecision();
   return m_data_r;
 }
 
 const DataTypes::RealVectorType&
 DataTagged::getTypedVectorRO(DataTypes::real_t dummy) const
 {
+  checkDoublePrecision();
   return m_data_r;
 }
 
@@ -1690,6 +1719,19 @@ DataTagged::getTypedVectorRO(DataTypes::cplx_t dummy) const
   return m_data_c;
 }
 
+DataTypes::Real32VectorType&
+DataTagged::getTypedVectorRW(DataTypes::real32_t dummy)
+{
+  CHECK_FOR_EX_WRITE
+  return m_data_f;
+}
+
+const DataTypes::Real32VectorType&
+DataTagged::getTypedVectorRO(DataTypes::real32_t dummy) const
+{
+  return m_data_f;
+}
+
 size_t
 DataTagged::getTagCount() const
 {
@@ -1699,6 +1741,10 @@ DataTagged::getTagCount() const
 
 void DataTagged::complicate()
 {
+    if (isSinglePrecision())
+    {
+        throw DataException("Error - single precision data can not be made complex. Use toDoublePrecision() first.");
+    }
     if (!isComplex())
     {
         fillComplexFromReal(m_data_r, m_data_c);
@@ -1707,5 +1753,29 @@ void DataTagged::complicate()
     }
 }
 
+void DataTagged::toSinglePrecision()
+{
+    if (isComplex())
+    {
+        throw DataException("Error - single precision storage is not supported for complex data.");
+    }
+    if (!isSinglePrecision())
+    {
+        fillReal32FromReal(m_data_r, m_data_f);
+        this->m_issingle=true;
+        m_data_r.resize(0,0,1);
+    }
+}
+
+void DataTagged::toDoublePrecision()
+{
+    if (isSinglePrecision())
+    {
+        fillRealFromReal32(m_data_f, m_data_r);
+        this->m_issingle=false;
+        m_data_f.resize(0,0,1);
+    }
+}
+
 }  // end of namespace
 
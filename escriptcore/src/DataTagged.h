@@ -471,6 +471,12 @@ TODO Make sure to document the relationship between tags and data, ie: data also
   virtual const DataTypes::CplxVectorType&
   getTypedVectorRO(DataTypes::cplx_t dummy) const;  
 
+  virtual DataTypes::Real32VectorType&
+  getTypedVectorRW(DataTypes::real32_t dummy);
+
+  virtual const DataTypes::Real32VectorType&
+  getTypedVectorRO(DataTypes::real32_t dummy) const;
+
   
   
 
@@ -690,6 +696,18 @@ TODO Make sure to document the relationship between tags and data, ie: data also
   
   void
   complicate();
+
+  /**
+   \brief Store the (real) values in single precision.
+  */
+  void
+  toSinglePrecision();
+
+  /**
+   \brief Store the values in double precision.
+  */
+  void
+  toDoublePrecision();
   
  protected:
 
@@ -705,7 +723,8 @@ TODO Make sure to document the relationship between tags and data, ie: data also
   
   // the actual data
   DataTypes::RealVectorType m_data_r;
-  DataTypes::CplxVectorType m_data_c;  
+  DataTypes::CplxVectorType m_data_c;
+  DataTypes::Real32VectorType m_data_f;  
   
 
 };
@@ -767,7 +786,7 @@ inline
 DataTypes::RealVectorType::size_type
 DataTagged::getLength() const
 {
-  return std::max(m_data_c.size(), m_data_r.size());
+  return std::max(std::max(m_data_c.size(), m_data_r.size()), m_data_f.size());
 }
 
 } // end of namespace
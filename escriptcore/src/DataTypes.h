@@ -52,6 +52,9 @@ namespace DataTypes {
   /// complex data type
   typedef std::complex<real_t> cplx_t;
 
+  /// type of the values of real Data stored in single precision
+  typedef float real32_t;
+
   /// type for array/matrix indices used both globally and on each rank
 #ifdef ESYS_INDEXTYPE_LONG
   typedef long index_t;
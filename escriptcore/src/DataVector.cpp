@@ -576,6 +576,17 @@ namespace escript {
       }
    }
 
+   void DataTypes::copyPoint(Real32VectorType& dest, Real32VectorType::size_type doffset, Real32VectorType::size_type nvals, const Real32VectorType& src, Real32VectorType::size_type soffset)
+   {
+      ESYS_ASSERT((dest.size()>0&&src.size()>0&&checkOffset(doffset,dest.size(),nvals)),
+                 "Error - Couldn't copy due to insufficient storage.");
+      if (checkOffset(doffset,dest.size(),nvals) && checkOffset(soffset,src.size(),nvals)) {
+         memcpy(&dest[doffset],&src[soffset],sizeof(real32_t)*nvals);
+      } else {
+         throw DataException("Error - invalid offset specified.");
+      }
+   }
+
    /**
     * \brief copy data from a real vector to a complex vector
     * The complex vector will be resized as needed and any previous
@@ -595,5 +606,33 @@ namespace escript {
        }
    }
 
+   void DataTypes::fillReal32FromReal(const RealVectorType& r, Real32VectorType& f)
+   {
+       if (f.size()!=r.size())
+       {
+	   f.resize(r.size(), 0, 1);
+       }
+       size_t limit=r.size();
+       #pragma omp parallel for schedule(static)
+       for (size_t i=0;i<limit;++i)
+       {
+	   f[i]=static_cast<real32_t>(r[i]);
+       }
+   }
+
+   void DataTypes::fillRealFromReal32(const Real32VectorType& f, RealVectorType& r)
+   {
+       if (r.size()!=f.size())
+       {
+	   r.resize(f.size(), 0, 1);
+       }
+       size_t limit=f.size();
+       #pragma omp parallel for schedule(static)
+       for (size_t i=0;i<limit;++i)
+       {
+	   r[i]=f[i];
+       }
+   }
+
 } // end of namespace
 
@@ -30,6 +30,7 @@
 
 // ensure that nobody else tries to instantiate the complex version
 extern template class escript::DataTypes::DataVectorAlt<escript::DataTypes::cplx_t>;
+extern template class escript::DataTypes::DataVectorAlt<escript::DataTypes::real32_t>;
 
 
 namespace escript {
@@ -42,6 +43,7 @@ namespace DataTypes
   //typedef DataVectorTaipan DataVector;
   typedef escript::DataTypes::DataVectorAlt<real_t> RealVectorType;//!< Vector to store underlying data.
   typedef escript::DataTypes::DataVectorAlt<cplx_t> CplxVectorType;
+  typedef escript::DataTypes::DataVectorAlt<real32_t> Real32VectorType;//!< Vector to store single precision data.
 
    /**
       \brief Display a single value (with the specified shape) from the data.
@@ -146,6 +148,17 @@ namespace DataTypes
    */
    void copyPoint(CplxVectorType& dest, vec_size_type doffset, vec_size_type nvals, const CplxVectorType& src, vec_size_type soffset);
 
+   /**
+      \brief  Copy a point from one vector to another. Note: This version does not check to see if shapes are the same.
+
+   \param dest - vector to copy to
+   \param doffset - beginning of the target datapoint in dest
+   \param nvals - the number of values comprising the datapoint
+   \param src - vector to copy from
+   \param soffset - beginning of the datapoint in src
+   */
+   void copyPoint(Real32VectorType& dest, vec_size_type doffset, vec_size_type nvals, const Real32VectorType& src, vec_size_type soffset);
+
    /**
     * \brief copy data from a real vector to a complex vector
     * The complex vector will be resized as needed and any previous
@@ -153,6 +166,22 @@ namespace DataTypes
    */
    void fillComplexFromReal(const RealVectorType& r, CplxVectorType& c);
 
+   /**
+    * \brief copy data from a double precision vector to a single precision
+    * vector. Values are rounded to the nearest float.
+    * The single precision vector will be resized as needed and any previous
+    * values will be replaced.
+   */
+   void fillReal32FromReal(const RealVectorType& r, Real32VectorType& f);
+
+   /**
+    * \brief copy data from a single precision vector to a double precision
+    * vector.
+    * The double precision vector will be resized as needed and any previous
+    * values will be replaced.
+   */
+   void fillRealFromReal32(const Real32VectorType& f, RealVectorType& r);
+
   /**
      \brief
      Copy a data slice specified by the given region and offset from the
@@ -108,6 +108,7 @@ DataVectorAlt<DataTypes::cplx_t>::copyFromArrayToOffset(const WrappedArray& valu
 }
 
 template class DataVectorAlt<DataTypes::cplx_t>;
+template class DataVectorAlt<DataTypes::real32_t>;
 
 }	// end namespace
 }	// end namespace
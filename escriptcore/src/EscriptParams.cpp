@@ -39,6 +39,7 @@ EscriptParams::EscriptParams()
 #else
     autoLazy = 0;
 #endif
+    lazyKernels = 1;
     lazyStrFmt = 0;
     lazyVerbose = 0;
 #ifdef FRESCOLLECTON
@@ -118,6 +119,8 @@ int EscriptParams::getInt(const std::string& name, int sentinel) const
 {
     if (name == "AUTOLAZY")
         return autoLazy;
+    else if (name == "LAZY_KERNELS")
+        return lazyKernels;
     else if (name == "LAZY_STR_FMT")
         return lazyStrFmt;
     else if (name == "LAZY_VERBOSE")
@@ -137,6 +140,8 @@ EscriptParams::setInt(const std::string& name, int value)
 {
     if (name == "AUTOLAZY")
         autoLazy = value;
+    else if (name == "LAZY_KERNELS")
+        lazyKernels = value;
     else if (name == "LAZY_STR_FMT")
         lazyStrFmt = value;
     else if (name == "LAZY_VERBOSE")
@@ -155,8 +160,9 @@ bp::list EscriptParams::listEscriptParams() const
 {
    bp::list l;
    l.append(bp::make_tuple("AUTOLAZY", autoLazy, "{0,1} Operations involving Expanded Data will create lazy results."));
+   l.append(bp::make_tuple("LAZY_KERNELS", lazyKernels, "{0,1} Compile lazy expressions into flat kernels when resolving them."));
    l.append(bp::make_tuple("LAZY_STR_FMT", lazyStrFmt, "{0,1,2}(TESTING ONLY) change output format for lazy expressions."));
-   l.append(bp::make_tuple("LAZY_VERBOSE", lazyVerbose, "{0,1} Print a warning when expressions are resolved because they are too large."));
+   l.append(bp::make_tuple("LAZY_VERBOSE", lazyVerbose, "{0,1} Print a warning when expressions are resolved because they are too large, and statistics (shared subexpressions, compiled kernels, sample blocks) when lazy expressions are resolved."));
    l.append(bp::make_tuple("RESOLVE_COLLECTIVE", resolveCollective, "(TESTING ONLY) {0.1} Collective operations will resolve their data."));
    l.append(bp::make_tuple("TOO_MANY_LEVELS", tooManyLevels, "(TESTING ONLY) maximum levels allowed in an expression."));
    l.append(bp::make_tuple("TOO_MANY_LINES", tooManyLines, "Maximum number of lines to output when printing data before printing a summary instead."));
@@ -173,7 +179,8 @@ bool EscriptParams::hasFeature(const std::string& name) const
         if (MPI_Comm_size(MPI_COMM_WORLD, &size) != MPI_SUCCESS || size > 1)
             return false;
 #endif
-        return hasFeature("paso") && (hasFeature("umfpack") || hasFeature("mkl"));
+        // paso has its own direct solver
+        return hasFeature("paso");
     }
 
     return features.count(name) > 0;
@@ -37,6 +37,7 @@ public:
     boost::python::list listEscriptParams() const;
 
     inline int getAutoLazy() const { return autoLazy; }
+    inline int getLazyKernels() const { return lazyKernels; }
     inline int getLazyStrFmt() const { return lazyStrFmt; }
     inline int getLazyVerbose() const { return lazyVerbose; }
     inline int getResolveCollective() const { return resolveCollective; }
@@ -51,6 +52,7 @@ private:
     // the number of parameters is small enough to avoid a map for performance
     // reasons
     int autoLazy;
+    int lazyKernels;
     int lazyStrFmt;
     int lazyVerbose;
     int resolveCollective;
@@ -0,0 +1,410 @@
+
+/*****************************************************************************
+*
+* Copyright (c) 2003-2018 by The University of Queensland
+* http://www.uq.edu.au
+*
+* Primary Business: Queensland, Australia
+* Licensed under the Apache License, version 2.0
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Development until 2012 by Earth Systems Science Computational Center (ESSCC)
+* Development 2012-2013 by School of Earth Sciences
+* Development from 2014 by Centre for Geoscience Computing (GeoComp)
+*
+*****************************************************************************/
+
+#include "LazyKernel.h"
+#include "ArrayOps.h"
+#include "DataLazy.h"
+#include "DataVectorOps.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <sstream>
+
+// number of values held by all registers of a thread together. The block
+// size is chosen so that the working set of a program stays in L2 cache.
+#define LAZY_BLOCK_VALUES 16384
+
+// operands of instructions are registers (>=0), inputs which are read
+// directly from their DataExpanded (<=-2) or not used (-1)
+#define NO_OPERAND -1
+#define DIRECT_VALUE(I) (-2-(I))
+#define DIRECT_INPUT(V) (-2-(V))
+
+using namespace std;
+
+namespace escript {
+
+using DataTypes::real_t;
+using DataTypes::RealVectorType;
+
+LazyKernel::LazyKernel(const DataLazy* root) :
+    m_numregisters(0),
+    m_blocksize(1),
+    m_regsize(0),
+    m_maxsamplesize(1),
+    m_dpps(root->getNumDPPSample())
+{
+    map<const DataLazy*, int> values;
+    compileNode(root, values);
+    for (size_t i=0; i<m_code.size(); ++i)
+        m_maxsamplesize=max(m_maxsamplesize, m_code[i].node->m_samplesize);
+    allocateRegisters();
+
+    const size_t perSample=(m_numregisters+1)*m_maxsamplesize;
+    m_blocksize=max<int>(1, LAZY_BLOCK_VALUES/perSample);
+    m_regsize=m_blocksize*m_maxsamplesize;
+}
+
+bool LazyKernel::canCompile(const DataLazy* node)
+{
+    if (node->m_readytype!='E' || node->isComplex()
+            || node->m_op==IDENTITY)
+        return false;
+    switch (node->m_opgroup) {
+        case G_UNARY:
+        case G_UNARY_R:
+        case G_UNARY_P:
+        case G_UNARY_PR:
+            return (node->m_op!=POS && !node->m_left->isComplex());
+        case G_BINARY:
+        case G_TENSORPROD:
+            return (!node->m_left->isComplex() && !node->m_right->isComplex());
+        case G_NP1OUT:
+            return ((node->m_op==SYM || node->m_op==NSYM)
+                    && !node->m_left->isComplex());
+        case G_NP1OUT_P:
+        case G_NP1OUT_2P:
+        case G_REDUCTION:
+            return !node->m_left->isComplex();
+        default:
+            return false;
+    }
+}
+
+int LazyKernel::compileNode(const DataLazy* node,
+                            map<const DataLazy*, int>& values)
+{
+    // nodes used several times in the expression are only evaluated once
+    map<const DataLazy*, int>::const_iterator it=values.find(node);
+    if (it!=values.end())
+        return it->second;
+
+    Instruction ins;
+    ins.node=node;
+    ins.input=-1;
+    ins.res=-1;
+    ins.left=NO_OPERAND;
+    ins.right=NO_OPERAND;
+    if (canCompile(node) && node->getNumDPPSample()==m_dpps) {
+        ins.left=compileNode(node->m_left.get(), values);
+        if (node->m_opgroup==G_BINARY || node->m_opgroup==G_TENSORPROD)
+            ins.right=compileNode(node->m_right.get(), values);
+    } else {
+        ins.input=addInput(node);
+        if (m_inputs[ins.input].direct) {
+            // no instruction required, the operands read the values of
+            // the DataExpanded directly
+            values[node]=DIRECT_VALUE(ins.input);
+            return DIRECT_VALUE(ins.input);
+        }
+    }
+    m_code.push_back(ins);
+    values[node]=m_code.size()-1;
+    return m_code.size()-1;
+}
+
+int LazyKernel::addInput(const DataLazy* node)
+{
+    Input in;
+    in.node=node;
+    in.expanded=(node->m_readytype=='E');
+    // the samples of a block are stored contiguously in a DataExpanded
+    in.direct=(in.expanded && node->m_op==IDENTITY);
+    m_inputs.push_back(in);
+    return m_inputs.size()-1;
+}
+
+bool LazyKernel::isElementWise(const Instruction& ins) const
+{
+    if (ins.input >= 0)
+        return false;
+    switch (ins.node->m_opgroup) {
+        case G_UNARY:
+        case G_UNARY_R:
+        case G_UNARY_P:
+        case G_UNARY_PR:
+            return true;
+        case G_BINARY:
+            return (ins.node->m_left->getNoValues()
+                    == ins.node->m_right->getNoValues());
+        default:
+            return false;
+    }
+}
+
+void LazyKernel::allocateRegisters()
+{
+    // the instructions refer to the values of other instructions so far,
+    // replace them by registers. Element-wise operations may store their
+    // result in the register of an argument which is not used afterwards,
+    // all others need a register of their own. The last instruction writes
+    // to the output.
+    vector<int> lastUse(m_code.size(), -1);
+    for (int i=0; i<m_code.size(); ++i) {
+        if (m_code[i].left >= 0)
+            lastUse[m_code[i].left]=i;
+        if (m_code[i].right >= 0)
+            lastUse[m_code[i].right]=i;
+    }
+    vector<int> regOf(m_code.size(), -1);
+    vector<int> freeRegs;
+    for (int i=0; i<m_code.size(); ++i) {
+        Instruction& ins=m_code[i];
+        const int l=ins.left;
+        const int r=ins.right;
+        vector<int> released;
+        // direct inputs keep their (negative) value
+        if (l >= 0) {
+            ins.left=regOf[l];
+            if (lastUse[l]==i)
+                released.push_back(regOf[l]);
+        }
+        if (r >= 0) {
+            ins.right=regOf[r];
+            if (lastUse[r]==i && r!=l)
+                released.push_back(regOf[r]);
+        }
+        const bool inPlace=isElementWise(ins);
+        if (inPlace)
+            freeRegs.insert(freeRegs.end(), released.begin(), released.end());
+        if (i==m_code.size()-1) {
+            ins.res=-1;
+        } else if (!freeRegs.empty()) {
+            ins.res=freeRegs.back();
+            freeRegs.pop_back();
+        } else {
+            ins.res=m_numregisters++;
+        }
+        if (!inPlace)
+            freeRegs.insert(freeRegs.end(), released.begin(), released.end());
+        regOf[i]=ins.res;
+    }
+}
+
+size_t LazyKernel::getWorkSize() const
+{
+    return max<size_t>(1, m_numregisters*m_regsize);
+}
+
+const RealVectorType& LazyKernel::getOperand(int op, int firstSample,
+                                             const RealVectorType& work,
+                                             size_t& offset) const
+{
+    if (op >= 0) {
+        offset=op*m_regsize;
+        return work;
+    }
+    const DataLazy* node=m_inputs[DIRECT_INPUT(op)].node;
+    offset=node->m_id->getPointOffset(firstSample, 0);
+    return node->m_id->getVectorRO();
+}
+
+void LazyKernel::load(const Input& in, int tid, int firstSample,
+                      int numSamples, RealVectorType& res,
+                      size_t offset) const
+{
+    // non-expanded inputs are repeated for each data point so all
+    // registers have the same layout
+    const size_t samplesize=in.node->m_samplesize;
+    const size_t novalues=in.node->getNoValues();
+    for (int s=0; s<numSamples; ++s) {
+        size_t roffset=0;
+        const RealVectorType* v=in.node->resolveNodeSample(tid,
+                                                 firstSample+s, roffset);
+        const real_t* src=&(*v)[roffset];
+        real_t* dest=&res[offset+s*samplesize];
+        if (in.expanded) {
+            memcpy(dest, src, samplesize*sizeof(real_t));
+        } else {
+            for (int d=0; d<m_dpps; ++d)
+                memcpy(dest+d*novalues, src, novalues*sizeof(real_t));
+        }
+    }
+}
+
+void LazyKernel::run(int tid, int firstSample, int numSamples,
+                     RealVectorType& out, size_t outOffset,
+                     RealVectorType& work) const
+{
+    const size_t points=numSamples*m_dpps;
+    for (size_t i=0; i<m_code.size(); ++i) {
+        const Instruction& ins=m_code[i];
+        RealVectorType& res=(ins.res < 0 ? out : work);
+        const size_t roffset=(ins.res < 0 ? outOffset : ins.res*m_regsize);
+        if (ins.input >= 0) {
+            load(m_inputs[ins.input], tid, firstSample, numSamples, res,
+                 roffset);
+            continue;
+        }
+        const DataLazy* node=ins.node;
+        const DataTypes::ShapeType& shape=node->getShape();
+        const size_t nv=node->getNoValues();
+        size_t loffset=0;
+        const RealVectorType& left=getOperand(ins.left, firstSample, work,
+                                              loffset);
+        const DataTypes::ShapeType& lshape=node->m_left->getShape();
+        const size_t lnv=node->m_left->getNoValues();
+        switch (node->m_opgroup) {
+            case G_UNARY:
+            case G_UNARY_R:
+            case G_UNARY_P:
+            case G_UNARY_PR:
+                tensor_unary_array_operation(points*nv, &left[loffset],
+                        &res[roffset], node->m_op, node->m_tol);
+                break;
+            case G_BINARY: {
+                size_t rroffset=0;
+                const RealVectorType& right=getOperand(ins.right,
+                                            firstSample, work, rroffset);
+                const size_t rnv=node->m_right->getNoValues();
+                if (lnv==rnv) {
+                    binaryOpVectorLazyArithmeticHelper<real_t, real_t, real_t>(
+                            &res[roffset], &left[0], &right[0],
+                            points*nv, 1, 1, 0, 0, 0, 0, 0,
+                            loffset, rroffset, node->m_op);
+                } else if (lnv==1) {
+                    // one scalar per data point on the left
+                    binaryOpVectorLazyArithmeticHelper<real_t, real_t, real_t>(
+                            &res[roffset], &left[0], &right[0],
+                            1, points, rnv, 1, 0, 1, 1, 0,
+                            loffset, rroffset, node->m_op);
+                } else {
+                    binaryOpVectorLazyArithmeticHelper<real_t, real_t, real_t>(
+                            &res[roffset], &left[0], &right[0],
+                            1, points, lnv, 1, 1, 0, 0, 1,
+                            loffset, rroffset, node->m_op);
+                }
+                break;
+            }
+            case G_TENSORPROD: {
+                size_t rroffset=0;
+                const RealVectorType& right=getOperand(ins.right,
+                                            firstSample, work, rroffset);
+                const size_t rnv=node->m_right->getNoValues();
+                for (size_t p=0; p<points; ++p) {
+                    matrix_matrix_product(node->m_SL, node->m_SM, node->m_SR,
+                            &left[loffset+p*lnv], &right[rroffset+p*rnv],
+                            &res[roffset+p*nv], node->m_transpose);
+                }
+                break;
+            }
+            case G_NP1OUT:
+                for (size_t p=0; p<points; ++p) {
+                    if (node->m_op==SYM)
+                        symmetric(left, lshape, loffset+p*lnv, res, shape,
+                                  roffset+p*nv);
+                    else
+                        antisymmetric(left, lshape, loffset+p*lnv, res,
+                                      shape, roffset+p*nv);
+                }
+                break;
+            case G_NP1OUT_P:
+                for (size_t p=0; p<points; ++p) {
+                    if (node->m_op==TRACE)
+                        trace(left, lshape, loffset+p*lnv, res, shape,
+                              roffset+p*nv, node->m_axis_offset);
+                    else
+                        transpose(left, lshape, loffset+p*lnv, res, shape,
+                                  roffset+p*nv, node->m_axis_offset);
+                }
+                break;
+            case G_NP1OUT_2P:
+                for (size_t p=0; p<points; ++p) {
+                    swapaxes(left, lshape, loffset+p*lnv, res, shape,
+                             roffset+p*nv, node->m_axis_offset,
+                             node->m_transpose);
+                }
+                break;
+            case G_REDUCTION:
+                for (size_t p=0; p<points; ++p) {
+                    if (node->m_op==MINVAL) {
+                        FMin op;
+                        res[roffset+p]=reductionOpVector(left, lshape,
+                                loffset+p*lnv, op,
+                                numeric_limits<real_t>::max());
+                    } else {
+                        FMax op;
+                        res[roffset+p]=reductionOpVector(left, lshape,
+                                loffset+p*lnv, op,
+                                numeric_limits<real_t>::max()*-1);
+                    }
+                }
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+string LazyKernel::toString() const
+{
+    size_t loads=0;
+    for (size_t i=0; i<m_code.size(); ++i) {
+        if (m_code[i].input >= 0)
+            loads++;
+    }
+    ostringstream oss;
+    oss << "Lazy kernel: " << m_code.size()-loads
+        << " operations, " << m_inputs.size() << " inputs ("
+        << m_inputs.size()-loads << " read in place), "
+        << m_numregisters << " registers, blocks of " << m_blocksize
+        << " samples";
+    return oss.str();
+}
+
+LazySampleBlocks::LazySampleBlocks(const DataLazy* root) :
+    m_root(root),
+    m_kernel(root),
+    m_numsamples(root->getNumSamples()),
+    m_samplesize(root->m_samplesize)
+{
+#ifdef _OPENMP
+    const int numthreads=omp_get_max_threads();
+#else
+    const int numthreads=1;
+#endif
+    m_blockvalues=m_kernel.getBlockSize()*m_samplesize;
+    m_values.resize(numthreads*m_blockvalues, 0., 1);
+    m_work.resize(numthreads, RealVectorType(m_kernel.getWorkSize()));
+    m_first.resize(numthreads, 0);
+    m_count.resize(numthreads, 0);
+    m_last.resize(numthreads, -1);
+}
+
+const RealVectorType* LazySampleBlocks::getSample(int tid, int sampleNo,
+                                                  size_t& roffset)
+{
+    const int first=m_first[tid];
+    if (sampleNo < first || sampleNo >= first+m_count[tid]) {
+        if (m_last[tid] >= 0 && sampleNo != m_last[tid]+1) {
+            // no sequential access, a block would mostly be wasted
+            m_last[tid]=sampleNo;
+            return m_root->resolveNodeSample(tid, sampleNo, roffset);
+        }
+        m_first[tid]=sampleNo;
+        m_count[tid]=min(m_kernel.getBlockSize(), m_numsamples-sampleNo);
+        m_kernel.run(tid, sampleNo, m_count[tid], m_values,
+                     tid*m_blockvalues, m_work[tid]);
+    }
+    m_last[tid]=sampleNo;
+    roffset=tid*m_blockvalues+(sampleNo-m_first[tid])*m_samplesize;
+    return &m_values;
+}
+
+} // end of namespace
+
@@ -0,0 +1,179 @@
+
+/*****************************************************************************
+*
+* Copyright (c) 2003-2018 by The University of Queensland
+* http://www.uq.edu.au
+*
+* Primary Business: Queensland, Australia
+* Licensed under the Apache License, version 2.0
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Development until 2012 by Earth Systems Science Computational Center (ESSCC)
+* Development 2012-2013 by School of Earth Sciences
+* Development from 2014 by Centre for Geoscience Computing (GeoComp)
+*
+*****************************************************************************/
+
+#ifndef __ESCRIPT_LAZYKERNEL_H__
+#define __ESCRIPT_LAZYKERNEL_H__
+
+#include "system_dep.h"
+#include "DataVector.h"
+#include "ES_optype.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace escript {
+
+class DataLazy;
+
+/**
+   \brief
+   A real valued DataLazy expression compiled into a flat program.
+
+   The expanded, real valued part of the expression is linearized into a
+   sequence of instructions working on registers. Each register holds the
+   values of a block of consecutive samples, so every instruction processes
+   all data points of the block in one long loop without any per node or per
+   sample dispatch. Identities, non-expanded and complex subexpressions and
+   conditional evaluations are inputs of the program. Expanded identities are
+   read in place, all other inputs are evaluated sample by sample by the
+   DataLazy resolver and loaded into registers.
+*/
+class LazyKernel
+{
+public:
+    /**
+       \brief
+       Compiles the expression with the given root. The root must satisfy
+       canCompile().
+    */
+    explicit LazyKernel(const DataLazy* root);
+
+    /**
+       \brief
+       Returns true if the node can be evaluated by an instruction, i.e. it
+       is a real valued, expanded operation on real values.
+    */
+    static bool canCompile(const DataLazy* node);
+
+    /**
+       \brief
+       Returns the number of samples evaluated by one call to run().
+    */
+    int getBlockSize() const { return m_blocksize; }
+
+    /**
+       \brief
+       Returns the number of values of work space required by run().
+    */
+    size_t getWorkSize() const;
+
+    /**
+       \brief
+       Evaluates the samples firstSample,...,firstSample+numSamples-1
+       (numSamples<=getBlockSize()) and stores them contiguously in out
+       starting at outOffset.
+       \param tid - thread number used for the buffers of the input nodes
+       \param work - work space of getWorkSize() values private to the thread
+    */
+    void run(int tid, int firstSample, int numSamples,
+             DataTypes::RealVectorType& out, size_t outOffset,
+             DataTypes::RealVectorType& work) const;
+
+    /**
+       \brief
+       Returns a description of the program.
+    */
+    std::string toString() const;
+
+private:
+    struct Input
+    {
+        const DataLazy* node;
+        bool expanded;          // otherwise one data point per sample
+        bool direct;            // read in place without loading
+    };
+
+    struct Instruction
+    {
+        const DataLazy* node;   // node evaluated by the instruction
+        int input;              // index of the input for loads, -1 otherwise
+        int res;                // result register, -1 is the output
+        int left;               // arguments
+        int right;
+    };
+
+    int compileNode(const DataLazy* node,
+                    std::map<const DataLazy*, int>& values);
+    int addInput(const DataLazy* node);
+    void allocateRegisters();
+    bool isElementWise(const Instruction& ins) const;
+    const DataTypes::RealVectorType& getOperand(int op, int firstSample,
+                                   const DataTypes::RealVectorType& work,
+                                   size_t& offset) const;
+    void load(const Input& in, int tid, int firstSample, int numSamples,
+              DataTypes::RealVectorType& res, size_t offset) const;
+
+    std::vector<Input> m_inputs;
+    std::vector<Instruction> m_code;
+    int m_numregisters;
+    int m_blocksize;
+    size_t m_regsize;           // values per register
+    size_t m_maxsamplesize;     // largest sample of all instructions
+    int m_dpps;                 // data points per sample
+};
+
+/**
+   \brief
+   Streams the samples of a compiled expression without storing the result.
+
+   Each thread evaluates a block of consecutive samples with the kernel when
+   it asks for a sample following the last one it asked for, and hands out
+   the samples of the block one at a time. Samples requested out of order are
+   evaluated individually by the DataLazy resolver.
+*/
+class LazySampleBlocks
+{
+public:
+    /**
+       \brief
+       Compiles the expression with the given root. The root must satisfy
+       LazyKernel::canCompile().
+    */
+    explicit LazySampleBlocks(const DataLazy* root);
+
+    /**
+       \brief
+       Returns the vector holding the values of the sample and sets roffset
+       to the start of the sample in it.
+       \param tid - number of the calling thread
+    */
+    const DataTypes::RealVectorType* getSample(int tid, int sampleNo,
+                                               size_t& roffset);
+
+    /**
+       \brief
+       Returns a description of the kernel.
+    */
+    std::string toString() const { return m_kernel.toString(); }
+
+private:
+    const DataLazy* m_root;
+    LazyKernel m_kernel;
+    int m_numsamples;
+    size_t m_samplesize;
+    size_t m_blockvalues;                           // values per block
+    DataTypes::RealVectorType m_values;             // one block per thread
+    std::vector<DataTypes::RealVectorType> m_work;  // work space per thread
+    std::vector<int> m_first;   // first sample of the block of each thread
+    std::vector<int> m_count;   // number of samples in the block
+    std::vector<int> m_last;    // last sample requested by each thread
+};
+
+} // end of namespace
+
+#endif // __ESCRIPT_LAZYKERNEL_H__
+
@@ -39,14 +39,17 @@ SolverBuddy::SolverBuddy() :
     preconditioner(SO_PRECONDITIONER_JACOBI),
     ode_solver(SO_ODESOLVER_LINEAR_CRANK_NICOLSON),
     smoother(SO_PRECONDITIONER_GAUSS_SEIDEL),
+    schwarz_local_solver(SO_PRECONDITIONER_ILU0),
     reordering(SO_REORDERING_DEFAULT),
     coarsening(SO_DEFAULT),
     amg_interpolation_method(SO_INTERPOLATION_DIRECT),
     level_max(100),
     coarsening_threshold(0.25),
     sweeps(1),
+    sweeps_set(false),
     pre_sweeps(1),
     post_sweeps(1),
+    schwarz_overlap(1),
     tolerance(1e-8),
     absolute_tolerance(0.),
     inner_tolerance(0.9),
@@ -55,6 +58,8 @@ SolverBuddy::SolverBuddy() :
     iter_max(100000),
     inner_iter_max(10),
     truncation(20),
+    ca_gmres_step_size(4),
+    num_recycled_vectors(0),
     restart(0),
     is_complex(false),
     symmetric(false),
@@ -64,6 +69,9 @@ SolverBuddy::SolverBuddy() :
     min_coarse_matrix_size(500),
     relaxation(0.3),
     use_local_preconditioner(false),
+    use_sliced_ellpack(false),
+    use_mixed_precision(false),
+    use_matrix_free(false),
     min_sparsity(0.05),
     refinements(2),
     coarse_refinements(2),
@@ -101,6 +109,10 @@ std::string SolverBuddy::getSummary() const
         if (getSolverMethod() == SO_METHOD_GMRES) {
             out << "Truncation  = " << getTruncation() << std::endl
                 << "Restart  = " << getRestart() << std::endl;
+        } else if (getSolverMethod() == SO_METHOD_CA_GMRES) {
+            out << "Truncation  = " << getTruncation() << std::endl
+                << "Restart  = " << getRestart() << std::endl
+                << "Step size = " << getCAGMRESStepSize() << std::endl;
         } else if (getSolverMethod() == SO_PRECONDITIONER_AMG) {
             out << "Number of pre / post sweeps = " << getNumPreSweeps()
                 << " / " << getNumPostSweeps() << ", " << getNumSweeps()
@@ -113,7 +125,11 @@ std::string SolverBuddy::getSummary() const
         }
         out << "Preconditioner = " << getName(getPreconditioner()) << std::endl
             << "Apply preconditioner locally = " << useLocalPreconditioner()
-            << std::endl;
+            << std::endl
+            << "Use sliced ELLPACK matrix-vector product = "
+            << useSlicedEllpack() << std::endl
+            << "Use mixed precision = " << useMixedPrecision() << std::endl
+            << "Use matrix-free operator = " << useMatrixFree() << std::endl;
         switch (getPreconditioner()) {
             case SO_PRECONDITIONER_AMG:
                 out << "Maximum number of levels = " << getLevelMax()
@@ -149,6 +165,13 @@ std::string SolverBuddy::getSummary() const
                     << " / " << getNumPostSweeps() << ", " << getNumSweeps()
                     << std::endl;
                 break;
+            case SO_PRECONDITIONER_CHEBYSHEV:
+                out << "Polynomial degree = ";
+                if (isNumSweepsSet())
+                    out << getNumSweeps() << std::endl;
+                else
+                    out << "default" << std::endl;
+                break;
             case SO_PRECONDITIONER_GAUSS_SEIDEL:
                 out << "Number of sweeps = " << getNumSweeps() << std::endl;
                 break;
@@ -160,6 +183,11 @@ std::string SolverBuddy::getSummary() const
                 out << "Relaxation factor = " << getRelaxationFactor()
                     << std::endl;
                 break;
+            case SO_PRECONDITIONER_SCHWARZ:
+                out << "Overlap = " << getSchwarzOverlap() << std::endl
+                    << "Local solver = " << getName(getSchwarzLocalSolver())
+                    << std::endl;
+                break;
             default:
                 break;
         } // preconditioner switch
@@ -182,6 +210,7 @@ const char* SolverBuddy::getName(int key) const
         case SO_PACKAGE_UMFPACK: return "UMFPACK";
 
         case SO_METHOD_BICGSTAB: return "BICGSTAB";
+        case SO_METHOD_CA_GMRES: return "CA_GMRES";
         case SO_METHOD_CGLS: return "CGLS";
         case SO_METHOD_CGS: return "CGS";
         case SO_METHOD_CHOLEVSKY: return "CHOLEVSKY";
@@ -198,12 +227,14 @@ const char* SolverBuddy::getName(int key) const
         case SO_METHOD_MINRES: return "MINRES";
         case SO_METHOD_NONLINEAR_GMRES: return "NONLINEAR_GMRES";
         case SO_METHOD_PCG: return "PCG";
+        case SO_METHOD_PIPELINED_PCG: return "PIPELINED_PCG";
         case SO_METHOD_PRES20: return "PRES20";
         case SO_METHOD_ROWSUM_LUMPING: return "ROWSUM_LUMPING";
         case SO_METHOD_TFQMR: return "TFQMR";
 
         case SO_PRECONDITIONER_AMG: return "AMG";
         case SO_PRECONDITIONER_AMLI: return "AMLI";
+        case SO_PRECONDITIONER_CHEBYSHEV: return "CHEBYSHEV";
         case SO_PRECONDITIONER_GAUSS_SEIDEL: return "GAUSS_SEIDEL";
         case SO_PRECONDITIONER_ILU0: return "ILU0";
         case SO_PRECONDITIONER_ILUT: return "ILUT";
@@ -211,6 +242,7 @@ const char* SolverBuddy::getName(int key) const
         case SO_PRECONDITIONER_NONE: return "NO_PRECONDITIONER";
         case SO_PRECONDITIONER_REC_ILU: return "REC_ILU";
         case SO_PRECONDITIONER_RILU: return "RILU";
+        case SO_PRECONDITIONER_SCHWARZ: return "SCHWARZ";
 
         case SO_ODESOLVER_BACKWARD_EULER: return "BACKWARD_EULER";
         case SO_ODESOLVER_CRANK_NICOLSON: return "CRANK_NICOLSON";
@@ -236,6 +268,7 @@ const char* SolverBuddy::getName(int key) const
         case SO_REORDERING_MINIMUM_FILL_IN: return "MINIMUM_FILL_IN";
         case SO_REORDERING_NESTED_DISSECTION: return "NESTED_DISSECTION";
         case SO_REORDERING_NONE: return "NO_REORDERING";
+        case SO_REORDERING_REVERSE_CUTHILL_MCKEE: return "REVERSE_CUTHILL_MCKEE";
         default:
             throw ValueError("getName() invalid option given");
     }
@@ -448,6 +481,7 @@ void SolverBuddy::setPreconditioner(int precon)
 #endif
 */
         case SO_PRECONDITIONER_AMLI:
+        case SO_PRECONDITIONER_CHEBYSHEV:
         case SO_PRECONDITIONER_GAUSS_SEIDEL:
         case SO_PRECONDITIONER_ILU0:
         case SO_PRECONDITIONER_ILUT:
@@ -455,6 +489,7 @@ void SolverBuddy::setPreconditioner(int precon)
         case SO_PRECONDITIONER_NONE:
         case SO_PRECONDITIONER_REC_ILU:
         case SO_PRECONDITIONER_RILU:
+        case SO_PRECONDITIONER_SCHWARZ:
             this->preconditioner = preconditioner;
             break;
         default:
@@ -482,12 +517,39 @@ SolverOptions SolverBuddy::getSmoother() const
     return smoother;
 }
 
+void SolverBuddy::setSchwarzOverlap(int overlap)
+{
+    if (overlap < 0)
+        throw ValueError("Schwarz overlap must be non-negative.");
+    this->schwarz_overlap = overlap;
+}
+
+int SolverBuddy::getSchwarzOverlap() const
+{
+    return schwarz_overlap;
+}
+
+void SolverBuddy::setSchwarzLocalSolver(int s)
+{
+    SolverOptions solver = static_cast<SolverOptions>(s);
+    if (solver != SO_PRECONDITIONER_ILU0 && solver != SO_METHOD_DIRECT) {
+        throw ValueError("unknown local solver for Schwarz preconditioner");
+    }
+    this->schwarz_local_solver = solver;
+}
+
+SolverOptions SolverBuddy::getSchwarzLocalSolver() const
+{
+    return schwarz_local_solver;
+}
+
 void SolverBuddy::setSolverMethod(int method)
 {
     SolverOptions meth = static_cast<SolverOptions>(method);
     switch(meth) {
         case SO_DEFAULT:
         case SO_METHOD_BICGSTAB:
+        case SO_METHOD_CA_GMRES:
         case SO_METHOD_CGLS:
         case SO_METHOD_CGS:
         case SO_METHOD_CHOLEVSKY:
@@ -499,6 +561,7 @@ void SolverBuddy::setSolverMethod(int method)
         case SO_METHOD_MINRES:
         case SO_METHOD_NONLINEAR_GMRES:
         case SO_METHOD_PCG:
+        case SO_METHOD_PIPELINED_PCG:
         case SO_METHOD_PRES20:
         case SO_METHOD_ROWSUM_LUMPING:
         case SO_METHOD_TFQMR:
@@ -509,7 +572,7 @@ void SolverBuddy::setSolverMethod(int method)
         case SO_METHOD_DIRECT_PARDISO:
         case SO_METHOD_DIRECT_SUPERLU:
         case SO_METHOD_DIRECT_TRILINOS:
-#if defined(ESYS_HAVE_UMFPACK) || defined(ESYS_HAVE_TRILINOS) || defined(ESYS_HAVE_MKL)
+#if defined(ESYS_HAVE_UMFPACK) || defined(ESYS_HAVE_TRILINOS) || defined(ESYS_HAVE_MKL) || defined(ESYS_HAVE_PASO)
 #ifndef ESYS_HAVE_TRILINOS
             // translate specific direct solver setting to generic one for PASO
             this->method = SO_METHOD_DIRECT;
@@ -579,6 +642,7 @@ void SolverBuddy::setReordering(int ordering)
         case SO_REORDERING_MINIMUM_FILL_IN:
         case SO_REORDERING_NESTED_DISSECTION:
         case SO_REORDERING_NONE:
+        case SO_REORDERING_REVERSE_CUTHILL_MCKEE:
             reordering = ord;
             break;
         default:
@@ -636,6 +700,30 @@ int SolverBuddy::getTruncation() const
     return truncation;
 }
 
+void SolverBuddy::setCAGMRESStepSize(int s)
+{
+    if (s < 1)
+        throw ValueError("CA-GMRES step size must be positive.");
+    ca_gmres_step_size = s;
+}
+
+int SolverBuddy::getCAGMRESStepSize() const
+{
+    return ca_gmres_step_size;
+}
+
+void SolverBuddy::setNumRecycledVectors(int k)
+{
+    if (k < 0)
+        throw ValueError("number of recycled vectors must be non-negative.");
+    num_recycled_vectors = k;
+}
+
+int SolverBuddy::getNumRecycledVectors() const
+{
+    return num_recycled_vectors;
+}
+
 void SolverBuddy::setInnerIterMax(int iter_max)
 {
     if (iter_max < 1)
@@ -699,6 +787,7 @@ void SolverBuddy::setNumSweeps(int sweeps)
     if (sweeps < 1)
         throw ValueError("number of sweeps must be positive.");
     this->sweeps = sweeps;
+    sweeps_set = true;
 }
 
 int SolverBuddy::getNumSweeps() const
@@ -706,6 +795,11 @@ int SolverBuddy::getNumSweeps() const
     return sweeps;
 }
 
+bool SolverBuddy::isNumSweepsSet() const
+{
+    return sweeps_set;
+}
+
 void SolverBuddy::setNumPreSweeps(int sweeps)
 {
     if (sweeps < 1)
@@ -927,6 +1021,75 @@ void SolverBuddy::setLocalPreconditioner(bool use)
         setLocalPreconditionerOff();
 }
 
+bool SolverBuddy::useSlicedEllpack() const
+{
+    return use_sliced_ellpack;
+}
+
+void SolverBuddy::setUseSlicedEllpackOn()
+{
+    use_sliced_ellpack = true;
+}
+
+void SolverBuddy::setUseSlicedEllpackOff()
+{
+    use_sliced_ellpack = false;
+}
+
+void SolverBuddy::setUseSlicedEllpack(bool use)
+{
+    if (use)
+        setUseSlicedEllpackOn();
+    else
+        setUseSlicedEllpackOff();
+}
+
+bool SolverBuddy::useMixedPrecision() const
+{
+    return use_mixed_precision;
+}
+
+void SolverBuddy::setUseMixedPrecisionOn()
+{
+    use_mixed_precision = true;
+}
+
+void SolverBuddy::setUseMixedPrecisionOff()
+{
+    use_mixed_precision = false;
+}
+
+void SolverBuddy::setUseMixedPrecision(bool use)
+{
+    if (use)
+        setUseMixedPrecisionOn();
+    else
+        setUseMixedPrecisionOff();
+}
+
+bool SolverBuddy::useMatrixFree() const
+{
+    return use_matrix_free;
+}
+
+void SolverBuddy::setUseMatrixFreeOn()
+{
+    use_matrix_free = true;
+}
+
+void SolverBuddy::setUseMatrixFreeOff()
+{
+    use_matrix_free = false;
+}
+
+void SolverBuddy::setUseMatrixFree(bool use)
+{
+    if (use)
+        setUseMatrixFreeOn();
+    else
+        setUseMatrixFreeOff();
+}
+
 void SolverBuddy::setMinCoarseMatrixSparsity(double sparsity)
 {
     if (sparsity < 0. || sparsity > 1.)
@@ -37,6 +37,7 @@ SO_PACKAGE_TRILINOS: The TRILINOS parallel solver class library from Sandia Nati
 SO_PACKAGE_UMFPACK: The UMFPACK library
 
 SO_METHOD_BICGSTAB: The stabilized Bi-Conjugate Gradient method
+SO_METHOD_CA_GMRES: The communication-avoiding (s-step) GMRES method with O(1) global reductions per s iterations
 SO_METHOD_CHOLEVSKY: The direct solver based on LDLT factorization (can only be applied for symmetric PDEs)
 SO_METHOD_CGS: The conjugate gradient square method
 SO_METHOD_CR: The conjugate residual method
@@ -51,12 +52,14 @@ SO_METHOD_ITERATIVE: The default iterative solver
 SO_METHOD_LSQR: Least squares with QR factorization
 SO_METHOD_MINRES: Minimum residual method
 SO_METHOD_PCG: The preconditioned conjugate gradient method (can only be applied for symmetric PDEs)
+SO_METHOD_PIPELINED_PCG: The pipelined preconditioned conjugate gradient method with one global reduction per iteration (can only be applied for symmetric PDEs)
 SO_METHOD_PRES20: Special GMRES with restart after 20 steps and truncation after 5 residuals
 SO_METHOD_ROWSUM_LUMPING: Matrix lumping using row sum
 SO_METHOD_TFQMR: Transpose Free Quasi Minimal Residual method
 
 SO_PRECONDITIONER_AMG: Algebraic Multi Grid
 SO_PRECONDITIONER_AMLI: Algebraic Multi Level Iteration
+SO_PRECONDITIONER_CHEBYSHEV: Chebyshev polynomial preconditioner, the degree is set by the number of sweeps (4 if the number of sweeps is not set)
 SO_PRECONDITIONER_GAUSS_SEIDEL: Gauss-Seidel preconditioner
 SO_PRECONDITIONER_ILU0: The incomplete LU factorization preconditioner with no fill-in
 SO_PRECONDITIONER_ILUT: The incomplete LU factorization preconditioner with fill-in
@@ -64,6 +67,7 @@ SO_PRECONDITIONER_JACOBI: The Jacobi preconditioner
 SO_PRECONDITIONER_NONE: no preconditioner is applied
 SO_PRECONDITIONER_REC_ILU: recursive ILU0
 SO_PRECONDITIONER_RILU: relaxed ILU0
+SO_PRECONDITIONER_SCHWARZ: restricted additive Schwarz preconditioner with overlapping subdomains
 
 SO_ODESOLVER_BACKWARD_EULER: backward Euler scheme
 SO_ODESOLVER_CRANK_NICOLSON: Crank-Nicolson scheme
@@ -87,6 +91,7 @@ SO_REORDERING_DEFAULT: the reordering method recommended by the solver
 SO_REORDERING_MINIMUM_FILL_IN: Reorder matrix to reduce fill-in during factorization
 SO_REORDERING_NESTED_DISSECTION: Reorder matrix to improve load balancing during factorization
 SO_REORDERING_NONE: No matrix reordering allowed
+SO_REORDERING_REVERSE_CUTHILL_MCKEE: Reorder matrix to reduce the bandwidth before iterative solves
 */
 enum SolverOptions
 {
@@ -105,6 +110,7 @@ enum SolverOptions
 
     // Solver methods
     SO_METHOD_BICGSTAB,
+    SO_METHOD_CA_GMRES,
     SO_METHOD_CGLS,
     SO_METHOD_CGS,
     SO_METHOD_CHOLEVSKY,
@@ -121,6 +127,7 @@ enum SolverOptions
     SO_METHOD_MINRES,
     SO_METHOD_NONLINEAR_GMRES,
     SO_METHOD_PCG,
+    SO_METHOD_PIPELINED_PCG,
     SO_METHOD_PRES20,
     SO_METHOD_ROWSUM_LUMPING,
     SO_METHOD_TFQMR,
@@ -128,6 +135,7 @@ enum SolverOptions
     // Preconditioners
     SO_PRECONDITIONER_AMG,
     SO_PRECONDITIONER_AMLI,
+    SO_PRECONDITIONER_CHEBYSHEV,
     SO_PRECONDITIONER_GAUSS_SEIDEL,
     SO_PRECONDITIONER_ILU0,
     SO_PRECONDITIONER_ILUT,
@@ -135,6 +143,7 @@ enum SolverOptions
     SO_PRECONDITIONER_NONE,
     SO_PRECONDITIONER_REC_ILU,
     SO_PRECONDITIONER_RILU,
+    SO_PRECONDITIONER_SCHWARZ,
 
     // ODE solvers
     SO_ODESOLVER_BACKWARD_EULER,
@@ -160,7 +169,8 @@ enum SolverOptions
     SO_REORDERING_DEFAULT,
     SO_REORDERING_MINIMUM_FILL_IN,
     SO_REORDERING_NESTED_DISSECTION,
-    SO_REORDERING_NONE
+    SO_REORDERING_NONE,
+    SO_REORDERING_REVERSE_CUTHILL_MCKEE
 };
 
 /// returns true if the passed solver method refers to a direct solver type
@@ -296,6 +306,7 @@ public:
             `SO_PRECONDITIONER_JACOBI`, `SO_PRECONDITIONER_AMG`,
             `SO_PRECONDITIONER_AMLI`, `SO_PRECONDITIONER_REC_ILU`,
             `SO_PRECONDITIONER_GAUSS_SEIDEL`, `SO_PRECONDITIONER_RILU`,
+            `SO_PRECONDITIONER_CHEBYSHEV`, `SO_PRECONDITIONER_SCHWARZ`,
             `SO_PRECONDITIONER_NONE`
 
         \note Not all packages support all preconditioners. It can be assumed
@@ -326,6 +337,34 @@ public:
     */
     SolverOptions getSmoother() const;
 
+    /**
+        Sets the number of layers of rows owned by neighbouring ranks which
+        are added to the local subdomain of the Schwarz preconditioner.
+
+        \param overlap overlap depth, 0 gives block Jacobi
+    */
+    void setSchwarzOverlap(int overlap);
+
+    /**
+        Returns the overlap depth of the Schwarz preconditioner.
+    */
+    int getSchwarzOverlap() const;
+
+    /**
+        Sets the solver used on the overlapping subdomains of the Schwarz
+        preconditioner.
+
+        \param solver key of the local solver, should be in
+               `SO_PRECONDITIONER_ILU0`, `SO_METHOD_DIRECT`
+    */
+    void setSchwarzLocalSolver(int solver);
+
+    /**
+        Returns the key of the solver used on the subdomains of the Schwarz
+        preconditioner.
+    */
+    SolverOptions getSchwarzLocalSolver() const;
+
     /**
         Sets the solver method to be used. Use ``method``=``SO_METHOD_DIRECT``
         to indicate that a direct rather than an iterative solver should be
@@ -336,8 +375,10 @@ public:
             `SO_DEFAULT`, `SO_METHOD_DIRECT`, `SO_METHOD_DIRECT_MUMPS`,
             `SO_METHOD_DIRECT_PARDISO`, `SO_METHOD_DIRECT_SUPERLU`,
             `SO_METHOD_DIRECT_TRILINOS`, `SO_METHOD_CHOLEVSKY`,
-            `SO_METHOD_PCG`, `SO_METHOD_CR`, `SO_METHOD_CGS`,
-            `SO_METHOD_BICGSTAB`, `SO_METHOD_GMRES`, `SO_METHOD_PRES20`,
+            `SO_METHOD_PCG`, `SO_METHOD_PIPELINED_PCG`, `SO_METHOD_CR`,
+            `SO_METHOD_CGS`,
+            `SO_METHOD_BICGSTAB`, `SO_METHOD_GMRES`, `SO_METHOD_CA_GMRES`,
+            `SO_METHOD_PRES20`,
             `SO_METHOD_ROWSUM_LUMPING`, `SO_METHOD_HRZ_LUMPING`,
             `SO_METHOD_ITERATIVE`, `SO_METHOD_LSQR`,
             `SO_METHOD_NONLINEAR_GMRES`, `SO_METHOD_TFQMR`, `SO_METHOD_MINRES`
@@ -393,10 +434,13 @@ public:
         Sets the key of the reordering method to be applied if supported by the
         solver. Some direct solvers support reordering
         to optimize compute time and storage use during elimination.
+        Paso's iterative solvers support reordering of the local unknowns
+        to reduce the bandwidth of the matrix.
 
         \param ordering selects the reordering strategy, should be in
                `SO_REORDERING_NONE`, `SO_REORDERING_MINIMUM_FILL_IN`,
-               `SO_REORDERING_NESTED_DISSECTION`, 'SO_REORDERING_DEFAULT`
+               `SO_REORDERING_NESTED_DISSECTION`,
+               `SO_REORDERING_REVERSE_CUTHILL_MCKEE`, 'SO_REORDERING_DEFAULT`
     */
     void setReordering(int ordering);
 
@@ -452,6 +496,38 @@ public:
     */
     int getTruncation() const;
 
+    /**
+        Sets the number of steps s of the communication-avoiding GMRES
+        method which are computed between two block orthogonalizations.
+        Larger values reduce the number of global reductions but may
+        lead to an ill-conditioned Krylov basis.
+
+        \param s number of steps per block, must be positive
+    */
+    void setCAGMRESStepSize(int s);
+
+    /**
+        Returns the number of steps of the communication-avoiding GMRES
+        method which are computed between two block orthogonalizations.
+    */
+    int getCAGMRESStepSize() const;
+
+    /**
+        Sets the number of approximate eigenvectors which are kept with the
+        system matrix between solves and used to deflate the next solve
+        (Krylov subspace recycling). This is only used by the PCG and GMRES
+        solvers. 0 disables recycling.
+
+        \param k number of recycled vectors, must be non-negative
+    */
+    void setNumRecycledVectors(int k);
+
+    /**
+        Returns the number of approximate eigenvectors which are recycled
+        between solves.
+    */
+    int getNumRecycledVectors() const;
+
     /**
         Sets the maximum number of iteration steps for the inner iteration.
 
@@ -520,7 +596,9 @@ public:
 
     /**
         Sets the number of sweeps in a Jacobi or Gauss-Seidel/SOR
-        preconditioner.
+        preconditioner. For the Chebyshev preconditioner this is the degree
+        of the polynomial, which defaults to 4 if the number of sweeps is
+        not set.
 
         \param sweeps number of sweeps
     */
@@ -532,6 +610,13 @@ public:
     */
     int getNumSweeps() const;
 
+    /**
+        Returns ``True`` if the number of sweeps has been set explicitly
+        via `setNumSweeps`. Preconditioners which use a different default
+        (e.g. the degree of the Chebyshev preconditioner) check this flag.
+    */
+    bool isNumSweepsSet() const;
+
     /**
         Sets the number of sweeps in the pre-smoothing step of a multi level
         solver or preconditioner
@@ -783,6 +868,87 @@ public:
     */
     void setLocalPreconditioner(bool local);
 
+    /**
+        Returns ``true`` if the matrix-vector product of iterative solvers
+        uses a sliced ELLPACK (SELL-C-sigma) copy of the matrix. The copy is
+        created at the start of each solve and improves the SIMD utilization
+        of the product at the cost of additional memory.
+    */
+    bool useSlicedEllpack() const;
+
+    /**
+        Sets the flag to use the sliced ELLPACK matrix-vector product to on
+    */
+    void setUseSlicedEllpackOn();
+
+    /**
+        Sets the flag to use the sliced ELLPACK matrix-vector product to off
+    */
+    void setUseSlicedEllpackOff();
+
+    /**
+        Sets the flag to use the sliced ELLPACK matrix-vector product
+
+        \param use If ``true``, a sliced ELLPACK copy of the matrix is used
+               in the matrix-vector product of iterative solvers
+    */
+    void setUseSlicedEllpack(bool use);
+
+    /**
+        Returns ``true`` if the preconditioner is stored and applied in
+        single precision where supported (Jacobi smoothers with block size
+        up to 8 and ILU0) while the residuals of the iterative solver are
+        kept in double precision. This reduces the memory traffic of the
+        preconditioner but may increase the number of iteration steps.
+    */
+    bool useMixedPrecision() const;
+
+    /**
+        Sets the flag to use the mixed precision mode to on
+    */
+    void setUseMixedPrecisionOn();
+
+    /**
+        Sets the flag to use the mixed precision mode to off
+    */
+    void setUseMixedPrecisionOff();
+
+    /**
+        Sets the flag to use the mixed precision mode
+
+        \param use If ``true``, the preconditioner is stored and applied in
+               single precision where supported
+    */
+    void setUseMixedPrecision(bool use);
+
+    /**
+        Returns ``true`` if the domain is asked for a matrix-free operator
+        instead of an assembled system matrix. The operator only keeps the
+        PDE coefficients and evaluates the element contributions at the
+        quadrature points whenever it is applied. It is only supported by
+        some domains (ripley) and iterative solvers (PCG, BiCGStab) with the
+        Jacobi or Chebyshev preconditioner.
+    */
+    bool useMatrixFree() const;
+
+    /**
+        Sets the flag to use a matrix-free operator to on
+    */
+    void setUseMatrixFreeOn();
+
+    /**
+        Sets the flag to use a matrix-free operator to off
+    */
+    void setUseMatrixFreeOff();
+
+    /**
+        Sets the flag to use a matrix-free operator
+
+        \param use If ``true``, the PDE operator is applied without
+               assembling a system matrix where supported
+    */
+    void setUseMatrixFree(bool use);
+
     /**
         Sets the minimum sparsity at the coarsest level. Typically a direct
         solver is used when the sparsity becomes larger than the set limit.
@@ -909,14 +1075,17 @@ protected:
     SolverOptions preconditioner;
     SolverOptions ode_solver;
     SolverOptions smoother;
+    SolverOptions schwarz_local_solver;
     SolverOptions reordering;
     SolverOptions coarsening;
     SolverOptions amg_interpolation_method;
     int level_max;
     double coarsening_threshold;
     int sweeps;
+    bool sweeps_set;
     int pre_sweeps;
     int post_sweeps;
+    int schwarz_overlap;
     double tolerance;
     double absolute_tolerance;
     double inner_tolerance;
@@ -925,6 +1094,8 @@ protected:
     int iter_max;
     int inner_iter_max;
     int truncation;
+    int ca_gmres_step_size;
+    int num_recycled_vectors;
     int restart; //0 will have to be None in python, will get tricky
     bool is_complex;
     bool symmetric;
@@ -934,6 +1105,9 @@ protected:
     int min_coarse_matrix_size;
     double relaxation;
     bool use_local_preconditioner;
+    bool use_sliced_ellpack;
+    bool use_mixed_precision;
+    bool use_matrix_free;
     double min_sparsity;
     int refinements;
     int coarse_refinements;
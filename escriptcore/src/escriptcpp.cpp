@@ -517,6 +517,14 @@ args("arg"), "assigns new location to the domain\n\n"
         ":return: True if this ``Data`` is not lazy.")
     .def("isComplex", &escript::Data::isComplex,":rtype: ``bool``\n"
 	":return: True if this ``Data`` stores complex values.")
+    .def("isSinglePrecision", &escript::Data::isSinglePrecision,":rtype: ``bool``\n"
+	":return: True if this ``Data`` stores its values in single precision.")
+    .def("toSinglePrecision", &escript::Data::toSinglePrecision,"Store the values in single precision.\n\n"
+	":note: Arithmetic between single precision ``Data`` objects and constants keeps single precision,"
+	" arithmetic with double precision ``Data`` gives double precision. Other operations raise an"
+	" exception until ``toDoublePrecision`` is called.\n"
+	":note: Complex data can not be stored in single precision.")
+    .def("toDoublePrecision", &escript::Data::toDoublePrecision,"Store the values in double precision.")
     .def("expand",&escript::Data::expand,"Convert the data to expanded representation if it is not expanded already.")
     .def("hasNaN",&escript::Data::hasNaN,"Returns return true if data contains NaN. [Note that for complex values, hasNaN and hasInf are not mutually exclusive.]")
     .def("replaceNaN",&escript::Data::replaceNaNPython,args("value"),"Replaces NaN values with value. [Note, for complex Data, both real and imaginary components are replaced even if only one part is NaN].")
@@ -920,6 +928,12 @@ args("arg"), "assigns new location to the domain\n\n"
         ":return: the solution *u* of the linear system *this*u=in*\n\n"
         ":param in:\n"
         ":type in: `Data`")
+     .def("solveMultiple",&escript::AbstractSystemMatrix::solveMultiple, args("in","options"),
+        ":return: the solutions *u_i* of the linear systems *this*u_i=in_i*\n"
+        "as a list. With paso's PCG and GMRES solvers the systems are\n"
+        "solved together so each matrix pass serves all right hand sides.\n\n"
+        ":param in: right hand sides\n"
+        ":type in: ``list`` of `Data`")
      .def("of",&escript::AbstractSystemMatrix::vectorMultiply,args("right"),
         "matrix*vector multiplication")
      .def("nullifyRowsAndCols",&escript::AbstractSystemMatrix::nullifyRowsAndCols)
@@ -961,6 +975,7 @@ args("source", "q", "r","factor"),
     .value("UMFPACK", escript::SO_PACKAGE_UMFPACK)
 
     .value("BICGSTAB", escript::SO_METHOD_BICGSTAB)
+    .value("CA_GMRES", escript::SO_METHOD_CA_GMRES)
     .value("CGLS", escript::SO_METHOD_CGLS)
     .value("CGS", escript::SO_METHOD_CGS)
     .value("CHOLEVSKY", escript::SO_METHOD_CHOLEVSKY)
@@ -978,12 +993,14 @@ args("source", "q", "r","factor"),
     .value("MINRES", escript::SO_METHOD_MINRES)
     .value("NONLINEAR_GMRES", escript::SO_METHOD_NONLINEAR_GMRES)
     .value("PCG", escript::SO_METHOD_PCG)
+    .value("PIPELINED_PCG", escript::SO_METHOD_PIPELINED_PCG)
     .value("PRES20", escript::SO_METHOD_PRES20)
     .value("ROWSUM_LUMPING", escript::SO_METHOD_ROWSUM_LUMPING)
     .value("TFQMR", escript::SO_METHOD_TFQMR)
 
     .value("AMG", escript::SO_PRECONDITIONER_AMG)
     .value("AMLI", escript::SO_PRECONDITIONER_AMLI)
+    .value("CHEBYSHEV", escript::SO_PRECONDITIONER_CHEBYSHEV)
     .value("GAUSS_SEIDEL", escript::SO_PRECONDITIONER_GAUSS_SEIDEL)
     .value("ILU0", escript::SO_PRECONDITIONER_ILU0)
     .value("ILUT", escript::SO_PRECONDITIONER_ILUT)
@@ -991,6 +1008,7 @@ args("source", "q", "r","factor"),
     .value("NO_PRECONDITIONER", escript::SO_PRECONDITIONER_NONE)
     .value("REC_ILU", escript::SO_PRECONDITIONER_REC_ILU)
     .value("RILU", escript::SO_PRECONDITIONER_RILU)
+    .value("SCHWARZ", escript::SO_PRECONDITIONER_SCHWARZ)
 
     .value("BACKWARD_EULER", escript::SO_ODESOLVER_BACKWARD_EULER)
     .value("CRANK_NICOLSON", escript::SO_ODESOLVER_CRANK_NICOLSON)
@@ -1013,7 +1031,8 @@ args("source", "q", "r","factor"),
     .value("DEFAULT_REORDERING", escript::SO_REORDERING_DEFAULT)
     .value("MINIMUM_FILL_IN", escript::SO_REORDERING_MINIMUM_FILL_IN)
     .value("NESTED_DISSECTION", escript::SO_REORDERING_NESTED_DISSECTION)
-    .value("NO_REORDERING", escript::SO_REORDERING_NONE);
+    .value("NO_REORDERING", escript::SO_REORDERING_NONE)
+    .value("REVERSE_CUTHILL_MCKEE", escript::SO_REORDERING_REVERSE_CUTHILL_MCKEE);
 
 
   class_<escript::SolverBuddy, escript::SB_ptr >("SolverBuddy","",init<>())
@@ -1078,23 +1097,34 @@ args("source", "q", "r","factor"),
     .def("getMinCoarseMatrixSize", &escript::SolverBuddy::getMinCoarseMatrixSize,"Returns the minimum size of the coarsest level matrix in AMG or AMLI")
     .def("setPreconditioner", &escript::SolverBuddy::setPreconditioner, args("preconditioner"),"Sets the preconditioner to be used.\n\n"
         ":param preconditioner: key of the preconditioner to be used.\n"
-        ":type preconditioner: in `ILU0`, `ILUT`, `JACOBI`, `AMG`, `AMLI`, `REC_ILU`, `GAUSS_SEIDEL`, `RILU`, `NO_PRECONDITIONER`\n"
+        ":type preconditioner: in `ILU0`, `ILUT`, `JACOBI`, `AMG`, `AMLI`, `REC_ILU`, `GAUSS_SEIDEL`, `RILU`, `CHEBYSHEV`, `SCHWARZ`, `NO_PRECONDITIONER`\n"
         ":note: Not all packages support all preconditioner. It can be assumed that a package makes a reasonable choice if it encounters an unknown"
         "preconditioner.\n")
     .def("getPreconditioner", &escript::SolverBuddy::getPreconditioner,"Returns the key of the preconditioner to be used.\n\n"
-        ":rtype: in the list `ILU0`, `ILUT`, `JACOBI`, `AMLI`, `AMG`, `REC_ILU`, `GAUSS_SEIDEL`, `RILU`,  `NO_PRECONDITIONER`")
+        ":rtype: in the list `ILU0`, `ILUT`, `JACOBI`, `AMLI`, `AMG`, `REC_ILU`, `GAUSS_SEIDEL`, `RILU`, `CHEBYSHEV`, `SCHWARZ`, `NO_PRECONDITIONER`")
     .def("setSmoother", &escript::SolverBuddy::setSmoother, args("smoother"),"Sets the smoother to be used.\n\n"
         ":param smoother: key of the smoother to be used.\n"
         ":type smoother: in `JACOBI`, `GAUSS_SEIDEL`\n"
         ":note: Not all packages support all smoothers. It can be assumed that a package makes a reasonable choice if it encounters an unknown smoother.")
     .def("getSmoother", &escript::SolverBuddy::getSmoother,"Returns key of the smoother to be used.\n\n"
         ":rtype: in the list `JACOBI`, `GAUSS_SEIDEL`")
+    .def("setSchwarzOverlap", &escript::SolverBuddy::setSchwarzOverlap, args("overlap"),"Sets the number of layers of rows owned by neighbouring ranks which are added to the local subdomain of the Schwarz preconditioner.\n\n"
+        ":param overlap: overlap depth, 0 gives block Jacobi\n"
+        ":type overlap: non-negative ``int``")
+    .def("getSchwarzOverlap", &escript::SolverBuddy::getSchwarzOverlap,"Returns the overlap depth of the Schwarz preconditioner.\n\n"
+        ":rtype: ``int``")
+    .def("setSchwarzLocalSolver", &escript::SolverBuddy::setSchwarzLocalSolver, args("solver"),"Sets the solver used on the overlapping subdomains of the Schwarz preconditioner.\n\n"
+        ":param solver: key of the local solver\n"
+        ":type solver: in `ILU0`, `DIRECT`\n"
+        ":note: `DIRECT` requires a build with a direct solver library (MKL or UMFPACK).")
+    .def("getSchwarzLocalSolver", &escript::SolverBuddy::getSchwarzLocalSolver,"Returns the key of the solver used on the subdomains of the Schwarz preconditioner.\n\n"
+        ":rtype: in the list `ILU0`, `DIRECT`")
     .def("setSolverMethod", &escript::SolverBuddy::setSolverMethod, args("method"),"Sets the solver method to be used. Use ``method``=``DIRECT`` to indicate that a direct rather than an iterative solver should be used and use ``method``=``ITERATIVE`` to indicate that an iterative rather than a direct solver should be used.\n\n"
         ":param method: key of the solver method to be used.\n"
-        ":type method: in `DEFAULT`, `DIRECT`, `CHOLEVSKY`, `PCG`, `CR`, `CGS`, `BICGSTAB`, `GMRES`, `PRES20`, `ROWSUM_LUMPING`, `HRZ_LUMPING`, `ITERATIVE`, `NONLINEAR_GMRES`, `TFQMR`, `MINRES`\n"
+        ":type method: in `DEFAULT`, `DIRECT`, `CHOLEVSKY`, `PCG`, `PIPELINED_PCG`, `CR`, `CGS`, `BICGSTAB`, `GMRES`, `CA_GMRES`, `PRES20`, `ROWSUM_LUMPING`, `HRZ_LUMPING`, `ITERATIVE`, `NONLINEAR_GMRES`, `TFQMR`, `MINRES`\n"
         ":note: Not all packages support all solvers. It can be assumed that a package makes a reasonable choice if it encounters an unknown solver method.")
     .def("getSolverMethod", &escript::SolverBuddy::getSolverMethod,"Returns key of the solver method to be used.\n\n"
-        ":rtype: in the list `DEFAULT`, `DIRECT`, `CHOLEVSKY`, `PCG`, `CR`, `CGS`, `BICGSTAB`, `GMRES`, `PRES20`, `ROWSUM_LUMPING`, `HRZ_LUMPING`, `MINRES`, `ITERATIVE`, `NONLINEAR_GMRES`, `TFQMR`")
+        ":rtype: in the list `DEFAULT`, `DIRECT`, `CHOLEVSKY`, `PCG`, `PIPELINED_PCG`, `CR`, `CGS`, `BICGSTAB`, `GMRES`, `CA_GMRES`, `PRES20`, `ROWSUM_LUMPING`, `HRZ_LUMPING`, `MINRES`, `ITERATIVE`, `NONLINEAR_GMRES`, `TFQMR`")
     .def("setPackage", &escript::SolverBuddy::setPackage, args("package"),"Sets the solver package to be used as a solver.\n\n"
         ":param package: key of the solver package to be used.\n"
         ":type package: in `DEFAULT`, `PASO`, `CUSP`, `MKL`, `UMFPACK`, `TRILINOS`\n"
@@ -1106,11 +1136,11 @@ args("source", "q", "r","factor"),
         ":type target: in `TARGET_CPU`, `TARGET_GPU`\n")
     .def("getSolverTarget", &escript::SolverBuddy::getSolverTarget, "Returns the solver target key\n\n"
         ":rtype: in the list `TARGET_CPU`, `TARGET_GPU`")
-    .def("setReordering", &escript::SolverBuddy::setReordering, args("ordering"),"Sets the key of the reordering method to be applied if supported by the solver. Some direct solvers support reordering to optimize compute time and storage use during elimination.\n\n"
+    .def("setReordering", &escript::SolverBuddy::setReordering, args("ordering"),"Sets the key of the reordering method to be applied if supported by the solver. Some direct solvers support reordering to optimize compute time and storage use during elimination. Paso's iterative solvers support reordering of the local unknowns to reduce the bandwidth of the matrix.\n\n"
         ":param ordering: selects the reordering strategy.\n"
-        ":type ordering: in 'NO_REORDERING', 'MINIMUM_FILL_IN', 'NESTED_DISSECTION', 'DEFAULT_REORDERING'")
+        ":type ordering: in 'NO_REORDERING', 'MINIMUM_FILL_IN', 'NESTED_DISSECTION', 'REVERSE_CUTHILL_MCKEE', 'DEFAULT_REORDERING'")
     .def("getReordering", &escript::SolverBuddy::getReordering,"Returns the key of the reordering method to be applied if supported by the solver.\n\n"
-        ":rtype: in `NO_REORDERING`, `MINIMUM_FILL_IN`, `NESTED_DISSECTION`, `DEFAULT_REORDERING`")
+        ":rtype: in `NO_REORDERING`, `MINIMUM_FILL_IN`, `NESTED_DISSECTION`, `REVERSE_CUTHILL_MCKEE`, `DEFAULT_REORDERING`")
     .def("setRestart", &escript::SolverBuddy::setRestart, args("restart"),"Sets the number of iterations steps after which GMRES performs a restart.\n\n"
         ":param restart: number of iteration steps after which to perform a restart. If 0 no restart is performed.\n"
         ":type restart: ``int``")
@@ -1126,6 +1156,16 @@ args("source", "q", "r","factor"),
         ":type truncation: ``int``")
     .def("getTruncation", &escript::SolverBuddy::getTruncation,"Returns the number of residuals in GMRES to be stored for orthogonalization\n\n"
         ":rtype: ``int``")
+    .def("setCAGMRESStepSize", &escript::SolverBuddy::setCAGMRESStepSize, args("s"),"Sets the number of steps of the communication-avoiding GMRES method which are computed between two block orthogonalizations. Larger values reduce the number of global reductions but may lead to an ill-conditioned Krylov basis.\n\n"
+        ":param s: number of steps per block\n"
+        ":type s: positive ``int``")
+    .def("getCAGMRESStepSize", &escript::SolverBuddy::getCAGMRESStepSize,"Returns the number of steps of the communication-avoiding GMRES method which are computed between two block orthogonalizations.\n\n"
+        ":rtype: ``int``")
+    .def("setNumRecycledVectors", &escript::SolverBuddy::setNumRecycledVectors, args("k"),"Sets the number of approximate eigenvectors which are kept with the system matrix between solves and used to deflate the next solve (Krylov subspace recycling). This is only used by the PCG and GMRES solvers. 0 disables recycling.\n\n"
+        ":param k: number of recycled vectors\n"
+        ":type k: non-negative ``int``")
+    .def("getNumRecycledVectors", &escript::SolverBuddy::getNumRecycledVectors,"Returns the number of approximate eigenvectors which are recycled between solves.\n\n"
+        ":rtype: ``int``")
     .def("setInnerIterMax", &escript::SolverBuddy::setInnerIterMax, args("iter_max"),"Sets the maximum number of iteration steps for the inner iteration.\n\n"
         ":param iter_max: maximum number of inner iterations\n"
         ":type iter_max: ``int``")
@@ -1153,11 +1193,14 @@ args("source", "q", "r","factor"),
     .def("getCoarseningThreshold", &escript::SolverBuddy::getCoarseningThreshold,"Returns the threshold for coarsening in the algebraic multi level solver\n"
         "or preconditioner\n\n"
         ":rtype: ``float``")
-    .def("setNumSweeps", &escript::SolverBuddy::setNumSweeps, args("sweeps"),"Sets the number of sweeps in a Jacobi or Gauss-Seidel/SOR preconditioner.\n\n"
+    .def("setNumSweeps", &escript::SolverBuddy::setNumSweeps, args("sweeps"),"Sets the number of sweeps in a Jacobi or Gauss-Seidel/SOR preconditioner\n"
+        "or the degree of the Chebyshev preconditioner (4 if not set).\n\n"
         ":param sweeps: number of sweeps\n"
         ":type sweeps: positive ``int``")
     .def("getNumSweeps", &escript::SolverBuddy::getNumSweeps,"Returns the number of sweeps in a Jacobi or Gauss-Seidel/SOR preconditioner.\n\n"
         ":rtype: ``int``")
+    .def("isNumSweepsSet", &escript::SolverBuddy::isNumSweepsSet,"Returns ``True`` if the number of sweeps has been set explicitly.\n\n"
+        ":rtype: ``bool``")
     .def("setNumPreSweeps", &escript::SolverBuddy::setNumPreSweeps, args("sweeps"),"Sets the number of sweeps in the pre-smoothing step of a multi level\n"
         "solver or preconditioner\n\n"
         ":param sweeps: number of sweeps\n"
@@ -1250,6 +1293,30 @@ args("source", "q", "r","factor"),
     .def("setLocalPreconditioner", &escript::SolverBuddy::setLocalPreconditioner, args("local"),"Sets the flag to use  local preconditioning\n\n"
         ":param use: If ``True``, local preconditioning on each MPI rank is applied\n"
         ":type use: ``bool``")
+    .def("useSlicedEllpack", &escript::SolverBuddy::useSlicedEllpack,"Returns ``True`` if the matrix-vector product of iterative solvers uses a sliced ELLPACK (SELL-C-sigma) copy of the matrix. The copy is created at the start of each solve and improves the SIMD utilization of the product at the cost of additional memory.\n\n"
+        ":return: ``True`` if the sliced ELLPACK matrix-vector product is used\n"
+        ":rtype: ``bool``")
+    .def("setUseSlicedEllpackOn", &escript::SolverBuddy::setUseSlicedEllpackOn,"Sets the flag to use the sliced ELLPACK matrix-vector product to on")
+    .def("setUseSlicedEllpackOff", &escript::SolverBuddy::setUseSlicedEllpackOff,"Sets the flag to use the sliced ELLPACK matrix-vector product to off")
+    .def("setUseSlicedEllpack", &escript::SolverBuddy::setUseSlicedEllpack, args("use"),"Sets the flag to use the sliced ELLPACK matrix-vector product\n\n"
+        ":param use: If ``True``, a sliced ELLPACK copy of the matrix is used in the matrix-vector product of iterative solvers\n"
+        ":type use: ``bool``")
+    .def("useMixedPrecision", &escript::SolverBuddy::useMixedPrecision,"Returns ``True`` if the preconditioner is stored and applied in single precision where supported (Jacobi smoothers with block size up to 8 and ILU0) while the residuals of the iterative solver are kept in double precision. This reduces the memory traffic of the preconditioner but may increase the number of iteration steps.\n\n"
+        ":return: ``True`` if the mixed precision mode is used\n"
+        ":rtype: ``bool``")
+    .def("setUseMixedPrecisionOn", &escript::SolverBuddy::setUseMixedPrecisionOn,"Sets the flag to use the mixed precision mode to on")
+    .def("setUseMixedPrecisionOff", &escript::SolverBuddy::setUseMixedPrecisionOff,"Sets the flag to use the mixed precision mode to off")
+    .def("setUseMixedPrecision", &escript::SolverBuddy::setUseMixedPrecision, args("use"),"Sets the flag to use the mixed precision mode\n\n"
+        ":param use: If ``True``, the preconditioner is stored and applied in single precision where supported\n"
+        ":type use: ``bool``")
+    .def("useMatrixFree", &escript::SolverBuddy::useMatrixFree,"Returns ``True`` if the domain is asked for a matrix-free operator instead of an assembled system matrix. The operator only keeps the PDE coefficients and evaluates the element contributions at the quadrature points whenever it is applied. It is only supported by some domains (ripley) and iterative solvers (PCG, BiCGStab) with the Jacobi or Chebyshev preconditioner.\n\n"
+        ":return: ``True`` if a matrix-free operator is used\n"
+        ":rtype: ``bool``")
+    .def("setUseMatrixFreeOn", &escript::SolverBuddy::setUseMatrixFreeOn,"Sets the flag to use a matrix-free operator to on")
+    .def("setUseMatrixFreeOff", &escript::SolverBuddy::setUseMatrixFreeOff,"Sets the flag to use a matrix-free operator to off")
+    .def("setUseMatrixFree", &escript::SolverBuddy::setUseMatrixFree, args("use"),"Sets the flag to use a matrix-free operator\n\n"
+        ":param use: If ``True``, the PDE operator is applied without assembling a system matrix where supported\n"
+        ":type use: ``bool``")
     .def("setMinCoarseMatrixSparsity", &escript::SolverBuddy::setMinCoarseMatrixSparsity, args("sparsity"),"Sets the minimum sparsity on the coarsest level. Typically a direct solver is used when the sparsity becomes bigger than the set limit.\n\n"
         ":param sparsity: minimal sparsity\n"
         ":type sparsity: ``float``")
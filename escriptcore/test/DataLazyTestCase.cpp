@@ -15,6 +15,7 @@
 *****************************************************************************/
 
 #include <escript/DataConstant.h>
+#include <escript/DataExpanded.h>
 #include "DataLazyTestCase.h"
 
 #include <escript/DataLazy.h>
@@ -316,6 +317,46 @@ void DataLazyTestCase::testLazy4()
 
 
 
+// This method tests that identical subexpressions built separately are
+// replaced by a single node
+void DataLazyTestCase::testLazyShared()
+{
+  cout << endl;
+  cout << "\tTesting shared subexpressions\n";
+
+  // expanded leaves, constant ones would be collapsed on construction
+  DataTypes::ShapeType shape;
+  DataTypes::RealVectorType data(1,1);
+  DataConstant c(FunctionSpace(),shape,data);
+  DataAbstract_ptr a(new DataLazy(DataAbstract_ptr(new DataExpanded(c))));
+  DataAbstract_ptr b(new DataLazy(DataAbstract_ptr(new DataExpanded(c))));
+  // (a+b) is built twice: sin(a+b)*(a+b)
+  DataLazy_ptr s1(new DataLazy(a,b,ADD));
+  DataLazy_ptr s2(new DataLazy(a,b,ADD));
+  DataLazy_ptr t(new DataLazy(s1,SIN));
+  DataLazy_ptr root(new DataLazy(t,s2,MUL));
+  CPPUNIT_ASSERT(root->getNodeKey().right==s2.get());
+
+  DataLazy::NodeTable table;
+  root->shareSubExpressions(table);
+  // a, b, a+b (twice) and sin(a+b) were visited, the second a+b is shared
+  CPPUNIT_ASSERT(table.canonical.size()==5);
+  CPPUNIT_ASSERT(table.shared==1);
+  CPPUNIT_ASSERT(table.canonical[s2.get()]==s1);
+  CPPUNIT_ASSERT(root->getNodeKey().right==s1.get());
+  CPPUNIT_ASSERT(t->getNodeKey().left==s1.get());
+
+  // sharing again finds nothing new
+  DataLazy::NodeTable table2;
+  root->shareSubExpressions(table2);
+  CPPUNIT_ASSERT(table2.canonical.size()==4);
+  CPPUNIT_ASSERT(table2.shared==0);
+
+  DataReady_ptr r=root->resolve();
+  CPPUNIT_ASSERT(std::abs(r->getVectorRO()[0]-sin(2.)*2.)<1e-12);
+}
+
+
 TestSuite* DataLazyTestCase::suite()
 {
   // create the suite of tests to perform.
@@ -331,6 +372,8 @@ TestSuite* DataLazyTestCase::suite()
               "Binary",&DataLazyTestCase::testLazy3));
   testSuite->addTest(new TestCaller<DataLazyTestCase>(
               "GTP",&DataLazyTestCase::testLazy4));
+  testSuite->addTest(new TestCaller<DataLazyTestCase>(
+              "Shared subexpressions",&DataLazyTestCase::testLazyShared));
   return testSuite;
 }
 
@@ -29,6 +29,7 @@ public:
   void testLazy2p();
   void testLazy3();
   void testLazy4();
+  void testLazyShared();
 
   static CppUnit::TestSuite* suite();
 };
@@ -48,5 +48,100 @@ class TestDomainTests(unittest.TestCase):
         ref=msk_ref*(-0.5)+(1.-msk_ref)*0.9
         self.assertTrue(Lsup(res-ref) <= self.TOL, "ReductionOnTestDomain Failed")
 
+    def testSinglePrecision(self):
+        dom = getTestDomainFunctionSpace(4,20,2).getDomain()
+        x=dom.getX()
+        a=sin(x)+2.
+        b=cos(x)
+        a_s=a.copy()
+        a_s.toSinglePrecision()
+        b_s=b.copy()
+        b_s.toSinglePrecision()
+        self.assertTrue(a_s.isSinglePrecision())
+        self.assertFalse(a.isSinglePrecision())
+        TOL=1.e-6
+        self.assertTrue(Lsup(a_s-a) <= TOL*Lsup(a), "single storage")
+        # single op single and single op constant stay single
+        res=a_s*b_s+b_s/a_s-1.
+        self.assertTrue(res.isSinglePrecision())
+        self.assertTrue(Lsup(res-(a*b+b/a-1.)) <= 10*TOL, "single arithmetic")
+        # single op double gives double
+        res=a_s*b
+        self.assertFalse(res.isSinglePrecision())
+        self.assertTrue(Lsup(res-a*b) <= 10*TOL, "mixed arithmetic")
+        # in-place updates keep the precision of the updated object
+        res=a_s.copy()
+        res*=b
+        res+=1.
+        self.assertTrue(res.isSinglePrecision())
+        self.assertTrue(Lsup(res-(a*b+1.)) <= 10*TOL, "in-place arithmetic")
+        # resolving does not change the precision
+        res.resolve()
+        self.assertTrue(res.isSinglePrecision())
+        self.assertFalse(res.isLazy())
+        # operations without single precision support fail
+        self.assertRaises(Exception, exp, a_s)
+        self.assertRaises(Exception, Lsup, a_s)
+        self.assertRaises(Exception, a_s.delay)
+        a_s.toDoublePrecision()
+        self.assertFalse(a_s.isSinglePrecision())
+        self.assertTrue(Lsup(exp(a_s)-exp(a)) <= 10*TOL*Lsup(exp(a)), "unary")
+        c=a.copy()
+        c.promote()
+        self.assertRaises(Exception, c.toSinglePrecision)
+
+    def testLazyKernels(self):
+        dom = getTestDomainFunctionSpace(4,20,2).getDomain()
+        x=dom.getX()
+        a=(sin(x)+2.).delay()
+        b=cos(x).delay()
+        ref=None
+        ref2=None
+        for k in (0, 1):
+            setEscriptParamInt("LAZY_KERNELS", k)
+            res=(a*b+exp(b)/a-1.)*whereNegative(b)+sqrt(a)*x[0]
+            res.resolve()
+            # tensor operations and reductions are evaluated in blocks too
+            res2=trace(symmetric(outer(a*x,b)))*a+maxval(transpose(outer(x,a)))
+            res2.resolve()
+            if ref is None:
+                ref=res
+                ref2=res2
+        setEscriptParamInt("LAZY_KERNELS", 1)
+        self.assertTrue(Lsup(res-ref) <= self.TOL*Lsup(ref), "lazy kernel differs from interpreter")
+        self.assertTrue(Lsup(res2-ref2) <= self.TOL*Lsup(ref2), "lazy kernel differs from interpreter for tensors")
+
+    def testLazySharedSubexpressions(self):
+        dom = getTestDomainFunctionSpace(4,20,2).getDomain()
+        x=dom.getX()
+        a=(sin(x)+2.).delay()
+        b=cos(x)
+        # each term builds its own copy of a+b
+        res=sin(a+b)*a+exp(a+b)/(a+b)-(a+b)*a
+        sol=sin(a+b)*a+exp(a+b)/(a+b)-(a+b)*a
+        res.resolve()
+        c=sin(x)+2.+b
+        ref=sin(c)*(sin(x)+2.)+exp(c)/c-c*(sin(x)+2.)
+        self.assertTrue(Lsup(res-ref) <= self.TOL*Lsup(ref), "shared subexpressions in resolve")
+        other=(a+b)*2.
+        resolveGroup([sol, other])
+        self.assertTrue(Lsup(sol-ref) <= self.TOL*Lsup(ref), "shared subexpressions in group resolve")
+        self.assertTrue(Lsup(other-c*2.) <= self.TOL*Lsup(ref), "shared subexpressions in group resolve")
+
+    def testLazyReductions(self):
+        dom = getTestDomainFunctionSpace(4,20,2).getDomain()
+        x=dom.getX()
+        a=(sin(x)+2.).delay()
+        b=cos(x)
+        res=trace(symmetric(outer(a*x,b)))*a-exp(a*x[0])
+        ref=trace(symmetric(outer(a*x,b)))*a-exp(a*x[0])
+        ref.resolve()
+        # reductions of lazy data do not resolve it
+        self.assertTrue(res.isLazy())
+        self.assertTrue(abs(Lsup(res)-Lsup(ref)) <= self.TOL*Lsup(ref), "lazy Lsup")
+        self.assertTrue(abs(sup(res)-sup(ref)) <= self.TOL*Lsup(ref), "lazy sup")
+        self.assertTrue(abs(inf(res)-inf(ref)) <= self.TOL*Lsup(ref), "lazy inf")
+        self.assertTrue(res.isLazy())
+
 if __name__ == '__main__':
     run_tests(__name__, exit_on_failure=True)
@@ -31,18 +31,17 @@ Test suite for linearPDEs class
 
 __author__="Lutz Gross, l.gross@uq.edu.au"
 
-from esys.escript.util import Lsup,kronecker,interpolate,whereZero, outer, swap_axes
+from esys.escript.util import Lsup,kronecker,interpolate,whereZero, outer, swap_axes, exp, length
 from esys.escript import Function,FunctionOnBoundary,FunctionOnContactZero,Solution,ReducedSolution,Vector,ContinuousFunction,Scalar, ReducedFunction,ReducedFunctionOnBoundary,ReducedFunctionOnContactZero,Data, Tensor4, Tensor, canInterpolate, getMPISizeWorld, hasFeature
 from esys.escript.linearPDEs import SolverBuddy, LinearPDE,IllegalCoefficientValue,Poisson, IllegalCoefficientFunctionSpace, TransportPDE, IllegalCoefficient, Helmholtz, LameEquation, SolverOptions
 import numpy
 import esys.escriptcore.utestselect as unittest
 
 mpisize = getMPISizeWorld()
-# skip_amg = hasFeature("paso") and mpisize > 1
-skip_amg = True
+skip_amg = hasFeature("paso") and mpisize > 1
 # Transport problems only work with paso
 no_paso = not hasFeature("paso")
-HAVE_DIRECT = hasFeature("trilinos") or hasFeature("umfpack") or hasFeature("mkl")
+HAVE_DIRECT = hasFeature("trilinos") or hasFeature("umfpack") or hasFeature("mkl") or hasFeature("paso")
 # PASO_DIRECT is only reported if we have paso and are running single rank
 CAN_USE_DIRECT = hasFeature("PASO_DIRECT") or hasFeature('trilinos')
 skip_muelu_long = False #no_paso and hasFeature("longindex")
@@ -411,6 +410,20 @@ class Test_LinearPDE_noLumping(Test_linearPDEs):
         sb.setSmoother(so.JACOBI)
         self.assertTrue(sb.getSmoother() == so.JACOBI, "Jacobi smoother is not set.")
 
+        self.assertTrue(sb.getSchwarzOverlap() == 1, "initial Schwarz overlap is wrong.")
+        self.assertRaises(ValueError,sb.setSchwarzOverlap,-1)
+        sb.setSchwarzOverlap(0)
+        self.assertTrue(sb.getSchwarzOverlap() == 0, "Schwarz overlap is wrong.")
+        sb.setSchwarzOverlap(2)
+        self.assertTrue(sb.getSchwarzOverlap() == 2, "Schwarz overlap is wrong.")
+
+        self.assertTrue(sb.getSchwarzLocalSolver() == so.ILU0, "initial Schwarz local solver is wrong.")
+        self.assertRaises(ValueError,sb.setSchwarzLocalSolver,so.JACOBI)
+        sb.setSchwarzLocalSolver(so.DIRECT)
+        self.assertTrue(sb.getSchwarzLocalSolver() == so.DIRECT, "direct Schwarz local solver is not set.")
+        sb.setSchwarzLocalSolver(so.ILU0)
+        self.assertTrue(sb.getSchwarzLocalSolver() == so.ILU0, "ILU0 Schwarz local solver is not set.")
+
         self.assertTrue(sb.getLevelMax() == 100, "initial LevelMax is wrong.")
         self.assertRaises(ValueError,sb.setLevelMax,-1)
         sb.setLevelMax(20)
@@ -486,6 +499,16 @@ class Test_LinearPDE_noLumping(Test_linearPDEs):
         sb.setTruncation(13)
         self.assertTrue(sb.getTruncation() == 13, "Truncation is wrong.")
 
+        self.assertTrue(sb.getCAGMRESStepSize() == 4, "initial CA-GMRES step size is wrong.")
+        self.assertRaises(ValueError,sb.setCAGMRESStepSize,0)
+        sb.setCAGMRESStepSize(6)
+        self.assertTrue(sb.getCAGMRESStepSize() == 6, "CA-GMRES step size is wrong.")
+
+        self.assertTrue(sb.getNumRecycledVectors() == 0, "initial number of recycled vectors is wrong.")
+        self.assertRaises(ValueError,sb.setNumRecycledVectors,-1)
+        sb.setNumRecycledVectors(8)
+        self.assertTrue(sb.getNumRecycledVectors() == 8, "number of recycled vectors is wrong.")
+
         self.assertTrue(sb.getRestart() == 0, "initial Truncation is wrong.")
         self.assertRaises(ValueError,sb.setTruncation,0)
         sb.setRestart(14)
@@ -532,6 +555,36 @@ class Test_LinearPDE_noLumping(Test_linearPDEs):
         self.assertTrue(sb.acceptConvergenceFailure(), "acceptConvergenceFailure (3) flag is wrong.")
         sb.setAcceptanceConvergenceFailure(accept=False)
         self.assertTrue(not sb.acceptConvergenceFailure(), "acceptConvergenceFailure (4) flag is wrong.")   
+
+        self.assertTrue(not sb.useSlicedEllpack(), "initial useSlicedEllpack flag is wrong.")
+        sb.setUseSlicedEllpackOn()
+        self.assertTrue(sb.useSlicedEllpack(), "useSlicedEllpack (1) flag is wrong.")
+        sb.setUseSlicedEllpackOff()
+        self.assertTrue(not sb.useSlicedEllpack(), "useSlicedEllpack (2) flag is wrong.")
+        sb.setUseSlicedEllpack(use=True)
+        self.assertTrue(sb.useSlicedEllpack(), "useSlicedEllpack (3) flag is wrong.")
+        sb.setUseSlicedEllpack(use=False)
+        self.assertTrue(not sb.useSlicedEllpack(), "useSlicedEllpack (4) flag is wrong.")
+
+        self.assertTrue(not sb.useMixedPrecision(), "initial useMixedPrecision flag is wrong.")
+        sb.setUseMixedPrecisionOn()
+        self.assertTrue(sb.useMixedPrecision(), "useMixedPrecision (1) flag is wrong.")
+        sb.setUseMixedPrecisionOff()
+        self.assertTrue(not sb.useMixedPrecision(), "useMixedPrecision (2) flag is wrong.")
+        sb.setUseMixedPrecision(use=True)
+        self.assertTrue(sb.useMixedPrecision(), "useMixedPrecision (3) flag is wrong.")
+        sb.setUseMixedPrecision(use=False)
+        self.assertTrue(not sb.useMixedPrecision(), "useMixedPrecision (4) flag is wrong.")
+
+        self.assertTrue(not sb.useMatrixFree(), "initial useMatrixFree flag is wrong.")
+        sb.setUseMatrixFreeOn()
+        self.assertTrue(sb.useMatrixFree(), "useMatrixFree (1) flag is wrong.")
+        sb.setUseMatrixFreeOff()
+        self.assertTrue(not sb.useMatrixFree(), "useMatrixFree (2) flag is wrong.")
+        sb.setUseMatrixFree(use=True)
+        self.assertTrue(sb.useMatrixFree(), "useMatrixFree (3) flag is wrong.")
+        sb.setUseMatrixFree(use=False)
+        self.assertTrue(not sb.useMatrixFree(), "useMatrixFree (4) flag is wrong.")
         
         self.assertTrue(sb.getReordering() == so.DEFAULT_REORDERING, "initial Reordering is wrong.")
         self.assertRaises(ValueError,sb.setReordering,-1)
@@ -541,6 +594,8 @@ class Test_LinearPDE_noLumping(Test_linearPDEs):
         self.assertTrue(sb.getReordering() == so.MINIMUM_FILL_IN, "MINIMUM_FILL_IN is not set.")
         sb.setReordering(so.NESTED_DISSECTION)
         self.assertTrue(sb.getReordering() == so.NESTED_DISSECTION, "NESTED_DISSECTION is not set.")
+        sb.setReordering(so.REVERSE_CUTHILL_MCKEE)
+        self.assertTrue(sb.getReordering() == so.REVERSE_CUTHILL_MCKEE, "REVERSE_CUTHILL_MCKEE is not set.")
         sb.setReordering(so.DEFAULT_REORDERING)
         self.assertTrue(sb.getReordering() == so.DEFAULT_REORDERING, "DEFAULT_REORDERING is not set.")
         
@@ -572,6 +627,8 @@ class Test_LinearPDE_noLumping(Test_linearPDEs):
         self.assertTrue(sb.getSolverMethod() == so.CHOLEVSKY, "CHOLEVSKY is not set.")
         sb.setSolverMethod(so.PCG)
         self.assertTrue(sb.getSolverMethod() == so.PCG, "PCG is not set.")
+        sb.setSolverMethod(so.PIPELINED_PCG)
+        self.assertTrue(sb.getSolverMethod() == so.PIPELINED_PCG, "PIPELINED_PCG is not set.")
         sb.setSolverMethod(so.CR)
         self.assertTrue(sb.getSolverMethod() == so.CR, "CR is not set.")
         sb.setSolverMethod(so.CGS)
@@ -580,6 +637,8 @@ class Test_LinearPDE_noLumping(Test_linearPDEs):
         self.assertTrue(sb.getSolverMethod() == so.BICGSTAB, "BICGSTAB is not set.")
         sb.setSolverMethod(so.GMRES)
         self.assertTrue(sb.getSolverMethod() == so.GMRES, "GMRES is not set.")
+        sb.setSolverMethod(so.CA_GMRES)
+        self.assertTrue(sb.getSolverMethod() == so.CA_GMRES, "CA_GMRES is not set.")
         sb.setSolverMethod(so.PRES20)
         self.assertTrue(sb.getSolverMethod() == so.PRES20, "PRES20 is not set.")
         sb.setSolverMethod(so.LUMPING)
@@ -616,6 +675,10 @@ class Test_LinearPDE_noLumping(Test_linearPDEs):
         self.assertTrue(sb.getPreconditioner() == so.RILU, "RILU is not set.")
         sb.setPreconditioner(so.AMLI)
         self.assertTrue(sb.getPreconditioner() == so.AMLI, "AMLI is not set.")
+        sb.setPreconditioner(so.CHEBYSHEV)
+        self.assertTrue(sb.getPreconditioner() == so.CHEBYSHEV, "CHEBYSHEV is not set.")
+        sb.setPreconditioner(so.SCHWARZ)
+        self.assertTrue(sb.getPreconditioner() == so.SCHWARZ, "SCHWARZ is not set.")
         sb.setPreconditioner(so.NO_PRECONDITIONER)
         self.assertTrue(sb.getPreconditioner() == so.NO_PRECONDITIONER, "NO_PRECONDITIONER is not set.")        
 
@@ -1746,6 +1809,59 @@ class Test_LinearPDE_noLumping(Test_linearPDEs):
             mypde.getSolverOptions().setVerbosity(self.VERBOSE)
             u=mypde.getSolution()
             self.assertTrue(self.check(u,1.),'solution is wrong.')
+    def test_PCG_JACOBI_SlicedEllpack(self):
+        mypde=LinearPDE(self.domain,debug=self.DEBUG)
+        mypde.setValue(A=kronecker(self.domain),D=1.,Y=1.)
+        mypde.getSolverOptions().setSolverMethod(SolverOptions.PCG)
+        mypde.getSolverOptions().setPreconditioner(SolverOptions.JACOBI)
+        mypde.getSolverOptions().setUseSlicedEllpack(True)
+        mypde.getSolverOptions().setVerbosity(self.VERBOSE)
+        u=mypde.getSolution()
+        self.assertTrue(self.check(u,1.),'solution is wrong.')
+    def test_PCG_JACOBI_MixedPrecision(self):
+        mypde=LinearPDE(self.domain,debug=self.DEBUG)
+        mypde.setValue(A=kronecker(self.domain),D=1.,Y=1.)
+        mypde.getSolverOptions().setSolverMethod(SolverOptions.PCG)
+        mypde.getSolverOptions().setPreconditioner(SolverOptions.JACOBI)
+        mypde.getSolverOptions().setUseMixedPrecision(True)
+        mypde.getSolverOptions().setVerbosity(self.VERBOSE)
+        u=mypde.getSolution()
+        self.assertTrue(self.check(u,1.),'solution is wrong.')
+    def test_PCG_JACOBI_MultipleRHS(self):
+        mypde=LinearPDE(self.domain,debug=self.DEBUG)
+        mypde.setValue(A=kronecker(self.domain),D=1.,Y=1.)
+        mypde.getSolverOptions().setSolverMethod(SolverOptions.PCG)
+        mypde.getSolverOptions().setPreconditioner(SolverOptions.JACOBI)
+        mypde.getSolverOptions().setVerbosity(self.VERBOSE)
+        mat,f=mypde.getSystem()
+        x=interpolate(self.domain.getX(),Solution(self.domain))
+        u_ex=[1.+x[0], x[0]*x[1], 0.*x[0], x[1]**2-2.]
+        u=mat.solveMultiple([mat.of(v) for v in u_ex],mypde.getSolverOptions())
+        self.assertEqual(len(u),4,'wrong number of solutions.')
+        self.assertTrue(self.check(u[0],u_ex[0]),'first solution is wrong.')
+        self.assertTrue(self.check(u[1],u_ex[1]),'second solution is wrong.')
+        self.assertTrue(Lsup(u[2])==0.,'third solution is wrong.')
+        self.assertTrue(self.check(u[3],u_ex[3]),'fourth solution is wrong.')
+    def test_PCG_JACOBI_Recycling(self):
+        mypde=LinearPDE(self.domain,debug=self.DEBUG)
+        mypde.setValue(A=kronecker(self.domain),D=1.,Y=1.)
+        mypde.getSolverOptions().setSolverMethod(SolverOptions.PCG)
+        mypde.getSolverOptions().setPreconditioner(SolverOptions.JACOBI)
+        mypde.getSolverOptions().setNumRecycledVectors(4)
+        mypde.getSolverOptions().setVerbosity(self.VERBOSE)
+        u=mypde.getSolution()
+        self.assertTrue(self.check(u,1.),'first solution is wrong.')
+        mypde.setValue(D=1.1,Y=2.2)
+        u=mypde.getSolution()
+        self.assertTrue(self.check(u,2.),'second solution is wrong.')
+    def test_PIPELINED_PCG_JACOBI(self):
+        mypde=LinearPDE(self.domain,debug=self.DEBUG)
+        mypde.setValue(A=kronecker(self.domain),D=1.,Y=1.)
+        mypde.getSolverOptions().setSolverMethod(SolverOptions.PIPELINED_PCG)
+        mypde.getSolverOptions().setPreconditioner(SolverOptions.JACOBI)
+        mypde.getSolverOptions().setVerbosity(self.VERBOSE)
+        u=mypde.getSolution()
+        self.assertTrue(self.check(u,1.),'solution is wrong.')
     def test_PCG_ILU0(self):
         mypde=LinearPDE(self.domain,debug=self.DEBUG)
         mypde.setValue(A=kronecker(self.domain),D=1.,Y=1.)
@@ -1754,6 +1870,15 @@ class Test_LinearPDE_noLumping(Test_linearPDEs):
         mypde.getSolverOptions().setVerbosity(self.VERBOSE)
         u=mypde.getSolution()
         self.assertTrue(self.check(u,1.),'solution is wrong.')
+    def test_PCG_ILU0_MixedPrecision(self):
+        mypde=LinearPDE(self.domain,debug=self.DEBUG)
+        mypde.setValue(A=kronecker(self.domain),D=1.,Y=1.)
+        mypde.getSolverOptions().setSolverMethod(SolverOptions.PCG)
+        mypde.getSolverOptions().setPreconditioner(SolverOptions.ILU0)
+        mypde.getSolverOptions().setUseMixedPrecision(True)
+        mypde.getSolverOptions().setVerbosity(self.VERBOSE)
+        u=mypde.getSolution()
+        self.assertTrue(self.check(u,1.),'solution is wrong.')
     def test_PCG_ILUT(self):
         mypde=LinearPDE(self.domain,debug=self.DEBUG)
         mypde.setValue(A=kronecker(self.domain),D=1.,Y=1.)
@@ -1787,6 +1912,27 @@ class Test_LinearPDE_noLumping(Test_linearPDEs):
         else:
             u=mypde.getSolution()
             self.assertTrue(self.check(u,1.),'solution is wrong.')
+    @unittest.skipIf(no_paso, "Paso not available")
+    def test_CHOLEVSKY_Paso(self):
+        mypde=LinearPDE(self.domain,debug=self.DEBUG)
+        mypde.setValue(A=kronecker(self.domain),D=1.,Y=1.)
+        mypde.setSymmetryOn()
+        mypde.getSolverOptions().setPackage(SolverOptions.PASO)
+        mypde.getSolverOptions().setSolverMethod(SolverOptions.CHOLEVSKY)
+        mypde.getSolverOptions().setVerbosity(self.VERBOSE)
+        u=mypde.getSolution()
+        self.assertTrue(self.check(u,1.),'solution is wrong.')
+    @unittest.skipIf(no_paso, "Paso not available")
+    def test_PCG_ILU0_REVERSE_CUTHILL_MCKEE(self):
+        mypde=LinearPDE(self.domain,debug=self.DEBUG)
+        mypde.setValue(A=kronecker(self.domain),D=1.,Y=1.)
+        mypde.getSolverOptions().setPackage(SolverOptions.PASO)
+        mypde.getSolverOptions().setSolverMethod(SolverOptions.PCG)
+        mypde.getSolverOptions().setPreconditioner(SolverOptions.ILU0)
+        mypde.getSolverOptions().setReordering(SolverOptions.REVERSE_CUTHILL_MCKEE)
+        mypde.getSolverOptions().setVerbosity(self.VERBOSE)
+        u=mypde.getSolution()
+        self.assertTrue(self.check(u,1.),'solution is wrong.')
 
     def test_BICGSTAB_JACOBI(self):
         mypde=LinearPDE(self.domain,debug=self.DEBUG)
@@ -2068,6 +2214,32 @@ class Test_LinearPDE_noLumping(Test_linearPDEs):
         mypde.getSolverOptions().setVerbosity(self.VERBOSE)
         u=mypde.getSolution()
         self.assertTrue(self.check(u,1.),'solution is wrong.')
+    def test_GMRES_JACOBI_MultipleRHS(self):
+        mypde=LinearPDE(self.domain,debug=self.DEBUG)
+        mypde.setValue(A=kronecker(self.domain),D=1.,Y=1.)
+        mypde.getSolverOptions().setSolverMethod(SolverOptions.GMRES)
+        mypde.getSolverOptions().setPreconditioner(SolverOptions.JACOBI)
+        mypde.getSolverOptions().setVerbosity(self.VERBOSE)
+        mat,f=mypde.getSystem()
+        x=interpolate(self.domain.getX(),Solution(self.domain))
+        u_ex=[1.+x[0], x[0]*x[1], x[1]**2-2.]
+        u=mat.solveMultiple([mat.of(v) for v in u_ex],mypde.getSolverOptions())
+        self.assertEqual(len(u),3,'wrong number of solutions.')
+        self.assertTrue(self.check(u[0],u_ex[0]),'first solution is wrong.')
+        self.assertTrue(self.check(u[1],u_ex[1]),'second solution is wrong.')
+        self.assertTrue(self.check(u[2],u_ex[2]),'third solution is wrong.')
+    def test_GMRES_JACOBI_Recycling(self):
+        mypde=LinearPDE(self.domain,debug=self.DEBUG)
+        mypde.setValue(A=kronecker(self.domain),D=1.,Y=1.)
+        mypde.getSolverOptions().setSolverMethod(SolverOptions.GMRES)
+        mypde.getSolverOptions().setPreconditioner(SolverOptions.JACOBI)
+        mypde.getSolverOptions().setNumRecycledVectors(4)
+        mypde.getSolverOptions().setVerbosity(self.VERBOSE)
+        u=mypde.getSolution()
+        self.assertTrue(self.check(u,1.),'first solution is wrong.')
+        mypde.setValue(D=1.1,Y=2.2)
+        u=mypde.getSolution()
+        self.assertTrue(self.check(u,2.),'second solution is wrong.')
     def test_GMRES_GAUSS_SEIDEL(self):
         mypde=LinearPDE(self.domain,debug=self.DEBUG)
         mypde.setValue(A=kronecker(self.domain),D=1.,Y=1.)
@@ -2113,6 +2285,24 @@ class Test_LinearPDE_noLumping(Test_linearPDEs):
         mypde.getSolverOptions().setVerbosity(self.VERBOSE)
         u=mypde.getSolution()
         self.assertTrue(self.check(u,1.),'solution is wrong.')
+    def test_CA_GMRES_JACOBI(self):
+        mypde=LinearPDE(self.domain,debug=self.DEBUG)
+        mypde.setValue(A=kronecker(self.domain),D=1.,Y=1.)
+        mypde.getSolverOptions().setSolverMethod(SolverOptions.CA_GMRES)
+        mypde.getSolverOptions().setPreconditioner(SolverOptions.JACOBI)
+        mypde.getSolverOptions().setVerbosity(self.VERBOSE)
+        u=mypde.getSolution()
+        self.assertTrue(self.check(u,1.),'solution is wrong.')
+    def test_CA_GMRES_step_size_ILU0(self):
+        mypde=LinearPDE(self.domain,debug=self.DEBUG)
+        mypde.setValue(A=kronecker(self.domain),D=1.,Y=1.)
+        mypde.getSolverOptions().setSolverMethod(SolverOptions.CA_GMRES)
+        mypde.getSolverOptions().setPreconditioner(SolverOptions.ILU0)
+        mypde.getSolverOptions().setVerbosity(self.VERBOSE)
+        mypde.getSolverOptions().setCAGMRESStepSize(6)
+        mypde.getSolverOptions().setTruncation(12)
+        u=mypde.getSolution()
+        self.assertTrue(self.check(u,1.),'solution is wrong.')
     def test_GMRES_truncation_restart_JACOBI(self):
         mypde=LinearPDE(self.domain,debug=self.DEBUG)
         mypde.setValue(A=kronecker(self.domain),D=1.,Y=1.)
@@ -2210,6 +2400,22 @@ class Test_LinearPDE_noLumping(Test_linearPDEs):
         mypde.getSolverOptions().setVerbosity(self.VERBOSE)
         u=mypde.getSolution()
         self.assertTrue(self.check(u,1.),'solution is wrong.')
+    def test_PCG_JACOBI_SlicedEllpack_System(self):
+        A=Tensor4(0.,Function(self.domain))
+        D=Tensor(1.,Function(self.domain))
+        Y=Vector(self.domain.getDim(),Function(self.domain))
+        for i in range(self.domain.getDim()): 
+            A[i,:,i,:]=kronecker(self.domain)
+            D[i,i]+=i
+            Y[i]+=i
+        mypde=LinearPDE(self.domain,debug=self.DEBUG)
+        mypde.setValue(A=A,D=D,Y=Y)
+        mypde.getSolverOptions().setSolverMethod(SolverOptions.PCG)
+        mypde.getSolverOptions().setPreconditioner(SolverOptions.JACOBI)
+        mypde.getSolverOptions().setUseSlicedEllpack(True)
+        mypde.getSolverOptions().setVerbosity(self.VERBOSE)
+        u=mypde.getSolution()
+        self.assertTrue(self.check(u,1.),'solution is wrong.')
     def test_PCG_GAUSS_SEIDEL_System(self):
         A=Tensor4(0.,Function(self.domain))
         D=Tensor(1.,Function(self.domain))
@@ -2260,6 +2466,35 @@ class Test_LinearPDE_noLumping(Test_linearPDEs):
         mypde.getSolverOptions().setVerbosity(self.VERBOSE)
         u=mypde.getSolution()
         self.assertTrue(self.check(u,1.),'solution is wrong.')
+    def test_PCG_JACOBI_MixedPrecision_System5(self):
+        mypde=self.getCoupledSystem(5)
+        mypde.getSolverOptions().setSolverMethod(SolverOptions.PCG)
+        mypde.getSolverOptions().setPreconditioner(SolverOptions.JACOBI)
+        mypde.getSolverOptions().setUseMixedPrecision(True)
+        mypde.getSolverOptions().setVerbosity(self.VERBOSE)
+        u=mypde.getSolution()
+        self.assertTrue(self.check(u,1.),'solution is wrong.')
+    def test_PCG_ILU0_MixedPrecision_System5(self):
+        mypde=self.getCoupledSystem(5)
+        mypde.getSolverOptions().setSolverMethod(SolverOptions.PCG)
+        mypde.getSolverOptions().setPreconditioner(SolverOptions.ILU0)
+        mypde.getSolverOptions().setUseMixedPrecision(True)
+        mypde.getSolverOptions().setVerbosity(self.VERBOSE)
+        u=mypde.getSolution()
+        self.assertTrue(self.check(u,1.),'solution is wrong.')
+    def getCoupledSystem(self, n):
+        # n components coupled through D so that the diagonal blocks are
+        # dense n x n blocks, the solution is 1 in all components
+        A=Data(0.,(n,self.domain.getDim(),n,self.domain.getDim()),Function(self.domain))
+        D=Data(-0.1,(n,n),Function(self.domain))
+        Y=Data(0.,(n,),Function(self.domain))
+        for i in range(n):
+            A[i,:,i,:]=kronecker(self.domain)
+            D[i,i]=1.+i
+            Y[i]=1.+i-0.1*(n-1)
+        mypde=LinearPDE(self.domain,numEquations=n,numSolutions=n,debug=self.DEBUG)
+        mypde.setValue(A=A,D=D,Y=Y)
+        return mypde
     def test_DIRECT_System(self):
         A=Tensor4(0.,Function(self.domain))
         D=Tensor(1.,Function(self.domain))
@@ -3816,6 +4051,45 @@ class Test_TransportPDE(Test_linearPDEs):
         self.assertTrue(u.getFunctionSpace() == ReducedSolution(self.domain), "wrong function space")
         self.assertTrue(self.check(u,10.+dt),'solution is wrong.')
 
+    @unittest.skipIf(no_paso, "Transport PDEs require Paso")
+    def test_reducedOn_System(self):
+        dt=0.1
+        mypde=TransportPDE(self.domain,numSolutions=2,debug=self.DEBUG)
+        mypde.setReducedOrderOn()
+        mypde.setInitialSolution([10.,20.])
+        mypde.setValue(M=kronecker(2),Y=[1.,2.])
+        u=mypde.getSolution(dt)
+        self.assertTrue(u.getFunctionSpace() == ReducedSolution(self.domain), "wrong function space")
+        self.assertTrue(self.check(u,numpy.array([10.+dt,20.+2*dt])),'solution is wrong.')
+
+    @unittest.skipIf(no_paso, "Transport PDEs require Paso")
+    def test_System_AC_vs_Scalar(self):
+        # two uncoupled components with different advection and diffusion
+        # have to give the same result as two scalar problems
+        dt=0.1
+        d=self.domain.getDim()
+        x=self.domain.getX()
+        u0=[exp(-20.*length(x-0.3)**2), 1.+x[0]*x[d-1]]
+        v=[numpy.zeros((d,)), numpy.zeros((d,))]
+        v[0][0]=1.
+        v[1][d-1]=-0.5
+        a=[0.01, 0.02]
+        A=numpy.zeros((2,d,2,d))
+        C=numpy.zeros((2,2,d))
+        for i in range(2):
+            A[i,:,i,:]=a[i]*numpy.eye(d)
+            C[i,i,:]=v[i]
+        mypde=TransportPDE(self.domain,numSolutions=2,debug=self.DEBUG)
+        mypde.setInitialSolution(u0[0]*numpy.array([1.,0.])+u0[1]*numpy.array([0.,1.]))
+        mypde.setValue(M=kronecker(2),A=A,C=C)
+        u=mypde.getSolution(dt)
+        for i in range(2):
+            mypde=TransportPDE(self.domain,numSolutions=1,debug=self.DEBUG)
+            mypde.setInitialSolution(u0[i])
+            mypde.setValue(M=1.,A=a[i]*kronecker(d),C=v[i])
+            u_i=mypde.getSolution(dt)
+            self.assertTrue(self.check(u[i],u_i),'component %d is wrong.'%i)
+
     def Off_test_reducedOff(self):
         dt=0.1
         mypde=TransportPDE(self.domain,numSolutions=1,debug=self.DEBUG)
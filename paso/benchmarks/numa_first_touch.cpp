@@ -0,0 +1,223 @@
+/*****************************************************************************
+*
+* Copyright (c) 2003-2018 by The University of Queensland
+* http://www.uq.edu.au
+*
+* Primary Business: Queensland, Australia
+* Licensed under the Apache License, version 2.0
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Development until 2012 by Earth Systems Science Computational Center (ESSCC)
+* Development 2012-2013 by School of Earth Sciences
+* Development from 2014 by Centre for Geoscience Computing (GeoComp)
+*
+*****************************************************************************/
+
+
+/****************************************************************************/
+
+/* Paso: benchmark for the NUMA placement of matrices and vectors            */
+
+/*  The 7-point Laplacian of a NX x NX x NX hexahedral grid with block size  */
+/*  B is set up twice: once with all arrays initialized by the master thread */
+/*  (so all pages are placed on its NUMA node) and once through the          */
+/*  first-touch path of paso (util::newIndexVector, util::newVector and the  */
+/*  SparseMatrix constructor). For both the time of the matrix-vector        */
+/*  product and the memory bandwidth achieved by the threads of each NUMA    */
+/*  node in a vector triad on their stripes are reported. Threads should be  */
+/*  pinned, e.g. OMP_PROC_BIND=spread OMP_PLACES=cores.                      */
+/*                                                                            */
+/*  Build against an installed escript, e.g.                                 */
+/*    g++ -fopenmp -O2 -I$ESCRIPT/include numa_first_touch.cpp \            */
+/*        -L$ESCRIPT/lib -lpaso -lescript -o numa_first_touch                */
+/*  and run as                                                               */
+/*    OMP_NUM_THREADS=32 OMP_PROC_BIND=spread ./numa_first_touch [NX [B]]    */
+
+/****************************************************************************/
+
+#include <paso/PasoUtil.h>
+#include <paso/SparseMatrix.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <sched.h>
+#endif
+
+using namespace paso;
+
+#define NUM_REPEATS 20
+
+/// returns the NUMA node of the CPU the calling thread runs on
+int getNumaNode()
+{
+#ifdef __linux__
+    const int cpu=sched_getcpu();
+    if (cpu >= 0) {
+        char path[64];
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+        DIR* dir=opendir(path);
+        if (dir != NULL) {
+            int node=-1;
+            struct dirent* entry;
+            while (node < 0 && (entry=readdir(dir)) != NULL) {
+                if (strncmp(entry->d_name, "node", 4) == 0)
+                    node=atoi(entry->d_name+4);
+            }
+            closedir(dir);
+            if (node >= 0)
+                return node;
+        }
+    }
+#endif
+    return 0;
+}
+
+/// 7-point Laplacian on a nx^3 grid. If firstTouch is set the arrays are
+/// touched by row stripes, otherwise by the master thread only.
+SparseMatrix_ptr makeLaplacian(dim_t nx, dim_t b, bool firstTouch)
+{
+    const dim_t n=nx*nx*nx;
+    index_t* ptr;
+    if (firstTouch) {
+        ptr=util::newIndexVector(n+1);
+    } else {
+        ptr=new index_t[n+1];
+        ptr[0]=0;
+    }
+    for (index_t row=0; row<n; ++row) {
+        const index_t i=row%nx, j=(row/nx)%nx, k=row/(nx*nx);
+        ptr[row+1]=ptr[row]+1+(i>0)+(i<nx-1)+(j>0)+(j<nx-1)+(k>0)+(k<nx-1);
+    }
+    index_t* index=new index_t[ptr[n]];
+#pragma omp parallel for schedule(static) if (firstTouch)
+    for (index_t row=0; row<n; ++row) {
+        const index_t i=row%nx, j=(row/nx)%nx, k=row/(nx*nx);
+        index_t iptr=ptr[row];
+        if (k>0) index[iptr++]=row-nx*nx;
+        if (j>0) index[iptr++]=row-nx;
+        if (i>0) index[iptr++]=row-1;
+        index[iptr++]=row;
+        if (i<nx-1) index[iptr++]=row+1;
+        if (j<nx-1) index[iptr++]=row+nx;
+        if (k<nx-1) index[iptr++]=row+nx*nx;
+    }
+    Pattern_ptr pattern(new Pattern(MATRIX_FORMAT_DEFAULT, n, n, ptr, index));
+    SparseMatrix_ptr A(new SparseMatrix(MATRIX_FORMAT_DEFAULT, pattern, b, b,
+                                        false));
+    if (!firstTouch) {
+        // replace the values by a copy placed by the master thread
+        delete[] A->val;
+        A->val=new double[A->len];
+        memset(A->val, 0, A->len*sizeof(double));
+    }
+#pragma omp parallel for schedule(static)
+    for (index_t row=0; row<n; ++row) {
+        for (index_t iptr=ptr[row]; iptr<ptr[row+1]; ++iptr) {
+            double* a=&A->val[iptr*b*b];
+            for (dim_t c=0; c<b; ++c)
+                a[c+b*c]=(index[iptr]==row) ? 6.+c : -1.;
+        }
+    }
+    return A;
+}
+
+/// returns a vector of length n placed by stripes or by the master thread
+double* makeVector(dim_t n, bool firstTouch)
+{
+    if (firstTouch)
+        return util::newVector(n);
+    double* x=new double[n];
+    memset(x, 0, n*sizeof(double));
+    return x;
+}
+
+/// runs the vector triad a=b+s*c on the thread stripes and returns the
+/// bandwidth in GB/s achieved by the threads of each NUMA node
+std::vector<double> triadBandwidth(dim_t n, double* a, const double* b,
+                                   const double* c)
+{
+#ifdef _OPENMP
+    const int num_threads=omp_get_max_threads();
+#else
+    const int num_threads=1;
+#endif
+    std::vector<int> node(num_threads);
+    std::vector<double> bw(num_threads);
+#pragma omp parallel for schedule(static)
+    for (int t=0; t<num_threads; ++t) {
+        const dim_t local_n=n/num_threads;
+        const dim_t rest=n-local_n*num_threads;
+        const dim_t n_start=local_n*t+std::min<dim_t>(t,rest);
+        const dim_t n_end=local_n*(t+1)+std::min<dim_t>(t+1,rest);
+        node[t]=getNumaNode();
+        const double t0=escript::gettime();
+        for (int r=0; r<NUM_REPEATS; ++r) {
+            #pragma ivdep
+            for (dim_t q=n_start; q<n_end; ++q)
+                a[q]=b[q]+1.0001*c[q];
+        }
+        const double time=escript::gettime()-t0;
+        bw[t]=3.*sizeof(double)*(n_end-n_start)*NUM_REPEATS/time*1.e-9;
+    }
+    std::vector<double> out;
+    for (int t=0; t<num_threads; ++t) {
+        if (node[t] >= (int)out.size())
+            out.resize(node[t]+1, 0.);
+        out[node[t]]+=bw[t];
+    }
+    return out;
+}
+
+int main(int argc, char** argv)
+{
+    const dim_t nx=(argc>1) ? atoi(argv[1]) : 100;
+    const dim_t b=(argc>2) ? atoi(argv[2]) : 1;
+    const dim_t n=nx*nx*nx*b;
+
+#ifdef _OPENMP
+    const int nt=omp_get_max_threads();
+#else
+    const int nt=1;
+#endif
+    printf("grid %d^3, block size %d, %d unknowns, %d threads\n",
+           (int)nx, (int)b, (int)n, nt);
+    const char* names[]={ "master thread", "first touch" };
+    for (int v=0; v<2; ++v) {
+        const bool firstTouch=(v==1);
+        SparseMatrix_ptr A(makeLaplacian(nx, b, firstTouch));
+        double* x=makeVector(n, firstTouch);
+        double* y=makeVector(n, firstTouch);
+        double* z=makeVector(n, firstTouch);
+        for (dim_t i=0; i<n; ++i)
+            x[i]=1.;
+
+        // matrix-vector product: values, column indices, row pointers,
+        // the result and (at least once) the input vector are streamed
+        SparseMatrix_MatrixVector_CSR_OFFSET0(1., A, x, 0., y);
+        double t0=escript::gettime();
+        for (int r=0; r<NUM_REPEATS; ++r)
+            SparseMatrix_MatrixVector_CSR_OFFSET0(1., A, x, 0., y);
+        const double time=(escript::gettime()-t0)/NUM_REPEATS;
+        const double bytes=A->len*sizeof(double)
+                          +A->pattern->len*sizeof(index_t)
+                          +(A->numRows+1)*sizeof(index_t)
+                          +2.*n*sizeof(double);
+        printf("%-14s MV %12.6e s %8.2f GB/s", names[v], time,
+               bytes/time*1.e-9);
+
+        const std::vector<double> bw(triadBandwidth(n, z, x, y));
+        for (size_t s=0; s<bw.size(); ++s)
+            printf("  node %d: %8.2f GB/s", (int)s, bw[s]);
+        printf("\n");
+        delete[] x;
+        delete[] y;
+        delete[] z;
+    }
+    return 0;
+}
@@ -0,0 +1,155 @@
+
+/*****************************************************************************
+*
+* Copyright (c) 2003-2018 by The University of Queensland
+* http://www.uq.edu.au
+*
+* Primary Business: Queensland, Australia
+* Licensed under the Apache License, version 2.0
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Development until 2012 by Earth Systems Science Computational Center (ESSCC)
+* Development 2012-2013 by School of Earth Sciences
+* Development from 2014 by Centre for Geoscience Computing (GeoComp)
+*
+*****************************************************************************/
+
+
+/****************************************************************************/
+
+/* Paso: benchmark for the local Gauss-Seidel sweeps                         */
+
+/*  Compares the sequential, tiled and colored Gauss-Seidel sweeps on the    */
+/*  7-point Laplacian of a NX x NX x NX hexahedral grid with block size B.  */
+/*  For each variant the time per sweep and the reduction of the residual    */
+/*  after a fixed number of smoothing steps are reported.                    */
+/*                                                                            */
+/*  Build against an installed escript, e.g.                                 */
+/*    g++ -fopenmp -O2 -I$ESCRIPT/include smoother_sweeps.cpp \             */
+/*        -L$ESCRIPT/lib -lpaso -lescript -o smoother_sweeps                 */
+/*  and run as                                                               */
+/*    OMP_NUM_THREADS=4 ./smoother_sweeps [NX [B [SWEEPS]]]                  */
+
+/****************************************************************************/
+
+#include <paso/PasoUtil.h>
+#include <paso/Preconditioner.h>
+#include <paso/SparseMatrix.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace paso;
+
+typedef void (*SweepFunction)(SparseMatrix_ptr, Preconditioner_LocalSmoother*,
+                              double*);
+
+/// 7-point Laplacian on a nx^3 grid, coupling each component of a block
+/// with the same component of the neighbours
+SparseMatrix_ptr makeLaplacian(dim_t nx, dim_t b)
+{
+    const dim_t n=nx*nx*nx;
+    index_t* ptr=new index_t[n+1];
+    index_t* index=new index_t[7*n];
+    dim_t nnz=0;
+    for (dim_t k=0; k<nx; ++k) {
+        for (dim_t j=0; j<nx; ++j) {
+            for (dim_t i=0; i<nx; ++i) {
+                const index_t row=i+nx*(j+nx*k);
+                ptr[row]=nnz;
+                if (k>0) index[nnz++]=row-nx*nx;
+                if (j>0) index[nnz++]=row-nx;
+                if (i>0) index[nnz++]=row-1;
+                index[nnz++]=row;
+                if (i<nx-1) index[nnz++]=row+1;
+                if (j<nx-1) index[nnz++]=row+nx;
+                if (k<nx-1) index[nnz++]=row+nx*nx;
+            }
+        }
+    }
+    ptr[n]=nnz;
+    Pattern_ptr pattern(new Pattern(MATRIX_FORMAT_DEFAULT, n, n, ptr, index));
+    SparseMatrix_ptr A(new SparseMatrix(MATRIX_FORMAT_DEFAULT, pattern, b, b,
+                                        false));
+    A->setValues(0.);
+    for (index_t row=0; row<n; ++row) {
+        for (index_t iptr=ptr[row]; iptr<ptr[row+1]; ++iptr) {
+            double* a=&A->val[iptr*b*b];
+            for (dim_t c=0; c<b; ++c)
+                a[c+b*c]=(index[iptr]==row) ? 6.+c : -1.;
+        }
+    }
+    return A;
+}
+
+/// runs `sweeps` steps of x <- x + S^{-1} (rhs - A x) and returns the
+/// time spent in the sweeps and the final relative residual
+void runSmoother(SparseMatrix_ptr A, Preconditioner_LocalSmoother* smoother,
+                 SweepFunction sweep, dim_t sweeps, double* time,
+                 double* reduction)
+{
+    const dim_t n=A->numRows*A->row_block_size;
+    double* x=new double[n];
+    double* r=new double[n];
+    double* rhs=new double[n];
+    for (dim_t i=0; i<n; ++i) {
+        x[i]=0.;
+        rhs[i]=1.;
+    }
+    double norm_rhs=std::sqrt((double)n);
+    *time=0.;
+    for (dim_t s=0; s<sweeps; ++s) {
+        util::copy(n, r, rhs);
+        SparseMatrix_MatrixVector_CSR_OFFSET0(-1., A, x, 1., r);
+        double t0=escript::gettime();
+        sweep(A, smoother, r);
+        *time+=escript::gettime()-t0;
+        util::update(n, 1., x, 1., r);
+    }
+    util::copy(n, r, rhs);
+    SparseMatrix_MatrixVector_CSR_OFFSET0(-1., A, x, 1., r);
+    double norm_r=0.;
+    for (dim_t i=0; i<n; ++i)
+        norm_r+=r[i]*r[i];
+    *reduction=std::sqrt(norm_r)/norm_rhs;
+    delete[] x;
+    delete[] r;
+    delete[] rhs;
+}
+
+int main(int argc, char** argv)
+{
+    const dim_t nx=(argc>1) ? atoi(argv[1]) : 60;
+    const dim_t b=(argc>2) ? atoi(argv[2]) : 1;
+    const dim_t sweeps=(argc>3) ? atoi(argv[3]) : 20;
+
+    SparseMatrix_ptr A(makeLaplacian(nx, b));
+    Preconditioner_LocalSmoother* smoother=
+                        Preconditioner_LocalSmoother_alloc(A, false, false, false);
+    // make sure the coloring is not accounted to the colored sweep
+    A->pattern->borrowColoringPointer();
+
+    const char* names[]={ "sequential", "tiled", "colored" };
+    SweepFunction sweepFunctions[]={
+            Preconditioner_LocalSmoother_Sweep_sequential,
+            Preconditioner_LocalSmoother_Sweep_tiled,
+            Preconditioner_LocalSmoother_Sweep_colored };
+
+#ifdef _OPENMP
+    const int nt=omp_get_max_threads();
+#else
+    const int nt=1;
+#endif
+    printf("grid %d^3, block size %d, %d unknowns, %d threads, %d sweeps\n",
+           (int)nx, (int)b, (int)(nx*nx*nx*b), nt, (int)sweeps);
+    printf("%-12s %16s %16s\n", "sweep", "time/sweep [s]", "residual");
+    for (int v=0; v<3; ++v) {
+        double time, reduction;
+        runSmoother(A, smoother, sweepFunctions[v], sweeps, &time, &reduction);
+        printf("%-12s %16.6e %16.6e\n", names[v], time/sweeps, reduction);
+    }
+    Preconditioner_LocalSmoother_free(smoother);
+    return 0;
+}
+
@@ -0,0 +1,954 @@
+
+/*****************************************************************************
+*
+* Copyright (c) 2003-2018 by The University of Queensland
+* http://www.uq.edu.au
+*
+* Primary Business: Queensland, Australia
+* Licensed under the Apache License, version 2.0
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Development until 2012 by Earth Systems Science Computational Center (ESSCC)
+* Development 2012-2013 by School of Earth Sciences
+* Development from 2014 by Centre for Geoscience Computing (GeoComp)
+*
+*****************************************************************************/
+
+
+/****************************************************************************/
+
+/* Paso: AMG preconditioner (MPI version)                                   */
+
+/****************************************************************************/
+
+/*
+   The hierarchy is built level by level:
+
+   (1) strong connections are identified on the main block of A
+       (|a_ij| >= theta * max_k |a_ik|), rows which are diagonally dominant
+       by more than the diagonal dominance threshold are eliminated,
+   (2) the C-points are given as a maximal independent set of the
+       (symmetrized) strength graph using Pattern::mis,
+   (3) the prolongation P is built using direct or classical interpolation
+       from C-points on the same rank (MATRIX_FORMAT_DIAGONAL_BLOCK),
+   (4) the coarse level operator is the Galerkin product R*A*P with R=P^T.
+       The coupling to other ranks is obtained by exchanging the rows of P
+       for the overlap and forming R*(A_couple*P_ghost).
+
+   On the coarsest level the supernodal direct solver is used on a single
+   rank. With MPI a dense LU factorization of the gathered matrix is used if
+   it is small enough, otherwise a few smoother sweeps.
+*/
+
+#include "Preconditioner.h"
+#include "Options.h"
+#include "PasoException.h"
+#include "PasoUtil.h"
+#include "Supernodal.h"
+
+#include <escript/FunctionSpace.h>
+
+#include <cstring> // memcpy
+#include <vector>
+
+namespace paso {
+
+// maximum number of unknowns for the dense direct solver on the coarsest level
+#define PASO_AMG_MAX_DIRECT_SIZE 2000
+
+// coarsening is stopped if the relative reduction is less than this
+#define PASO_AMG_MIN_REDUCTION 0.1
+
+#define AMG_IS_ELIMINATED -2
+#define AMG_IS_AVAILABLE -1
+#define AMG_IS_F 0
+#define AMG_IS_C 1
+
+void Preconditioner_AMG_free(Preconditioner_AMG* in)
+{
+    if (in != NULL) {
+        Preconditioner_AMG_free(in->AMG_C);
+        Preconditioner_Smoother_free(in->Smoother);
+        delete[] in->r;
+        delete[] in->x_C;
+        delete[] in->b_C;
+        delete[] in->lu;
+        delete[] in->lu_pivot;
+        delete[] in->lu_buffer;
+        delete[] in->lu_counts;
+        delete[] in->lu_offsets;
+        // the symbolic factorization is kept with the matrix
+        Supernodal_freeNumeric(in->A_direct.get());
+        delete in;
+    }
+}
+
+/// returns the distance of two diagonal entries within a block
+static inline dim_t getDiagonalStride(const_SparseMatrix_ptr A)
+{
+    return (A->block_size == A->row_block_size) ? 1 : A->row_block_size+1;
+}
+
+/// returns the Frobenius norm of a block
+static inline double getBlockNorm(dim_t block_size, const double* block)
+{
+    double s = 0.;
+    for (dim_t k = 0; k < block_size; ++k)
+        s += block[k]*block[k];
+    return sqrt(s);
+}
+
+/*
+   Identifies the strong connections in the main block of A and marks
+   diagonally dominant rows as eliminated. On return S_ptr/S_pos hold for
+   each row the positions of strong connections within A->mainBlock (the
+   strong connections to other ranks are ignored).
+*/
+static void Preconditioner_AMG_setStrongConnections(SystemMatrix_ptr A,
+                    double theta, double tau, index_t* split,
+                    index_t* S_ptr, index_t** S_pos)
+{
+    const_SparseMatrix_ptr main(A->mainBlock);
+    const_SparseMatrix_ptr couple(A->col_coupleBlock);
+    const dim_t n = main->numRows;
+    const dim_t block_size = main->block_size;
+    const bool has_couple = (couple->pattern->ptr != NULL);
+    double* threshold = new double[n];
+
+#pragma omp parallel for
+    for (index_t i = 0; i < n; ++i) {
+        double diag = 0., max_offdiag = 0., sum_offdiag = 0.;
+        for (index_t iptr = main->pattern->ptr[i]; iptr < main->pattern->ptr[i+1]; ++iptr) {
+            const double m = getBlockNorm(block_size, &main->val[iptr*block_size]);
+            if (main->pattern->index[iptr] == i) {
+                diag = m;
+            } else {
+                max_offdiag = std::max(max_offdiag, m);
+                sum_offdiag += m;
+            }
+        }
+        if (has_couple) {
+            for (index_t iptr = couple->pattern->ptr[i]; iptr < couple->pattern->ptr[i+1]; ++iptr) {
+                const double m = getBlockNorm(block_size, &couple->val[iptr*block_size]);
+                max_offdiag = std::max(max_offdiag, m);
+                sum_offdiag += m;
+            }
+        }
+        if (sum_offdiag > tau * diag) {
+            split[i] = AMG_IS_AVAILABLE;
+            threshold[i] = theta * max_offdiag;
+        } else {
+            split[i] = AMG_IS_ELIMINATED;
+            threshold[i] = -1.;
+        }
+        S_ptr[i] = 0;
+        if (split[i] == AMG_IS_AVAILABLE) {
+            for (index_t iptr = main->pattern->ptr[i]; iptr < main->pattern->ptr[i+1]; ++iptr) {
+                if (main->pattern->index[iptr] != i && getBlockNorm(block_size,
+                            &main->val[iptr*block_size]) >= threshold[i])
+                    S_ptr[i]++;
+            }
+        }
+    }
+    S_ptr[n] = util::cumsum(n, S_ptr);
+    *S_pos = new index_t[S_ptr[n]];
+#pragma omp parallel for
+    for (index_t i = 0; i < n; ++i) {
+        if (split[i] == AMG_IS_AVAILABLE) {
+            index_t k = S_ptr[i];
+            for (index_t iptr = main->pattern->ptr[i]; iptr < main->pattern->ptr[i+1]; ++iptr) {
+                if (main->pattern->index[iptr] != i && getBlockNorm(block_size,
+                            &main->val[iptr*block_size]) >= threshold[i])
+                    (*S_pos)[k++] = iptr;
+            }
+        }
+    }
+    delete[] threshold;
+}
+
+/*
+   Selects the C-points as a maximal independent set of the symmetrized
+   strength graph. F-points without a strong connection to a C-point are
+   added to the C-points. Returns the number of C-points.
+*/
+static dim_t Preconditioner_AMG_selectCoarse(const_SparseMatrix_ptr main,
+                    index_t* split, const index_t* S_ptr, const index_t* S_pos)
+{
+    const dim_t n = main->numRows;
+    const index_t* index = main->pattern->index;
+
+    // S + S^T (duplicates are harmless for the MIS)
+    index_t* G_ptr = new index_t[n+1];
+    for (index_t i = 0; i < n; ++i)
+        G_ptr[i] = 0;
+    for (index_t i = 0; i < n; ++i) {
+        G_ptr[i] += S_ptr[i+1]-S_ptr[i];
+        for (index_t iptr = S_ptr[i]; iptr < S_ptr[i+1]; ++iptr)
+            G_ptr[index[S_pos[iptr]]]++;
+    }
+    const index_t s = util::cumsum(n, G_ptr);
+    G_ptr[n] = s;
+    index_t* G_idx = new index_t[s];
+    index_t* fill = new index_t[n];
+    for (index_t i = 0; i < n; ++i)
+        fill[i] = G_ptr[i];
+    for (index_t i = 0; i < n; ++i) {
+        for (index_t iptr = S_ptr[i]; iptr < S_ptr[i+1]; ++iptr) {
+            const index_t j = index[S_pos[iptr]];
+            G_idx[fill[i]++] = j;
+            G_idx[fill[j]++] = i;
+        }
+    }
+    delete[] fill;
+    Pattern_ptr G(new Pattern(MATRIX_FORMAT_DEFAULT, n, n, G_ptr, G_idx));
+
+    index_t* mis_marker = new index_t[n];
+#pragma omp parallel for
+    for (index_t i = 0; i < n; ++i)
+        mis_marker[i] = (split[i] == AMG_IS_AVAILABLE) ? -1 : 0;
+    G->mis(mis_marker);
+
+    for (index_t i = 0; i < n; ++i) {
+        if (split[i] == AMG_IS_AVAILABLE)
+            split[i] = mis_marker[i] ? AMG_IS_C : AMG_IS_F;
+    }
+    delete[] mis_marker;
+
+    // make sure that each F-point has a strong C neighbour
+    dim_t n_C = 0;
+    for (index_t i = 0; i < n; ++i) {
+        if (split[i] == AMG_IS_F) {
+            bool found = false;
+            for (index_t iptr = S_ptr[i]; iptr < S_ptr[i+1]; ++iptr) {
+                if (split[index[S_pos[iptr]]] == AMG_IS_C) {
+                    found = true;
+                    break;
+                }
+            }
+            if (!found)
+                split[i] = AMG_IS_C;
+        }
+        if (split[i] == AMG_IS_C)
+            n_C++;
+    }
+    return n_C;
+}
+
+/*
+   Builds the prolongation operator from the C/F splitting. For each
+   component of the block the diagonal entries of the blocks are used.
+   P is returned in MATRIX_FORMAT_DIAGONAL_BLOCK format.
+*/
+static SparseMatrix_ptr Preconditioner_AMG_getProlongation(SystemMatrix_ptr A,
+                    const index_t* split, const index_t* coarse_index,
+                    dim_t n_C, const index_t* S_ptr, const index_t* S_pos,
+                    index_t interpolation)
+{
+    const_SparseMatrix_ptr main(A->mainBlock);
+    const_SparseMatrix_ptr couple(A->col_coupleBlock);
+    const dim_t n = main->numRows;
+    const dim_t b = main->row_block_size;
+    const dim_t block_size = main->block_size;
+    const dim_t stride = getDiagonalStride(main);
+    const bool has_couple = (couple->pattern->ptr != NULL);
+    const bool classic = (interpolation == PASO_CLASSIC_INTERPOLATION ||
+             interpolation == PASO_CLASSIC_INTERPOLATION_WITH_FF_COUPLING);
+    const index_t* A_ptr = main->pattern->ptr;
+    const index_t* A_idx = main->pattern->index;
+    const index_t* main_ptr = main->borrowMainDiagonalPointer();
+
+    index_t* P_ptr = new index_t[n+1];
+#pragma omp parallel for
+    for (index_t i = 0; i < n; ++i) {
+        if (split[i] == AMG_IS_C) {
+            P_ptr[i] = 1;
+        } else if (split[i] == AMG_IS_F) {
+            dim_t k = 0;
+            for (index_t iptr = S_ptr[i]; iptr < S_ptr[i+1]; ++iptr) {
+                if (split[A_idx[S_pos[iptr]]] == AMG_IS_C)
+                    k++;
+            }
+            P_ptr[i] = k;
+        } else {
+            P_ptr[i] = 0;
+        }
+    }
+    const index_t s = util::cumsum(n, P_ptr);
+    P_ptr[n] = s;
+    index_t* P_idx = new index_t[s];
+    double* P_val = new double[s*b];
+
+#pragma omp parallel
+    {
+        // positions in A of the interpolatory points of the current row
+        std::vector<index_t> C_pos;
+        std::vector<double> numer;
+#pragma omp for
+        for (index_t i = 0; i < n; ++i) {
+            if (split[i] == AMG_IS_C) {
+                P_idx[P_ptr[i]] = coarse_index[i];
+                for (dim_t c = 0; c < b; ++c)
+                    P_val[P_ptr[i]*b+c] = 1.;
+            } else if (split[i] == AMG_IS_F) {
+                C_pos.clear();
+                for (index_t iptr = S_ptr[i]; iptr < S_ptr[i+1]; ++iptr) {
+                    if (split[A_idx[S_pos[iptr]]] == AMG_IS_C)
+                        C_pos.push_back(S_pos[iptr]);
+                }
+                const dim_t n_Ci = C_pos.size();
+                numer.resize(n_Ci);
+                for (dim_t k = 0; k < n_Ci; ++k)
+                    P_idx[P_ptr[i]+k] = coarse_index[A_idx[C_pos[k]]];
+
+                for (dim_t c = 0; c < b; ++c) {
+                    const dim_t ic = c*stride;
+                    double a_ii = main->val[main_ptr[i]*block_size+ic];
+                    if (!classic) {
+                        // direct interpolation
+                        double sum_N_neg = 0., sum_N_pos = 0.;
+                        double sum_C_neg = 0., sum_C_pos = 0.;
+                        for (index_t iptr = A_ptr[i]; iptr < A_ptr[i+1]; ++iptr) {
+                            if (A_idx[iptr] != i) {
+                                const double a = main->val[iptr*block_size+ic];
+                                if (a < 0) {
+                                    sum_N_neg += a;
+                                } else {
+                                    sum_N_pos += a;
+                                }
+                            }
+                        }
+                        if (has_couple) {
+                            for (index_t iptr = couple->pattern->ptr[i]; iptr < couple->pattern->ptr[i+1]; ++iptr) {
+                                const double a = couple->val[iptr*block_size+ic];
+                                if (a < 0) {
+                                    sum_N_neg += a;
+                                } else {
+                                    sum_N_pos += a;
+                                }
+                            }
+                        }
+                        for (dim_t k = 0; k < n_Ci; ++k) {
+                            const double a = main->val[C_pos[k]*block_size+ic];
+                            if (a < 0) {
+                                sum_C_neg += a;
+                            } else {
+                                sum_C_pos += a;
+                            }
+                        }
+                        const double alpha = (sum_C_neg < 0) ? sum_N_neg/sum_C_neg : 0.;
+                        double beta = 0.;
+                        if (sum_C_pos > 0) {
+                            beta = sum_N_pos/sum_C_pos;
+                        } else {
+                            a_ii += sum_N_pos;
+                        }
+                        for (dim_t k = 0; k < n_Ci; ++k) {
+                            const double a = main->val[C_pos[k]*block_size+ic];
+                            P_val[(P_ptr[i]+k)*b+c] = (a < 0) ? -alpha*a/a_ii : -beta*a/a_ii;
+                        }
+                    } else {
+                        // classical interpolation: strong F-F connections
+                        // are distributed to the common C-points, weak
+                        // connections are lumped to the diagonal
+                        for (dim_t k = 0; k < n_Ci; ++k)
+                            numer[k] = main->val[C_pos[k]*block_size+ic];
+                        dim_t kS = S_ptr[i];
+                        for (index_t iptr = A_ptr[i]; iptr < A_ptr[i+1]; ++iptr) {
+                            const index_t j = A_idx[iptr];
+                            const double a_ij = main->val[iptr*block_size+ic];
+                            const bool is_strong = (kS < S_ptr[i+1] && S_pos[kS] == iptr);
+                            if (is_strong)
+                                kS++;
+                            if (j == i || (is_strong && split[j] == AMG_IS_C))
+                                continue;
+                            if (is_strong && split[j] == AMG_IS_F) {
+                                double den = 0.;
+                                for (dim_t k = 0; k < n_Ci; ++k) {
+                                    const index_t m = A_idx[C_pos[k]];
+                                    const index_t* where_p = (index_t*)bsearch(&m,
+                                            &A_idx[A_ptr[j]], A_ptr[j+1]-A_ptr[j],
+                                            sizeof(index_t), util::comparIndex);
+                                    if (where_p != NULL)
+                                        den += main->val[(where_p-A_idx)*block_size+ic];
+                                }
+                                if (std::abs(den) > 0.) {
+                                    for (dim_t k = 0; k < n_Ci; ++k) {
+                                        const index_t m = A_idx[C_pos[k]];
+                                        const index_t* where_p = (index_t*)bsearch(&m,
+                                                &A_idx[A_ptr[j]], A_ptr[j+1]-A_ptr[j],
+                                                sizeof(index_t), util::comparIndex);
+                                        if (where_p != NULL)
+                                            numer[k] += a_ij*main->val[(where_p-A_idx)*block_size+ic]/den;
+                                    }
+                                    continue;
+                                }
+                            }
+                            a_ii += a_ij;
+                        }
+                        if (has_couple) {
+                            for (index_t iptr = couple->pattern->ptr[i]; iptr < couple->pattern->ptr[i+1]; ++iptr)
+                                a_ii += couple->val[iptr*block_size+ic];
+                        }
+                        for (dim_t k = 0; k < n_Ci; ++k)
+                            P_val[(P_ptr[i]+k)*b+c] = -numer[k]/a_ii;
+                    }
+                }
+            }
+        }
+    } // end parallel region
+
+    Pattern_ptr pattern(new Pattern(MATRIX_FORMAT_DEFAULT, n, n_C, P_ptr, P_idx));
+    SparseMatrix_ptr P(new SparseMatrix(MATRIX_FORMAT_DIAGONAL_BLOCK, pattern,
+                                        b, b, false));
+#pragma omp parallel for
+    for (index_t i = 0; i < s*b; ++i)
+        P->val[i] = P_val[i];
+    delete[] P_val;
+    return P;
+}
+
+/// returns an empty pattern with numOutput rows and numInput columns
+static Pattern_ptr Preconditioner_AMG_getEmptyPattern(dim_t numOutput,
+                                                     dim_t numInput)
+{
+    index_t* ptr = new index_t[numOutput+1];
+    for (index_t i = 0; i < numOutput+1; ++i)
+        ptr[i] = 0;
+    return Pattern_ptr(new Pattern(MATRIX_FORMAT_DEFAULT, numOutput, numInput,
+                                   ptr, new index_t[0]));
+}
+
+/*
+   Builds the coarse level SystemMatrix R*A*P. Under MPI the rows of P
+   for the overlap are collected from the neighbouring ranks to form the
+   coupling of the coarse operator and its connector.
+*/
+static SystemMatrix_ptr Preconditioner_AMG_getCoarseMatrix(SystemMatrix_ptr A,
+                    SparseMatrix_ptr P, SparseMatrix_ptr R,
+                    const std::vector<index_t>& coarse_offset)
+{
+    const escript::JMPI& mpi_info = A->mpi_info;
+    const dim_t b = A->mainBlock->row_block_size;
+    const dim_t n_C = P->numCols;
+    dim_t n_C_ghost = 0;
+
+    // main block
+    SparseMatrix_ptr AP(SparseMatrix_MatrixMatrixTranspose(A->mainBlock, P, R));
+    SparseMatrix_ptr A_C_main(SparseMatrix_MatrixMatrix(R, AP));
+    AP.reset();
+
+    SparseMatrix_ptr A_C_couple;
+    std::vector<int> send_neighbour, recv_neighbour;
+    std::vector<index_t> send_offset(1, 0), recv_offset(1, 0);
+    std::vector<index_t> send_shared, recv_shared;
+
+#ifdef ESYS_MPI
+    if (mpi_info->size > 1) {
+        const_Connector_ptr connector(A->col_coupler->connector);
+        const_SharedComponents_ptr send(connector->send);
+        const_SharedComponents_ptr recv(connector->recv);
+        const index_t* P_ptr = P->pattern->ptr;
+        const index_t* P_idx = P->pattern->index;
+        const index_t my_offset = coarse_offset[mpi_info->rank];
+
+        // maximum number of entries in a row of P
+        dim_t max_len = 0, max_len_loc = 0;
+        for (index_t i = 0; i < P->numRows; ++i)
+            max_len_loc = std::max(max_len_loc, P_ptr[i+1]-P_ptr[i]);
+        MPI_Allreduce(&max_len_loc, &max_len, 1, MPI_DIM_T, MPI_MAX, mpi_info->comm);
+        const dim_t len = 1 + max_len*(b+1);
+
+        // a row of P is packed as [length, (global column, values) ... ]
+        // and sent using a connector on the shared rows only
+        index_t* identity = new index_t[send->numSharedComponents];
+        for (index_t i = 0; i < send->numSharedComponents; ++i)
+            identity[i] = i;
+        SharedComponents_ptr p_send(new SharedComponents(
+                    send->numSharedComponents, send->neighbour, identity,
+                    send->offsetInShared));
+        SharedComponents_ptr p_recv(new SharedComponents(
+                    send->numSharedComponents, recv->neighbour, recv->shared,
+                    recv->offsetInShared));
+        delete[] identity;
+        Connector_ptr p_connector(new Connector(p_send, p_recv));
+        Coupler<real_t> p_coupler(p_connector, len, mpi_info);
+
+        double* buffer = new double[send->numSharedComponents*len];
+#pragma omp parallel for
+        for (index_t k = 0; k < send->numSharedComponents; ++k) {
+            const index_t i = send->shared[k];
+            double* row = &buffer[k*len];
+            row[0] = P_ptr[i+1]-P_ptr[i];
+            for (index_t iptr = P_ptr[i]; iptr < P_ptr[i+1]; ++iptr) {
+                double* entry = &row[1+(iptr-P_ptr[i])*(b+1)];
+                entry[0] = P_idx[iptr] + my_offset;
+                for (dim_t c = 0; c < b; ++c)
+                    entry[1+c] = P->val[iptr*b+c];
+            }
+        }
+        p_coupler.startCollect(buffer);
+        const double* remote = p_coupler.finishCollect();
+
+        // number the coarse ghost points by neighbour and global index
+        const dim_t n_ghost = recv->numSharedComponents;
+        std::vector<index_t> ghost_id;
+        recv_neighbour = recv->neighbour;
+        for (dim_t p = 0; p < recv->neighbour.size(); ++p) {
+            const size_t first = ghost_id.size();
+            for (index_t k = recv->offsetInShared[p]; k < recv->offsetInShared[p+1]; ++k) {
+                const double* row = &remote[k*len];
+                for (dim_t l = 0; l < (dim_t)row[0]; ++l)
+                    ghost_id.push_back((index_t)row[1+l*(b+1)]);
+            }
+            std::sort(ghost_id.begin()+first, ghost_id.end());
+            ghost_id.erase(std::unique(ghost_id.begin()+first, ghost_id.end()),
+                           ghost_id.end());
+            recv_offset.push_back(ghost_id.size());
+        }
+        n_C_ghost = ghost_id.size();
+        for (index_t k = 0; k < n_C_ghost; ++k)
+            recv_shared.push_back(n_C + k);
+
+        // the rows of P for the overlap
+        index_t* G_ptr = new index_t[n_ghost+1];
+        G_ptr[0] = 0;
+        for (index_t k = 0; k < n_ghost; ++k)
+            G_ptr[k+1] = G_ptr[k] + (index_t)remote[k*len];
+        index_t* G_idx = new index_t[G_ptr[n_ghost]];
+        double* G_val = new double[G_ptr[n_ghost]*b];
+        for (dim_t p = 0; p < recv->neighbour.size(); ++p) {
+            const index_t* first = &ghost_id[0] + recv_offset[p];
+            const index_t* last = &ghost_id[0] + recv_offset[p+1];
+            for (index_t k = recv->offsetInShared[p]; k < recv->offsetInShared[p+1]; ++k) {
+                const double* row = &remote[k*len];
+                for (index_t l = 0; l < G_ptr[k+1]-G_ptr[k]; ++l) {
+                    const index_t id = (index_t)row[1+l*(b+1)];
+                    G_idx[G_ptr[k]+l] = std::lower_bound(first, last, id) - &ghost_id[0];
+                    for (dim_t c = 0; c < b; ++c)
+                        G_val[(G_ptr[k]+l)*b+c] = row[2+l*(b+1)+c];
+                }
+            }
+        }
+        const index_t G_len = G_ptr[n_ghost];
+        Pattern_ptr G_pattern(new Pattern(MATRIX_FORMAT_DEFAULT, n_ghost,
+                                          n_C_ghost, G_ptr, G_idx));
+        SparseMatrix_ptr P_ghost(new SparseMatrix(MATRIX_FORMAT_DIAGONAL_BLOCK,
+                                          G_pattern, b, b, false));
+        for (index_t i = 0; i < G_len*b; ++i)
+            P_ghost->val[i] = G_val[i];
+        delete[] G_val;
+        delete[] buffer;
+
+        if (A->col_coupleBlock->pattern->ptr != NULL) {
+            SparseMatrix_ptr AP_couple(SparseMatrix_MatrixMatrix(
+                                            A->col_coupleBlock, P_ghost));
+            A_C_couple = SparseMatrix_MatrixMatrix(R, AP_couple);
+        }
+
+        // the coarse points to be sent are the columns of the rows of P
+        // sent to the neighbours
+        send_neighbour = send->neighbour;
+        for (dim_t p = 0; p < send->neighbour.size(); ++p) {
+            const size_t first = send_shared.size();
+            for (index_t k = send->offsetInShared[p]; k < send->offsetInShared[p+1]; ++k) {
+                const index_t i = send->shared[k];
+                for (index_t iptr = P_ptr[i]; iptr < P_ptr[i+1]; ++iptr)
+                    send_shared.push_back(P_idx[iptr]);
+            }
+            std::sort(send_shared.begin()+first, send_shared.end());
+            send_shared.erase(std::unique(send_shared.begin()+first,
+                                          send_shared.end()), send_shared.end());
+            send_offset.push_back(send_shared.size());
+        }
+    }
+#endif
+    if (!A_C_couple) {
+        A_C_couple.reset(new SparseMatrix(A_C_main->type,
+                    Preconditioner_AMG_getEmptyPattern(n_C, n_C_ghost), b, b,
+                    true));
+    }
+    if (send_neighbour.empty())
+        send_offset.assign(1, 0);
+    if (recv_neighbour.empty())
+        recv_offset.assign(1, 0);
+
+    SharedComponents_ptr send_C(new SharedComponents(n_C, send_neighbour,
+                send_shared.empty() ? NULL : &send_shared[0], send_offset));
+    SharedComponents_ptr recv_C(new SharedComponents(n_C, recv_neighbour,
+                recv_shared.empty() ? NULL : &recv_shared[0], recv_offset));
+    Connector_ptr connector_C(new Connector(send_C, recv_C));
+    escript::Distribution_ptr distribution(new escript::Distribution(mpi_info,
+                                                                coarse_offset));
+    SystemMatrixPattern_ptr pattern(new SystemMatrixPattern(
+                MATRIX_FORMAT_DEFAULT, distribution, distribution,
+                A_C_main->pattern, A_C_couple->pattern,
+                Preconditioner_AMG_getEmptyPattern(n_C_ghost, n_C),
+                connector_C, connector_C));
+    SystemMatrix_ptr A_C(new SystemMatrix(MATRIX_FORMAT_DEFAULT, pattern, b, b,
+                true, escript::FunctionSpace(), escript::FunctionSpace()));
+    A_C->mainBlock = A_C_main;
+    A_C->col_coupleBlock = A_C_couple;
+    return A_C;
+}
+
+/*
+   Assembles the matrix on all ranks as a dense matrix and computes its
+   LU factorization with partial pivoting.
+*/
+static void Preconditioner_AMG_setDirect(SystemMatrix_ptr A,
+                                         Preconditioner_AMG* amg)
+{
+    const escript::JMPI& mpi_info = A->mpi_info;
+    const_SparseMatrix_ptr main(A->mainBlock);
+    const_SparseMatrix_ptr couple(A->col_coupleBlock);
+    const dim_t b = main->row_block_size;
+    const dim_t block_size = main->block_size;
+    const bool is_diagonal_block = (block_size == b && b > 1);
+    const dim_t n = main->numRows;
+    const dim_t n_loc = n*b;
+    const dim_t N = A->getGlobalTotalNumRows();
+
+    amg->lu_counts = new int[mpi_info->size];
+    amg->lu_offsets = new int[mpi_info->size+1];
+#ifdef ESYS_MPI
+    int my_n = n_loc;
+    MPI_Allgather(&my_n, 1, MPI_INT, amg->lu_counts, 1, MPI_INT, mpi_info->comm);
+#else
+    amg->lu_counts[0] = n_loc;
+#endif
+    amg->lu_offsets[0] = 0;
+    for (int p = 0; p < mpi_info->size; ++p)
+        amg->lu_offsets[p+1] = amg->lu_offsets[p] + amg->lu_counts[p];
+    const index_t my_offset = amg->lu_offsets[mpi_info->rank];
+
+    // global index of the columns of the couple block
+    const double* remote_id = NULL;
+    double* local_id = new double[n_loc];
+    for (index_t i = 0; i < n_loc; ++i)
+        local_id[i] = my_offset + i;
+    if (mpi_info->size > 1) {
+        A->startCollect(local_id);
+        remote_id = A->finishCollect();
+    }
+
+    double* rows = new double[((size_t)n_loc)*N];
+#pragma omp parallel for
+    for (index_t i = 0; i < n_loc; ++i) {
+        for (index_t j = 0; j < N; ++j)
+            rows[((size_t)i)*N+j] = 0.;
+    }
+#pragma omp parallel for
+    for (index_t i = 0; i < n; ++i) {
+        for (index_t iptr = main->pattern->ptr[i]; iptr < main->pattern->ptr[i+1]; ++iptr) {
+            const index_t j = main->pattern->index[iptr];
+            for (dim_t ir = 0; ir < b; ++ir) {
+                double* row = &rows[((size_t)(i*b+ir))*N];
+                for (dim_t ic = 0; ic < b; ++ic) {
+                    if (is_diagonal_block) {
+                        if (ir == ic)
+                            row[my_offset+j*b+ic] += main->val[iptr*block_size+ir];
+                    } else {
+                        row[my_offset+j*b+ic] += main->val[iptr*block_size+ir+b*ic];
+                    }
+                }
+            }
+        }
+        if (remote_id != NULL && couple->pattern->ptr != NULL) {
+            for (index_t iptr = couple->pattern->ptr[i]; iptr < couple->pattern->ptr[i+1]; ++iptr) {
+                const index_t j = couple->pattern->index[iptr];
+                for (dim_t ir = 0; ir < b; ++ir) {
+                    double* row = &rows[((size_t)(i*b+ir))*N];
+                    for (dim_t ic = 0; ic < b; ++ic) {
+                        const index_t jg = (index_t)remote_id[j*b+ic];
+                        if (is_diagonal_block) {
+                            if (ir == ic)
+                                row[jg] += couple->val[iptr*block_size+ir];
+                        } else {
+                            row[jg] += couple->val[iptr*block_size+ir+b*ic];
+                        }
+                    }
+                }
+            }
+        }
+    }
+    delete[] local_id;
+
+    amg->n_lu = N;
+    amg->lu = new double[((size_t)N)*N];
+    amg->lu_pivot = new index_t[N];
+    amg->lu_buffer = new double[N];
+#ifdef ESYS_MPI
+    {
+        int* counts = new int[mpi_info->size];
+        int* offsets = new int[mpi_info->size];
+        for (int p = 0; p < mpi_info->size; ++p) {
+            counts[p] = amg->lu_counts[p]*N;
+            offsets[p] = amg->lu_offsets[p]*N;
+        }
+        MPI_Allgatherv(rows, n_loc*N, MPI_DOUBLE, amg->lu, counts, offsets,
+                       MPI_DOUBLE, mpi_info->comm);
+        delete[] counts;
+        delete[] offsets;
+    }
+#else
+    memcpy(amg->lu, rows, sizeof(double)*N*N);
+#endif
+    delete[] rows;
+
+    // LU factorization with partial pivoting (row major). Zero pivots
+    // (e.g. from a singular pure Neumann problem) are regularized.
+    double* a = amg->lu;
+    double norm = 0.;
+    for (size_t k = 0; k < ((size_t)N)*N; ++k)
+        norm = std::max(norm, std::abs(a[k]));
+    const double tiny = std::max(norm, 1.) * N * escript::DataTypes::real_t_eps();
+    for (index_t k = 0; k < N; ++k) {
+        index_t p = k;
+        for (index_t i = k+1; i < N; ++i) {
+            if (std::abs(a[((size_t)i)*N+k]) > std::abs(a[((size_t)p)*N+k]))
+                p = i;
+        }
+        amg->lu_pivot[k] = p;
+        if (p != k) {
+            for (index_t j = 0; j < N; ++j)
+                std::swap(a[((size_t)k)*N+j], a[((size_t)p)*N+j]);
+        }
+        if (std::abs(a[((size_t)k)*N+k]) <= tiny)
+            a[((size_t)k)*N+k] = (a[((size_t)k)*N+k] < 0) ? -tiny : tiny;
+        const double inv_pivot = 1./a[((size_t)k)*N+k];
+#pragma omp parallel for
+        for (index_t i = k+1; i < N; ++i) {
+            double* row_i = &a[((size_t)i)*N];
+            const double* row_k = &a[((size_t)k)*N];
+            const double l = row_i[k] * inv_pivot;
+            row_i[k] = l;
+            if (l != 0.) {
+                for (index_t j = k+1; j < N; ++j)
+                    row_i[j] -= l*row_k[j];
+            }
+        }
+    }
+}
+
+/// solves with the dense LU factorization on the coarsest level
+static void Preconditioner_AMG_solveDirect(SystemMatrix_ptr A,
+                    Preconditioner_AMG* amg, double* x, const double* b)
+{
+    const escript::JMPI& mpi_info = A->mpi_info;
+    const dim_t N = amg->n_lu;
+    const dim_t n_loc = amg->lu_counts[mpi_info->rank];
+    const double* a = amg->lu;
+    double* y = amg->lu_buffer;
+#ifdef ESYS_MPI
+    MPI_Allgatherv(const_cast<double*>(b), n_loc, MPI_DOUBLE, y,
+                   amg->lu_counts, amg->lu_offsets, MPI_DOUBLE, mpi_info->comm);
+#else
+    memcpy(y, b, sizeof(double)*n_loc);
+#endif
+    for (index_t k = 0; k < N; ++k) {
+        const index_t p = amg->lu_pivot[k];
+        if (p != k)
+            std::swap(y[k], y[p]);
+    }
+    for (index_t i = 1; i < N; ++i) {
+        const double* row = &a[((size_t)i)*N];
+        double s = y[i];
+        for (index_t j = 0; j < i; ++j)
+            s -= row[j]*y[j];
+        y[i] = s;
+    }
+    for (index_t i = N-1; i >= 0; --i) {
+        const double* row = &a[((size_t)i)*N];
+        double s = y[i];
+        for (index_t j = i+1; j < N; ++j)
+            s -= row[j]*y[j];
+        y[i] = s/row[i];
+    }
+    util::copy(n_loc, x, &y[amg->lu_offsets[mpi_info->rank]]);
+}
+
+Preconditioner_AMG* Preconditioner_AMG_alloc(SystemMatrix_ptr A, dim_t level,
+                                             Options* options)
+{
+    const escript::JMPI& mpi_info = A->mpi_info;
+    const dim_t n = A->mainBlock->numRows;
+    const dim_t n_block = A->mainBlock->row_block_size;
+    const dim_t N = A->getGlobalNumRows();
+    const double sparsity = A->getSparsity();
+    const bool verbose = options->verbose;
+
+    Preconditioner_AMG* out = new Preconditioner_AMG;
+    out->level = level;
+    out->Smoother = NULL;
+    out->AMG_C = NULL;
+    out->r = NULL;
+    out->x_C = NULL;
+    out->b_C = NULL;
+    out->pre_sweeps = options->pre_sweeps;
+    out->post_sweeps = options->post_sweeps;
+    out->n_lu = 0;
+    out->lu = NULL;
+    out->lu_pivot = NULL;
+    out->lu_buffer = NULL;
+    out->lu_counts = NULL;
+    out->lu_offsets = NULL;
+
+    if (verbose) {
+        printf("Preconditioner_AMG: level %d: %d unknowns, sparsity %e.\n",
+               level, A->getGlobalTotalNumRows(), sparsity);
+    }
+
+    bool is_coarsest = (level >= options->level_max ||
+                        N <= options->min_coarse_matrix_size ||
+                        sparsity >= options->min_coarse_sparsity);
+    try {
+        if (!is_coarsest) {
+            double time0 = escript::gettime();
+            index_t* split = new index_t[n];
+            index_t* S_ptr = new index_t[n+1];
+            index_t* S_pos = NULL;
+            Preconditioner_AMG_setStrongConnections(A,
+                    options->coarsening_threshold,
+                    options->diagonal_dominance_threshold, split, S_ptr, &S_pos);
+            const dim_t n_C = Preconditioner_AMG_selectCoarse(A->mainBlock,
+                                                       split, S_ptr, S_pos);
+            std::vector<index_t> coarse_offset(mpi_info->size+1, 0);
+#ifdef ESYS_MPI
+            MPI_Allgather(&n_C, 1, MPI_DIM_T, &coarse_offset[1], 1, MPI_DIM_T,
+                          mpi_info->comm);
+#else
+            coarse_offset[1] = n_C;
+#endif
+            for (int p = 0; p < mpi_info->size; ++p)
+                coarse_offset[p+1] += coarse_offset[p];
+            const dim_t N_C = coarse_offset[mpi_info->size];
+            options->coarsening_selection_time += escript::gettime()-time0;
+
+            if (N_C == 0 || N_C > (1.-PASO_AMG_MIN_REDUCTION)*N) {
+                if (verbose)
+                    printf("Preconditioner_AMG: level %d: coarsening stalled (%d coarse points).\n",
+                           level, N_C);
+                is_coarsest = true;
+            } else {
+                time0 = escript::gettime();
+                index_t* coarse_index = new index_t[n];
+                index_t k = 0;
+                for (index_t i = 0; i < n; ++i)
+                    coarse_index[i] = (split[i] == AMG_IS_C) ? k++ : -1;
+                out->P = Preconditioner_AMG_getProlongation(A, split,
+                            coarse_index, n_C, S_ptr, S_pos,
+                            options->interpolation_method);
+                delete[] coarse_index;
+                out->R = out->P->getTranspose();
+                out->A_C = Preconditioner_AMG_getCoarseMatrix(A, out->P,
+                                                       out->R, coarse_offset);
+                options->coarsening_matrix_time += escript::gettime()-time0;
+                out->r = new double[n*n_block];
+                out->x_C = new double[n_C*n_block];
+                out->b_C = new double[n_C*n_block];
+            }
+            delete[] split;
+            delete[] S_ptr;
+            delete[] S_pos;
+        }
+
+        if (is_coarsest) {
+            options->num_level = level;
+            options->coarse_level_sparsity = sparsity;
+            options->num_coarse_unknowns = A->getGlobalTotalNumRows();
+            if (mpi_info->size == 1) {
+                if (verbose)
+                    printf("Preconditioner_AMG: level %d: sparse direct solver is used on coarsest level.\n",
+                           level);
+                out->A_direct = A->mainBlock;
+                Supernodal_factorize(out->A_direct, false, verbose);
+            } else if (A->getGlobalTotalNumRows() <= PASO_AMG_MAX_DIRECT_SIZE) {
+                if (verbose)
+                    printf("Preconditioner_AMG: level %d: dense LU is used on coarsest level.\n",
+                           level);
+                Preconditioner_AMG_setDirect(A, out);
+            } else {
+                if (verbose)
+                    printf("Preconditioner_AMG: level %d: smoother is used on coarsest level.\n",
+                           level);
+                out->Smoother = Preconditioner_Smoother_alloc(A,
+                        options->smoother == PASO_JACOBI, false,
+                        options->mixed_precision, verbose);
+                out->r = new double[n*n_block];
+            }
+        } else {
+            out->Smoother = Preconditioner_Smoother_alloc(A,
+                        options->smoother == PASO_JACOBI, false,
+                        options->mixed_precision, verbose);
+            out->AMG_C = Preconditioner_AMG_alloc(out->A_C, level+1, options);
+        }
+    } catch (PasoException& e) {
+        Preconditioner_AMG_free(out);
+        throw;
+    }
+    return out;
+}
+
+/*
+   smoother sweeps x <- x + S^{-1}(b-A*x) with the residual taken over all
+   ranks. If x_is_initial is false x=0 is used as initial guess.
+*/
+static void Preconditioner_AMG_smooth(SystemMatrix_ptr A,
+                    Preconditioner_AMG* amg, double* x, const double* b,
+                    dim_t sweeps, bool x_is_initial)
+{
+    const dim_t n = A->getTotalNumRows();
+    Preconditioner_LocalSmoother* smoother = amg->Smoother->localSmoother;
+    double* r = amg->r;
+    dim_t nsweeps = sweeps;
+
+    if (!x_is_initial) {
+        util::copy(n, x, b);
+        Preconditioner_LocalSmoother_Sweep(A->mainBlock, smoother, x);
+        nsweeps--;
+    }
+    while (nsweeps > 0) {
+        util::copy(n, r, b);
+        A->MatrixVector_CSR_OFFSET0(-1., x, 1., r); // r = b - A*x
+        Preconditioner_LocalSmoother_Sweep(A->mainBlock, smoother, r);
+        util::AXPY(n, x, 1., r);
+        nsweeps--;
+    }
+}
+
+/// applies a V-cycle: x = AMG(b)
+void Preconditioner_AMG_solve(SystemMatrix_ptr A, Preconditioner_AMG* amg,
+                              double* x, double* b)
+{
+    const dim_t n = A->getTotalNumRows();
+
+    if (amg->A_direct) {
+        Supernodal_solve(amg->A_direct, x, b, false, 0, false);
+    } else if (amg->lu != NULL) {
+        Preconditioner_AMG_solveDirect(A, amg, x, b);
+    } else if (amg->AMG_C == NULL) {
+        Preconditioner_AMG_smooth(A, amg, x, b,
+                std::max(amg->pre_sweeps+amg->post_sweeps, 1), false);
+    } else {
+        // presmoothing
+        Preconditioner_AMG_smooth(A, amg, x, b, std::max(amg->pre_sweeps, 1), false);
+        // r = b - A*x, b_C = R*r
+        util::copy(n, amg->r, b);
+        A->MatrixVector_CSR_OFFSET0(-1., x, 1., amg->r);
+        SparseMatrix_MatrixVector_CSR_OFFSET0_DIAG(1., amg->R, amg->r, 0., amg->b_C);
+        // coarse level correction x = x + P*AMG_C(b_C)
+        Preconditioner_AMG_solve(amg->A_C, amg->AMG_C, amg->x_C, amg->b_C);
+        SparseMatrix_MatrixVector_CSR_OFFSET0_DIAG(1., amg->P, amg->x_C, 1., x);
+        // postsmoothing
+        if (amg->post_sweeps > 0)
+            Preconditioner_AMG_smooth(A, amg, x, b, amg->post_sweeps, true);
+    }
+}
+
+#undef AMG_IS_ELIMINATED
+#undef AMG_IS_AVAILABLE
+#undef AMG_IS_F
+#undef AMG_IS_C
+
+} // namespace paso
+
@@ -20,6 +20,7 @@
 */
 
 #include "Solver.h"
+#include "PasoUtil.h"
 #include "SystemMatrix.h"
 
 namespace paso {
@@ -46,7 +47,8 @@ namespace paso {
 *  Arguments
 *  =========
 *
-*  A       (input)
+*  A       (input) linear operator providing the matrix-vector product
+*          and the preconditioner.
 *
 *  R       (input) DOUBLE PRECISION array, dimension N.
 *          On entry, residual of initial guess X
@@ -74,22 +76,20 @@ namespace paso {
 *  ==============================================================
 */
 
-SolverResult Solver_BiCGStab(SystemMatrix_ptr A, double* r, double* x,
+SolverResult Solver_BiCGStab(LinearOperator* A, double* r, double* x,
                              dim_t* iter, double* tolerance, Performance* pp)
 {
   /* Local variables */
-  double *rtld=NULL,*p=NULL,*v=NULL,*t=NULL,*phat=NULL,*shat=NULL,*s=NULL;/*, *buf1=NULL, *buf0=NULL;*/
-  double beta,norm_of_residual=0,sum_1,sum_2,sum_3,sum_4,norm_of_residual_global=0;
+  double *rtld=NULL,*p=NULL,*v=NULL,*t=NULL,*phat=NULL,*shat=NULL;
+  double beta,norm_of_residual=0,sum_2,sum_3,norm_of_residual_global=0;
   double alpha=0, omega=0, omegaNumtr, omegaDenumtr, rho, tol, rho1=0;
-#ifdef ESYS_MPI
-  double loc_sum[2], sum[2];
-#endif
+  double sum[2];
   dim_t num_iter=0,maxit,num_iter_global=0;
   dim_t i0;
   bool breakFlag=false, maxIterFlag=false, convergeFlag=false;
   SolverResult status = NoError;
   double *resid = tolerance;
-  dim_t n = A->getTotalNumRows();
+  dim_t n = A->getLen();
 
   /* Test the input parameters. */
 
@@ -103,7 +103,6 @@ SolverResult Solver_BiCGStab(SystemMatrix_ptr A, double* r, double* x,
     t=new double[n];
     phat=new double[n];
     shat=new double[n];
-    s=new double[n];
 
     /* now bicgstab starts : */
     maxit = *iter;
@@ -118,7 +117,6 @@ SolverResult Solver_BiCGStab(SystemMatrix_ptr A, double* r, double* x,
 
     #pragma omp parallel for private(i0) schedule(static)
     for (i0 = 0; i0 < n; i0++) {
-        rtld[i0]=0;
         p[i0]=0;
         v[i0]=0;
         t[i0]=0;
@@ -126,100 +124,65 @@ SolverResult Solver_BiCGStab(SystemMatrix_ptr A, double* r, double* x,
         shat[i0]=0;
         rtld[i0] = r[i0];
     }
+    rho = util::innerProduct(n, rtld, r, A->mpi_info);
 
     /*     Perform BiConjugate Gradient Stabilized iteration. */
+    /*     The vector updates are fused with the inner products which      */
+    /*     follow them. S = R - ALPHA*V is kept in R and RHO of the next    */
+    /*     iteration is computed together with the norm of the residual.    */
 
     L10:
       ++(num_iter);
-        sum_1 = 0;
-        sum_2 = 0;
-        sum_3 = 0;
-        sum_4 = 0;
-        omegaNumtr = 0.0;
-      omegaDenumtr = 0.0;
-      #pragma omp parallel for private(i0) reduction(+:sum_1) schedule(static)
-      for (i0 = 0; i0 < n; i0++) sum_1 += rtld[i0] * r[i0];
-      #ifdef ESYS_MPI
-          loc_sum[0] = sum_1;
-          MPI_Allreduce(loc_sum, &sum_1, 1, MPI_DOUBLE, MPI_SUM, A->mpi_info->comm);
-      #endif
-      rho = sum_1;
 
       if (! (breakFlag = (std::abs(rho) <= TOLERANCE_FOR_SCALARS))) {
         /*        Compute vector P. */
 
         if (num_iter > 1) {
           beta = rho / rho1 * (alpha / omega);
-          #pragma omp parallel for private(i0) schedule(static)
-          for (i0 = 0; i0 < n; i0++) p[i0] = r[i0] + beta * (p[i0] - omega * v[i0]);
+          util::linearCombination(n, p, PASO_ONE, r, beta, p, -beta*omega, v);
         } else {
-          #pragma omp parallel for private(i0) schedule(static)
-          for (i0 = 0; i0 < n; i0++) p[i0] = r[i0];
+          util::copy(n, p, r);
         }
 
         /*        Compute direction adjusting vector PHAT and scalar ALPHA. */
 
         A->solvePreconditioner(&phat[0], &p[0]);
-        A->MatrixVector_CSR_OFFSET0(PASO_ONE, &phat[0], PASO_ZERO, &v[0]);
+        A->matrixVector(PASO_ONE, &phat[0], PASO_ZERO, &v[0]);
 
-        #pragma omp parallel for private(i0) reduction(+:sum_2) schedule(static)
-        for (i0 = 0; i0 < n; i0++) sum_2 += rtld[i0] * v[i0];
-        #ifdef ESYS_MPI
-           loc_sum[0] = sum_2;
-            MPI_Allreduce(loc_sum, &sum_2, 1, MPI_DOUBLE, MPI_SUM, A->mpi_info->comm);
-        #endif
+        sum_2 = util::innerProduct(n, rtld, v, A->mpi_info);
         if (! (breakFlag = (std::abs(sum_2) <= TOLERANCE_FOR_SCALARS))) {
            alpha = rho / sum_2;
 
-           #pragma omp parallel for private(i0) reduction(+:sum_3) schedule(static)
-           for (i0 = 0; i0 < n; i0++) {
-             r[i0] -= alpha * v[i0];
-             s[i0] = r[i0];
-             sum_3 += s[i0] * s[i0];
-           }
-           #ifdef ESYS_MPI
-               loc_sum[0] = sum_3;
-               MPI_Allreduce(loc_sum, &sum_3, 1, MPI_DOUBLE, MPI_SUM, A->mpi_info->comm);
-           #endif
+           /*        S = R - ALPHA*V */
+           sum_3 = util::updateAndInnerProduct(n, PASO_ONE, r, -alpha, v, r,
+                                               A->mpi_info);
            norm_of_residual = sqrt(sum_3);
 
            /*        Early check for tolerance. */
            if ( (convergeFlag = (norm_of_residual <= tol)) ) {
-             #pragma omp parallel for  private(i0) schedule(static)
-             for (i0 = 0; i0 < n; i0++) x[i0] += alpha * phat[i0];
+             util::AXPY(n, x, alpha, phat);
              maxIterFlag = false;
              breakFlag = false;
            } else {
              /*           Compute stabilizer vector SHAT and scalar OMEGA. */
-             A->solvePreconditioner(&shat[0], &s[0]);
-             A->MatrixVector_CSR_OFFSET0(PASO_ONE, &shat[0],PASO_ZERO,&t[0]);
+             A->solvePreconditioner(&shat[0], &r[0]);
+             A->matrixVector(PASO_ONE, &shat[0],PASO_ZERO,&t[0]);
 
-             #pragma omp parallel for private(i0) reduction(+:omegaNumtr,omegaDenumtr) schedule(static)
-             for (i0 = 0; i0 < n; i0++) {
-               omegaNumtr +=t[i0] * s[i0];
-               omegaDenumtr += t[i0] * t[i0];
-             }
-             #ifdef ESYS_MPI
-                loc_sum[0] = omegaNumtr;
-                loc_sum[1] = omegaDenumtr;
-                MPI_Allreduce(loc_sum, sum, 2, MPI_DOUBLE, MPI_SUM, A->mpi_info->comm);
-                omegaNumtr=sum[0];
-                omegaDenumtr=sum[1];
-             #endif
+             util::innerProducts(n, t, r, t, t, sum, A->mpi_info);
+             omegaNumtr=sum[0];
+             omegaDenumtr=sum[1];
              if (! (breakFlag = (std::abs(omegaDenumtr) <= TOLERANCE_FOR_SCALARS))) {
                 omega = omegaNumtr / omegaDenumtr;
 
-                #pragma omp parallel for private(i0) reduction(+:sum_4) schedule(static)
-                for (i0 = 0; i0 < n; i0++) {
-                  x[i0] += alpha * phat[i0] + omega * shat[i0];
-                  r[i0] = s[i0]-omega * t[i0];
-                  sum_4 += r[i0] * r[i0];
-                }
-                #ifdef ESYS_MPI
-                   loc_sum[0] = sum_4;
-                    MPI_Allreduce(loc_sum, &sum_4, 1, MPI_DOUBLE, MPI_SUM, A->mpi_info->comm);
-                #endif
-                norm_of_residual = sqrt(sum_4);
+                util::linearCombination(n, x, PASO_ONE, x, alpha, phat,
+                                        omega, shat);
+                /*           R = S - OMEGA*T together with RHO of the next */
+                /*           iteration                                       */
+                rho1 = rho;
+                util::updateAndInnerProducts(n, PASO_ONE, r, -omega, t, r,
+                                             rtld, sum, A->mpi_info);
+                norm_of_residual = sqrt(sum[0]);
+                rho = sum[1];
                 convergeFlag = norm_of_residual <= tol;
                 maxIterFlag = num_iter > maxit;
                 breakFlag = (std::abs(omega) <= TOLERANCE_FOR_SCALARS);
@@ -227,7 +190,6 @@ SolverResult Solver_BiCGStab(SystemMatrix_ptr A, double* r, double* x,
            }
         }
         if (!(convergeFlag || maxIterFlag || breakFlag)) {
-          rho1 = rho;
           goto L10;
         }
       }
@@ -246,12 +208,18 @@ SolverResult Solver_BiCGStab(SystemMatrix_ptr A, double* r, double* x,
     delete[] t;
     delete[] phat;
     delete[] shat;
-    delete[] s;
     *iter=num_iter_global;
     *resid=norm_of_residual_global;
 
     return status;
 }
 
+SolverResult Solver_BiCGStab(SystemMatrix_ptr A, double* r, double* x,
+                             dim_t* iter, double* tolerance, Performance* pp)
+{
+    SystemMatrixOperator op(A);
+    return Solver_BiCGStab(&op, r, x, iter, tolerance, pp);
+}
+
 } // namespace paso
 
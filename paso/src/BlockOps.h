@@ -20,6 +20,7 @@
 #include "Paso.h"
 #include "PasoException.h"
 
+#include <algorithm> // swap
 #include <cstring> // memcpy
 
 #ifdef ESYS_HAVE_LAPACK
@@ -74,25 +75,147 @@ inline void BlockOps_SMV_3(double* R, const double* mat, const double* V)
     R[2] -= A31 * S1 + A32 * S2 + A33 * S3;
 }
 
-#define PASO_MISSING_CLAPACK throw PasoException("You need to install a LAPACK version to enable operations on block sizes > 3.")
+/// largest block size for which the templated kernels below are used by the
+/// BlockOps_*_N routines. Larger blocks are handled by LAPACK.
+#define PASO_BLOCKOPS_MAX_N 8
+
+/*
+   Kernels for NxN blocks (column major) with N known at compile time. The
+   loops are fully unrolled by the compiler and the loops over the rows of a
+   block column vectorize. The matrix may be stored in single precision.
+*/
+
+/// performs operation R=R-mat*V (V and R are not overlapping)
+template <int N, typename T>
+inline void BlockOps_SMV(double* R, const T* mat, const double* V)
+{
+    for (int j=0; j<N; ++j) {
+        const double S = V[j];
+        #pragma ivdep
+        for (int i=0; i<N; ++i)
+            R[i] -= mat[i+N*j] * S;
+    }
+}
+
+/// performs operation R=mat*V (V and R are not overlapping)
+template <int N, typename T>
+inline void BlockOps_MV(double* R, const T* mat, const double* V)
+{
+    for (int i=0; i<N; ++i)
+        R[i] = 0.;
+    for (int j=0; j<N; ++j) {
+        const double S = V[j];
+        #pragma ivdep
+        for (int i=0; i<N; ++i)
+            R[i] += mat[i+N*j] * S;
+    }
+}
+
+/// inplace matrix vector product V=mat*V
+template <int N, typename T>
+inline void BlockOps_MViP(const T* mat, double* V)
+{
+    double S[N];
+    for (int i=0; i<N; ++i)
+        S[i] = V[i];
+    BlockOps_MV<N>(V, mat, S);
+}
+
+/// performs operation C=C-A*B (C does not overlap with A or B)
+template <int N>
+inline void BlockOps_SMM(double* C, const double* A, const double* B)
+{
+    for (int k=0; k<N; ++k)
+        BlockOps_SMV<N>(&C[N*k], A, &B[N*k]);
+}
+
+/// inplace matrix product B=A*B
+template <int N>
+inline void BlockOps_MMiP(const double* A, double* B)
+{
+    for (int k=0; k<N; ++k)
+        BlockOps_MViP<N>(A, &B[N*k]);
+}
+
+/// invA=A^{-1} by Gauss-Jordan elimination with partial pivoting
+template <int N>
+inline void BlockOps_invM(double* invA, const double* A, int* failed)
+{
+    double a[N*N];
+    for (int l=0; l<N*N; ++l) {
+        a[l] = A[l];
+        invA[l] = 0.;
+    }
+    for (int i=0; i<N; ++i)
+        invA[i+N*i] = 1.;
+    for (int k=0; k<N; ++k) {
+        int p = k;
+        for (int i=k+1; i<N; ++i) {
+            if (std::abs(a[i+N*k]) > std::abs(a[p+N*k]))
+                p = i;
+        }
+        if (!(std::abs(a[p+N*k]) > 0)) {
+            *failed = 1;
+            return;
+        }
+        if (p != k) {
+            for (int j=0; j<N; ++j) {
+                std::swap(a[k+N*j], a[p+N*j]);
+                std::swap(invA[k+N*j], invA[p+N*j]);
+            }
+        }
+        const double D = 1./a[k+N*k];
+        for (int j=0; j<N; ++j) {
+            a[k+N*j] *= D;
+            invA[k+N*j] *= D;
+        }
+        for (int i=0; i<N; ++i) {
+            const double f = a[i+N*k];
+            if (i != k && f != 0.) {
+                for (int j=0; j<N; ++j) {
+                    a[i+N*j] -= f*a[k+N*j];
+                    invA[i+N*j] -= f*invA[k+N*j];
+                }
+            }
+        }
+    }
+}
+
+#define PASO_MISSING_CLAPACK throw PasoException("You need to install a LAPACK version to enable operations on block sizes > 8.")
 
 /// performs operation R=R-mat*V (V and R are not overlapping) - NxN
 inline void BlockOps_SMV_N(dim_t N, double* R, const double* mat, const double* V)
 {
+    switch (N) {
+        case 4: BlockOps_SMV<4>(R, mat, V); break;
+        case 5: BlockOps_SMV<5>(R, mat, V); break;
+        case 6: BlockOps_SMV<6>(R, mat, V); break;
+        case 7: BlockOps_SMV<7>(R, mat, V); break;
+        case 8: BlockOps_SMV<8>(R, mat, V); break;
+        default:
 #ifdef ESYS_HAVE_LAPACK
-    cblas_dgemv(CblasColMajor,CblasNoTrans, N, N, -1., mat, N, V, 1, 1., R, 1);
+            cblas_dgemv(CblasColMajor,CblasNoTrans, N, N, -1., mat, N, V, 1, 1., R, 1);
 #else
-    PASO_MISSING_CLAPACK;
+            PASO_MISSING_CLAPACK;
 #endif
+    }
 }
 
 inline void BlockOps_MV_N(dim_t N, double* R, const double* mat, const double* V)
 {
+    switch (N) {
+        case 4: BlockOps_MV<4>(R, mat, V); break;
+        case 5: BlockOps_MV<5>(R, mat, V); break;
+        case 6: BlockOps_MV<6>(R, mat, V); break;
+        case 7: BlockOps_MV<7>(R, mat, V); break;
+        case 8: BlockOps_MV<8>(R, mat, V); break;
+        default:
 #ifdef ESYS_HAVE_LAPACK
-    cblas_dgemv(CblasColMajor,CblasNoTrans, N, N, 1., mat, N, V, 1, 0., R, 1);
+            cblas_dgemv(CblasColMajor,CblasNoTrans, N, N, 1., mat, N, V, 1, 0., R, 1);
 #else
-    PASO_MISSING_CLAPACK;
+            PASO_MISSING_CLAPACK;
 #endif
+    }
 }
 
 inline void BlockOps_invM_2(double* invA, const double* A, int* failed)
@@ -143,9 +266,23 @@ inline void BlockOps_invM_3(double* invA, const double* A, int* failed)
     }
 }
 
-/// LU factorization of NxN matrix mat with partial pivoting
+/// factorization of NxN matrix mat for BlockOps_solve_N. For
+/// 4<=N<=PASO_BLOCKOPS_MAX_N mat is replaced by its inverse, otherwise by
+/// its LU factorization with partial pivoting.
 inline void BlockOps_invM_N(dim_t N, double* mat, index_t* pivot, int* failed)
 {
+    if (N >= 4 && N <= PASO_BLOCKOPS_MAX_N) {
+        double invA[PASO_BLOCKOPS_MAX_N*PASO_BLOCKOPS_MAX_N];
+        switch (N) {
+            case 4: BlockOps_invM<4>(invA, mat, failed); break;
+            case 5: BlockOps_invM<5>(invA, mat, failed); break;
+            case 6: BlockOps_invM<6>(invA, mat, failed); break;
+            case 7: BlockOps_invM<7>(invA, mat, failed); break;
+            case 8: BlockOps_invM<8>(invA, mat, failed); break;
+        }
+        BlockOps_Cpy_N(N*N, mat, invA);
+        return;
+    }
 #ifdef ESYS_HAVE_LAPACK
 #ifdef ESYS_MKL_LAPACK
     int res = 0;
@@ -162,9 +299,16 @@ inline void BlockOps_invM_N(dim_t N, double* mat, index_t* pivot, int* failed)
 #endif
 }
 
-/// solves system of linear equations A*X=B
+/// solves system of linear equations A*X=B with mat from BlockOps_invM_N
 inline void BlockOps_solve_N(dim_t N, double* X, double* mat, index_t* pivot, int* failed)
 {
+    switch (N) {
+        case 4: BlockOps_MViP<4>(mat, X); return;
+        case 5: BlockOps_MViP<5>(mat, X); return;
+        case 6: BlockOps_MViP<6>(mat, X); return;
+        case 7: BlockOps_MViP<7>(mat, X); return;
+        case 8: BlockOps_MViP<8>(mat, X); return;
+    }
 #ifdef ESYS_HAVE_LAPACK
 #ifdef ESYS_MKL_LAPACK
     int res = 0;
@@ -243,6 +387,57 @@ inline void BlockOps_solveAll(dim_t n_block, dim_t n, double* D,
     }
 }
 
+/// x=D*x for n blocks of size N
+template <int N, typename T>
+inline void BlockOps_MViPAll(dim_t n, const T* D, double* x)
+{
+#pragma omp parallel for
+    for (dim_t i=0; i<n; ++i)
+        BlockOps_MViP<N>(&D[N*N*i], &x[N*i]);
+}
+
+/// as above but with the inverse diagonal blocks D stored in single
+/// precision. Only block sizes up to PASO_BLOCKOPS_MAX_N are supported.
+inline void BlockOps_solveAll(dim_t n_block, dim_t n, const float* D,
+                              double* x)
+{
+    if (n_block == 1) {
+#pragma omp parallel for
+        for (dim_t i=0; i<n; ++i)
+            x[i] *= D[i];
+    } else if (n_block == 2) {
+#pragma omp parallel for
+        for (dim_t i=0; i<n; ++i) {
+            const float* d = &D[4*i];
+            const double S1 = x[2*i];
+            const double S2 = x[2*i+1];
+            x[2*i  ] = d[0]*S1 + d[2]*S2;
+            x[2*i+1] = d[1]*S1 + d[3]*S2;
+        }
+    } else if (n_block == 3) {
+#pragma omp parallel for
+        for (dim_t i=0; i<n; ++i) {
+            const float* d = &D[9*i];
+            const double S1 = x[3*i];
+            const double S2 = x[3*i+1];
+            const double S3 = x[3*i+2];
+            x[3*i  ] = d[0]*S1 + d[3]*S2 + d[6]*S3;
+            x[3*i+1] = d[1]*S1 + d[4]*S2 + d[7]*S3;
+            x[3*i+2] = d[2]*S1 + d[5]*S2 + d[8]*S3;
+        }
+    } else {
+        switch (n_block) {
+            case 4: BlockOps_MViPAll<4>(n, D, x); break;
+            case 5: BlockOps_MViPAll<5>(n, D, x); break;
+            case 6: BlockOps_MViPAll<6>(n, D, x); break;
+            case 7: BlockOps_MViPAll<7>(n, D, x); break;
+            case 8: BlockOps_MViPAll<8>(n, D, x); break;
+            default:
+                throw PasoException("BlockOps_solveAll: single precision diagonal is only supported for block sizes up to 8.");
+        }
+    }
+}
+
 } // namespace paso
 
 #endif // __PASO_BLOCKOPS_H__
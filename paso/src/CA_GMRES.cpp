@@ -0,0 +1,580 @@
+
+/*****************************************************************************
+*
+* Copyright (c) 2003-2018 by The University of Queensland
+* http://www.uq.edu.au
+*
+* Primary Business: Queensland, Australia
+* Licensed under the Apache License, version 2.0
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Development until 2012 by Earth Systems Science Computational Center (ESSCC)
+* Development 2012-2013 by School of Earth Sciences
+* Development from 2014 by Centre for Geoscience Computing (GeoComp)
+*
+*****************************************************************************/
+
+
+/*
+*  Purpose
+*  =======
+*
+*  Solver_CA_GMRES solves the linear system A*x=b using the
+*  communication-avoiding (s-step) variant of the restarted GMRES method
+*  with right preconditioning, see M. Hoemmen: Communication-avoiding Krylov
+*  subspace methods, PhD thesis, UC Berkeley, 2010.
+*
+*  In each block s new basis vectors are generated by applying the
+*  preconditioned operator s times to the last orthonormal basis vector
+*  (matrix powers kernel). The block is orthogonalized against the existing
+*  basis and within itself by two passes of block classical Gram-Schmidt
+*  combined with a Cholesky QR factorization (BCGS2/CholQR2). All inner
+*  products of a pass are computed in one sweep and combined into a single
+*  global reduction, i.e. a block of s iterations requires two global
+*  reductions instead of the O(s^2) reductions of standard GMRES. The upper
+*  Hessenberg matrix of the Arnoldi process is recovered from the change of
+*  basis and the block factors.
+*
+*  The first cycle uses the monomial basis. Once a Hessenberg matrix is
+*  available the Newton basis with Leja-ordered Chebyshev shifts on the
+*  interval spanned by the field of values of the Hessenberg matrix is used
+*  which keeps the basis well conditioned for larger s.
+*
+*  Convergence test: norm( b - A*x )< TOL.
+*
+*  Arguments
+*  =========
+*
+*  r       (input/output) double array, dimension n.
+*          On entry, residual of initial guess x
+*
+*  x       (input/output) double array, dimension n.
+*          On input, the initial guess.
+*
+*  iter    (input/output) int
+*          On input, the maximum num_iterations to be performed.
+*          On output, actual number of num_iterations performed.
+*
+*  tolerance (input/output) DOUBLE PRECISION
+*          On input, the allowable convergence measure for
+*          norm( b - A*x )
+*          On output, the final value of this measure.
+*
+*  restart (input) number of iteration steps after which the method is
+*          restarted. It is rounded up to a multiple of step_size.
+*
+*  step_size (input) number of steps s per block
+*
+*  ==============================================================
+*/
+
+#include "Solver.h"
+#include "PasoUtil.h"
+
+#include <algorithm>
+#include <cmath>
+
+// number of rows processed in one go by the block kernels
+#define PASO_CA_GMRES_CHUNK 256
+
+// a block column is considered linearly dependent on the previous columns
+// if its squared norm drops below this fraction of its initial value
+#define PASO_CA_GMRES_RANK_TOLERANCE 1.e-12
+
+namespace paso {
+
+namespace {
+
+/// computes the upper triangular Cholesky factor R of the p x p symmetric
+/// matrix G (both column-major, leading dimension p). diag holds reference
+/// values for the diagonal entries to detect a loss of rank. Returns the
+/// number of leading columns for which the factorization succeeded.
+dim_t cholesky(dim_t p, const double* G, const double* diag, double* R)
+{
+    for (dim_t k=0; k<p*p; ++k)
+        R[k] = 0.;
+    for (dim_t j=0; j<p; ++j) {
+        double d = G[j+p*j];
+        for (dim_t k=0; k<j; ++k)
+            d -= R[k+p*j]*R[k+p*j];
+        if (!(d > PASO_CA_GMRES_RANK_TOLERANCE*diag[j]))
+            return j;
+        R[j+p*j] = std::sqrt(d);
+        for (dim_t l=j+1; l<p; ++l) {
+            double t = G[j+p*l];
+            for (dim_t k=0; k<j; ++k)
+                t -= R[k+p*j]*R[k+p*l];
+            R[j+p*l] = t/R[j+p*j];
+        }
+    }
+    return p;
+}
+
+/// one pass of block classical Gram-Schmidt of the p vectors W against the
+/// J orthonormal vectors Q followed by a Cholesky QR factorization of the
+/// projected block. All inner products are reduced in a single call.
+/// On return W holds the orthonormal block, C (J x p) and R (p x p,
+/// upper triangular) are such that W_in = Q*C + W_out*R.
+/// Returns the number of leading columns of W which are linearly
+/// independent, only these are valid on return.
+dim_t blockOrthogonalize(dim_t n, dim_t J, double** Q, dim_t p, double** W,
+                         double* C, double* R, const escript::JMPI& mpi_info)
+{
+    const dim_t len = J*p + p*p;
+    double* loc_dots = new double[len];
+    double* dots = new double[len];
+    double* G = &dots[J*p];
+    const dim_t numChunks = (n+PASO_CA_GMRES_CHUNK-1)/PASO_CA_GMRES_CHUNK;
+
+    for (dim_t k=0; k<len; ++k)
+        loc_dots[k] = 0.;
+#pragma omp parallel
+    {
+        double* ss = new double[len];
+        for (dim_t k=0; k<len; ++k)
+            ss[k] = 0.;
+#pragma omp for schedule(static)
+        for (dim_t c=0; c<numChunks; ++c) {
+            const index_t i0 = c*PASO_CA_GMRES_CHUNK;
+            const index_t i1 = std::min(i0+PASO_CA_GMRES_CHUNK, n);
+            for (dim_t b=0; b<p; ++b) {
+                const double* w = W[b];
+                for (dim_t a=0; a<J; ++a) {
+                    const double* q = Q[a];
+                    double s = 0.;
+#pragma ivdep
+                    for (index_t i=i0; i<i1; ++i)
+                        s += q[i]*w[i];
+                    ss[a+J*b] += s;
+                }
+                for (dim_t a=0; a<=b; ++a) {
+                    const double* v = W[a];
+                    double s = 0.;
+#pragma ivdep
+                    for (index_t i=i0; i<i1; ++i)
+                        s += v[i]*w[i];
+                    ss[J*p+a+p*b] += s;
+                }
+            }
+        }
+#pragma omp critical
+        {
+            for (dim_t k=0; k<len; ++k)
+                loc_dots[k] += ss[k];
+        }
+        delete[] ss;
+    }
+#ifdef ESYS_MPI
+    MPI_Allreduce(loc_dots, dots, len, MPI_DOUBLE, MPI_SUM, mpi_info->comm);
+#else
+    for (dim_t k=0; k<len; ++k)
+        dots[k] = loc_dots[k];
+#endif
+
+    // Gram matrix of the projected block W-Q*C is G-C^T*C
+    for (dim_t b=0; b<p; ++b) {
+        for (dim_t a=0; a<=b; ++a) {
+            for (dim_t k=0; k<J; ++k)
+                G[a+p*b] -= dots[k+J*a]*dots[k+J*b];
+            G[b+p*a] = G[a+p*b];
+        }
+        // the reference for the rank test is the norm before projection
+        loc_dots[b] = G[b+p*b];
+        for (dim_t k=0; k<J; ++k)
+            loc_dots[b] += dots[k+J*b]*dots[k+J*b];
+    }
+    for (dim_t k=0; k<J*p; ++k)
+        C[k] = dots[k];
+    const dim_t rank = cholesky(p, G, loc_dots, R);
+
+    // W = (W-Q*C)*R^{-1} for the leading rank columns
+    if (rank > 0) {
+#pragma omp parallel for schedule(static)
+        for (dim_t c=0; c<numChunks; ++c) {
+            const index_t i0 = c*PASO_CA_GMRES_CHUNK;
+            const index_t i1 = std::min(i0+PASO_CA_GMRES_CHUNK, n);
+            for (dim_t b=0; b<rank; ++b) {
+                double* w = W[b];
+                for (dim_t a=0; a<J; ++a) {
+                    const double* q = Q[a];
+                    const double f = C[a+J*b];
+#pragma ivdep
+                    for (index_t i=i0; i<i1; ++i)
+                        w[i] -= f*q[i];
+                }
+                for (dim_t a=0; a<b; ++a) {
+                    const double* v = W[a];
+                    const double f = R[a+p*b];
+#pragma ivdep
+                    for (index_t i=i0; i<i1; ++i)
+                        w[i] -= f*v[i];
+                }
+                const double f = 1./R[b+p*b];
+#pragma ivdep
+                for (index_t i=i0; i<i1; ++i)
+                    w[i] *= f;
+            }
+        }
+    }
+    delete[] loc_dots;
+    delete[] dots;
+    return rank;
+}
+
+/// returns the smallest and largest eigenvalue of the symmetric part of the
+/// leading k x k block of the Hessenberg matrix H (column-major, leading
+/// dimension ld)
+void fieldOfValuesInterval(dim_t k, const double* H, dim_t ld, double& lo,
+                           double& hi)
+{
+    double* S = new double[k*k];
+    for (dim_t j=0; j<k; ++j)
+        for (dim_t i=0; i<k; ++i)
+            S[i+k*j] = (H[i+ld*j]+H[j+ld*i])/2.;
+
+    util::symmetricEigen(k, S, NULL);
+    lo = hi = S[0];
+    for (dim_t i=1; i<k; ++i) {
+        lo = std::min(lo, S[i+k*i]);
+        hi = std::max(hi, S[i+k*i]);
+    }
+    delete[] S;
+}
+
+/// sets the s shifts of the Newton basis to the Chebyshev points of the
+/// interval [lo,hi] in Leja ordering and the scaling factors to the half
+/// width of the interval
+void setShifts(dim_t s, double lo, double hi, double* theta, double* sigma)
+{
+    const double centre = (lo+hi)/2.;
+    const double radius = (hi-lo)/2.;
+    double* nodes = new double[s];
+    bool* used = new bool[s];
+    for (dim_t i=0; i<s; ++i) {
+        nodes[i] = centre + radius*std::cos((2.*i+1.)*M_PI/(2.*s));
+        used[i] = false;
+    }
+    for (dim_t k=0; k<s; ++k) {
+        dim_t best = -1;
+        double bestVal = -1.;
+        for (dim_t i=0; i<s; ++i) {
+            if (used[i])
+                continue;
+            double val = std::abs(nodes[i]);
+            if (k > 0) {
+                val = 1.;
+                for (dim_t l=0; l<k; ++l)
+                    val *= std::abs(nodes[i]-theta[l]);
+            }
+            if (val > bestVal) {
+                bestVal = val;
+                best = i;
+            }
+        }
+        used[best] = true;
+        theta[k] = nodes[best];
+    }
+    const double scale = std::max(radius,
+                        1.e-8*std::max(std::abs(lo), std::abs(hi)));
+    for (dim_t k=0; k<s; ++k)
+        sigma[k] = scale;
+    delete[] nodes;
+    delete[] used;
+}
+
+} // anonymous namespace
+
+SolverResult Solver_CA_GMRES(SystemMatrix_ptr A, double* r, double* x,
+                             dim_t* iter, double* tolerance, dim_t restart,
+                             dim_t step_size, Performance* pp)
+{
+    if (step_size <= 0 || restart <= 0) {
+        return InputError;
+    }
+    const dim_t n = A->getTotalNumRows();
+    const dim_t maxit = *iter;
+    const double tol = *tolerance;
+    const dim_t s = step_size;
+    // the restart length is rounded up to a multiple of the step size
+    const dim_t m = ((restart+s-1)/s)*s;
+    const dim_t ld = m+1;
+    bool breakFlag=false, maxIterFlag=false, convergeFlag=false;
+    SolverResult status = NoError;
+    dim_t num_iter = 0;
+    double norm_of_residual;
+    bool haveShifts = false;
+
+    double** Q = new double*[m+1];
+    for (dim_t k=0; k<=m; ++k)
+        Q[k] = new double[n];
+    double* z = new double[n];
+    double* u = new double[n];
+    double* H = new double[ld*m];   // Hessenberg matrix of the cycle
+    double* Hr = new double[ld*m];  // H after the Givens rotations
+    double* cs = new double[m];
+    double* sn = new double[m];
+    double* g = new double[m+1];
+    double* y = new double[m];
+    double* C1 = new double[ld*s];
+    double* C2 = new double[ld*s];
+    double* R1 = new double[s*s];
+    double* R2 = new double[s*s];
+    double* Rv = new double[(ld+s)*(s+1)];
+    double* M = new double[(ld+s)*s];
+    double* S = new double[s*s];
+    double* theta = new double[s];
+    double* sigma = new double[s];
+
+    // the first cycle uses the monomial basis
+    for (dim_t k=0; k<s; ++k) {
+        theta[k] = 0.;
+        sigma[k] = 1.;
+    }
+
+    Performance_startMonitor(pp, PERFORMANCE_SOLVER);
+    norm_of_residual = util::l2(n, r, A->mpi_info);
+
+    while (!(convergeFlag || maxIterFlag || breakFlag)) {
+        convergeFlag = (norm_of_residual <= tol);
+        maxIterFlag = (num_iter >= maxit);
+        if (convergeFlag || maxIterFlag)
+            break;
+
+        // start a new cycle with q_0 = r/|r|
+        const double beta = norm_of_residual;
+        const double fac = 1./beta;
+#pragma omp parallel for schedule(static)
+        for (index_t i=0; i<n; ++i)
+            Q[0][i] = r[i]*fac;
+        for (dim_t k=0; k<ld*m; ++k)
+            H[k] = 0.;
+        g[0] = beta;
+        dim_t j = 0; // number of completed columns of H
+        bool endCycle = false;
+
+        while (j < m && !endCycle) {
+            const dim_t J = j+1;
+            const dim_t pr = std::min(s, m-j);
+
+            // matrix powers kernel: v_{i+1} = (A*M*v_i - theta_i*v_i)/sigma_i
+            // with v_0 = q_j, the new vectors are stored in Q[J..J+pr-1]
+            for (dim_t i=0; i<pr; ++i) {
+                double* v = Q[j+i];
+                double* w = Q[J+i];
+                Performance_stopMonitor(pp, PERFORMANCE_SOLVER);
+                Performance_startMonitor(pp, PERFORMANCE_PRECONDITIONER);
+                A->solvePreconditioner(z, v);
+                Performance_stopMonitor(pp, PERFORMANCE_PRECONDITIONER);
+                Performance_startMonitor(pp, PERFORMANCE_MVM);
+                A->MatrixVector_CSR_OFFSET0(PASO_ONE, z, PASO_ZERO, w);
+                Performance_stopMonitor(pp, PERFORMANCE_MVM);
+                Performance_startMonitor(pp, PERFORMANCE_SOLVER);
+                const double th = theta[i];
+                const double sc = 1./sigma[i];
+#pragma omp parallel for schedule(static)
+                for (index_t k=0; k<n; ++k)
+                    w[k] = (w[k]-th*v[k])*sc;
+            }
+
+            // two passes of block Gram-Schmidt with Cholesky QR, i.e.
+            // W = Q*C + W_new*R with C = C1+C2*R1, R = R2*R1
+            const dim_t p1 = blockOrthogonalize(n, J, Q, pr, &Q[J], C1, R1,
+                                                A->mpi_info);
+            const dim_t ldR2 = std::max(p1, (dim_t)1);
+            dim_t p = 0;
+            if (p1 > 0) {
+                p = blockOrthogonalize(n, J, Q, p1, &Q[J], C2, R2,
+                                       A->mpi_info);
+            } else {
+                for (dim_t a=0; a<J; ++a)
+                    C2[a] = 0.;
+                R1[0] = 1.;
+            }
+            if (p == 0) {
+                // v_1 is in the span of the basis: the Krylov space is
+                // (numerically) invariant and the column j of H is
+                // completed with a zero subdiagonal entry
+                p = 1;
+                endCycle = true;
+                R2[0] = 0.;
+            }
+            // C1 <- C1 + C2*R1 (J x p), R2 <- R2*R1 (p x p)
+            for (dim_t b=0; b<p; ++b) {
+                for (dim_t a=0; a<J; ++a) {
+                    double t = 0.;
+                    for (dim_t k=0; k<=b; ++k)
+                        t += C2[a+J*k]*R1[k+pr*b];
+                    C1[a+J*b] += t;
+                }
+            }
+            for (dim_t b=p-1; b>=0; --b) {
+                for (dim_t a=0; a<=b; ++a) {
+                    double t = 0.;
+                    for (dim_t k=a; k<=b; ++k)
+                        t += R2[a+ldR2*k]*R1[k+pr*b];
+                    R2[a+ldR2*b] = t;
+                }
+            }
+
+            // recover the columns j..j+p-1 of H from
+            // A*M*[q_j..q_{j+p-1}]*S = [Q,Q_new]*Rv*T - Q*H_old*K
+            // where [v_0..v_p] = [Q,Q_new]*Rv, T holds the shifts and K, S
+            // are the top rows and the triangular part of Rv[:,0..p-1]
+            const dim_t nr = J+p;
+            for (dim_t k=0; k<nr*(p+1); ++k)
+                Rv[k] = 0.;
+            Rv[j] = 1.;
+            for (dim_t b=1; b<=p; ++b) {
+                for (dim_t a=0; a<J; ++a)
+                    Rv[a+nr*b] = C1[a+J*(b-1)];
+                for (dim_t a=0; a<b; ++a)
+                    Rv[J+a+nr*b] = R2[a+ldR2*(b-1)];
+            }
+            for (dim_t i=0; i<p; ++i) {
+                for (dim_t a=0; a<nr; ++a)
+                    M[a+nr*i] = theta[i]*Rv[a+nr*i] + sigma[i]*Rv[a+nr*(i+1)];
+                // subtract H_old*K[:,i], K[:,i] = Rv[0..j-1, i]
+                for (dim_t k=0; k<j; ++k) {
+                    const double f = Rv[k+nr*i];
+                    if (f != 0.) {
+                        for (dim_t a=0; a<=k+1; ++a)
+                            M[a+nr*i] -= H[a+ld*k]*f;
+                    }
+                }
+            }
+            for (dim_t b=0; b<p; ++b)
+                for (dim_t a=0; a<p; ++a)
+                    S[a+p*b] = Rv[j+a+nr*b];
+            // H[:,j+i] = (M[:,i] - sum_{k<i} H[:,j+k]*S(k,i))/S(i,i)
+            for (dim_t i=0; i<p; ++i) {
+                double* h = &H[ld*(j+i)];
+                for (dim_t a=0; a<nr; ++a) {
+                    double t = M[a+nr*i];
+                    for (dim_t k=0; k<i; ++k)
+                        t -= H[a+ld*(j+k)]*S[k+p*i];
+                    h[a] = t/S[i+p*i];
+                    if (!std::isfinite(h[a]))
+                        breakFlag = true;
+                }
+                // enforce the Hessenberg structure
+                for (dim_t a=j+i+2; a<nr; ++a)
+                    h[a] = 0.;
+            }
+            if (breakFlag) {
+                // the basis could not be extended (singular Cholesky
+                // factor), the cycle ends with the columns completed so far
+                break;
+            }
+
+            // update the least squares problem by Givens rotations
+            for (dim_t i=0; i<p; ++i) {
+                const dim_t k = j+i;
+                double* hr = &Hr[ld*k];
+                for (dim_t a=0; a<=k+1; ++a)
+                    hr[a] = H[a+ld*k];
+                for (dim_t l=0; l<k; ++l) {
+                    const double t = cs[l]*hr[l] + sn[l]*hr[l+1];
+                    hr[l+1] = -sn[l]*hr[l] + cs[l]*hr[l+1];
+                    hr[l] = t;
+                }
+                const double d = std::sqrt(hr[k]*hr[k] + hr[k+1]*hr[k+1]);
+                if (d > 0.) {
+                    cs[k] = hr[k]/d;
+                    sn[k] = hr[k+1]/d;
+                } else {
+                    cs[k] = 1.;
+                    sn[k] = 0.;
+                }
+                hr[k] = d;
+                hr[k+1] = 0.;
+                g[k+1] = -sn[k]*g[k];
+                g[k] = cs[k]*g[k];
+                if (std::abs(g[k+1]) <= tol || k+1+num_iter >= maxit) {
+                    p = i+1;
+                    endCycle = true;
+                    break;
+                }
+            }
+            j += p;
+        }
+        num_iter += j;
+
+        // solve Hr*y = g and update x += M*Q*y and r -= A*M*Q*y
+        for (dim_t k=j-1; k>=0; --k) {
+            double t = g[k];
+            for (dim_t l=k+1; l<j; ++l)
+                t -= Hr[k+ld*l]*y[l];
+            y[k] = (Hr[k+ld*k] != 0.) ? t/Hr[k+ld*k] : 0.;
+        }
+#pragma omp parallel for schedule(static)
+        for (index_t i=0; i<n; ++i) {
+            double t = 0.;
+            for (dim_t k=0; k<j; ++k)
+                t += Q[k][i]*y[k];
+            u[i] = t;
+        }
+        Performance_stopMonitor(pp, PERFORMANCE_SOLVER);
+        Performance_startMonitor(pp, PERFORMANCE_PRECONDITIONER);
+        A->solvePreconditioner(z, u);
+        Performance_stopMonitor(pp, PERFORMANCE_PRECONDITIONER);
+        Performance_startMonitor(pp, PERFORMANCE_MVM);
+        A->MatrixVector_CSR_OFFSET0(PASO_ONE, z, PASO_ZERO, u);
+        Performance_stopMonitor(pp, PERFORMANCE_MVM);
+        Performance_startMonitor(pp, PERFORMANCE_SOLVER);
+#pragma omp parallel for schedule(static)
+        for (index_t i=0; i<n; ++i) {
+            x[i] += z[i];
+            r[i] -= u[i];
+        }
+        norm_of_residual = util::l2(n, r, A->mpi_info);
+        if (!std::isfinite(norm_of_residual))
+            breakFlag = true;
+
+        // use the Newton basis with shifts from the field of values of H
+        // for the next cycle
+        if (!haveShifts && j >= s) {
+            double lo, hi;
+            fieldOfValuesInterval(j, H, ld, lo, hi);
+            if (std::isfinite(lo) && std::isfinite(hi) && hi > lo) {
+                setShifts(s, lo, hi, theta, sigma);
+                haveShifts = true;
+            }
+        }
+    }
+    // end of iterations
+    if (convergeFlag) {
+        status = NoError;
+    } else if (maxIterFlag) {
+        status = MaxIterReached;
+    } else if (breakFlag) {
+        status = Breakdown;
+    }
+    Performance_stopMonitor(pp, PERFORMANCE_SOLVER);
+
+    for (dim_t k=0; k<=m; ++k)
+        delete[] Q[k];
+    delete[] Q;
+    delete[] z;
+    delete[] u;
+    delete[] H;
+    delete[] Hr;
+    delete[] cs;
+    delete[] sn;
+    delete[] g;
+    delete[] y;
+    delete[] C1;
+    delete[] C2;
+    delete[] R1;
+    delete[] R2;
+    delete[] Rv;
+    delete[] M;
+    delete[] S;
+    delete[] theta;
+    delete[] sigma;
+    *iter = num_iter;
+    *tolerance = norm_of_residual;
+    return status;
+}
+
+} // namespace paso
+
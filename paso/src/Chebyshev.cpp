@@ -0,0 +1,279 @@
+
+/*****************************************************************************
+*
+* Copyright (c) 2003-2018 by The University of Queensland
+* http://www.uq.edu.au
+*
+* Primary Business: Queensland, Australia
+* Licensed under the Apache License, version 2.0
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Development until 2012 by Earth Systems Science Computational Center (ESSCC)
+* Development 2012-2013 by School of Earth Sciences
+* Development from 2014 by Centre for Geoscience Computing (GeoComp)
+*
+*****************************************************************************/
+
+
+/****************************************************************************/
+
+/* Paso: Chebyshev polynomial preconditioner                                */
+
+/*  The preconditioner applies a polynomial p of given degree in D^{-1}*A   */
+/*  such that x = p(D^{-1}*A)*D^{-1}*b approximates A^{-1}*b where D is the */
+/*  main diagonal of A. The polynomial is the shifted and scaled Chebyshev  */
+/*  polynomial for the interval [lambda_min, lambda_max] which is derived   */
+/*  from an estimate of the largest eigenvalue of D^{-1}*A obtained by a    */
+/*  few Lanczos (symmetric case) or power iterations. The estimate is       */
+/*  computed once when the preconditioner is set up and is reused for all   */
+/*  solves with the same matrix. Only the operator and its diagonal are     */
+/*  required so the preconditioner can be used with matrix-free operators   */
+/*  and does not need any global reductions when it is applied.             */
+
+/****************************************************************************/
+
+#include "Preconditioner.h"
+#include "PasoUtil.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+// number of Lanczos steps used to estimate the largest eigenvalue of
+// symmetric operators
+#define PASO_CHEBYSHEV_LANCZOS_STEPS 10
+
+// number of power iterations used to estimate the largest eigenvalue of
+// non-symmetric operators
+#define PASO_CHEBYSHEV_POWER_ITERATIONS 10
+
+// the estimate of the largest eigenvalue is increased by this factor to
+// make sure that the spectrum is covered
+#define PASO_CHEBYSHEV_SAFETY_FACTOR 1.1
+
+// ratio lambda_max/lambda_min of the interval targeted by the polynomial
+#define PASO_CHEBYSHEV_EIGENVALUE_RATIO 30.
+
+namespace paso {
+
+void Preconditioner_Chebyshev_free(Preconditioner_Chebyshev* in)
+{
+    if (in != NULL) {
+        delete[] in->inv_diag;
+        delete[] in->r;
+        delete[] in->d;
+        delete in;
+    }
+}
+
+namespace {
+
+/// returns the largest eigenvalue of the symmetric tridiagonal matrix with
+/// main diagonal alpha[0..m-1] and off-diagonal beta[0..m-2] using
+/// bisection on the Sturm sequence
+double tridiagonalMaxEigenvalue(dim_t m, const double* alpha,
+                                const double* beta)
+{
+    // Gershgorin bounds
+    double lo = alpha[0], hi = alpha[0];
+    for (dim_t i=0; i<m; ++i) {
+        const double r = (i>0 ? std::abs(beta[i-1]) : 0.)
+                       + (i<m-1 ? std::abs(beta[i]) : 0.);
+        lo = std::min(lo, alpha[i]-r);
+        hi = std::max(hi, alpha[i]+r);
+    }
+    for (int k=0; k<100 && hi-lo > 1.e-12*std::abs(hi); ++k) {
+        const double mid = (lo+hi)/2.;
+        // number of eigenvalues less than mid
+        dim_t count = 0;
+        double d = 1.;
+        for (dim_t i=0; i<m; ++i) {
+            const double b2 = (i>0 ? beta[i-1]*beta[i-1] : 0.);
+            d = alpha[i] - mid - (i>0 ? b2/d : 0.);
+            if (d == 0.)
+                d = -1.e-300;
+            if (d < 0.)
+                count++;
+        }
+        if (count == m) {
+            hi = mid;
+        } else {
+            lo = mid;
+        }
+    }
+    return hi;
+}
+
+/// estimates the largest eigenvalue of D^{-1}*A by Lanczos iterations
+/// in the D-inner product which is appropriate for symmetric A and
+/// positive D. v and w are work arrays of length n.
+double estimateMaxEigenvalue_Lanczos(LinearOperator* A,
+                                     const double* inv_diag, double* v,
+                                     double* w)
+{
+    const dim_t n = A->getLen();
+    const dim_t m = PASO_CHEBYSHEV_LANCZOS_STEPS;
+    double* work = new double[n];
+    double* v_old = work;
+    double* z = new double[n];
+    double alpha[PASO_CHEBYSHEV_LANCZOS_STEPS];
+    double beta[PASO_CHEBYSHEV_LANCZOS_STEPS];
+    dim_t k;
+
+    // z = D*v, v = v/|v|_D
+#pragma omp parallel for schedule(static)
+    for (index_t i=0; i<n; ++i) {
+        z[i] = v[i]/inv_diag[i];
+        v_old[i] = 0.;
+    }
+    double norm_v = std::sqrt(util::innerProduct(n, v, z, A->mpi_info));
+    util::scale(n, v, 1./norm_v);
+    for (k=0; k<m; ++k) {
+        // w = D^{-1}*A*v - alpha_k*v - beta_{k-1}*v_old
+        A->matrixVector(1., v, 0., z);
+        alpha[k] = util::innerProduct(n, z, v, A->mpi_info);
+        const double b = (k>0 ? beta[k-1] : 0.);
+#pragma omp parallel for schedule(static)
+        for (index_t i=0; i<n; ++i) {
+            w[i] = inv_diag[i]*z[i] - alpha[k]*v[i] - b*v_old[i];
+            z[i] = w[i]/inv_diag[i];
+        }
+        beta[k] = std::sqrt(std::max(util::innerProduct(n, w, z, A->mpi_info),
+                                     0.));
+        if (k == m-1 || beta[k] <= 1.e-10*std::abs(alpha[k])) {
+            k++;
+            break;
+        }
+        std::swap(v_old, v);
+#pragma omp parallel for schedule(static)
+        for (index_t i=0; i<n; ++i)
+            v[i] = w[i]/beta[k];
+    }
+    delete[] work;
+    delete[] z;
+    return tridiagonalMaxEigenvalue(k, alpha, beta);
+}
+
+/// estimates the largest eigenvalue of D^{-1}*A by power iterations.
+/// v and w are work arrays of length n.
+double estimateMaxEigenvalue_Power(LinearOperator* A,
+                                   const double* inv_diag, double* v,
+                                   double* w)
+{
+    const dim_t n = A->getLen();
+    double lambda = 0.;
+    for (dim_t k=0; k<PASO_CHEBYSHEV_POWER_ITERATIONS; ++k) {
+        const double norm_v = util::l2(n, v, A->mpi_info);
+        if (!(norm_v > 0.))
+            break;
+        util::scale(n, v, 1./norm_v);
+        A->matrixVector(1., v, 0., w);
+#pragma omp parallel for schedule(static)
+        for (index_t i=0; i<n; ++i)
+            w[i] *= inv_diag[i];
+        lambda = util::l2(n, w, A->mpi_info);
+        std::swap(v, w);
+    }
+    return lambda;
+}
+
+} // anonymous namespace
+
+Preconditioner_Chebyshev* Preconditioner_Chebyshev_alloc(LinearOperator* A,
+                            dim_t degree, bool symmetric, bool verbose)
+{
+    const dim_t n = A->getLen();
+    Preconditioner_Chebyshev* out = new Preconditioner_Chebyshev;
+    out->n = n;
+    out->degree = std::max(degree, (dim_t)1);
+    out->inv_diag = new double[n];
+    out->r = new double[n];
+    out->d = new double[n];
+
+    const double time0 = escript::gettime();
+    A->getDiagonal(out->inv_diag);
+    dim_t numNonPositive = 0;
+#pragma omp parallel for schedule(static) reduction(+:numNonPositive)
+    for (index_t i=0; i<n; ++i) {
+        const double a = out->inv_diag[i];
+        if (!(a > 0.))
+            numNonPositive++;
+        out->inv_diag[i] = (std::abs(a) > 0.) ? 1./a : 1.;
+    }
+#ifdef ESYS_MPI
+    if (symmetric) {
+        dim_t localCount = numNonPositive;
+        MPI_Allreduce(&localCount, &numNonPositive, 1, MPI_DIM_T, MPI_SUM,
+                      A->mpi_info->comm);
+    }
+#endif
+    // Lanczos requires D to define an inner product
+    const bool useLanczos = (symmetric && numNonPositive == 0);
+
+    double* v = out->r;
+    double* w = out->d;
+#pragma omp parallel for schedule(static)
+    for (index_t i=0; i<n; ++i)
+        v[i] = 1.+1./(1.+(i%7));
+    double lambda;
+    if (useLanczos) {
+        lambda = estimateMaxEigenvalue_Lanczos(A, out->inv_diag, v, w);
+    } else {
+        lambda = estimateMaxEigenvalue_Power(A, out->inv_diag, v, w);
+    }
+    if (!(lambda > 0.))
+        lambda = 1.;
+    out->lambda_max = PASO_CHEBYSHEV_SAFETY_FACTOR*lambda;
+    out->lambda_min = out->lambda_max/PASO_CHEBYSHEV_EIGENVALUE_RATIO;
+
+    if (verbose) {
+        printf("Preconditioner_Chebyshev: polynomial of degree %d on interval "
+               "[%e, %e] (%d %s iterations).\n", (int)out->degree,
+               out->lambda_min, out->lambda_max,
+               useLanczos ? PASO_CHEBYSHEV_LANCZOS_STEPS :
+                            PASO_CHEBYSHEV_POWER_ITERATIONS,
+               useLanczos ? "Lanczos" : "power");
+        printf("timing: Chebyshev setup: %e\n", escript::gettime()-time0);
+    }
+    return out;
+}
+
+/*
+ * sets x = p(D^{-1}*A)*D^{-1}*b using the three-term recurrence of the
+ * Chebyshev iteration with zero initial guess, see e.g. Y. Saad: Iterative
+ * Methods for Sparse Linear Systems, 2nd ed., Algorithm 12.1
+ */
+void Preconditioner_Chebyshev_solve(LinearOperator* A,
+        Preconditioner_Chebyshev* prec, double* x, const double* b)
+{
+    const dim_t n = prec->n;
+    const double theta = (prec->lambda_max+prec->lambda_min)/2.;
+    const double delta = (prec->lambda_max-prec->lambda_min)/2.;
+    const double sigma = theta/delta;
+    const double* inv_diag = prec->inv_diag;
+    double* r = prec->r;
+    double* d = prec->d;
+    double rho = 1./sigma;
+
+#pragma omp parallel for schedule(static)
+    for (index_t i=0; i<n; ++i) {
+        d[i] = inv_diag[i]*b[i]/theta;
+        x[i] = d[i];
+    }
+    for (dim_t k=1; k<prec->degree; ++k) {
+        util::copy(n, r, b);
+        A->matrixVector(-1., x, 1., r);
+        const double rho_new = 1./(2.*sigma-rho);
+        const double c0 = rho_new*rho;
+        const double c1 = 2.*rho_new/delta;
+#pragma omp parallel for schedule(static)
+        for (index_t i=0; i<n; ++i) {
+            d[i] = c0*d[i] + c1*inv_diag[i]*r[i];
+            x[i] += d[i];
+        }
+        rho = rho_new;
+    }
+}
+
+} // namespace paso
+
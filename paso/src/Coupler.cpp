@@ -28,16 +28,19 @@ namespace paso {
 
 template<typename Scalar>
 Coupler<Scalar>::Coupler(const_Connector_ptr conn, dim_t blockSize,
-                         escript::JMPI mpiInfo) :
+                         escript::JMPI mpiInfo, bool persistent) :
     connector(conn),
     block_size(blockSize),
     in_use(false),
+    persistent(persistent),
+    requests_initialized(false),
     data(NULL),
     send_buffer(NULL),
     recv_buffer(NULL),
     mpi_requests(NULL),
     mpi_stati(NULL),
-    mpi_info(mpiInfo)
+    mpi_info(mpiInfo),
+    comm(mpiInfo->comm)
 {
 #ifdef ESYS_MPI
     mpi_requests = new MPI_Request[conn->send->neighbour.size() +
@@ -47,6 +50,10 @@ Coupler<Scalar>::Coupler(const_Connector_ptr conn, dim_t blockSize,
     if (mpi_info->size > 1) {
         send_buffer = new Scalar[conn->send->numSharedComponents * block_size];
         recv_buffer = new Scalar[conn->recv->numSharedComponents * block_size];
+        // the fixed tags of the persistent requests must not match messages
+        // of other exchanges, so these use their own communicator
+        if (persistent)
+            MPI_Comm_dup(mpi_info->comm, &comm);
     }
 #endif
 }
@@ -55,6 +62,20 @@ template<typename Scalar>
 Coupler<Scalar>::~Coupler()
 {
 #ifdef ESYS_MPI
+    if (persistent && mpi_info->size > 1) {
+        // couplers may outlive MPI when held by Python objects
+        int finalized = 0;
+        MPI_Finalized(&finalized);
+        if (!finalized) {
+            if (requests_initialized) {
+                const dim_t numRequests = connector->recv->neighbour.size() +
+                                          connector->send->neighbour.size();
+                for (dim_t i=0; i < numRequests; ++i)
+                    MPI_Request_free(&mpi_requests[i]);
+            }
+            MPI_Comm_free(&comm);
+        }
+    }
     delete[] send_buffer;
     delete[] recv_buffer;
     delete[] mpi_requests;
@@ -72,13 +93,39 @@ void Coupler<Scalar>::startCollect(const Scalar* in)
             throw PasoException("Coupler::startCollect: Coupler in use.");
         }
         MPI_Datatype mpiType = (sizeof(Scalar) == sizeof(double) ? MPI_DOUBLE : MPI_DOUBLE_COMPLEX);
+        const dim_t numRecv = connector->recv->neighbour.size();
+        const dim_t numSend = connector->send->neighbour.size();
+        if (persistent && !requests_initialized) {
+            // the requests are created at the first exchange and are bound
+            // to the coupler's own communicator, so the tag is simply the
+            // rank of the sender. Standard mode sends are used so small
+            // messages can go out eagerly.
+            for (dim_t i=0; i < numRecv; ++i) {
+                MPI_Recv_init(&recv_buffer[connector->recv->offsetInShared[i]*block_size],
+                        (connector->recv->offsetInShared[i+1]-connector->recv->offsetInShared[i])*block_size,
+                        mpiType, connector->recv->neighbour[i],
+                        connector->recv->neighbour[i], comm,
+                        &mpi_requests[i]);
+            }
+            for (dim_t i=0; i < numSend; ++i) {
+                MPI_Send_init(&send_buffer[connector->send->offsetInShared[i]*block_size],
+                        (connector->send->offsetInShared[i+1] - connector->send->offsetInShared[i])*block_size,
+                        mpiType, connector->send->neighbour[i],
+                        mpi_info->rank, comm, &mpi_requests[i+numRecv]);
+            }
+            requests_initialized = true;
+        }
         // start receiving input
-        for (dim_t i=0; i < connector->recv->neighbour.size(); ++i) {
-            MPI_Irecv(&recv_buffer[connector->recv->offsetInShared[i]*block_size],
-                    (connector->recv->offsetInShared[i+1]-connector->recv->offsetInShared[i])*block_size,
-                    mpiType, connector->recv->neighbour[i],
-                    mpi_info->counter()+connector->recv->neighbour[i],
-                    mpi_info->comm, &mpi_requests[i]);
+        if (persistent) {
+            MPI_Startall(numRecv, mpi_requests);
+        } else {
+            for (dim_t i=0; i < numRecv; ++i) {
+                MPI_Irecv(&recv_buffer[connector->recv->offsetInShared[i]*block_size],
+                        (connector->recv->offsetInShared[i+1]-connector->recv->offsetInShared[i])*block_size,
+                        mpiType, connector->recv->neighbour[i],
+                        mpi_info->counter()+connector->recv->neighbour[i],
+                        mpi_info->comm, &mpi_requests[i]);
+            }
         }
         // collect values into buffer
         const int numSharedSend = connector->send->numSharedComponents;
@@ -97,14 +144,18 @@ void Coupler<Scalar>::startCollect(const Scalar* in)
             }
         }
         // send buffer out
-        for (dim_t i=0; i < connector->send->neighbour.size(); ++i) {
-            MPI_Issend(&send_buffer[connector->send->offsetInShared[i]*block_size],
-                    (connector->send->offsetInShared[i+1] - connector->send->offsetInShared[i])*block_size,
-                    mpiType, connector->send->neighbour[i],
-                    mpi_info->counter()+mpi_info->rank, mpi_info->comm,
-                    &mpi_requests[i+connector->recv->neighbour.size()]);
+        if (persistent) {
+            MPI_Startall(numSend, &mpi_requests[numRecv]);
+        } else {
+            for (dim_t i=0; i < numSend; ++i) {
+                MPI_Issend(&send_buffer[connector->send->offsetInShared[i]*block_size],
+                        (connector->send->offsetInShared[i+1] - connector->send->offsetInShared[i])*block_size,
+                        mpiType, connector->send->neighbour[i],
+                        mpi_info->counter()+mpi_info->rank, mpi_info->comm,
+                        &mpi_requests[i+numRecv]);
+            }
+            mpi_info->incCounter(mpi_info->size);
         }
-        mpi_info->incCounter(mpi_info->size);
         in_use = true;
     }
 #endif
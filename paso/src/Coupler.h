@@ -98,7 +98,14 @@ struct Connector
 template<typename Scalar>
 struct Coupler
 {
-    Coupler(const_Connector_ptr, dim_t blockSize, escript::JMPI mpiInfo);
+    /// if `persistent` is true the MPI send and receive requests are
+    /// created once (at the first exchange) and restarted by every
+    /// subsequent startCollect. Use this for couplers that perform many
+    /// exchanges, e.g. in matrix-vector products. A persistent coupler
+    /// communicates on a duplicate of the communicator of mpiInfo, so the
+    /// constructor is collective.
+    Coupler(const_Connector_ptr, dim_t blockSize, escript::JMPI mpiInfo,
+            bool persistent=false);
     ~Coupler();
 
     void startCollect(const Scalar* in);
@@ -139,6 +146,9 @@ struct Coupler
     const_Connector_ptr connector;
     dim_t block_size;
     bool in_use;
+    bool persistent;
+    // true once the persistent requests have been created
+    bool requests_initialized;
 
     // unmanaged pointer to data to be sent
     Scalar* data;
@@ -147,6 +157,8 @@ struct Coupler
     MPI_Request* mpi_requests;
     MPI_Status* mpi_stati;
     escript::JMPI mpi_info;
+    // communicator of the messages, a duplicate for persistent couplers
+    MPI_Comm comm;
 };
 
 
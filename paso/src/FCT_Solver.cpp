@@ -42,13 +42,52 @@ namespace paso {
 
 static const real_t LARGE_POSITIVE_FLOAT = escript::DataTypes::real_t_max();
 
+// returns a matrix for the diagonal entries of the blocks of A. Entries
+// outside the diagonals are not used by the FCT scheme so this keeps the
+// memory traffic per component at the level of block size 1.
+static SystemMatrix_ptr makeDiagonalBlocks(SystemMatrix_ptr A)
+{
+    const dim_t nb = A->row_block_size;
+    if (nb == 1)
+        return A;
+
+    return SystemMatrix_ptr(new SystemMatrix(
+                A->type | MATRIX_FORMAT_DIAGONAL_BLOCK, A->pattern, nb, nb,
+                true, A->getRowFunctionSpace(), A->getColumnFunctionSpace()));
+}
+
+// copies the diagonal entries of the blocks of A into out which has been
+// created by makeDiagonalBlocks(A)
+static void copyDiagonalBlocks(SystemMatrix_ptr out, const_SystemMatrix_ptr A)
+{
+    if (out == A)
+        return;
+
+    const dim_t nb = A->row_block_size;
+    const SparseMatrix* in_blocks[2] = { A->mainBlock.get(),
+                                         A->col_coupleBlock.get() };
+    SparseMatrix* out_blocks[2] = { out->mainBlock.get(),
+                                    out->col_coupleBlock.get() };
+    for (int b = 0; b < 2; b++) {
+        const double* in_val = in_blocks[b]->val;
+        double* out_val = out_blocks[b]->val;
+        const dim_t numEntries = in_blocks[b]->pattern->len;
+#pragma omp parallel for
+        for (index_t iptr = 0; iptr < numEntries; ++iptr) {
+            for (dim_t k = 0; k < nb; ++k)
+                out_val[iptr*nb+k] = in_val[iptr*nb*nb+k*(nb+1)];
+        }
+    }
+}
+
 FCT_Solver::FCT_Solver(const_TransportProblem_ptr tp, Options* options) :
-    transportproblem(tp),
+    transportproblem(tp.get()),
     omega(0),
+    dt(0),
     z(NULL),
     du(NULL)
 {
-    const dim_t blockSize = tp->getBlockSize();
+    const dim_t blockSize = tp->transport_matrix->row_block_size;
     const dim_t n = tp->getTotalNumRows();
     mpi_info = tp->mpi_info;
     flux_limiter = new FCT_FluxLimiter(tp);
@@ -57,8 +96,13 @@ FCT_Solver::FCT_Solver(const_TransportProblem_ptr tp, Options* options) :
         du = new double[n];
         z = new double[n];
     }
-    u_coupler.reset(new Coupler<real_t>(tp->borrowConnector(), blockSize, mpi_info));
-    u_old_coupler.reset(new Coupler<real_t>(tp->borrowConnector(), blockSize, mpi_info));
+    u_coupler.reset(new Coupler<real_t>(tp->borrowConnector(), blockSize, mpi_info, true));
+    u_old_coupler.reset(new Coupler<real_t>(tp->borrowConnector(), blockSize, mpi_info, true));
+    mass_matrix = makeDiagonalBlocks(tp->mass_matrix);
+    transport_matrix = makeDiagonalBlocks(tp->transport_matrix);
+    // the main diagonal is not used
+    low_order_matrix = makeDiagonalBlocks(tp->iteration_matrix);
+    setMatrices();
 
     if (options->ode_solver == PASO_LINEAR_CRANK_NICOLSON) {
         method = PASO_LINEAR_CRANK_NICOLSON;
@@ -79,29 +123,47 @@ FCT_Solver::~FCT_Solver()
     delete[] du;
 }
 
+void FCT_Solver::setMatrices()
+{
+    copyDiagonalBlocks(mass_matrix, transportproblem->mass_matrix);
+    copyDiagonalBlocks(transport_matrix, transportproblem->transport_matrix);
+    copyDiagonalBlocks(low_order_matrix, transportproblem->iteration_matrix);
+    // the iteration matrix has been rebuilt
+    dt = 0.;
+}
+
 // modifies the main diagonal of the iteration matrix to introduce new dt
 void FCT_Solver::initialize(double _dt, Options* options, Performance* pp)
 {
     const real_t EPSILON = escript::DataTypes::real_t_eps();
-    const_TransportProblem_ptr fctp(transportproblem);
+    const TransportProblem* fctp = transportproblem;
+    // the iteration matrix and its preconditioner are still valid
+    if (_dt == dt && fctp->iteration_matrix->solver_p != NULL)
+        return;
+
     const index_t* main_iptr = fctp->borrowMainDiagonalPointer();
-    const dim_t n = fctp->transport_matrix->getTotalNumRows();
+    const dim_t nb = fctp->iteration_matrix->row_block_size;
+    const dim_t nblk = fctp->iteration_matrix->block_size;
+    const dim_t numRows = fctp->iteration_matrix->getNumRows();
     const double theta = getTheta();
     omega = 1. / (_dt * theta);
-    dim_t i;
     Options options2;
 
     solve_free(fctp->iteration_matrix.get());
     //   fctp->iteration_matrix[i,i]=m[i]/(dt theta) -l[i,i]
     dt = _dt;
-    #pragma omp parallel for private(i)
-    for (i = 0; i < n; ++i) {
-        const double m_i = fctp->lumped_mass_matrix[i];
-        const double l_ii = fctp->main_diagonal_low_order_transport_matrix[i];
-        if ( m_i > 0 ) {
-            fctp->iteration_matrix->mainBlock->val[main_iptr[i]] = m_i * omega - l_ii;
-        } else {
-            fctp->iteration_matrix->mainBlock->val[main_iptr[i]] = std::abs(m_i * omega - l_ii)/(EPSILON*EPSILON);
+#pragma omp parallel for
+    for (index_t ir = 0; ir < numRows; ++ir) {
+        for (dim_t k = 0; k < nb; ++k) {
+            const index_t i = ir*nb+k;
+            const index_t iptr_ii = main_iptr[ir]*nblk+k*(nb+1);
+            const double m_i = fctp->lumped_mass_matrix[i];
+            const double l_ii = fctp->main_diagonal_low_order_transport_matrix[i];
+            if ( m_i > 0 ) {
+                fctp->iteration_matrix->mainBlock->val[iptr_ii] = m_i * omega - l_ii;
+            } else {
+                fctp->iteration_matrix->mainBlock->val[iptr_ii] = std::abs(m_i * omega - l_ii)/(EPSILON*EPSILON);
+            }
         }
     }
 
@@ -143,11 +205,14 @@ SolverResult FCT_Solver::update(double* u, double* u_old, Options* options,
 SolverResult FCT_Solver::updateLCN(double* u, double* u_old, Options* options,
                                    Performance* pp)
 {
-    dim_t sweep_max, i;
+    dim_t sweep_max;
     double const RTOL = options->tolerance;
     const dim_t n = transportproblem->getTotalNumRows();
     SystemMatrix_ptr iteration_matrix(transportproblem->iteration_matrix);
     const index_t* main_iptr = transportproblem->borrowMainDiagonalPointer();
+    const dim_t nb = iteration_matrix->row_block_size;
+    const dim_t nblk = iteration_matrix->block_size;
+    const dim_t numRows = iteration_matrix->getNumRows();
     SolverResult errorCode = NoError;
     double norm_u_tilde;
 
@@ -173,12 +238,15 @@ SolverResult FCT_Solver::updateLCN(double* u, double* u_old, Options* options,
 
     util::scale(n, b, omega);
     // solve (m-dt/2*L) u = b in the form (omega*m-L) u = b * omega with omega*dt/2=1
-   #pragma omp for private(i) schedule(static)
-    for (i = 0; i < n; ++i) {
-       if (!(transportproblem->lumped_mass_matrix[i] > 0)) {
-         b[i] = flux_limiter->u_tilde[i]
-             * transportproblem->iteration_matrix->mainBlock->val[main_iptr[i]];
-       }
+#pragma omp parallel for
+    for (index_t ir = 0; ir < numRows; ++ir) {
+        for (dim_t k = 0; k < nb; ++k) {
+            const index_t i = ir*nb+k;
+            if (!(transportproblem->lumped_mass_matrix[i] > 0)) {
+                b[i] = flux_limiter->u_tilde[i]
+                    * iteration_matrix->mainBlock->val[main_iptr[ir]*nblk+k*(nb+1)];
+            }
+        }
     }
     // initial guess is u<- -u + 2*u_tilde
     util::update(n, -1., u, 2., flux_limiter->u_tilde);
@@ -216,7 +284,7 @@ SolverResult FCT_Solver::updateNL(double* u, double* u_old, Options* options,
     // expected value of convergence rate
     const double critical_rate = 0.95;
 
-    const_TransportProblem_ptr fctp(transportproblem);
+    const TransportProblem* fctp = transportproblem;
     dim_t i;
     double norm_u_tilde, norm_du=LARGE_POSITIVE_FLOAT, norm_du_old, rate=1.;
     const dim_t n = fctp->transport_matrix->getTotalNumRows();
@@ -389,46 +457,50 @@ void FCT_Solver::setAntiDiffusionFlux_CN(SystemMatrix_ptr flux_matrix)
     const double* remote_u = u_coupler->borrowRemoteData();
     const double* remote_u_old = u_old_coupler->borrowRemoteData();
     const double dt_half = dt/2;
-    const_TransportProblem_ptr fct(transportproblem);
-    const_SystemMatrixPattern_ptr pattern(fct->iteration_matrix->pattern);
-    const dim_t n = fct->iteration_matrix->getTotalNumRows();
+    const_SystemMatrixPattern_ptr pattern(low_order_matrix->pattern);
+    const dim_t nb = low_order_matrix->row_block_size;
+    const dim_t numRows = low_order_matrix->getNumRows();
 
 #pragma omp parallel for
-    for (dim_t i = 0; i < n; ++i) {
-        const double u_i = u[i];
-        const double u_old_i = u_old[i];
-
-        #pragma ivdep
-        for (index_t iptr_ij = pattern->mainPattern->ptr[i];
-                     iptr_ij < pattern->mainPattern->ptr[i+1]; ++iptr_ij) {
-            const index_t j   = pattern->mainPattern->index[iptr_ij];
-            const double m_ij = fct->mass_matrix->mainBlock->val[iptr_ij];
-            // this is in fact -d_ij
-            const double d_ij = fct->transport_matrix->mainBlock->val[iptr_ij]+
-                fct->iteration_matrix->mainBlock->val[iptr_ij];
-            const double u_old_j = u_old[j];
-            const double u_j = u[j];
-
-            // (m_{ij} - dt (1-theta) d_{ij}) (u_old[j]-u_old[i]) - (m_{ij} + dt theta d_{ij}) (u[j]-u[i])
-            flux_matrix->mainBlock->val[iptr_ij] =
-                (m_ij+dt_half*d_ij)*(u_old_j-u_old_i) -
-                        (m_ij-dt_half*d_ij)*(u_j-u_i);
+    for (index_t ir = 0; ir < numRows; ++ir) {
+        for (dim_t k = 0; k < nb; ++k) {
+            const double u_i = u[ir*nb+k];
+            const double u_old_i = u_old[ir*nb+k];
 
-        }
-        #pragma ivdep
-        for (index_t iptr_ij = pattern->col_couplePattern->ptr[i];
-                   iptr_ij < pattern->col_couplePattern->ptr[i+1]; iptr_ij++) {
-            const index_t j = pattern->col_couplePattern->index[iptr_ij];
-            const double m_ij = fct->mass_matrix->col_coupleBlock->val[iptr_ij];
-            // this is in fact -d_ij
-            const double d_ij =
-                fct->transport_matrix->col_coupleBlock->val[iptr_ij] +
-                fct->iteration_matrix->col_coupleBlock->val[iptr_ij];
-            const double u_old_j = remote_u_old[j];
-            const double u_j = remote_u[j];
-            flux_matrix->col_coupleBlock->val[iptr_ij] =
-                (m_ij+dt_half*d_ij)*(u_old_j-u_old_i) -
-                        (m_ij-dt_half*d_ij)*(u_j-u_i);
+            #pragma ivdep
+            for (index_t iptr_ij = pattern->mainPattern->ptr[ir];
+                         iptr_ij < pattern->mainPattern->ptr[ir+1]; ++iptr_ij) {
+                const index_t j = pattern->mainPattern->index[iptr_ij]*nb+k;
+                const index_t iptr = iptr_ij*nb+k;
+                const double m_ij = mass_matrix->mainBlock->val[iptr];
+                // this is in fact -d_ij
+                const double d_ij = transport_matrix->mainBlock->val[iptr]+
+                    low_order_matrix->mainBlock->val[iptr];
+                const double u_old_j = u_old[j];
+                const double u_j = u[j];
+
+                // (m_{ij} - dt (1-theta) d_{ij}) (u_old[j]-u_old[i]) - (m_{ij} + dt theta d_{ij}) (u[j]-u[i])
+                flux_matrix->mainBlock->val[iptr] =
+                    (m_ij+dt_half*d_ij)*(u_old_j-u_old_i) -
+                            (m_ij-dt_half*d_ij)*(u_j-u_i);
+
+            }
+            #pragma ivdep
+            for (index_t iptr_ij = pattern->col_couplePattern->ptr[ir];
+                       iptr_ij < pattern->col_couplePattern->ptr[ir+1]; iptr_ij++) {
+                const index_t j = pattern->col_couplePattern->index[iptr_ij]*nb+k;
+                const index_t iptr = iptr_ij*nb+k;
+                const double m_ij = mass_matrix->col_coupleBlock->val[iptr];
+                // this is in fact -d_ij
+                const double d_ij =
+                    transport_matrix->col_coupleBlock->val[iptr] +
+                    low_order_matrix->col_coupleBlock->val[iptr];
+                const double u_old_j = remote_u_old[j];
+                const double u_j = remote_u[j];
+                flux_matrix->col_coupleBlock->val[iptr] =
+                    (m_ij+dt_half*d_ij)*(u_old_j-u_old_i) -
+                            (m_ij-dt_half*d_ij)*(u_j-u_i);
+            }
         }
     }
 }
@@ -439,42 +511,46 @@ void FCT_Solver::setAntiDiffusionFlux_BE(SystemMatrix_ptr flux_matrix)
     const double* u_old = u_old_coupler->borrowLocalData();
     const double* remote_u = u_coupler->borrowRemoteData();
     const double* remote_u_old = u_old_coupler->borrowRemoteData();
-    const_TransportProblem_ptr fct(transportproblem);
-    const_SystemMatrixPattern_ptr pattern(fct->iteration_matrix->pattern);
-    const dim_t n = fct->iteration_matrix->getTotalNumRows();
+    const_SystemMatrixPattern_ptr pattern(low_order_matrix->pattern);
+    const dim_t nb = low_order_matrix->row_block_size;
+    const dim_t numRows = low_order_matrix->getNumRows();
 
 #pragma omp parallel for
-    for (dim_t i = 0; i < n; ++i) {
-        const double u_i = u[i];
-        const double u_old_i = u_old[i];
-        #pragma ivdep
-        for (index_t iptr_ij = pattern->mainPattern->ptr[i];
-                     iptr_ij < pattern->mainPattern->ptr[i+1]; iptr_ij++) {
-            const index_t j = pattern->mainPattern->index[iptr_ij];
-            const double m_ij = fct->mass_matrix->mainBlock->val[iptr_ij];
-            // this is in fact -d_ij
-            const double d_ij = fct->transport_matrix->mainBlock->val[iptr_ij]+
-                fct->iteration_matrix->mainBlock->val[iptr_ij];
-            const double u_old_j = u_old[j];
-            const double u_j = u[j];
-
-            flux_matrix->mainBlock->val[iptr_ij] =
-                m_ij*(u_old_j-u_old_i) - (m_ij-dt*d_ij)*(u_j-u_i);
-        }
-        #pragma ivdep
-        for (index_t iptr_ij = pattern->col_couplePattern->ptr[i];
-                   iptr_ij < pattern->col_couplePattern->ptr[i+1]; iptr_ij++) {
-            const index_t j = pattern->col_couplePattern->index[iptr_ij];
-            const double m_ij = fct->mass_matrix->col_coupleBlock->val[iptr_ij];
-            // this is in fact -d_ij
-            const double d_ij =
-                fct->transport_matrix->col_coupleBlock->val[iptr_ij] +
-                fct->iteration_matrix->col_coupleBlock->val[iptr_ij];
-            const double u_old_j = remote_u_old[j];
-            const double u_j = remote_u[j];
-
-            flux_matrix->col_coupleBlock->val[iptr_ij] =
-                m_ij*(u_old_j-u_old_i) - (m_ij-dt*d_ij)*(u_j-u_i);
+    for (index_t ir = 0; ir < numRows; ++ir) {
+        for (dim_t k = 0; k < nb; ++k) {
+            const double u_i = u[ir*nb+k];
+            const double u_old_i = u_old[ir*nb+k];
+            #pragma ivdep
+            for (index_t iptr_ij = pattern->mainPattern->ptr[ir];
+                         iptr_ij < pattern->mainPattern->ptr[ir+1]; iptr_ij++) {
+                const index_t j = pattern->mainPattern->index[iptr_ij]*nb+k;
+                const index_t iptr = iptr_ij*nb+k;
+                const double m_ij = mass_matrix->mainBlock->val[iptr];
+                // this is in fact -d_ij
+                const double d_ij = transport_matrix->mainBlock->val[iptr]+
+                    low_order_matrix->mainBlock->val[iptr];
+                const double u_old_j = u_old[j];
+                const double u_j = u[j];
+
+                flux_matrix->mainBlock->val[iptr] =
+                    m_ij*(u_old_j-u_old_i) - (m_ij-dt*d_ij)*(u_j-u_i);
+            }
+            #pragma ivdep
+            for (index_t iptr_ij = pattern->col_couplePattern->ptr[ir];
+                       iptr_ij < pattern->col_couplePattern->ptr[ir+1]; iptr_ij++) {
+                const index_t j = pattern->col_couplePattern->index[iptr_ij]*nb+k;
+                const index_t iptr = iptr_ij*nb+k;
+                const double m_ij = mass_matrix->col_coupleBlock->val[iptr];
+                // this is in fact -d_ij
+                const double d_ij =
+                    transport_matrix->col_coupleBlock->val[iptr] +
+                    low_order_matrix->col_coupleBlock->val[iptr];
+                const double u_old_j = remote_u_old[j];
+                const double u_j = remote_u[j];
+
+                flux_matrix->col_coupleBlock->val[iptr] =
+                    m_ij*(u_old_j-u_old_i) - (m_ij-dt*d_ij)*(u_j-u_i);
+            }
         }
     }
 }
@@ -496,50 +572,55 @@ void FCT_Solver::setAntiDiffusionFlux_linearCN(SystemMatrix_ptr flux_matrix)
     const double* u_old = u_old_coupler->borrowLocalData();
     const double* remote_u_tilde = u_tilde_coupler->borrowRemoteData();
     const double* remote_u_old = u_old_coupler->borrowRemoteData();
-    const_TransportProblem_ptr fct(transportproblem);
-    const_SystemMatrixPattern_ptr pattern(fct->iteration_matrix->pattern);
-    const dim_t n = fct->iteration_matrix->getTotalNumRows();
+    const_SystemMatrixPattern_ptr pattern(low_order_matrix->pattern);
+    const dim_t nb = low_order_matrix->row_block_size;
+    const dim_t numRows = low_order_matrix->getNumRows();
 
 #pragma omp parallel for
-    for (dim_t i = 0; i < n; ++i) {
-        const double u_tilde_i = u_tilde[i];
-        const double u_old_i = u_old[i];
-        const double du_i = u_tilde_i - u_old_i;
-        #pragma ivdep
-        for (index_t iptr_ij = pattern->mainPattern->ptr[i];
-                     iptr_ij < pattern->mainPattern->ptr[i+1]; iptr_ij++) {
-            const index_t j = pattern->mainPattern->index[iptr_ij];
-            const double m_ij = fct->mass_matrix->mainBlock->val[iptr_ij];
-            // this is in fact -d_ij
-            const double d_ij = fct->transport_matrix->mainBlock->val[iptr_ij]+
-                fct->iteration_matrix->mainBlock->val[iptr_ij];
-            const double u_tilde_j = u_tilde[j];
-            const double u_old_j = u_old[j];
-            const double du_j = u_tilde_j - u_old_j;
-
-            flux_matrix->mainBlock->val[iptr_ij] = 2 * m_ij * ( du_i - du_j ) -
-                                          dt * d_ij * ( u_tilde_i - u_tilde_j);
-        }
-        #pragma ivdep
-        for (index_t iptr_ij=pattern->col_couplePattern->ptr[i];
-                     iptr_ij<pattern->col_couplePattern->ptr[i+1]; iptr_ij++) {
-
-            const index_t j = pattern->col_couplePattern->index[iptr_ij];
-            const double m_ij = fct->mass_matrix->col_coupleBlock->val[iptr_ij];
-            // this is in fact -d_ij
-            const double d_ij =
-                fct->transport_matrix->col_coupleBlock->val[iptr_ij] +
-                fct->iteration_matrix->col_coupleBlock->val[iptr_ij];
-            const double u_tilde_j = remote_u_tilde[j];
-            const double u_old_j = remote_u_old[j];
-            const double du_j = u_tilde_j - u_old_j;
-
-            flux_matrix->col_coupleBlock->val[iptr_ij] =
-                2*m_ij * ( du_i - du_j ) - dt * d_ij * (u_tilde_i - u_tilde_j);
+    for (index_t ir = 0; ir < numRows; ++ir) {
+        for (dim_t k = 0; k < nb; ++k) {
+            const double u_tilde_i = u_tilde[ir*nb+k];
+            const double u_old_i = u_old[ir*nb+k];
+            const double du_i = u_tilde_i - u_old_i;
+            #pragma ivdep
+            for (index_t iptr_ij = pattern->mainPattern->ptr[ir];
+                         iptr_ij < pattern->mainPattern->ptr[ir+1]; iptr_ij++) {
+                const index_t j = pattern->mainPattern->index[iptr_ij]*nb+k;
+                const index_t iptr = iptr_ij*nb+k;
+                const double m_ij = mass_matrix->mainBlock->val[iptr];
+                // this is in fact -d_ij
+                const double d_ij = transport_matrix->mainBlock->val[iptr]+
+                    low_order_matrix->mainBlock->val[iptr];
+                const double u_tilde_j = u_tilde[j];
+                const double u_old_j = u_old[j];
+                const double du_j = u_tilde_j - u_old_j;
+
+                flux_matrix->mainBlock->val[iptr] = 2 * m_ij * ( du_i - du_j ) -
+                                              dt * d_ij * ( u_tilde_i - u_tilde_j);
+            }
+            #pragma ivdep
+            for (index_t iptr_ij=pattern->col_couplePattern->ptr[ir];
+                         iptr_ij<pattern->col_couplePattern->ptr[ir+1]; iptr_ij++) {
+
+                const index_t j = pattern->col_couplePattern->index[iptr_ij]*nb+k;
+                const index_t iptr = iptr_ij*nb+k;
+                const double m_ij = mass_matrix->col_coupleBlock->val[iptr];
+                // this is in fact -d_ij
+                const double d_ij =
+                    transport_matrix->col_coupleBlock->val[iptr] +
+                    low_order_matrix->col_coupleBlock->val[iptr];
+                const double u_tilde_j = remote_u_tilde[j];
+                const double u_old_j = remote_u_old[j];
+                const double du_j = u_tilde_j - u_old_j;
+
+                flux_matrix->col_coupleBlock->val[iptr] =
+                    2*m_ij * ( du_i - du_j ) - dt * d_ij * (u_tilde_i - u_tilde_j);
+            }
         }
     }
 }
 
+
 /****************************************************************************/
 
 double FCT_Solver::getSafeTimeStepSize(const_TransportProblem_ptr fctp)
@@ -608,56 +689,59 @@ void FCT_Solver::setLowOrderOperator(TransportProblem_ptr fc)
     }
 
     const_SystemMatrixPattern_ptr pattern(fc->iteration_matrix->pattern);
-    const dim_t n = fc->iteration_matrix->getTotalNumRows();
+    const dim_t nb = fc->iteration_matrix->row_block_size;
+    const dim_t nblk = fc->iteration_matrix->block_size;
+    const dim_t numRows = fc->iteration_matrix->getNumRows();
 #pragma omp parallel for
-    for (dim_t i = 0; i < n; ++i) {
-        double sum = fc->transport_matrix->mainBlock->val[main_iptr[i]];
-        //printf("sum[%d] = %e -> ", i, sum);
-
-        // look at a[i,j]
-        for (index_t iptr_ij=pattern->mainPattern->ptr[i];iptr_ij<pattern->mainPattern->ptr[i+1]; ++iptr_ij) {
-            const index_t j = pattern->mainPattern->index[iptr_ij];
-            const double rtmp1 = fc->transport_matrix->mainBlock->val[iptr_ij];
-            if (j != i) {
+    for (index_t i = 0; i < numRows; ++i) {
+        for (dim_t k = 0; k < nb; ++k) {
+            // components are treated independently using the diagonal
+            // entries of the blocks
+            const dim_t kk = k*(nb+1);
+            double sum = fc->transport_matrix->mainBlock->val[main_iptr[i]*nblk+kk];
+
+            // look at a[i,j]
+            for (index_t iptr_ij=pattern->mainPattern->ptr[i];iptr_ij<pattern->mainPattern->ptr[i+1]; ++iptr_ij) {
+                const index_t j = pattern->mainPattern->index[iptr_ij];
+                const double rtmp1 = fc->transport_matrix->mainBlock->val[iptr_ij*nblk+kk];
+                if (j != i) {
+                    // find entry a[j,i]
+                    #pragma ivdep
+                    for (index_t iptr_ji=pattern->mainPattern->ptr[j]; iptr_ji<pattern->mainPattern->ptr[j+1]; ++iptr_ji) {
+
+                        if (pattern->mainPattern->index[iptr_ji] == i) {
+                            const double rtmp2=fc->transport_matrix->mainBlock->val[iptr_ji*nblk+kk];
+                            const double d_ij=-MIN3(0.,rtmp1,rtmp2);
+                            fc->iteration_matrix->mainBlock->val[iptr_ij*nblk+kk]=-(rtmp1+d_ij);
+                            sum-=d_ij;
+                            break;
+                        }
+                    }
+                }
+            }
+            for (index_t iptr_ij=pattern->col_couplePattern->ptr[i];iptr_ij<pattern->col_couplePattern->ptr[i+1]; ++iptr_ij) {
+                const index_t j = pattern->col_couplePattern->index[iptr_ij];
+                const double rtmp1 = fc->transport_matrix->col_coupleBlock->val[iptr_ij*nblk+kk];
                 // find entry a[j,i]
                 #pragma ivdep
-                for (index_t iptr_ji=pattern->mainPattern->ptr[j]; iptr_ji<pattern->mainPattern->ptr[j+1]; ++iptr_ji) {
-
-                    if (pattern->mainPattern->index[iptr_ji] == i) {
-                        const double rtmp2=fc->transport_matrix->mainBlock->val[iptr_ji];
-                        //printf("a[%d,%d]=%e\n",i,j,rtmp1);
-                        //printf("a[%d,%d]=%e\n",j,i,rtmp2);
+                for (index_t iptr_ji=pattern->row_couplePattern->ptr[j]; iptr_ji<pattern->row_couplePattern->ptr[j+1]; ++iptr_ji) {
+                    if (pattern->row_couplePattern->index[iptr_ji]==i) {
+                        const double rtmp2=fc->transport_matrix->row_coupleBlock->val[iptr_ji*nblk+kk];
                         const double d_ij=-MIN3(0.,rtmp1,rtmp2);
-                        fc->iteration_matrix->mainBlock->val[iptr_ij]=-(rtmp1+d_ij);
-//printf("l[%d,%d]=%e\n",i,j,fc->iteration_matrix->mainBlock->val[iptr_ij]);
+                        fc->iteration_matrix->col_coupleBlock->val[iptr_ij*nblk+kk]=-(rtmp1+d_ij);
+                        fc->iteration_matrix->row_coupleBlock->val[iptr_ji*nblk+kk]=-(rtmp2+d_ij);
                         sum-=d_ij;
                         break;
                     }
                 }
             }
+            // set main diagonal entry
+            fc->main_diagonal_low_order_transport_matrix[i*nb+k] = sum;
         }
-        for (index_t iptr_ij=pattern->col_couplePattern->ptr[i];iptr_ij<pattern->col_couplePattern->ptr[i+1]; ++iptr_ij) {
-            const index_t j = pattern->col_couplePattern->index[iptr_ij];
-            const double rtmp1 = fc->transport_matrix->col_coupleBlock->val[iptr_ij];
-            // find entry a[j,i]
-            #pragma ivdep
-            for (index_t iptr_ji=pattern->row_couplePattern->ptr[j]; iptr_ji<pattern->row_couplePattern->ptr[j+1]; ++iptr_ji) {
-                if (pattern->row_couplePattern->index[iptr_ji]==i) {
-                    const double rtmp2=fc->transport_matrix->row_coupleBlock->val[iptr_ji];
-                    const double d_ij=-MIN3(0.,rtmp1,rtmp2);
-                    fc->iteration_matrix->col_coupleBlock->val[iptr_ij]=-(rtmp1+d_ij);
-                    fc->iteration_matrix->row_coupleBlock->val[iptr_ji]=-(rtmp2+d_ij);
-                    sum-=d_ij;
-                    break;
-                }
-            }
-        }
-        // set main diagonal entry
-        fc->main_diagonal_low_order_transport_matrix[i] = sum;
-        //printf("%e\n", sum);
     }
 }
 
+
 /*
  * out_i=m_i u_i + a * \sum_{j <> i} l_{ij} (u_j-u_i) where m_i>0
  *       = u_i                                        where m_i<=0
@@ -665,12 +749,14 @@ void FCT_Solver::setLowOrderOperator(TransportProblem_ptr fc)
  */
 void FCT_Solver::setMuPaLu(double* out, const_Coupler_ptr<real_t> coupler, double a)
 {
-    const_SystemMatrix_ptr L(transportproblem->iteration_matrix);
+    const_SystemMatrix_ptr L(low_order_matrix);
     const double* M = transportproblem->lumped_mass_matrix;
     const_SystemMatrixPattern_ptr pattern(L->pattern);
     const double* u = coupler->borrowLocalData();
     const double* remote_u = coupler->borrowRemoteData();
     const dim_t n = L->getTotalNumRows();
+    const dim_t nb = L->row_block_size;
+    const dim_t numRows = L->getNumRows();
 
 #pragma omp parallel for
     for (dim_t i = 0; i < n; ++i) {
@@ -682,27 +768,30 @@ void FCT_Solver::setMuPaLu(double* out, const_Coupler_ptr<real_t> coupler, doubl
     }
     if (std::abs(a) > 0) {
 #pragma omp parallel for
-        for (dim_t i = 0; i < n; ++i) {
-            if (M[i] > 0.) {
-                double sum = 0;
-                const double u_i = u[i];
-                #pragma ivdep
-                for (index_t iptr_ij = pattern->mainPattern->ptr[i];
-                             iptr_ij < pattern->mainPattern->ptr[i+1];
-                             iptr_ij++) {
-                    const index_t j = pattern->mainPattern->index[iptr_ij];
-                    const double l_ij = L->mainBlock->val[iptr_ij];
-                    sum += l_ij*(u[j]-u_i);
-                }
-                #pragma ivdep
-                for (index_t iptr_ij = pattern->col_couplePattern->ptr[i];
-                             iptr_ij < pattern->col_couplePattern->ptr[i+1];
-                             iptr_ij++) {
-                    const index_t j=pattern->col_couplePattern->index[iptr_ij];
-                    const double l_ij = L->col_coupleBlock->val[iptr_ij];
-                    sum += l_ij*(remote_u[j]-u_i);
+        for (index_t ir = 0; ir < numRows; ++ir) {
+            for (dim_t k = 0; k < nb; ++k) {
+                const index_t i = ir*nb+k;
+                if (M[i] > 0.) {
+                    double sum = 0;
+                    const double u_i = u[i];
+                    #pragma ivdep
+                    for (index_t iptr_ij = pattern->mainPattern->ptr[ir];
+                                 iptr_ij < pattern->mainPattern->ptr[ir+1];
+                                 iptr_ij++) {
+                        const index_t j = pattern->mainPattern->index[iptr_ij]*nb+k;
+                        const double l_ij = L->mainBlock->val[iptr_ij*nb+k];
+                        sum += l_ij*(u[j]-u_i);
+                    }
+                    #pragma ivdep
+                    for (index_t iptr_ij = pattern->col_couplePattern->ptr[ir];
+                                 iptr_ij < pattern->col_couplePattern->ptr[ir+1];
+                                 iptr_ij++) {
+                        const index_t j=pattern->col_couplePattern->index[iptr_ij]*nb+k;
+                        const double l_ij = L->col_coupleBlock->val[iptr_ij*nb+k];
+                        sum += l_ij*(remote_u[j]-u_i);
+                    }
+                    out[i] += a*sum;
                 }
-                out[i] += a*sum;
             }
         }
     }
@@ -38,6 +38,11 @@ struct FCT_Solver
 
     void initialize(double dt, Options* options, Performance* pp);
 
+    /// copies the diagonal entries of the blocks of the matrices of the
+    /// transport problem. Needs to be called whenever the matrices of the
+    /// transport problem have been rebuilt.
+    void setMatrices();
+
     static double getSafeTimeStepSize(const_TransportProblem_ptr tp);
 
     static void setLowOrderOperator(TransportProblem_ptr tp);
@@ -55,7 +60,9 @@ struct FCT_Solver
         return method == PASO_BACKWARD_EULER ? 1. : 0.5;
     }
 
-    const_TransportProblem_ptr transportproblem;
+    /// borrowed reference, the transport problem keeps the solver between
+    /// calls of TransportProblem::solve
+    const TransportProblem* transportproblem;
     escript::JMPI mpi_info;
     FCT_FluxLimiter* flux_limiter;
     index_t method;
@@ -66,6 +73,12 @@ struct FCT_Solver
     double* du;
     Coupler_ptr<real_t> u_coupler;
     Coupler_ptr<real_t> u_old_coupler; /* last time step */
+    /// diagonal entries of the blocks of the mass matrix, the transport
+    /// matrix and the (negative) low order transport matrix. For block
+    /// size 1 these are the matrices of the transport problem.
+    SystemMatrix_ptr mass_matrix;
+    SystemMatrix_ptr transport_matrix;
+    SystemMatrix_ptr low_order_matrix;
 };
 
 
@@ -38,6 +38,13 @@ struct FCT_FluxLimiter
         return antidiffusive_fluxes->pattern;
     }
 
+    /// number of components per node. Components are limited independently
+    /// using the diagonal entries of the matrix blocks.
+    inline dim_t getBlockSize() const
+    {
+        return antidiffusive_fluxes->row_block_size;
+    }
+
     void setU_tilde(const double* Mu_tilde);
     void addLimitedFluxes_Start();
     void addLimitedFluxes_Complete(double* b);
@@ -29,6 +29,53 @@ Function::~Function()
 {
 }
 
+LinearOperator::LinearOperator(const escript::JMPI& mpiInfo) :
+    mpi_info(mpiInfo)
+{
+}
+
+LinearOperator::~LinearOperator()
+{
+}
+
+void LinearOperator::solvePreconditioner(double* x, double* b)
+{
+    util::copy(getLen(), x, b);
+}
+
+SystemMatrixOperator::SystemMatrixOperator(SystemMatrix_ptr matrix) :
+    LinearOperator(matrix->mpi_info),
+    A(matrix)
+{
+}
+
+void SystemMatrixOperator::matrixVector(double alpha, const double* x,
+                                        double beta, double* y)
+{
+    A->MatrixVector_CSR_OFFSET0(alpha, x, beta, y);
+}
+
+void SystemMatrixOperator::getDiagonal(double* diag)
+{
+    const dim_t n = A->getNumRows();
+    const dim_t row_block_size = A->row_block_size;
+    const dim_t block_size = A->block_size;
+    const index_t* main_ptr = A->borrowMainDiagonalPointer();
+    const double* val = A->mainBlock->val;
+#pragma omp parallel for schedule(static)
+    for (index_t i=0; i<n; ++i) {
+        for (dim_t ib=0; ib<row_block_size; ++ib) {
+            diag[i*row_block_size+ib] =
+                val[main_ptr[i]*block_size+ib+row_block_size*ib];
+        }
+    }
+}
+
+void SystemMatrixOperator::solvePreconditioner(double* x, double* b)
+{
+    A->solvePreconditioner(x, b);
+}
+
 SolverResult Function::derivative(double* J0w, const double* w, const double* f0,
                            const double* x0, double* setoff, Performance* pp)
 {
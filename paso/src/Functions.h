@@ -58,6 +58,48 @@ struct LinearSystem : public Function
     dim_t n;
 };
 
+/// abstract linear operator which is applied without storing a matrix,
+/// e.g. by computing element matrices on the fly
+struct LinearOperator
+{
+    LinearOperator(const escript::JMPI& mpi_info);
+    virtual ~LinearOperator();
+
+    /// sets y = alpha*A*x + beta*y
+    virtual void matrixVector(double alpha, const double* x, double beta,
+                              double* y) = 0;
+
+    /// copies the main diagonal of A into diag
+    virtual void getDiagonal(double* diag) = 0;
+
+    /// returns the (local) length of the vectors the operator is applied to
+    virtual dim_t getLen() = 0;
+
+    /// sets x = M^{-1}*b for the preconditioner M used with the operator by
+    /// the Krylov solvers. By default no preconditioner is applied.
+    virtual void solvePreconditioner(double* x, double* b);
+
+    const escript::JMPI mpi_info;
+};
+
+/// exposes an assembled SystemMatrix and its preconditioner as a linear
+/// operator
+struct SystemMatrixOperator : public LinearOperator
+{
+    SystemMatrixOperator(SystemMatrix_ptr matrix);
+
+    virtual void matrixVector(double alpha, const double* x, double beta,
+                              double* y);
+
+    virtual void getDiagonal(double* diag);
+
+    virtual dim_t getLen() { return A->getTotalNumRows(); }
+
+    virtual void solvePreconditioner(double* x, double* b);
+
+    SystemMatrix_ptr A;
+};
+
 } // namespace paso
 
 #endif // __PASO_FUNCTIONS_H__
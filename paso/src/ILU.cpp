@@ -27,6 +27,7 @@
 /****************************************************************************/
 
 #include "Paso.h"
+#include "BlockOps.h"
 #include "PasoUtil.h"
 #include "Preconditioner.h"
 
@@ -36,12 +37,64 @@ void Solver_ILU_free(Solver_ILU * in)
 {
     if (in!=NULL) {
         delete[] in->factors;
+        delete[] in->factors_sp;
         delete in;
     }
 }
 
-/// constructs the incomplete block factorization
-Solver_ILU* Solver_getILU(SparseMatrix_ptr A, bool verbose)
+/// eliminates the rows of colour `color` for NxN blocks, 4<=N<=8
+template <int N>
+void Solver_getILU_color(SparseMatrix_ptr A, double* factors,
+                         const index_t* colorOf, const index_t* ptr_main,
+                         index_t color, int* failed)
+{
+    const dim_t n=A->numRows;
+#pragma omp parallel for schedule(static)
+    for (index_t i = 0; i < n; ++i) {
+        if (colorOf[i]==color) {
+            for (index_t color2=0;color2<color;++color2) {
+                for (index_t iptr_ik=A->pattern->ptr[i];iptr_ik<A->pattern->ptr[i+1]; ++iptr_ik) {
+                    const index_t k=A->pattern->index[iptr_ik];
+                    if (colorOf[k]==color2) {
+                        /* a_ij=a_ij-a_ik*a_kj */
+                        for (index_t iptr_kj=A->pattern->ptr[k];iptr_kj<A->pattern->ptr[k+1]; iptr_kj++) {
+                            const index_t j=A->pattern->index[iptr_kj];
+                            if (colorOf[j]>color2) {
+                                for (index_t iptr_ij=A->pattern->ptr[i];iptr_ij<A->pattern->ptr[i+1]; iptr_ij++) {
+                                    if (j==A->pattern->index[iptr_ij]) {
+                                        BlockOps_SMM<N>(&factors[N*N*iptr_ij], &factors[N*N*iptr_ik], &factors[N*N*iptr_kj]);
+                                        break;
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+            const index_t iptr_main=ptr_main[i];
+            double D[N*N];
+            int failed_i=0;
+            BlockOps_invM<N>(D, &factors[N*N*iptr_main], &failed_i);
+            if (failed_i > 0) {
+                *failed=1;
+            } else {
+                BlockOps_Cpy_N(N*N, &factors[N*N*iptr_main], D);
+                /* a_ik=a_ii^{-1}*a_ik */
+                for (index_t iptr_ik=A->pattern->ptr[i];iptr_ik<A->pattern->ptr[i+1]; ++iptr_ik) {
+                    const index_t k=A->pattern->index[iptr_ik];
+                    if (colorOf[k]>color)
+                        BlockOps_MMiP<N>(D, &factors[N*N*iptr_ik]);
+                }
+            }
+        }
+    }
+}
+
+/// constructs the incomplete block factorization. If mixed_precision is set
+/// the factors are stored in single precision once the factorization is
+/// complete.
+Solver_ILU* Solver_getILU(SparseMatrix_ptr A, bool mixed_precision,
+                          bool verbose)
 {
     const dim_t n=A->numRows;
     const dim_t n_block=A->row_block_size;
@@ -53,6 +106,7 @@ Solver_ILU* Solver_getILU(SparseMatrix_ptr A, bool verbose)
     index_t i,iptr_main,iptr_ik,k,iptr_kj,j,iptr_ij,color,color2, iptr;
     Solver_ILU* out=new Solver_ILU;
     out->factors=new double[A->len];
+    out->factors_sp=NULL;
 
     double time0 = escript::gettime();
 
@@ -290,11 +344,31 @@ Solver_ILU* Solver_getILU(SparseMatrix_ptr A, bool verbose)
                 }
             }
         } else {
-            throw PasoException("Solver_getILU: block size greater than 3 is not supported.");
+            int failed=0;
+            switch (n_block) {
+                case 4: Solver_getILU_color<4>(A, out->factors, colorOf, ptr_main, color, &failed); break;
+                case 5: Solver_getILU_color<5>(A, out->factors, colorOf, ptr_main, color, &failed); break;
+                case 6: Solver_getILU_color<6>(A, out->factors, colorOf, ptr_main, color, &failed); break;
+                case 7: Solver_getILU_color<7>(A, out->factors, colorOf, ptr_main, color, &failed); break;
+                case 8: Solver_getILU_color<8>(A, out->factors, colorOf, ptr_main, color, &failed); break;
+                default:
+                    throw PasoException("Solver_getILU: block size greater than 8 is not supported.");
+            }
+            if (failed > 0)
+                throw PasoException("Solver_getILU: non-regular main diagonal block.");
         }
 #pragma omp barrier
     }
 
+    if (mixed_precision) {
+        out->factors_sp=new float[A->len];
+#pragma omp parallel for schedule(static)
+        for (index_t l=0; l<A->len; ++l)
+            out->factors_sp[l]=static_cast<float>(out->factors[l]);
+        delete[] out->factors;
+        out->factors=NULL;
+    }
+
     if (verbose) {
         const double time_fac=escript::gettime()-time0;
         printf("timing: ILU: coloring/elimination: %e sec\n",time_fac);
@@ -313,8 +387,49 @@ Solver_ILU* Solver_getILU(SparseMatrix_ptr A, bool verbose)
    vector is available.
 */
 
-void Solver_solveILU(SparseMatrix_ptr A, Solver_ILU* ilu, double* x,
-                     const double* b)
+/// forward substitution for the rows of colour `color` for NxN blocks
+template <int N, typename T>
+void Solver_solveILU_forward(SparseMatrix_ptr A, const T* factors, double* x,
+                             const index_t* colorOf, const index_t* ptr_main,
+                             index_t color)
+{
+    const dim_t n=A->numRows;
+#pragma omp parallel for schedule(static)
+    for (index_t i = 0; i < n; ++i) {
+        if (colorOf[i]==color) {
+            /* x_i=x_i-a_ik*x_k */
+            for (index_t iptr_ik=A->pattern->ptr[i];iptr_ik<A->pattern->ptr[i+1]; ++iptr_ik) {
+                const index_t k=A->pattern->index[iptr_ik];
+                if (colorOf[k]<color)
+                    BlockOps_SMV<N>(&x[N*i], &factors[N*N*iptr_ik], &x[N*k]);
+            }
+            BlockOps_MViP<N>(&factors[N*N*ptr_main[i]], &x[N*i]);
+        }
+    }
+}
+
+/// backward substitution for the rows of colour `color` for NxN blocks
+template <int N, typename T>
+void Solver_solveILU_backward(SparseMatrix_ptr A, const T* factors, double* x,
+                              const index_t* colorOf, index_t color)
+{
+    const dim_t n=A->numRows;
+#pragma omp parallel for schedule(static)
+    for (index_t i = 0; i < n; ++i) {
+        if (colorOf[i]==color) {
+            /* x_i=x_i-a_ik*x_k */
+            for (index_t iptr_ik=A->pattern->ptr[i];iptr_ik<A->pattern->ptr[i+1]; ++iptr_ik) {
+                const index_t k=A->pattern->index[iptr_ik];
+                if (colorOf[k]>color)
+                    BlockOps_SMV<N>(&x[N*i], &factors[N*N*iptr_ik], &x[N*k]);
+            }
+        }
+    }
+}
+
+template <typename T>
+void Solver_solveILU_tmpl(SparseMatrix_ptr A, const T* factors, double* x,
+                          const double* b)
 {
     dim_t i,k;
     index_t color,iptr_ik,iptr_main;
@@ -342,11 +457,11 @@ void Solver_solveILU(SparseMatrix_ptr A, Solver_ILU* ilu, double* x,
                         k=A->pattern->index[iptr_ik];
                         if (colorOf[k]<color) {
                             R1=x[k];
-                            S1-=ilu->factors[iptr_ik]*R1;
+                            S1-=factors[iptr_ik]*R1;
                         }
                     }
                     iptr_main=ptr_main[i];
-                    x[i]=ilu->factors[iptr_main]*S1;
+                    x[i]=factors[iptr_main]*S1;
                 }
             }
         } else if (n_block==2) {
@@ -361,13 +476,13 @@ void Solver_solveILU(SparseMatrix_ptr A, Solver_ILU* ilu, double* x,
                         if (colorOf[k]<color) {
                             R1=x[2*k];
                             R2=x[2*k+1];
-                            S1-=ilu->factors[4*iptr_ik  ]*R1+ilu->factors[4*iptr_ik+2]*R2;
-                            S2-=ilu->factors[4*iptr_ik+1]*R1+ilu->factors[4*iptr_ik+3]*R2;
+                            S1-=factors[4*iptr_ik  ]*R1+factors[4*iptr_ik+2]*R2;
+                            S2-=factors[4*iptr_ik+1]*R1+factors[4*iptr_ik+3]*R2;
                         }
                     }
                     iptr_main=ptr_main[i];
-                    x[2*i  ]=ilu->factors[4*iptr_main  ]*S1+ilu->factors[4*iptr_main+2]*S2;
-                    x[2*i+1]=ilu->factors[4*iptr_main+1]*S1+ilu->factors[4*iptr_main+3]*S2;
+                    x[2*i  ]=factors[4*iptr_main  ]*S1+factors[4*iptr_main+2]*S2;
+                    x[2*i+1]=factors[4*iptr_main+1]*S1+factors[4*iptr_main+3]*S2;
                 }
             }
         } else if (n_block==3) {
@@ -384,17 +499,25 @@ void Solver_solveILU(SparseMatrix_ptr A, Solver_ILU* ilu, double* x,
                             R1=x[3*k];
                             R2=x[3*k+1];
                             R3=x[3*k+2];
-                            S1-=ilu->factors[9*iptr_ik  ]*R1+ilu->factors[9*iptr_ik+3]*R2+ilu->factors[9*iptr_ik+6]*R3;
-                            S2-=ilu->factors[9*iptr_ik+1]*R1+ilu->factors[9*iptr_ik+4]*R2+ilu->factors[9*iptr_ik+7]*R3;
-                            S3-=ilu->factors[9*iptr_ik+2]*R1+ilu->factors[9*iptr_ik+5]*R2+ilu->factors[9*iptr_ik+8]*R3;
+                            S1-=factors[9*iptr_ik  ]*R1+factors[9*iptr_ik+3]*R2+factors[9*iptr_ik+6]*R3;
+                            S2-=factors[9*iptr_ik+1]*R1+factors[9*iptr_ik+4]*R2+factors[9*iptr_ik+7]*R3;
+                            S3-=factors[9*iptr_ik+2]*R1+factors[9*iptr_ik+5]*R2+factors[9*iptr_ik+8]*R3;
                         }
                     }
                     iptr_main=ptr_main[i];
-                    x[3*i  ]=ilu->factors[9*iptr_main  ]*S1+ilu->factors[9*iptr_main+3]*S2+ilu->factors[9*iptr_main+6]*S3;
-                    x[3*i+1]=ilu->factors[9*iptr_main+1]*S1+ilu->factors[9*iptr_main+4]*S2+ilu->factors[9*iptr_main+7]*S3;
-                    x[3*i+2]=ilu->factors[9*iptr_main+2]*S1+ilu->factors[9*iptr_main+5]*S2+ilu->factors[9*iptr_main+8]*S3;
+                    x[3*i  ]=factors[9*iptr_main  ]*S1+factors[9*iptr_main+3]*S2+factors[9*iptr_main+6]*S3;
+                    x[3*i+1]=factors[9*iptr_main+1]*S1+factors[9*iptr_main+4]*S2+factors[9*iptr_main+7]*S3;
+                    x[3*i+2]=factors[9*iptr_main+2]*S1+factors[9*iptr_main+5]*S2+factors[9*iptr_main+8]*S3;
                 }
             }
+        } else {
+            switch (n_block) {
+                case 4: Solver_solveILU_forward<4>(A, factors, x, colorOf, ptr_main, color); break;
+                case 5: Solver_solveILU_forward<5>(A, factors, x, colorOf, ptr_main, color); break;
+                case 6: Solver_solveILU_forward<6>(A, factors, x, colorOf, ptr_main, color); break;
+                case 7: Solver_solveILU_forward<7>(A, factors, x, colorOf, ptr_main, color); break;
+                case 8: Solver_solveILU_forward<8>(A, factors, x, colorOf, ptr_main, color); break;
+            }
         }
     }
     /* backward substitution */
@@ -409,7 +532,7 @@ void Solver_solveILU(SparseMatrix_ptr A, Solver_ILU* ilu, double* x,
                         k=A->pattern->index[iptr_ik];
                         if (colorOf[k]>color) {
                             R1=x[k];
-                            S1-=ilu->factors[iptr_ik]*R1;
+                            S1-=factors[iptr_ik]*R1;
                         }
                     }
                     x[i]=S1;
@@ -427,8 +550,8 @@ void Solver_solveILU(SparseMatrix_ptr A, Solver_ILU* ilu, double* x,
                         if (colorOf[k]>color) {
                             R1=x[2*k];
                             R2=x[2*k+1];
-                            S1-=ilu->factors[4*iptr_ik  ]*R1+ilu->factors[4*iptr_ik+2]*R2;
-                            S2-=ilu->factors[4*iptr_ik+1]*R1+ilu->factors[4*iptr_ik+3]*R2;
+                            S1-=factors[4*iptr_ik  ]*R1+factors[4*iptr_ik+2]*R2;
+                            S2-=factors[4*iptr_ik+1]*R1+factors[4*iptr_ik+3]*R2;
                         }
                     }
                     x[2*i]=S1;
@@ -449,9 +572,9 @@ void Solver_solveILU(SparseMatrix_ptr A, Solver_ILU* ilu, double* x,
                             R1=x[3*k];
                             R2=x[3*k+1];
                             R3=x[3*k+2];
-                            S1-=ilu->factors[9*iptr_ik  ]*R1+ilu->factors[9*iptr_ik+3]*R2+ilu->factors[9*iptr_ik+6]*R3;
-                            S2-=ilu->factors[9*iptr_ik+1]*R1+ilu->factors[9*iptr_ik+4]*R2+ilu->factors[9*iptr_ik+7]*R3;
-                            S3-=ilu->factors[9*iptr_ik+2]*R1+ilu->factors[9*iptr_ik+5]*R2+ilu->factors[9*iptr_ik+8]*R3;
+                            S1-=factors[9*iptr_ik  ]*R1+factors[9*iptr_ik+3]*R2+factors[9*iptr_ik+6]*R3;
+                            S2-=factors[9*iptr_ik+1]*R1+factors[9*iptr_ik+4]*R2+factors[9*iptr_ik+7]*R3;
+                            S3-=factors[9*iptr_ik+2]*R1+factors[9*iptr_ik+5]*R2+factors[9*iptr_ik+8]*R3;
                         }
                     }
                     x[3*i]=S1;
@@ -459,10 +582,28 @@ void Solver_solveILU(SparseMatrix_ptr A, Solver_ILU* ilu, double* x,
                     x[3*i+2]=S3;
                 }
             }
+        } else {
+            switch (n_block) {
+                case 4: Solver_solveILU_backward<4>(A, factors, x, colorOf, color); break;
+                case 5: Solver_solveILU_backward<5>(A, factors, x, colorOf, color); break;
+                case 6: Solver_solveILU_backward<6>(A, factors, x, colorOf, color); break;
+                case 7: Solver_solveILU_backward<7>(A, factors, x, colorOf, color); break;
+                case 8: Solver_solveILU_backward<8>(A, factors, x, colorOf, color); break;
+            }
         }
 #pragma omp barrier
     }
 }
 
+void Solver_solveILU(SparseMatrix_ptr A, Solver_ILU* ilu, double* x,
+                     const double* b)
+{
+    if (ilu->factors_sp) {
+        Solver_solveILU_tmpl(A, ilu->factors_sp, x, b);
+    } else {
+        Solver_solveILU_tmpl(A, ilu->factors, x, b);
+    }
+}
+
 } // namespace paso
 
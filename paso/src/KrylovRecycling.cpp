@@ -0,0 +1,1001 @@
+
+/*****************************************************************************
+*
+* Copyright (c) 2003-2018 by The University of Queensland
+* http://www.uq.edu.au
+*
+* Primary Business: Queensland, Australia
+* Licensed under the Apache License, version 2.0
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Development until 2012 by Earth Systems Science Computational Center (ESSCC)
+* Development 2012-2013 by School of Earth Sciences
+* Development from 2014 by Centre for Geoscience Computing (GeoComp)
+*
+*****************************************************************************/
+
+
+/*
+*  Purpose
+*  =======
+*
+*  Krylov subspace recycling for sequences of linear systems A_i*x_i=b_i with
+*  slowly changing A_i, e.g. from time stepping. A small set of approximate
+*  eigenvectors U is kept with the system matrix (see RecycledSubspace) and
+*  used to deflate the next solve:
+*
+*  Solver_DeflatedPCG is the deflated preconditioned conjugate gradient
+*  method, see Y. Saad, M. Yeung, J. Erhel, F. Guyomarc'h: A deflated
+*  version of the conjugate gradient algorithm, SIAM J. Sci. Comput. 21,
+*  2000. The search directions are kept A-orthogonal to W=U. After the
+*  solve the recycled vectors are replaced by the Ritz vectors of the
+*  smallest Ritz values of A on the space spanned by W and the first search
+*  directions.
+*
+*  Solver_GCRODR is a right preconditioned GMRES with deflated restarting
+*  in the spirit of GCRO-DR, see M. Parks et al.: Recycling Krylov subspaces
+*  for sequences of linear systems, SIAM J. Sci. Comput. 28, 2006. The
+*  Arnoldi process for A*M is run in the orthogonal complement of C=A*M*U.
+*  After each cycle U is replaced by the vectors of the space spanned by U
+*  and the Arnoldi vectors on which A*M is smallest (right singular vectors
+*  of the smallest singular values) which leads to a symmetric eigenvalue
+*  problem rather than the harmonic Ritz problem of the original method.
+*
+*  Convergence test: norm( b - A*x )< TOL.
+*
+*  Arguments
+*  =========
+*
+*  r       (input/output) double array, dimension n.
+*          On entry, residual of initial guess x
+*
+*  x       (input/output) double array, dimension n.
+*          On input, the initial guess.
+*
+*  iter    (input/output) int
+*          On input, the maximum num_iterations to be performed.
+*          On output, actual number of num_iterations performed.
+*
+*  tolerance (input/output) DOUBLE PRECISION
+*          On input, the allowable convergence measure for
+*          norm( b - A*x )
+*          On output, the final value of this measure.
+*
+*  restart (input) number of iteration steps after which GMRES is restarted
+*
+*  num_recycled (input) maximum number of recycled vectors
+*
+*  ==============================================================
+*/
+
+#include "Solver.h"
+#include "Options.h"
+#include "PasoUtil.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// number of rows processed in one go by the block kernels
+#define PASO_RECYCLING_CHUNK 256
+
+// eigenvalues of a Gram matrix below this fraction of the largest one are
+// treated as zero, i.e. the corresponding directions are dropped
+#define PASO_RECYCLING_RANK_TOLERANCE 1.e-12
+
+// same for W^T*A*W in the deflated PCG. The Ritz vectors are obtained from
+// the iteration scalars so rounding errors can produce spurious directions
+// with tiny energy which would make the deflated iteration unstable.
+#define PASO_RECYCLING_ENERGY_TOLERANCE 1.e-8
+
+namespace paso {
+
+namespace {
+
+/// computes D = X^T*Y (p x q, column-major) for the p vectors X and the q
+/// vectors Y using a single global reduction
+void blockInnerProducts(dim_t n, dim_t p, double* const* X, dim_t q,
+                        double* const* Y, double* D,
+                        const escript::JMPI& mpi_info)
+{
+    const dim_t len = p*q;
+    const dim_t numChunks = (n+PASO_RECYCLING_CHUNK-1)/PASO_RECYCLING_CHUNK;
+    double* loc_dots = new double[len];
+
+    for (dim_t k=0; k<len; ++k)
+        loc_dots[k] = 0.;
+#pragma omp parallel
+    {
+        double* ss = new double[len];
+        for (dim_t k=0; k<len; ++k)
+            ss[k] = 0.;
+#pragma omp for schedule(static)
+        for (dim_t c=0; c<numChunks; ++c) {
+            const index_t i0 = c*PASO_RECYCLING_CHUNK;
+            const index_t i1 = std::min(i0+PASO_RECYCLING_CHUNK, n);
+            for (dim_t b=0; b<q; ++b) {
+                const double* y = Y[b];
+                for (dim_t a=0; a<p; ++a) {
+                    const double* v = X[a];
+                    double s = 0.;
+#pragma ivdep
+                    for (index_t i=i0; i<i1; ++i)
+                        s += v[i]*y[i];
+                    ss[a+p*b] += s;
+                }
+            }
+        }
+#pragma omp critical
+        {
+            for (dim_t k=0; k<len; ++k)
+                loc_dots[k] += ss[k];
+        }
+        delete[] ss;
+    }
+#ifdef ESYS_MPI
+    MPI_Allreduce(loc_dots, D, len, MPI_DOUBLE, MPI_SUM, mpi_info->comm);
+#else
+    for (dim_t k=0; k<len; ++k)
+        D[k] = loc_dots[k];
+#endif
+    delete[] loc_dots;
+}
+
+/// Y = beta*Y + X*T for the p vectors X and the q vectors Y where T is
+/// p x q (column-major). The vectors Y must not overlap with X.
+void blockUpdate(dim_t n, dim_t p, double* const* X, dim_t q,
+                 const double* T, double beta, double* const* Y)
+{
+    const dim_t numChunks = (n+PASO_RECYCLING_CHUNK-1)/PASO_RECYCLING_CHUNK;
+#pragma omp parallel for schedule(static)
+    for (dim_t c=0; c<numChunks; ++c) {
+        const index_t i0 = c*PASO_RECYCLING_CHUNK;
+        const index_t i1 = std::min(i0+PASO_RECYCLING_CHUNK, n);
+        for (dim_t b=0; b<q; ++b) {
+            double* y = Y[b];
+            if (beta == 0.) {
+                for (index_t i=i0; i<i1; ++i)
+                    y[i] = 0.;
+            } else if (beta != 1.) {
+                for (index_t i=i0; i<i1; ++i)
+                    y[i] *= beta;
+            }
+            for (dim_t a=0; a<p; ++a) {
+                const double* v = X[a];
+                const double f = T[a+p*b];
+                if (f != 0.) {
+#pragma ivdep
+                    for (index_t i=i0; i<i1; ++i)
+                        y[i] += f*v[i];
+                }
+            }
+        }
+    }
+}
+
+/// computes (A*W)^T*z, r^T*z, r^T*r, (r-rs)^T*(r-rs) and (r-rs)^T*rs for
+/// the deflated PCG method in one sweep and a single global reduction (in
+/// this order, p+4 values)
+void deflationInnerProducts(dim_t n, dim_t p, double* const* AW,
+                            const double* r, const double* z,
+                            const double* rs, double* D,
+                            const escript::JMPI& mpi_info)
+{
+    const dim_t len = p+4;
+    const dim_t numChunks = (n+PASO_RECYCLING_CHUNK-1)/PASO_RECYCLING_CHUNK;
+    double* loc_dots = new double[len];
+
+    for (dim_t k=0; k<len; ++k)
+        loc_dots[k] = 0.;
+#pragma omp parallel
+    {
+        double* ss = new double[len];
+        for (dim_t k=0; k<len; ++k)
+            ss[k] = 0.;
+#pragma omp for schedule(static)
+        for (dim_t c=0; c<numChunks; ++c) {
+            const index_t i0 = c*PASO_RECYCLING_CHUNK;
+            const index_t i1 = std::min(i0+PASO_RECYCLING_CHUNK, n);
+            for (dim_t a=0; a<p; ++a) {
+                const double* v = AW[a];
+                double s = 0.;
+#pragma ivdep
+                for (index_t i=i0; i<i1; ++i)
+                    s += v[i]*z[i];
+                ss[a] += s;
+            }
+            double s0 = 0., s1 = 0., s2 = 0., s3 = 0.;
+#pragma ivdep
+            for (index_t i=i0; i<i1; ++i) {
+                const double dr = r[i]-rs[i];
+                s0 += r[i]*z[i];
+                s1 += r[i]*r[i];
+                s2 += dr*dr;
+                s3 += dr*rs[i];
+            }
+            ss[p] += s0;
+            ss[p+1] += s1;
+            ss[p+2] += s2;
+            ss[p+3] += s3;
+        }
+#pragma omp critical
+        {
+            for (dim_t k=0; k<len; ++k)
+                loc_dots[k] += ss[k];
+        }
+        delete[] ss;
+    }
+#ifdef ESYS_MPI
+    MPI_Allreduce(loc_dots, D, len, MPI_DOUBLE, MPI_SUM, mpi_info->comm);
+#else
+    for (dim_t k=0; k<len; ++k)
+        D[k] = loc_dots[k];
+#endif
+    delete[] loc_dots;
+}
+
+/// returns the number r of eigenvalues of the symmetric p x p matrix G which
+/// are larger than tol times the largest one together with T (p x r,
+/// column-major) such that T^T*G*T = I. G is overwritten.
+dim_t orthonormalizer(dim_t p, double* G, double* T,
+                      double tol = PASO_RECYCLING_RANK_TOLERANCE)
+{
+    if (p == 0)
+        return 0;
+    double* Q = new double[p*p];
+    util::symmetricEigen(p, G, Q);
+    double lmax = 0.;
+    for (dim_t i=0; i<p; ++i)
+        lmax = std::max(lmax, G[i+p*i]);
+    dim_t rank = 0;
+    for (dim_t i=0; i<p; ++i) {
+        const double lambda = G[i+p*i];
+        if (lambda > tol*lmax) {
+            const double f = 1./std::sqrt(lambda);
+            for (dim_t a=0; a<p; ++a)
+                T[a+p*rank] = Q[a+p*i]*f;
+            rank++;
+        }
+    }
+    delete[] Q;
+    return rank;
+}
+
+/// solves the symmetric generalized eigenvalue problem F*y = theta*G*y on
+/// the subspace on which G is not singular and returns in Y (p x k) the
+/// eigenvectors of the k smallest eigenvalues, normalized such that
+/// Y^T*G*Y = I. F and G are overwritten. Returns the number of vectors
+/// found which may be less than k.
+dim_t smallestRitzVectors(dim_t p, double* F, double* G, dim_t k, double* Y)
+{
+    double* T = new double[p*p];
+    const dim_t rank = orthonormalizer(p, G, T);
+    const dim_t kk = std::min(k, rank);
+    if (kk > 0) {
+        // S = T^T*F*T, symmetrized
+        double* FT = new double[p*rank];
+        double* S = new double[rank*rank];
+        double* Q = new double[rank*rank];
+        for (dim_t b=0; b<rank; ++b) {
+            for (dim_t a=0; a<p; ++a) {
+                double t = 0.;
+                for (dim_t l=0; l<p; ++l)
+                    t += F[a+p*l]*T[l+p*b];
+                FT[a+p*b] = t;
+            }
+        }
+        for (dim_t b=0; b<rank; ++b) {
+            for (dim_t a=0; a<rank; ++a) {
+                double t = 0.;
+                for (dim_t l=0; l<p; ++l)
+                    t += T[l+p*a]*FT[l+p*b];
+                S[a+rank*b] = t;
+            }
+        }
+        for (dim_t b=0; b<rank; ++b) {
+            for (dim_t a=0; a<b; ++a) {
+                const double t = (S[a+rank*b]+S[b+rank*a])/2.;
+                S[a+rank*b] = S[b+rank*a] = t;
+            }
+        }
+        util::symmetricEigen(rank, S, Q);
+        std::vector<std::pair<double, dim_t> > order(rank);
+        for (dim_t i=0; i<rank; ++i)
+            order[i] = std::make_pair(S[i+rank*i], i);
+        std::sort(order.begin(), order.end());
+        for (dim_t c=0; c<kk; ++c) {
+            const double* q = &Q[rank*order[c].second];
+            for (dim_t a=0; a<p; ++a) {
+                double t = 0.;
+                for (dim_t l=0; l<rank; ++l)
+                    t += T[a+p*l]*q[l];
+                Y[a+p*c] = t;
+            }
+        }
+        delete[] FT;
+        delete[] S;
+        delete[] Q;
+    }
+    delete[] T;
+    return kk;
+}
+
+/// returns pointers to the k columns of the n x k matrix U
+double** columns(dim_t n, dim_t k, double* U)
+{
+    double** c = new double*[std::max(k, (dim_t)1)];
+    for (dim_t j=0; j<k; ++j)
+        c[j] = &U[n*j];
+    return c;
+}
+
+/// returns the recycled subspace of A for the given method. A subspace which
+/// was created by another method or for another vector length is discarded.
+RecycledSubspace* getRecycledSubspace(SystemMatrix* A, index_t method,
+                                      dim_t n)
+{
+    RecycledSubspace* rs = A->recycled_subspace;
+    if (rs && (rs->method != method || rs->n != n)) {
+        RecycledSubspace_free(A);
+        rs = NULL;
+    }
+    if (!rs) {
+        rs = new RecycledSubspace;
+        rs->method = method;
+        rs->n = n;
+        rs->dim = 0;
+        rs->U = NULL;
+        rs->V = NULL;
+        A->recycled_subspace = rs;
+    }
+    return rs;
+}
+
+/// replaces the vectors of the recycled subspace by U and V (may be NULL)
+/// which are taken over
+void setRecycledVectors(RecycledSubspace* rs, dim_t dim, double* U, double* V)
+{
+    delete[] rs->U;
+    delete[] rs->V;
+    rs->U = U;
+    rs->V = V;
+    rs->dim = dim;
+}
+
+/// z = M*v
+void applyPreconditioner(SystemMatrix_ptr A, double* z, double* v,
+                         Performance* pp)
+{
+    Performance_stopMonitor(pp, PERFORMANCE_SOLVER);
+    Performance_startMonitor(pp, PERFORMANCE_PRECONDITIONER);
+    A->solvePreconditioner(z, v);
+    Performance_stopMonitor(pp, PERFORMANCE_PRECONDITIONER);
+    Performance_startMonitor(pp, PERFORMANCE_SOLVER);
+}
+
+/// w = A*z
+void applyOperator(SystemMatrix_ptr A, double* w, double* z, Performance* pp)
+{
+    Performance_stopMonitor(pp, PERFORMANCE_SOLVER);
+    Performance_startMonitor(pp, PERFORMANCE_MVM);
+    A->MatrixVector_CSR_OFFSET0(PASO_ONE, z, PASO_ZERO, w);
+    Performance_stopMonitor(pp, PERFORMANCE_MVM);
+    Performance_startMonitor(pp, PERFORMANCE_SOLVER);
+}
+
+} // anonymous namespace
+
+void RecycledSubspace_free(SystemMatrix* A)
+{
+    if (A->recycled_subspace) {
+        delete[] A->recycled_subspace->U;
+        delete[] A->recycled_subspace->V;
+        delete A->recycled_subspace;
+        A->recycled_subspace = NULL;
+    }
+}
+
+SolverResult Solver_DeflatedPCG(SystemMatrix_ptr A, double* r, double* x,
+                                dim_t* iter, double* tolerance,
+                                dim_t num_recycled, Performance* pp)
+{
+    if (num_recycled <= 0) {
+        return InputError;
+    }
+    const dim_t n = A->getTotalNumRows();
+    const dim_t maxit = *iter;
+    const double tol = *tolerance;
+    const dim_t k = num_recycled;
+    // number of preconditioned residuals which are kept to update the
+    // subspace
+    const dim_t ell = 2*k;
+    bool breakFlag=false, maxIterFlag=false, convergeFlag=false;
+    SolverResult status = NoError;
+    dim_t num_iter = 0;
+    dim_t numStored = 0;   // number of stored z_j
+    dim_t numComplete = 0; // number of stored z_j for which delta_j is known
+    double norm_of_residual;
+
+    RecycledSubspace* recycled = getRecycledSubspace(A.get(), PASO_PCG, n);
+    dim_t p = std::min(recycled->dim, k);
+
+    // Z = [W, z_0..z_{ell-1}] and MZ = M^{-1}*Z = [M^{-1}*W, r_0..r_{ell-1}]
+    double* Z = new double[n*(k+ell)];
+    double* MZ = new double[n*(k+ell)];
+    double* AW = new double[n*k];
+    double** Zc = columns(n, k+ell, Z);
+    double** MZc = columns(n, k+ell, MZ);
+    double** AWc = columns(n, k, AW);
+    double* z = new double[n];
+    double* d = new double[n];
+    double* q = new double[n];
+    double* rs = new double[n];
+    double* x2 = new double[n];
+    double* D = new double[(k+ell)*(k+ell)];
+    double* T = new double[k*k];
+    double* mu = new double[k+4];
+    // scalars of the first ell iterations
+    double* rhos = new double[ell];
+    double* betas = new double[ell];
+    double* deltas = new double[ell];
+    double* mus = new double[std::max(k*ell, (dim_t)1)];
+
+    Performance_startMonitor(pp, PERFORMANCE_SOLVER);
+    if (p > 0) {
+        // W = U*T, A*W = A*U*T with W^T*A*W = I. Directions on which A is
+        // not positive (anymore) are dropped.
+        double* AU = new double[n*p];
+        double** Uc = columns(n, p, recycled->U);
+        double** Vc = columns(n, p, recycled->V ? recycled->V : recycled->U);
+        double** AUc = columns(n, p, AU);
+        for (dim_t j=0; j<p; ++j)
+            applyOperator(A, AUc[j], Uc[j], pp);
+        blockInnerProducts(n, p, Uc, p, AUc, D, A->mpi_info);
+        for (dim_t b=0; b<p; ++b) {
+            for (dim_t a=0; a<b; ++a) {
+                const double t = (D[a+p*b]+D[b+p*a])/2.;
+                D[a+p*b] = D[b+p*a] = t;
+            }
+        }
+        const dim_t rank = orthonormalizer(p, D, T,
+                                           PASO_RECYCLING_ENERGY_TOLERANCE);
+        blockUpdate(n, p, Uc, rank, T, 0., Zc);
+        blockUpdate(n, p, Vc, rank, T, 0., MZc);
+        blockUpdate(n, p, AUc, rank, T, 0., AWc);
+        delete[] Uc;
+        delete[] Vc;
+        delete[] AUc;
+        delete[] AU;
+        p = rank;
+    }
+    if (p > 0) {
+        // x += W*W^T*r, r -= A*W*W^T*r so that W^T*r = 0
+        blockInnerProducts(n, p, Zc, 1, &r, mu, A->mpi_info);
+        blockUpdate(n, p, Zc, 1, mu, 1., &x);
+        for (dim_t a=0; a<p; ++a)
+            mu[a] = -mu[a];
+        blockUpdate(n, p, AWc, 1, mu, 1., &r);
+    }
+
+    // as in Solver_PCG the convergence test uses the smoothed residual rs
+    // belonging to the smoothed solution x
+    util::copy(n, rs, r);
+    util::copy(n, x2, x);
+    util::zeroes(n, d);
+
+    // z = M*r, mu = (A*W)^T*z, rho = r^T*z and |r|^2
+    applyPreconditioner(A, z, r, pp);
+    deflationInnerProducts(n, p, AWc, r, z, rs, mu, A->mpi_info);
+    double rho = mu[p];
+    double beta = 0.;
+    norm_of_residual = std::sqrt(mu[p+1]);
+    convergeFlag = (norm_of_residual <= tol);
+
+    while (true) {
+        if (numStored < ell) {
+            util::copy(n, Zc[p+numStored], z);
+            util::copy(n, MZc[p+numStored], r);
+            rhos[numStored] = rho;
+            betas[numStored] = beta;
+            for (dim_t a=0; a<p; ++a)
+                mus[a+p*numStored] = mu[a];
+            numStored++;
+        }
+        // d = z + beta*d - W*mu
+        for (dim_t a=0; a<p; ++a)
+            mu[a] = -mu[a];
+#pragma omp parallel for schedule(static)
+        for (index_t i=0; i<n; ++i)
+            d[i] = z[i] + beta*d[i];
+        blockUpdate(n, p, Zc, 1, mu, 1., &d);
+
+        if (convergeFlag || maxIterFlag || breakFlag)
+            break;
+        ++num_iter;
+        applyOperator(A, q, d, pp);
+        const double delta = util::innerProduct(n, d, q, A->mpi_info);
+        breakFlag = (std::abs(delta) <= TOLERANCE_FOR_SCALARS);
+        if (breakFlag)
+            break;
+        if (numComplete < numStored)
+            deltas[numComplete++] = delta;
+        const double alpha = rho/delta;
+#pragma omp parallel for schedule(static)
+        for (index_t i=0; i<n; ++i) {
+            x2[i] += alpha*d[i];
+            r[i] -= alpha*q[i];
+        }
+        applyPreconditioner(A, z, r, pp);
+        deflationInnerProducts(n, p, AWc, r, z, rs, mu, A->mpi_info);
+        const double rho_new = mu[p];
+        // rs = (1-gamma)*rs + gamma*r minimizes |rs|, x accordingly
+        const double gamma = (std::abs(mu[p+2]) <= PASO_ZERO ? 0. :
+                                                          -mu[p+3]/mu[p+2]);
+        double norm2_of_rs = 0.;
+#pragma omp parallel
+        {
+            double ss = 0.;
+#pragma omp for schedule(static)
+            for (index_t i=0; i<n; ++i) {
+                rs[i] += gamma*(r[i]-rs[i]);
+                x[i] += gamma*(x2[i]-x[i]);
+                ss += rs[i]*rs[i];
+            }
+#pragma omp critical
+            norm2_of_rs += ss;
+        }
+#ifdef ESYS_MPI
+        double loc_norm = norm2_of_rs;
+        MPI_Allreduce(&loc_norm, &norm2_of_rs, 1, MPI_DOUBLE, MPI_SUM,
+                      A->mpi_info->comm);
+#endif
+        norm_of_residual = std::sqrt(norm2_of_rs);
+        convergeFlag = (norm_of_residual <= tol);
+        maxIterFlag = (num_iter >= maxit);
+        if (!convergeFlag)
+            breakFlag = (std::abs(rho_new) <= TOLERANCE_FOR_SCALARS);
+        beta = rho_new/rho;
+        rho = rho_new;
+    }
+    // end of iterations
+    if (convergeFlag) {
+        status = NoError;
+    } else if (maxIterFlag) {
+        status = MaxIterReached;
+    } else if (breakFlag) {
+        status = Breakdown;
+    }
+    // return the residual of the smoothed solution
+    util::copy(n, r, rs);
+
+    // Rayleigh-Ritz for M*A on span(Z), i.e. F*y = theta*G*y with
+    // F = Z^T*A*Z and G = Z^T*M^{-1}*Z, keeping the k smallest Ritz values.
+    // With z_j = d_j - beta_j*d_{j-1} + W*mu_j, the A-orthogonality of W and
+    // the search directions and the M^{-1}-orthogonality of the z_j all
+    // entries apart from W^T*M^{-1}*W follow from the iteration scalars.
+    const dim_t nz = p + numComplete;
+    if (nz > 0) {
+        double* F = new double[nz*nz];
+        double* G = new double[nz*nz];
+        for (dim_t l=0; l<nz*nz; ++l) {
+            F[l] = 0.;
+            G[l] = 0.;
+        }
+        if (p > 0) {
+            blockInnerProducts(n, p, Zc, p, MZc, D, A->mpi_info);
+            for (dim_t b=0; b<p; ++b) {
+                F[b+nz*b] = 1.;
+                for (dim_t a=0; a<p; ++a)
+                    G[a+nz*b] = (D[a+p*b]+D[b+p*a])/2.;
+            }
+        }
+        for (dim_t j=0; j<numComplete; ++j) {
+            const dim_t jj = p+j;
+            G[jj+nz*jj] = rhos[j];
+            for (dim_t a=0; a<p; ++a)
+                F[a+nz*jj] = F[jj+nz*a] = mus[a+p*j];
+            for (dim_t i=0; i<=j; ++i) {
+                double f = 0.;
+                for (dim_t a=0; a<p; ++a)
+                    f += mus[a+p*i]*mus[a+p*j];
+                if (i == j) {
+                    f += deltas[j];
+                    if (j > 0)
+                        f += betas[j]*betas[j]*deltas[j-1];
+                } else if (i == j-1) {
+                    f -= betas[j]*deltas[i];
+                }
+                F[p+i+nz*jj] = F[jj+nz*(p+i)] = f;
+            }
+        }
+        double* Yr = new double[nz*k];
+        const dim_t kk = smallestRitzVectors(nz, F, G, k, Yr);
+        double* Unew = new double[n*std::max(kk, (dim_t)1)];
+        double* Vnew = new double[n*std::max(kk, (dim_t)1)];
+        double** Unewc = columns(n, kk, Unew);
+        double** Vnewc = columns(n, kk, Vnew);
+        blockUpdate(n, nz, Zc, kk, Yr, 0., Unewc);
+        blockUpdate(n, nz, MZc, kk, Yr, 0., Vnewc);
+        setRecycledVectors(recycled, kk, Unew, Vnew);
+        delete[] Unewc;
+        delete[] Vnewc;
+        delete[] Yr;
+        delete[] F;
+        delete[] G;
+    }
+    Performance_stopMonitor(pp, PERFORMANCE_SOLVER);
+
+    delete[] Zc;
+    delete[] MZc;
+    delete[] AWc;
+    delete[] Z;
+    delete[] MZ;
+    delete[] AW;
+    delete[] z;
+    delete[] d;
+    delete[] q;
+    delete[] rs;
+    delete[] x2;
+    delete[] D;
+    delete[] T;
+    delete[] mu;
+    delete[] rhos;
+    delete[] betas;
+    delete[] deltas;
+    delete[] mus;
+    *iter = num_iter;
+    *tolerance = norm_of_residual;
+    return status;
+}
+
+SolverResult Solver_GCRODR(SystemMatrix_ptr A, double* r, double* x,
+                           dim_t* iter, double* tolerance, dim_t restart,
+                           dim_t num_recycled, Performance* pp)
+{
+    if (restart <= 0 || num_recycled <= 0) {
+        return InputError;
+    }
+    const dim_t n = A->getTotalNumRows();
+    const dim_t maxit = *iter;
+    const double tol = *tolerance;
+    const dim_t m = restart;
+    const dim_t k = num_recycled;
+    const dim_t ld = m+1;
+    bool breakFlag=false, maxIterFlag=false, convergeFlag=false;
+    SolverResult status = NoError;
+    dim_t num_iter = 0;
+    double norm_of_residual;
+
+    RecycledSubspace* recycled = getRecycledSubspace(A.get(), PASO_GMRES, n);
+    dim_t p = std::min(recycled->dim, k);
+
+    // U and C = A*M*U with orthonormal C, the Arnoldi vectors V and the
+    // bases Z = [U, V_0..V_{m-1}] and W = [C, V_0..V_m]
+    double* U = new double[n*k];
+    double* C = new double[n*k];
+    double* Unew = new double[n*k];
+    double* Cnew = new double[n*k];
+    double* V = new double[n*(m+1)];
+    double** Vc = columns(n, m+1, V);
+    double** Zc = new double*[k+m];
+    double** Wc = new double*[k+m+2];
+    double* z = new double[n];
+    double* t = new double[n];
+    double* H = new double[ld*m];   // Hessenberg matrix of the cycle
+    double* Hr = new double[ld*m];  // H after the Givens rotations
+    double* B = new double[k*m];    // B = C^T*A*M*V
+    double* cs = new double[m];
+    double* sn = new double[m];
+    double* g = new double[m+1];
+    double* y = new double[k+m+1];
+    double* h = new double[k+m+2];
+    double* h2 = new double[k+m+2];
+    const dim_t nzmax = k+m;
+    double* Gbar = new double[(nzmax+1)*nzmax];
+    double* F = new double[nzmax*nzmax];
+    double* G = new double[nzmax*nzmax];
+    double* Yr = new double[nzmax*k];
+    double* GY = new double[(nzmax+1)*k];
+    double* S = new double[k*k];
+    double* T = new double[k*k];
+    double* Yt = new double[(nzmax+1)*k];
+
+    Performance_startMonitor(pp, PERFORMANCE_SOLVER);
+    if (p > 0) {
+        // C = A*M*U, then C = C*T and U = U*T such that C^T*C = I
+        // (two passes for stability)
+        util::copy(n*p, U, recycled->U);
+        double** Uc = columns(n, p, U);
+        double** Cc = columns(n, p, C);
+        for (dim_t j=0; j<p; ++j) {
+            applyPreconditioner(A, z, Uc[j], pp);
+            applyOperator(A, Cc[j], z, pp);
+        }
+        for (int pass=0; pass<2 && p>0; ++pass) {
+            blockInnerProducts(n, p, Cc, p, Cc, S, A->mpi_info);
+            const dim_t rank = orthonormalizer(p, S, T);
+            double** Unewc = columns(n, rank, Unew);
+            double** Cnewc = columns(n, rank, Cnew);
+            blockUpdate(n, p, Uc, rank, T, 0., Unewc);
+            blockUpdate(n, p, Cc, rank, T, 0., Cnewc);
+            delete[] Unewc;
+            delete[] Cnewc;
+            std::swap(U, Unew);
+            std::swap(C, Cnew);
+            p = rank;
+            delete[] Uc;
+            delete[] Cc;
+            Uc = columns(n, p, U);
+            Cc = columns(n, p, C);
+        }
+        if (p > 0) {
+            // x += M*U*C^T*r, r -= C*C^T*r
+            blockInnerProducts(n, p, Cc, 1, &r, y, A->mpi_info);
+            blockUpdate(n, p, Uc, 1, y, 0., &t);
+            applyPreconditioner(A, z, t, pp);
+            util::AXPY(n, x, 1., z);
+            for (dim_t a=0; a<p; ++a)
+                y[a] = -y[a];
+            blockUpdate(n, p, Cc, 1, y, 1., &r);
+        }
+        delete[] Uc;
+        delete[] Cc;
+    }
+    norm_of_residual = util::l2(n, r, A->mpi_info);
+
+    while (!(convergeFlag || maxIterFlag || breakFlag)) {
+        convergeFlag = (norm_of_residual <= tol);
+        maxIterFlag = (num_iter >= maxit);
+        if (convergeFlag || maxIterFlag)
+            break;
+
+        for (dim_t a=0; a<p; ++a) {
+            Zc[a] = &U[n*a];
+            Wc[a] = &C[n*a];
+        }
+        for (dim_t a=0; a<=m; ++a) {
+            if (a < m)
+                Zc[p+a] = Vc[a];
+            Wc[p+a] = Vc[a];
+        }
+
+        // start a new cycle with v_0 = r/|r|
+        const double beta = norm_of_residual;
+        util::linearCombination(n, Vc[0], 1./beta, r, 0., r);
+        for (dim_t l=0; l<ld*m; ++l)
+            H[l] = 0.;
+        g[0] = beta;
+        dim_t j = 0;
+        bool endCycle = false;
+
+        while (j < m && !endCycle) {
+            // w = A*M*v_j orthogonalized against [C, V_0..V_j] by two
+            // passes of classical Gram-Schmidt. The second pass also
+            // returns |w|^2 so that each pass needs one reduction only.
+            double* w = Vc[j+1];
+            applyPreconditioner(A, z, Vc[j], pp);
+            applyOperator(A, w, z, pp);
+            const dim_t nb = p+j+1;
+            blockInnerProducts(n, nb, Wc, 1, &w, h, A->mpi_info);
+            for (dim_t a=0; a<nb; ++a)
+                h2[a] = -h[a];
+            blockUpdate(n, nb, Wc, 1, h2, 1., &w);
+            blockInnerProducts(n, nb+1, Wc, 1, &w, h2, A->mpi_info);
+            double norm2 = h2[nb];
+            for (dim_t a=0; a<nb; ++a) {
+                h[a] += h2[a];
+                norm2 -= h2[a]*h2[a];
+                h2[a] = -h2[a];
+            }
+            blockUpdate(n, nb, Wc, 1, h2, 1., &w);
+            if (!(norm2 > 1.e-8*h2[nb])) {
+                // cancellation, recompute the norm
+                norm2 = util::innerProduct(n, w, w, A->mpi_info);
+            }
+            const double hn = std::sqrt(std::max(norm2, 0.));
+            for (dim_t a=0; a<p; ++a)
+                B[a+k*j] = h[a];
+            for (dim_t a=0; a<=j; ++a)
+                H[a+ld*j] = h[p+a];
+            H[j+1+ld*j] = hn;
+            if (hn > 0.) {
+                util::linearCombination(n, w, 1./hn, w, 0., w);
+            } else {
+                // the Krylov space is invariant
+                util::zeroes(n, w);
+                endCycle = true;
+            }
+
+            // update the least squares problem by Givens rotations
+            double* hr = &Hr[ld*j];
+            for (dim_t a=0; a<=j+1; ++a)
+                hr[a] = H[a+ld*j];
+            for (dim_t l=0; l<j; ++l) {
+                const double s = cs[l]*hr[l] + sn[l]*hr[l+1];
+                hr[l+1] = -sn[l]*hr[l] + cs[l]*hr[l+1];
+                hr[l] = s;
+            }
+            const double dd = std::sqrt(hr[j]*hr[j] + hr[j+1]*hr[j+1]);
+            if (dd > 0.) {
+                cs[j] = hr[j]/dd;
+                sn[j] = hr[j+1]/dd;
+            } else {
+                cs[j] = 1.;
+                sn[j] = 0.;
+            }
+            hr[j] = dd;
+            hr[j+1] = 0.;
+            g[j+1] = -sn[j]*g[j];
+            g[j] = cs[j]*g[j];
+            ++j;
+            if (std::abs(g[j]) <= tol || num_iter+j >= maxit)
+                endCycle = true;
+        }
+        num_iter += j;
+
+        // solve Hr*y = g, then x += M*(V*y - U*B*y) and
+        // r = V_{j+1}*(beta*e_1 - H*y)
+        for (dim_t l=j-1; l>=0; --l) {
+            double s = g[l];
+            for (dim_t a=l+1; a<j; ++a)
+                s -= Hr[l+ld*a]*y[a];
+            y[l] = (Hr[l+ld*l] != 0.) ? s/Hr[l+ld*l] : 0.;
+        }
+        blockUpdate(n, j, Vc, 1, y, 0., &t);
+        for (dim_t a=0; a<p; ++a) {
+            double s = 0.;
+            for (dim_t l=0; l<j; ++l)
+                s -= B[a+k*l]*y[l];
+            h[a] = s;
+        }
+        blockUpdate(n, p, Zc, 1, h, 1., &t);
+        applyPreconditioner(A, z, t, pp);
+        util::AXPY(n, x, 1., z);
+        for (dim_t a=0; a<=j; ++a) {
+            double s = (a == 0 ? beta : 0.);
+            for (dim_t l=std::max(a-1, (dim_t)0); l<j; ++l)
+                s -= H[a+ld*l]*y[l];
+            h[a] = s;
+        }
+        blockUpdate(n, j+1, Vc, 1, h, 0., &r);
+        norm_of_residual = util::l2(n, r, A->mpi_info);
+        // GMRES does not increase the residual, if it does the basis has
+        // lost orthogonality
+        breakFlag = !(norm_of_residual < beta);
+
+        // update the recycled space from Z = [U, V_0..V_{j-1}] using
+        // A*M*Z = W*Gbar with Gbar = [I B; 0 H] and the orthonormal
+        // W = [C, V_0..V_j]: the new U are the vectors y minimizing
+        // |A*M*Z*y|/|Z*y|, i.e. the eigenvectors of the smallest eigenvalues
+        // of Gbar^T*Gbar*y = theta*Z^T*Z*y.
+        const dim_t nz = p+j;
+        const dim_t ldg = nz+1;
+        for (dim_t l=0; l<ldg*nz; ++l)
+            Gbar[l] = 0.;
+        for (dim_t a=0; a<p; ++a) {
+            Gbar[a+ldg*a] = 1.;
+            for (dim_t l=0; l<j; ++l)
+                Gbar[a+ldg*(p+l)] = B[a+k*l];
+        }
+        for (dim_t l=0; l<j; ++l)
+            for (dim_t a=0; a<=l+1; ++a)
+                Gbar[p+a+ldg*(p+l)] = H[a+ld*l];
+        for (dim_t b=0; b<nz; ++b) {
+            for (dim_t a=0; a<=b; ++a) {
+                double s = 0.;
+                for (dim_t l=0; l<ldg; ++l)
+                    s += Gbar[l+ldg*a]*Gbar[l+ldg*b];
+                F[a+nz*b] = F[b+nz*a] = s;
+            }
+        }
+        // G = Z^T*Z, the V block is the identity
+        for (dim_t l=0; l<nz*nz; ++l)
+            G[l] = 0.;
+        for (dim_t a=p; a<nz; ++a)
+            G[a+nz*a] = 1.;
+        if (p > 0) {
+            blockInnerProducts(n, p, Zc, nz, Zc, Yt, A->mpi_info);
+            for (dim_t b=0; b<nz; ++b) {
+                for (dim_t a=0; a<p; ++a) {
+                    G[a+nz*b] = Yt[a+p*b];
+                    if (b >= p)
+                        G[b+nz*a] = Yt[a+p*b];
+                }
+            }
+        }
+        dim_t kk = smallestRitzVectors(nz, F, G, k, Yr);
+        // orthonormalize GY = Gbar*Y locally (twice) and apply the same
+        // transformation to Y so that C_new = W*GY and U_new = Z*Y
+        for (dim_t b=0; b<kk; ++b) {
+            for (dim_t a=0; a<ldg; ++a) {
+                double s = 0.;
+                for (dim_t l=0; l<nz; ++l)
+                    s += Gbar[a+ldg*l]*Yr[l+nz*b];
+                GY[a+ldg*b] = s;
+            }
+        }
+        for (int pass=0; pass<2 && kk>0; ++pass) {
+            for (dim_t b=0; b<kk; ++b) {
+                for (dim_t a=0; a<=b; ++a) {
+                    double s = 0.;
+                    for (dim_t l=0; l<ldg; ++l)
+                        s += GY[l+ldg*a]*GY[l+ldg*b];
+                    S[a+kk*b] = S[b+kk*a] = s;
+                }
+            }
+            const dim_t rank = orthonormalizer(kk, S, T);
+            for (dim_t b=0; b<rank; ++b) {
+                for (dim_t a=0; a<nz; ++a) {
+                    double s = 0.;
+                    for (dim_t l=0; l<kk; ++l)
+                        s += Yr[a+nz*l]*T[l+kk*b];
+                    Yt[a+nz*b] = s;
+                }
+            }
+            std::copy(Yt, Yt+nz*rank, Yr);
+            for (dim_t b=0; b<rank; ++b) {
+                for (dim_t a=0; a<ldg; ++a) {
+                    double s = 0.;
+                    for (dim_t l=0; l<kk; ++l)
+                        s += GY[a+ldg*l]*T[l+kk*b];
+                    Yt[a+ldg*b] = s;
+                }
+            }
+            std::copy(Yt, Yt+ldg*rank, GY);
+            kk = rank;
+        }
+        double** Unewc = columns(n, kk, Unew);
+        double** Cnewc = columns(n, kk, Cnew);
+        blockUpdate(n, nz, Zc, kk, Yr, 0., Unewc);
+        blockUpdate(n, nz+1, Wc, kk, GY, 0., Cnewc);
+        delete[] Unewc;
+        delete[] Cnewc;
+        std::swap(U, Unew);
+        std::swap(C, Cnew);
+        p = kk;
+    }
+    // end of iterations
+    if (convergeFlag) {
+        status = NoError;
+    } else if (maxIterFlag) {
+        status = MaxIterReached;
+    } else if (breakFlag) {
+        status = Breakdown;
+    }
+    Performance_stopMonitor(pp, PERFORMANCE_SOLVER);
+
+    // U is handed over to the recycled subspace
+    setRecycledVectors(recycled, p, U, NULL);
+    delete[] C;
+    delete[] Unew;
+    delete[] Cnew;
+    delete[] Vc;
+    delete[] V;
+    delete[] Zc;
+    delete[] Wc;
+    delete[] z;
+    delete[] t;
+    delete[] H;
+    delete[] Hr;
+    delete[] B;
+    delete[] cs;
+    delete[] sn;
+    delete[] g;
+    delete[] y;
+    delete[] h;
+    delete[] h2;
+    delete[] Gbar;
+    delete[] F;
+    delete[] G;
+    delete[] Yr;
+    delete[] GY;
+    delete[] S;
+    delete[] T;
+    delete[] Yt;
+    *iter = num_iter;
+    *tolerance = norm_of_residual;
+    return status;
+}
+
+} // namespace paso
+
@@ -21,6 +21,8 @@
 #include "PasoUtil.h"
 #include "SystemMatrix.h"
 
+#include <algorithm>
+
 namespace paso {
 
 /*
@@ -73,14 +75,24 @@ SolverResult Solver_MINRES(SystemMatrix_ptr A, double* R, double* X,
     bool convergeFlag=false;
     SolverResult status = NoError;
 
+    // The vectors of the three-term recurrences are rotated rather than
+    // copied and the normalization of z is folded into the coefficients so
+    // that each update is a single pass over memory.
     double* ZNEW = new double[n];
     double* Z = new double[n];
     double* AZ = new double[n];
     double* W = new double[n];
-    double* R_old = new double[n];
     double* W_old = new double[n];
-    double* R_ancient = new double[n];
     double* W_ancient = new double[n];
+    double* R_old = new double[n];
+    double* R_ancient = new double[n];
+    double* const R_buf1 = R_old;
+    double* const R_buf2 = R_ancient;
+    double* const R_in = R;
+
+    util::zeroes(n, W);
+    util::zeroes(n, W_old);
+    util::zeroes(n, R_old);
 
     // z  <- Prec*r
     A->solvePreconditioner(Z, R);
@@ -103,24 +115,19 @@ SolverResult Solver_MINRES(SystemMatrix_ptr A, double* R, double* X,
     }
 
     while (!convergeFlag && status == NoError) {
-        //  z <- z / gamma
-        util::scale(n, Z, 1./gamma);
+        // Z holds the unnormalized z, i.e. z = Z/gamma
 
-        //  Az <- A*z
+        //  Az <- A*Z
         A->MatrixVector_CSR_OFFSET0(PASO_ONE, Z, PASO_ZERO, AZ);
 
         //  delta <- Az'.z
-        delta = util::innerProduct(n, AZ, Z, A->mpi_info);
+        delta = util::innerProduct(n, AZ, Z, A->mpi_info)/(gamma*gamma);
 
         //  r_new <- Az-delta/gamma * r - gamma/gamma_old r_old
-        if (num_iter>0)
-            util::copy(n, R_ancient, R_old); //  r__ancient <- r_old
-
-        util::copy(n, R_old, R); //  r_old <- r
-        util::copy(n, R, AZ);    //  r <- Az
-        util::AXPY(n, R, -delta/gamma, R_old); // r <- r - delta/gamma v
-        if (num_iter > 0)
-            util::AXPY(n, R, -gamma/gamma_old, R_ancient); // r <- r - gamma/gamma_old r__ancient
+        util::linearCombination(n, R_ancient, 1./gamma, AZ, -delta/gamma, R,
+                                (num_iter > 0 ? -gamma/gamma_old : 0.), R_old);
+        std::swap(R_old, R_ancient); //  r_ancient <- r_old
+        std::swap(R, R_old);         //  r_old <- r, r <- r_new
 
         //  z <- prec*r
         A->solvePreconditioner(ZNEW, R);
@@ -150,36 +157,31 @@ SolverResult Solver_MINRES(SystemMatrix_ptr A, double* R, double* X,
 
             rnorm_prec = rnorm_prec * s;
 
-            // w_new <- (z-alpha_3 w - alpha_2 w_old)/alpha_1
-
-            if (num_iter > 1)
-                util::copy(n, W_ancient, W_old); //  w__ancient <- w_old
-            if (num_iter > 0)
-                util::copy(n, W_old, W); //  w_old <- w
-
-            util::copy(n, W, Z);
-            if (num_iter > 1)
-                util::AXPY(n, W, -alpha_3, W_ancient); // w <- w - alpha_3 w__ancient
-            if (num_iter > 0)
-                util::AXPY(n, W, -alpha_2, W_old); // w <- w - alpha_2 w_old
-            util::scale(n, W, 1.0 / alpha_1);      // w <- w / alpha_1
-
-            util::AXPY(n, X, c * eta, W);          // x <- x + c eta w
+            // w_new <- (z-alpha_3 w_old - alpha_2 w)/alpha_1, x <- x + c eta w_new
+            std::swap(W_old, W_ancient); //  w_ancient <- w_old
+            std::swap(W, W_old);         //  w_old <- w
+            util::linearCombination(n, W, 1./(gamma_old*alpha_1), Z,
+                    (num_iter > 1 ? -alpha_3/alpha_1 : 0.), W_ancient,
+                    (num_iter > 0 ? -alpha_2/alpha_1 : 0.), W_old);
+            util::AXPY(n, X, c * eta, W);
             eta = - s * eta;
             convergeFlag = rnorm_prec <= tol;
         } else {
             status = Breakdown;
         }
-        util::copy(n, Z, ZNEW);
+        std::swap(Z, ZNEW);
         ++num_iter;
         if (!convergeFlag && num_iter >= maxit)
             status = MaxIterReached;
     }
+    // return the last residual in the array passed in
+    if (R != R_in)
+        util::copy(n, R_in, R);
     delete[] Z;
     delete[] ZNEW;
     delete[] AZ;
-    delete[] R_old;
-    delete[] R_ancient;
+    delete[] R_buf1;
+    delete[] R_buf2;
     delete[] W;
     delete[] W_old;
     delete[] W_ancient;
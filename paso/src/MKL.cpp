@@ -32,30 +32,54 @@
 
 namespace paso {
 
+#ifdef ESYS_HAVE_MKL
+/// the PARDISO handle together with the information needed to decide whether
+/// its symbolic and numeric factorizations can be reused
+struct MKL_Handler {
+    _MKL_DSS_HANDLE_t pt[64];
+    /// the pattern the symbolic factorization was computed for
+    const_Pattern_ptr pattern;
+    /// reordering method used by the symbolic factorization
+    index_t reordering;
+    /// true if the numeric factorization is available
+    bool factorized;
+};
+
+namespace {
+
+/// calls PARDISO to release memory in the given phase, returns the error code
+ES_MKL_INT releaseMKL(SparseMatrix* A, ES_MKL_INT phase)
+{
+    ES_MKL_INT mtype = MKL_MTYPE_REAL_UNSYM;
+    ES_MKL_INT n = A->numRows;
+    ES_MKL_INT maxfct=1; // number of factorizations on the same pattern
+    ES_MKL_INT mnum =1;  // factorization to be handled in this call
+    ES_MKL_INT msglvl=0; // message level
+    ES_MKL_INT nrhs=1;   // number of right hand sides
+    ES_MKL_INT idum;     // dummy integer
+    _DOUBLE_PRECISION_t ddum;      // dummy float
+    ES_MKL_INT error=MKL_ERROR_NO; // error code
+    ES_MKL_INT iparm[64];          // parameters
+    MKL_Handler* handler = reinterpret_cast<MKL_Handler*>(A->solver_p);
+    ES_MKL_INT* ptr = reinterpret_cast<ES_MKL_INT*>(A->pattern->ptr);
+    ES_MKL_INT* index = reinterpret_cast<ES_MKL_INT*>(A->pattern->index);
+    for (index_t i=0; i<64; ++i)
+        iparm[i]=0;
+
+    ES_PARDISO(handler->pt, &maxfct, &mnum, &mtype, &phase, &n, A->val, ptr,
+               index, &idum, &nrhs, iparm, &msglvl, &ddum, &ddum, &error);
+    return error;
+}
+
+} // anonymous namespace
+#endif
+
 void MKL_free(SparseMatrix* A)
 {
 #ifdef ESYS_HAVE_MKL
     if (A && A->solver_p && A->solver_package==PASO_MKL) {
-        ES_MKL_INT mtype = MKL_MTYPE_REAL_UNSYM;
-        ES_MKL_INT n = A->numRows;
-        ES_MKL_INT maxfct=1; // number of factorizations on the same pattern
-        ES_MKL_INT mnum =1;  // factorization to be handled in this call
-        ES_MKL_INT msglvl=0; // message level
-        ES_MKL_INT nrhs=1;   // number of right hand sides
-        ES_MKL_INT idum;     // dummy integer
-        _DOUBLE_PRECISION_t ddum;      // dummy float
-        ES_MKL_INT error=MKL_ERROR_NO; // error code
-        ES_MKL_INT iparm[64];          // parameters
-        _MKL_DSS_HANDLE_t* pt = (_MKL_DSS_HANDLE_t*)A->solver_p;
-        ES_MKL_INT phase = MKL_PHASE_RELEASE_MEMORY;
-        ES_MKL_INT* ptr = reinterpret_cast<ES_MKL_INT*>(A->pattern->ptr);
-        ES_MKL_INT* index = reinterpret_cast<ES_MKL_INT*>(A->pattern->index);
-        for (index_t i=0; i<64; ++i)
-            iparm[i]=0;
-
-        ES_PARDISO(pt, &maxfct, &mnum, &mtype, &phase, &n, A->val, ptr,
-                   index, &idum, &nrhs, iparm, &msglvl,&ddum, &ddum, &error);
-        delete[] A->solver_p;
+        const ES_MKL_INT error = releaseMKL(A, MKL_PHASE_RELEASE_MEMORY);
+        delete reinterpret_cast<MKL_Handler*>(A->solver_p);
         A->solver_p=NULL;
         if (error != MKL_ERROR_NO)
             throw PasoException("Memory release in MKL library failed.");
@@ -63,6 +87,23 @@ void MKL_free(SparseMatrix* A)
 #endif
 }
 
+/// releases the numeric factorization only. The symbolic factorization is
+/// kept as it only depends on the pattern and can be reused when the values
+/// change.
+void MKL_freeNumeric(SparseMatrix* A)
+{
+#ifdef ESYS_HAVE_MKL
+    if (A && A->solver_p && A->solver_package==PASO_MKL) {
+        MKL_Handler* handler = reinterpret_cast<MKL_Handler*>(A->solver_p);
+        if (handler->factorized) {
+            handler->factorized = false;
+            if (releaseMKL(A, MKL_PHASE_RELEASE_FACTORIZATION) != MKL_ERROR_NO)
+                throw PasoException("Memory release in MKL library failed.");
+        }
+    }
+#endif
+}
+
 void MKL_solve(SparseMatrix_ptr A, double* out, double* in, index_t reordering,
                dim_t numRefinements, bool verbose)
 {
@@ -91,7 +132,7 @@ void MKL_solve(SparseMatrix_ptr A, double* out, double* in, index_t reordering,
     ES_MKL_INT phase = MKL_PHASE_SYMBOLIC_FACTORIZATION;
     ES_MKL_INT error=MKL_ERROR_NO;  /* error code */
     ES_MKL_INT iparm[64]; /* parameters */
-    _MKL_DSS_HANDLE_t* pt = (_MKL_DSS_HANDLE_t *)(A->solver_p);
+    MKL_Handler* handler = reinterpret_cast<MKL_Handler*>(A->solver_p);
 
     for (index_t i=0; i<64; ++i)
         iparm[i]=0;
@@ -121,42 +162,57 @@ void MKL_solve(SparseMatrix_ptr A, double* out, double* in, index_t reordering,
 
     double time0;
 
-    if (pt==NULL) {
+    // the symbolic factorization is kept when the values are reset (see
+    // MKL_freeNumeric) but cannot be reused for another pattern or ordering
+    if (handler != NULL && (handler->pattern != A->pattern
+                            || handler->reordering != reordering)) {
+        MKL_free(A.get());
+        handler = NULL;
+    }
+    if (handler==NULL) {
         // allocate address pointer
-        pt = new _MKL_DSS_HANDLE_t[64];
+        handler = new MKL_Handler;
         for (index_t i=0; i<64; ++i)
-            pt[i] = NULL;
-        A->solver_p = (void*) pt;
+            handler->pt[i] = NULL;
+        handler->pattern = A->pattern;
+        handler->reordering = reordering;
+        handler->factorized = false;
+        A->solver_p = (void*) handler;
         A->solver_package = PASO_MKL;
         // symbolic factorization
         phase = MKL_PHASE_SYMBOLIC_FACTORIZATION;
         time0 = escript::gettime();
-        ES_PARDISO(pt, &maxfct, &mnum, &mtype, &phase, &n, A->val,
+        ES_PARDISO(handler->pt, &maxfct, &mnum, &mtype, &phase, &n, A->val,
                    ptr, index, &idum, &nrhs, iparm, &msglvl, in, out, &error);
         if (error != MKL_ERROR_NO) {
              if (verbose)
                  printf("MKL: symbolic factorization failed.\n");
              MKL_free(A.get());
              throw PasoException("symbolic factorization in MKL library failed.");
-        } else {
-            // LDU factorization
-            phase = MKL_PHASE_FACTORIZATION;
-            ES_PARDISO(pt, &maxfct, &mnum, &mtype, &phase, &n, A->val, ptr,
-                       index, &idum, &nrhs, iparm, &msglvl, in, out, &error);
-            if (error != MKL_ERROR_NO) {
-                if (verbose)
-                    printf("MKL: LDU factorization failed.\n");
-                MKL_free(A.get());
-                throw PasoException("factorization in MKL library failed. Most likely the matrix is singular.");
-           }
-           if (verbose)
-               printf("MKL: LDU factorization completed (time = %e).\n", escript::gettime()-time0);
         }
+        if (verbose)
+            printf("MKL: symbolic factorization completed (time = %e).\n", escript::gettime()-time0);
+    }
+    if (!handler->factorized) {
+        // LDU factorization
+        phase = MKL_PHASE_FACTORIZATION;
+        time0 = escript::gettime();
+        ES_PARDISO(handler->pt, &maxfct, &mnum, &mtype, &phase, &n, A->val,
+                   ptr, index, &idum, &nrhs, iparm, &msglvl, in, out, &error);
+        if (error != MKL_ERROR_NO) {
+            if (verbose)
+                printf("MKL: LDU factorization failed.\n");
+            MKL_free(A.get());
+            throw PasoException("factorization in MKL library failed. Most likely the matrix is singular.");
+        }
+        handler->factorized = true;
+        if (verbose)
+            printf("MKL: LDU factorization completed (time = %e).\n", escript::gettime()-time0);
     }
     // forward backward substitution
     time0 = escript::gettime();
     phase = MKL_PHASE_SOLVE;
-    ES_PARDISO(pt, &maxfct, &mnum, &mtype, &phase, &n, A->val,
+    ES_PARDISO(handler->pt, &maxfct, &mnum, &mtype, &phase, &n, A->val,
                ptr, index, &idum, &nrhs, iparm, &msglvl, in, out, &error);
     if (verbose) printf("MKL: solve completed.\n");
     if (error != MKL_ERROR_NO) {
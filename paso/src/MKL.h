@@ -53,6 +53,7 @@ namespace paso {
 #define MKL_REORDERING_MINIMUM_DEGREE 0
 #define MKL_REORDERING_NESTED_DISSECTION 2
 #define MKL_REORDERING_NESTED_DISSECTION_OMP 3
+#define MKL_PHASE_RELEASE_FACTORIZATION 0
 #define MKL_PHASE_SYMBOLIC_FACTORIZATION 11
 #define MKL_PHASE_FACTORIZATION 22
 #define MKL_PHASE_SOLVE 33
@@ -60,6 +61,7 @@ namespace paso {
 
 
 void MKL_free(SparseMatrix* A);
+void MKL_freeNumeric(SparseMatrix* A);
 void MKL_solve(SparseMatrix_ptr A, double* out, double* in, index_t reordering,
                dim_t numRefinements, bool verbose);
 
@@ -50,17 +50,26 @@ Options::Options(const bp::object& options)
     drop_storage = sb.getDropStorage();
     truncation = sb.getTruncation();
     restart = sb._getRestartForC();
+    ca_gmres_step_size = sb.getCAGMRESStepSize();
+    num_recycled_vectors = sb.getNumRecycledVectors();
     sweeps = sb.getNumSweeps();
     pre_sweeps = sb.getNumPreSweeps();
     post_sweeps = sb.getNumPostSweeps();
+    if (sb.isNumSweepsSet())
+        chebyshev_degree = sweeps;
     level_max = sb.getLevelMax();
     min_coarse_matrix_size = sb.getMinCoarseMatrixSize();
     coarsening_threshold = sb.getCoarseningThreshold();
     accept_failed_convergence = sb.acceptConvergenceFailure();
     coarsening_method = mapEscriptOption(sb.getCoarsening());
     smoother = mapEscriptOption(sb.getSmoother());
+    schwarz_overlap = sb.getSchwarzOverlap();
+    schwarz_local_solver = mapEscriptOption(sb.getSchwarzLocalSolver());
+    interpolation_method = mapEscriptOption(sb.getAMGInterpolation());
     relaxation_factor = sb.getRelaxationFactor();
     use_local_preconditioner = sb.useLocalPreconditioner();
+    use_sliced_ellpack = sb.useSlicedEllpack();
+    mixed_precision = sb.useMixedPrecision();
     min_coarse_sparsity = sb.getMinCoarseMatrixSparsity();
     refinements = sb.getNumRefinements();
     coarse_matrix_refinements = sb.getNumCoarseMatrixRefinements();
@@ -86,9 +95,12 @@ void Options::setDefaults()
     drop_storage = 2.;
     restart = -1;
     truncation = 20;
+    ca_gmres_step_size = 4;
+    num_recycled_vectors = 0;
     sweeps = 2;
     pre_sweeps = 2;
     post_sweeps = 2;
+    chebyshev_degree = PASO_CHEBYSHEV_DEFAULT_DEGREE;
     coarsening_threshold = 0.25;
     min_coarse_matrix_size = 500;
     level_max = 100;
@@ -96,7 +108,12 @@ void Options::setDefaults()
     coarsening_method = PASO_DEFAULT;
     relaxation_factor = 0.95;
     smoother = PASO_GS;
+    schwarz_overlap = 1;
+    schwarz_local_solver = PASO_ILU0;
+    interpolation_method = PASO_DIRECT_INTERPOLATION;
     use_local_preconditioner = false;
+    use_sliced_ellpack = false;
+    mixed_precision = false;
     min_coarse_sparsity = 0.05;
     refinements = 2;
     coarse_matrix_refinements = 0;
@@ -158,15 +175,23 @@ void Options::show() const
         << "\tdrop_storage = " << drop_storage << std::endl
         << "\trestart = " << restart << std::endl
         << "\ttruncation = " << truncation << std::endl
+        << "\tca_gmres_step_size = " << ca_gmres_step_size << std::endl
+        << "\tnum_recycled_vectors = " << num_recycled_vectors << std::endl
         << "\tsweeps = " << sweeps << std::endl
         << "\tpre_sweeps = " << pre_sweeps << std::endl
         << "\tpost_sweeps = " << post_sweeps << std::endl
+        << "\tchebyshev_degree = " << chebyshev_degree << std::endl
         << "\tcoarsening_threshold = " << coarsening_threshold << std::endl
         << "\tlevel_max = " << level_max << std::endl
         << "\taccept_failed_convergence = " << accept_failed_convergence << std::endl
         << "\tcoarsening_method = " << name(coarsening_method) << " (" << coarsening_method << ")" << std::endl
+        << "\tinterpolation_method = " << name(interpolation_method) << " (" << interpolation_method << ")" << std::endl
         << "\trelaxation_factor = " << relaxation_factor << std::endl
+        << "\tschwarz_overlap = " << schwarz_overlap << std::endl
+        << "\tschwarz_local_solver = " << name(schwarz_local_solver) << " (" << schwarz_local_solver << ")" << std::endl
         << "\tuse_local_preconditioner = " << use_local_preconditioner << std::endl
+        << "\tuse_sliced_ellpack = " << use_sliced_ellpack << std::endl
+        << "\tmixed_precision = " << mixed_precision << std::endl
         << "\tmin_coarse_sparsity = " << min_coarse_sparsity << std::endl
         << "\trefinements = " << refinements << std::endl
         << "\tcoarse_matrix_refinements = " << coarse_matrix_refinements << std::endl
@@ -201,6 +226,10 @@ const char* Options::name(int key)
             return "GMRES";
        case PASO_PRES20:
             return "PRES20";
+       case PASO_PIPELINED_PCG:
+            return "PIPELINED_PCG";
+       case PASO_CA_GMRES:
+            return "CA_GMRES";
        case PASO_NO_REORDERING:
             return "NO_REORDERING";
        case PASO_MINIMUM_FILL_IN:
@@ -215,6 +244,8 @@ const char* Options::name(int key)
             return "ITERATIVE";
        case PASO_PASO:
             return "PASO";
+       case PASO_AMG:
+            return "AMG";
        case PASO_REC_ILU:
             return "REC_ILU";
        case PASO_TRILINOS:
@@ -229,10 +260,22 @@ const char* Options::name(int key)
             return "GAUSS_SEIDEL";
        case PASO_RILU:
             return "RILU";
+       case PASO_CHEBYSHEV:
+            return "CHEBYSHEV";
+       case PASO_SCHWARZ:
+            return "SCHWARZ";
        case PASO_DEFAULT_REORDERING:
             return "DEFAULT_REORDERING";
+       case PASO_REVERSE_CUTHILL_MCKEE:
+            return "REVERSE_CUTHILL_MCKEE";
        case PASO_NO_PRECONDITIONER:
             return "NO_PRECONDITIONER";
+       case PASO_CLASSIC_INTERPOLATION_WITH_FF_COUPLING:
+            return "CLASSIC_INTERPOLATION_WITH_FF_COUPLING";
+       case PASO_CLASSIC_INTERPOLATION:
+            return "CLASSIC_INTERPOLATION";
+       case PASO_DIRECT_INTERPOLATION:
+            return "DIRECT_INTERPOLATION";
        case PASO_CRANK_NICOLSON:
             return "PASO_CRANK_NICOLSON";
        case PASO_LINEAR_CRANK_NICOLSON:
@@ -257,12 +300,18 @@ int Options::getSolver(int solver, int pack, bool symmetry,
             case PASO_PCG:
                 out=PASO_PCG;
                 break;
+            case PASO_PIPELINED_PCG:
+                out=PASO_PIPELINED_PCG;
+                break;
             case PASO_PRES20:
                 out=PASO_PRES20;
                 break;
             case PASO_GMRES:
                 out=PASO_GMRES;
                 break;
+            case PASO_CA_GMRES:
+                out=PASO_CA_GMRES;
+                break;
             case PASO_NONLINEAR_GMRES:
                 out=PASO_NONLINEAR_GMRES;
                 break;
@@ -272,6 +321,12 @@ int Options::getSolver(int solver, int pack, bool symmetry,
             case PASO_MINRES:
                 out=PASO_MINRES;
                 break;
+            case PASO_CHOLEVSKY:
+                out=PASO_CHOLEVSKY;
+                break;
+            case PASO_DIRECT:
+                out=PASO_DIRECT;
+                break;
             default:
                 if (symmetry) {
                     out=PASO_PCG;
@@ -304,12 +359,14 @@ int Options::getSolver(int solver, int pack, bool symmetry,
                 out=PASO_BICGSTAB;
                 break;
             case PASO_PCG:
+            case PASO_PIPELINED_PCG:
                 out=PASO_PCG;
                 break;
             case PASO_PRES20:
                 out=PASO_PRES20;
                 break;
             case PASO_GMRES:
+            case PASO_CA_GMRES:
                 out=PASO_GMRES;
                 break;
             case PASO_TFQMR:
@@ -343,7 +400,8 @@ int Options::getPackage(int solver, int pack, bool symmetry,
     switch (pack) {
         case PASO_DEFAULT:
             if (solver == PASO_DIRECT) {
-                // these packages require CSC which is not supported with MPI
+                // these packages require CSC which is not supported with MPI.
+                // Without them the supernodal solver of paso is used.
                 if (mpi_info->size == 1) {
 #ifdef ESYS_HAVE_MKL
                     out = PASO_MKL;
@@ -392,6 +450,8 @@ int Options::mapEscriptOption(int escriptOption)
 
         case escript::SO_METHOD_BICGSTAB:
             return PASO_BICGSTAB;
+        case escript::SO_METHOD_CA_GMRES:
+            return PASO_CA_GMRES;
         case escript::SO_METHOD_CGS:
             return PASO_CGS;
         case escript::SO_METHOD_CHOLEVSKY:
@@ -410,11 +470,17 @@ int Options::mapEscriptOption(int escriptOption)
             return PASO_NONLINEAR_GMRES;
         case escript::SO_METHOD_PCG:
             return PASO_PCG;
+        case escript::SO_METHOD_PIPELINED_PCG:
+            return PASO_PIPELINED_PCG;
         case escript::SO_METHOD_PRES20:
             return PASO_PRES20;
         case escript::SO_METHOD_TFQMR:
             return PASO_TFQMR;
             
+        case escript::SO_PRECONDITIONER_AMG:
+            return PASO_AMG;
+        case escript::SO_PRECONDITIONER_CHEBYSHEV:
+            return PASO_CHEBYSHEV;
         case escript::SO_PRECONDITIONER_GAUSS_SEIDEL:
             return PASO_GAUSS_SEIDEL;
         case escript::SO_PRECONDITIONER_ILU0:
@@ -429,6 +495,8 @@ int Options::mapEscriptOption(int escriptOption)
             return PASO_REC_ILU;
         case escript::SO_PRECONDITIONER_RILU:
             return PASO_RILU;
+        case escript::SO_PRECONDITIONER_SCHWARZ:
+            return PASO_SCHWARZ;
 
         case escript::SO_ODESOLVER_BACKWARD_EULER:         
             return PASO_BACKWARD_EULER;
@@ -452,6 +520,8 @@ int Options::mapEscriptOption(int escriptOption)
             return PASO_NESTED_DISSECTION;
         case escript::SO_REORDERING_NONE:
             return PASO_NO_REORDERING;
+        case escript::SO_REORDERING_REVERSE_CUTHILL_MCKEE:
+            return PASO_REVERSE_CUTHILL_MCKEE;
 
         default:
             std::stringstream temp;
@@ -46,6 +46,8 @@
 #define PASO_JACOBI 10
 #define PASO_GMRES 11
 #define PASO_PRES20 12
+#define PASO_PIPELINED_PCG 13
+#define PASO_CA_GMRES 14
 #define PASO_MKL 15
 #define PASO_UMFPACK 16
 #define PASO_NO_REORDERING 17
@@ -53,6 +55,7 @@
 #define PASO_NESTED_DISSECTION 19
 #define PASO_ITERATIVE 20
 #define PASO_PASO 21
+#define PASO_AMG 22
 #define PASO_REC_ILU  23
 #define PASO_TRILINOS  24
 #define PASO_NONLINEAR_GMRES  25
@@ -62,6 +65,9 @@
 #define PASO_GS PASO_GAUSS_SEIDEL
 #define PASO_RILU 29
 #define PASO_DEFAULT_REORDERING 30
+#define PASO_CHEBYSHEV 31
+#define PASO_SCHWARZ 32
+#define PASO_REVERSE_CUTHILL_MCKEE 33
 #define PASO_NO_PRECONDITIONER 36
 #define PASO_CLASSIC_INTERPOLATION_WITH_FF_COUPLING 50
 #define PASO_CLASSIC_INTERPOLATION 51
@@ -72,6 +78,9 @@
 
 #define PASO_SMOOTHER 99999999
 
+/// degree of the Chebyshev preconditioner if the number of sweeps is not set
+#define PASO_CHEBYSHEV_DEFAULT_DEGREE 4
+
 namespace paso {
 
 struct Options
@@ -113,7 +122,7 @@ struct Options
     double inner_tolerance;
     bool adapt_inner_tolerance;
     bool verbose;
-    bool reordering;
+    int reordering;
     int preconditioner;
     dim_t iter_max;
     dim_t inner_iter_max;
@@ -121,18 +130,26 @@ struct Options
     double drop_storage;
     index_t truncation;
     index_t restart;
+    int ca_gmres_step_size;
+    int num_recycled_vectors;
     int sweeps;
     int pre_sweeps;
     int post_sweeps;
+    int chebyshev_degree;
     int cycle_type;
     int level_max;
     dim_t min_coarse_matrix_size;
     int smoother;
+    int schwarz_overlap;
+    int schwarz_local_solver;
+    int interpolation_method;
     double coarsening_threshold;
     bool accept_failed_convergence;
     index_t coarsening_method;
     double relaxation_factor;
     bool use_local_preconditioner;
+    bool use_sliced_ellpack;
+    bool mixed_precision;
     double min_coarse_sparsity;
     dim_t refinements;
     dim_t coarse_matrix_refinements;
@@ -21,7 +21,9 @@
 *
 *  PCG solves the linear system A*x = b using the
 *  preconditioned conjugate gradient method plus a smoother.
-*  A has to be symmetric.
+*  A has to be symmetric. A is a linear operator providing the matrix-vector
+*  product and the preconditioner, e.g. a SystemMatrixOperator or a
+*  matrix-free operator.
 *
 *  Convergence test: norm( b - A*x )< TOL.
 *
@@ -59,7 +61,7 @@ namespace paso {
 #define USE_DYNAMIC_SCHEDULING
 #endif
 
-SolverResult Solver_PCG(SystemMatrix_ptr A, double* r, double* x, dim_t* iter,
+SolverResult Solver_PCG(LinearOperator* A, double* r, double* x, dim_t* iter,
                         double* tolerance, Performance* pp)
 {
     dim_t maxit,num_iter_global, len,rest, np, ipp;
@@ -67,7 +69,7 @@ SolverResult Solver_PCG(SystemMatrix_ptr A, double* r, double* x, dim_t* iter,
     dim_t i0, istart, iend;
     bool breakFlag=false, maxIterFlag=false, convergeFlag=false;
     SolverResult status = NoError;
-    const dim_t n = A->getTotalNumRows();
+    const dim_t n = A->getLen();
     double *resid = tolerance;
     double tau_old,beta,delta,gamma_1,gamma_2,alpha,sum_1,sum_2,sum_3,sum_4,sum_5,tol;
 #ifdef ESYS_MPI
@@ -220,7 +222,7 @@ SolverResult Solver_PCG(SystemMatrix_ptr A, double* r, double* x, dim_t* iter,
         // v = A*p
         Performance_stopMonitor(pp, PERFORMANCE_SOLVER);
         Performance_startMonitor(pp, PERFORMANCE_MVM);
-        A->MatrixVector_CSR_OFFSET0(PASO_ONE, p, PASO_ZERO, v);
+        A->matrixVector(PASO_ONE, p, PASO_ZERO, v);
         Performance_stopMonitor(pp, PERFORMANCE_MVM);
         Performance_startMonitor(pp, PERFORMANCE_SOLVER);
 
@@ -365,5 +367,179 @@ SolverResult Solver_PCG(SystemMatrix_ptr A, double* r, double* x, dim_t* iter,
     return status;
 }
 
-} // namespace paso
+SolverResult Solver_PCG(SystemMatrix_ptr A, double* r, double* x, dim_t* iter,
+                        double* tolerance, Performance* pp)
+{
+    SystemMatrixOperator op(A);
+    return Solver_PCG(&op, r, x, iter, tolerance, pp);
+}
+
+/*
+*  Solver_PCG_pipelined solves A*x = b using the pipelined preconditioned
+*  conjugate gradient method by Ghysels and Vanroose (Parallel Computing 40,
+*  2014). The inner products (r,u), (w,u) and (r,r) of an iteration are
+*  computed in one sweep together with the vector updates and combined into
+*  a single (non-blocking) global reduction. The reduction is overlapped
+*  with the application of the preconditioner and the matrix-vector product.
+*  A has to be symmetric.
+*
+*  The convergence test is norm(r) < TOL where r is the recursively updated
+*  residual. Arguments are the same as for Solver_PCG.
+*/
+SolverResult Solver_PCG_pipelined(SystemMatrix_ptr A, double* r, double* x,
+                                  dim_t* iter, double* tolerance,
+                                  Performance* pp)
+{
+    const dim_t n = A->getTotalNumRows();
+    const dim_t maxit = *iter;
+    const double tol = *tolerance;
+    bool breakFlag=false, maxIterFlag=false, convergeFlag=false;
+    SolverResult status = NoError;
+    double loc_sum[3], sum[3];
+    double gamma, delta, alpha=0., alpha_old=0., beta=0., gamma_old=0.;
+    double norm_of_residual=0.;
+    dim_t num_iter = 0;
 
+    double* u=new double[n]; // u = M*r
+    double* w=new double[n]; // w = A*u
+    double* m=new double[n]; // m = M*w
+    double* v=new double[n]; // v = A*m
+    double* p=new double[n];
+    double* s=new double[n];
+    double* q=new double[n];
+    double* z=new double[n];
+
+    Performance_startMonitor(pp, PERFORMANCE_PRECONDITIONER);
+    A->solvePreconditioner(u, r);
+    Performance_stopMonitor(pp, PERFORMANCE_PRECONDITIONER);
+    Performance_startMonitor(pp, PERFORMANCE_MVM);
+    A->MatrixVector_CSR_OFFSET0(PASO_ONE, u, PASO_ZERO, w);
+    Performance_stopMonitor(pp, PERFORMANCE_MVM);
+    Performance_startMonitor(pp, PERFORMANCE_SOLVER);
+
+    loc_sum[0] = 0.;
+    loc_sum[1] = 0.;
+    loc_sum[2] = 0.;
+    #pragma omp parallel
+    {
+        double ss0=0., ss1=0., ss2=0.;
+        #pragma omp for schedule(static)
+        for (dim_t i=0; i<n; ++i) {
+            p[i]=0.;
+            s[i]=0.;
+            q[i]=0.;
+            z[i]=0.;
+            ss0+=r[i]*u[i];
+            ss1+=w[i]*u[i];
+            ss2+=r[i]*r[i];
+        }
+        #pragma omp critical
+        {
+            loc_sum[0]+=ss0;
+            loc_sum[1]+=ss1;
+            loc_sum[2]+=ss2;
+        }
+    }
+
+    // start of iterations
+    while (!(convergeFlag || maxIterFlag || breakFlag)) {
+        ++num_iter;
+        // start the global reduction of gamma=(r,u), delta=(w,u), (r,r)...
+#ifdef ESYS_MPI
+#if MPI_VERSION >= 3
+        MPI_Request request;
+        MPI_Iallreduce(loc_sum, sum, 3, MPI_DOUBLE, MPI_SUM, A->mpi_info->comm, &request);
+#else
+        MPI_Allreduce(loc_sum, sum, 3, MPI_DOUBLE, MPI_SUM, A->mpi_info->comm);
+#endif
+#else
+        sum[0]=loc_sum[0];
+        sum[1]=loc_sum[1];
+        sum[2]=loc_sum[2];
+#endif
+        // ...and overlap with m = M*w and v = A*m
+        Performance_stopMonitor(pp, PERFORMANCE_SOLVER);
+        Performance_startMonitor(pp, PERFORMANCE_PRECONDITIONER);
+        A->solvePreconditioner(m, w);
+        Performance_stopMonitor(pp, PERFORMANCE_PRECONDITIONER);
+        Performance_startMonitor(pp, PERFORMANCE_MVM);
+        A->MatrixVector_CSR_OFFSET0(PASO_ONE, m, PASO_ZERO, v);
+        Performance_stopMonitor(pp, PERFORMANCE_MVM);
+        Performance_startMonitor(pp, PERFORMANCE_SOLVER);
+#if defined(ESYS_MPI) && MPI_VERSION >= 3
+        MPI_Wait(&request, MPI_STATUS_IGNORE);
+#endif
+        gamma=sum[0];
+        delta=sum[1];
+        norm_of_residual=sqrt(sum[2]);
+
+        convergeFlag = norm_of_residual <= tol;
+        maxIterFlag = num_iter > maxit;
+        if (convergeFlag || maxIterFlag)
+            break;
+
+        if (num_iter > 1) {
+            beta=gamma/gamma_old;
+            delta-=beta*gamma/alpha_old;
+        } else {
+            beta=0.;
+        }
+        breakFlag = (std::abs(delta) <= TOLERANCE_FOR_SCALARS ||
+                     std::abs(gamma) <= TOLERANCE_FOR_SCALARS);
+        if (breakFlag)
+            break;
+        alpha=gamma/delta;
+
+        // z=v+beta*z, q=m+beta*q, s=w+beta*s, p=u+beta*p,
+        // x=x+alpha*p, r=r-alpha*s, u=u-alpha*q, w=w-alpha*z
+        loc_sum[0] = 0.;
+        loc_sum[1] = 0.;
+        loc_sum[2] = 0.;
+        #pragma omp parallel
+        {
+            double ss0=0., ss1=0., ss2=0.;
+            #pragma omp for schedule(static)
+            for (dim_t i=0; i<n; ++i) {
+                z[i]=v[i]+beta*z[i];
+                q[i]=m[i]+beta*q[i];
+                s[i]=w[i]+beta*s[i];
+                p[i]=u[i]+beta*p[i];
+                x[i]+=alpha*p[i];
+                r[i]-=alpha*s[i];
+                u[i]-=alpha*q[i];
+                w[i]-=alpha*z[i];
+                ss0+=r[i]*u[i];
+                ss1+=w[i]*u[i];
+                ss2+=r[i]*r[i];
+            }
+            #pragma omp critical
+            {
+                loc_sum[0]+=ss0;
+                loc_sum[1]+=ss1;
+                loc_sum[2]+=ss2;
+            }
+        }
+        gamma_old=gamma;
+        alpha_old=alpha;
+    }
+    // end of iterations
+    if (maxIterFlag) {
+        status = MaxIterReached;
+    } else if (breakFlag) {
+        status = Breakdown;
+    }
+    Performance_stopMonitor(pp, PERFORMANCE_SOLVER);
+    delete[] u;
+    delete[] w;
+    delete[] m;
+    delete[] v;
+    delete[] p;
+    delete[] s;
+    delete[] q;
+    delete[] z;
+    *iter=num_iter;
+    *tolerance=norm_of_residual;
+    return status;
+}
+
+} // namespace paso
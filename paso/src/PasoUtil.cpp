@@ -316,7 +316,8 @@ index_t arg_max(dim_t n, dim_t* lambda)
     return argmax;
 }
 
-void zeroes(dim_t n, double* x)
+template <typename T>
+static void zeroStripes(dim_t n, T* x)
 {
     dim_t i,local_n,rest,n_start,n_end,q;
 #ifdef _OPENMP
@@ -336,6 +337,25 @@ void zeroes(dim_t n, double* x)
     }
 }
 
+void zeroes(dim_t n, double* x)
+{
+    zeroStripes(n, x);
+}
+
+double* newVector(dim_t n)
+{
+    double* x=new double[n];
+    zeroStripes(n, x);
+    return x;
+}
+
+index_t* newIndexVector(dim_t n)
+{
+    index_t* x=new index_t[n];
+    zeroStripes(n, x);
+    return x;
+}
+
 void update(dim_t n, double a, double* x, double b, const double* y)
 {
     dim_t i,local_n,rest,n_start,n_end,q;
@@ -533,6 +553,161 @@ double l2(dim_t n, const double* x, escript::JMPI mpiinfo)
     return sqrt(out);
 }
 
+void innerProducts(dim_t n, const double* x1, const double* y1,
+                   const double* x2, const double* y2, double* out,
+                   escript::JMPI mpiinfo)
+{
+    double my_out[2] = {0., 0.};
+#ifdef _OPENMP
+    const int num_threads=omp_get_max_threads();
+#else
+    const int num_threads=1;
+#endif
+
+#pragma omp parallel for
+    for (dim_t i=0; i<num_threads; ++i) {
+        const dim_t local_n = n/num_threads;
+        const dim_t rest = n-local_n*num_threads;
+        const dim_t n_start = local_n*i+std::min(i,rest);
+        const dim_t n_end = local_n*(i+1)+std::min(i+1,rest);
+        double local_out0 = 0., local_out1 = 0.;
+        #pragma ivdep
+        for (dim_t q=n_start; q<n_end; ++q) {
+            local_out0 += x1[q]*y1[q];
+            local_out1 += x2[q]*y2[q];
+        }
+#pragma omp critical
+        {
+            my_out[0] += local_out0;
+            my_out[1] += local_out1;
+        }
+    }
+#ifdef ESYS_MPI
+    MPI_Allreduce(my_out, out, 2, MPI_DOUBLE, MPI_SUM, mpiinfo->comm);
+#else
+    out[0] = my_out[0];
+    out[1] = my_out[1];
+#endif
+}
+
+void linearCombination(dim_t n, double* z, double a, const double* x,
+                       double b, const double* y, double c, const double* w)
+{
+#ifdef _OPENMP
+    const int num_threads=omp_get_max_threads();
+#else
+    const int num_threads=1;
+#endif
+
+#pragma omp parallel for
+    for (dim_t i=0; i<num_threads; ++i) {
+        const dim_t local_n = n/num_threads;
+        const dim_t rest = n-local_n*num_threads;
+        const dim_t n_start = local_n*i+std::min(i,rest);
+        const dim_t n_end = local_n*(i+1)+std::min(i+1,rest);
+        #pragma ivdep
+        for (dim_t q=n_start; q<n_end; ++q)
+            z[q] = a*x[q]+b*y[q]+c*w[q];
+    }
+}
+
+void updateAndAXPY(dim_t n, double a, double* x, double b, const double* y,
+                   double* z, double c)
+{
+#ifdef _OPENMP
+    const int num_threads=omp_get_max_threads();
+#else
+    const int num_threads=1;
+#endif
+
+#pragma omp parallel for
+    for (dim_t i=0; i<num_threads; ++i) {
+        const dim_t local_n = n/num_threads;
+        const dim_t rest = n-local_n*num_threads;
+        const dim_t n_start = local_n*i+std::min(i,rest);
+        const dim_t n_end = local_n*(i+1)+std::min(i+1,rest);
+        #pragma ivdep
+        for (dim_t q=n_start; q<n_end; ++q) {
+            const double xq = a*x[q]+b*y[q];
+            x[q] = xq;
+            z[q] += c*xq;
+        }
+    }
+}
+
+double updateAndInnerProduct(dim_t n, double a, double* x, double b,
+                             const double* y, const double* z,
+                             escript::JMPI mpiinfo)
+{
+    double my_out = 0, out = 0.;
+#ifdef _OPENMP
+    const int num_threads=omp_get_max_threads();
+#else
+    const int num_threads=1;
+#endif
+
+#pragma omp parallel for
+    for (dim_t i=0; i<num_threads; ++i) {
+        const dim_t local_n = n/num_threads;
+        const dim_t rest = n-local_n*num_threads;
+        const dim_t n_start = local_n*i+std::min(i,rest);
+        const dim_t n_end = local_n*(i+1)+std::min(i+1,rest);
+        double local_out = 0.;
+        for (dim_t q=n_start; q<n_end; ++q) {
+            x[q] = a*x[q]+b*y[q];
+            local_out += x[q]*z[q];
+        }
+#pragma omp critical
+        {
+            my_out += local_out;
+        }
+    }
+#ifdef ESYS_MPI
+    MPI_Allreduce(&my_out, &out, 1, MPI_DOUBLE, MPI_SUM, mpiinfo->comm);
+#else
+    out = my_out;
+#endif
+    return out;
+}
+
+void updateAndInnerProducts(dim_t n, double a, double* x, double b,
+                            const double* y, const double* z1,
+                            const double* z2, double* out,
+                            escript::JMPI mpiinfo)
+{
+    double my_out[2] = {0., 0.};
+#ifdef _OPENMP
+    const int num_threads=omp_get_max_threads();
+#else
+    const int num_threads=1;
+#endif
+
+#pragma omp parallel for
+    for (dim_t i=0; i<num_threads; ++i) {
+        const dim_t local_n = n/num_threads;
+        const dim_t rest = n-local_n*num_threads;
+        const dim_t n_start = local_n*i+std::min(i,rest);
+        const dim_t n_end = local_n*(i+1)+std::min(i+1,rest);
+        double local_out0 = 0., local_out1 = 0.;
+        for (dim_t q=n_start; q<n_end; ++q) {
+            x[q] = a*x[q]+b*y[q];
+            local_out0 += x[q]*z1[q];
+            local_out1 += x[q]*z2[q];
+        }
+#pragma omp critical
+        {
+            my_out[0] += local_out0;
+            my_out[1] += local_out1;
+        }
+    }
+#ifdef ESYS_MPI
+    MPI_Allreduce(my_out, out, 2, MPI_DOUBLE, MPI_SUM, mpiinfo->comm);
+#else
+    out[0] = my_out[0];
+    out[1] = my_out[1];
+#endif
+}
+
 void applyGivensRotations(dim_t n, double* v, const double* c, const double* s)
 {
     #pragma ivdep
@@ -544,6 +719,56 @@ void applyGivensRotations(dim_t n, double* v, const double* c, const double* s)
    }
 }
 
+void symmetricEigen(dim_t n, double* S, double* Q)
+{
+    if (Q) {
+        for (dim_t j=0; j<n; ++j)
+            for (dim_t i=0; i<n; ++i)
+                Q[i+n*j] = (i==j ? 1. : 0.);
+    }
+    for (int sweep=0; sweep<50; ++sweep) {
+        double off = 0., total = 0.;
+        for (dim_t j=0; j<n; ++j) {
+            for (dim_t i=0; i<n; ++i) {
+                total += S[i+n*j]*S[i+n*j];
+                if (i != j)
+                    off += S[i+n*j]*S[i+n*j];
+            }
+        }
+        if (off <= 1.e-24*total)
+            break;
+        for (dim_t p=0; p<n-1; ++p) {
+            for (dim_t q=p+1; q<n; ++q) {
+                const double apq = S[p+n*q];
+                if (apq == 0.)
+                    continue;
+                const double theta = (S[q+n*q]-S[p+n*p])/(2.*apq);
+                const double t = (theta >= 0. ? 1. : -1.)
+                               / (std::abs(theta)+std::sqrt(theta*theta+1.));
+                const double c = 1./std::sqrt(t*t+1.);
+                const double s = t*c;
+                for (dim_t i=0; i<n; ++i) {
+                    const double sip = S[i+n*p], siq = S[i+n*q];
+                    S[i+n*p] = c*sip - s*siq;
+                    S[i+n*q] = s*sip + c*siq;
+                }
+                for (dim_t i=0; i<n; ++i) {
+                    const double spi = S[p+n*i], sqi = S[q+n*i];
+                    S[p+n*i] = c*spi - s*sqi;
+                    S[q+n*i] = s*spi + c*sqi;
+                }
+                if (Q) {
+                    for (dim_t i=0; i<n; ++i) {
+                        const double qip = Q[i+n*p], qiq = Q[i+n*q];
+                        Q[i+n*p] = c*qip - s*qiq;
+                        Q[i+n*q] = s*qip + c*qiq;
+                    }
+                }
+            }
+        }
+    }
+}
+
 } // namespace util
 } // namespace paso
 
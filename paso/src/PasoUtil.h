@@ -59,6 +59,12 @@ index_t iMax(dim_t N, const index_t* array);
 double innerProduct(dim_t N, const double* x, const double* y,
                     escript::JMPI mpiInfo);
 
+/// computes the global inner products out[0]=x1'*y1 and out[1]=x2'*y2 in a
+/// single pass and with a single reduction
+void innerProducts(dim_t N, const double* x1, const double* y1,
+                   const double* x2, const double* y2, double* out,
+                   escript::JMPI mpiInfo);
+
 /// returns true if array contains value
 bool isAny(dim_t N, const index_t* array, index_t value);
 
@@ -70,19 +76,57 @@ double l2(dim_t N, const double* x, escript::JMPI mpiInfo);
 void linearCombination(dim_t N, double* z, double a, const double* x, double b,
                        const double* y);
 
+/// Performs an update of the form z = a*x+b*y+c*w in a single pass. z may be
+/// identical with any of x, y or w.
+void linearCombination(dim_t N, double* z, double a, const double* x, double b,
+                       const double* y, double c, const double* w);
+
 /// returns the global Lsup of x
 double lsup(dim_t N, const double* x, escript::JMPI mpiInfo);
 
 /// returns the number of positive values in x
 dim_t numPositives(dim_t N, const double* x, escript::JMPI mpiInfo);
 
+/// Computes the eigenvalues and eigenvectors of the small symmetric N x N
+/// matrix S (column-major) by cyclic Jacobi rotations. On return the
+/// diagonal of S holds the eigenvalues and column i of Q the eigenvector
+/// belonging to S(i,i). Q may be NULL if no eigenvectors are needed.
+void symmetricEigen(dim_t N, double* S, double* Q);
+
 /// Performs an update of the form x = a*x+b*y  where y and x are long vectors.
 /// If b=0, y is not used.
 void update(dim_t N, double a, double* x, double b, const double* y);
 
+/// Performs x = a*x+b*y followed by z = z+c*x in a single pass
+void updateAndAXPY(dim_t N, double a, double* x, double b, const double* y,
+                   double* z, double c);
+
+/// Performs x = a*x+b*y and returns the global inner product of the new x
+/// with z in the same pass. z may be x.
+double updateAndInnerProduct(dim_t N, double a, double* x, double b,
+                             const double* y, const double* z,
+                             escript::JMPI mpiInfo);
+
+/// Performs x = a*x+b*y and computes the global inner products
+/// out[0]=x'*z1 and out[1]=x'*z2 of the new x in the same pass with a single
+/// reduction. z1 and z2 may be x.
+void updateAndInnerProducts(dim_t N, double a, double* x, double b,
+                            const double* y, const double* z1,
+                            const double* z2, double* out,
+                            escript::JMPI mpiInfo);
+
 /// fills array x with zeroes
 void zeroes(dim_t N, double* x);
 
+/// Allocates an array of length N and fills it with zeroes in the same
+/// per-thread stripes as the vector operations above and the matrix-vector
+/// product. On NUMA systems the first touch places each memory page on the
+/// socket of the thread which works on it later. Release with delete[].
+double* newVector(dim_t N);
+
+/// as newVector but for an index array, e.g. the ptr array of a pattern
+index_t* newIndexVector(dim_t N);
+
 /// out = in
 inline void copy(dim_t N, double* out, const double* in)
 {
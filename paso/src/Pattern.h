@@ -57,6 +57,10 @@ struct Pattern : boost::enable_shared_from_this<Pattern>
 
     void reduceBandwidth(index_t* oldToNew);
 
+    /// returns a nested dissection ordering of the symmetrized pattern
+    /// which reduces the fill-in of a direct solver
+    void nestedDissection(index_t* oldToNew) const;
+
     Pattern_ptr multiply(int type, const_Pattern_ptr other) const;
 
     Pattern_ptr binop(int type, const_Pattern_ptr other) const;
@@ -121,6 +125,21 @@ struct Pattern : boost::enable_shared_from_this<Pattern>
     index_t* coloring;
 };
 
+/// drops a level structure (breadth first search tree) from root in the
+/// graph given by adj_ptr and adj. Only vertices v with mark[v]==id are
+/// visited (all vertices if mark is NULL) and level[v] needs to be negative
+/// for these on input. On output level[v] is the level of v, vertices holds
+/// the vertices of the tree by level and firstVertexInLevel[i] points to the
+/// first vertex of level i in vertices (length numLevels+1).
+/// Returns the number of levels or -1 if a level with maxLevelWidth or more
+/// vertices is found.
+dim_t Pattern_dropLevelStructure(index_t root, const index_t* adj_ptr,
+                                 const index_t* adj, const index_t* mark,
+                                 index_t id, index_t* level,
+                                 index_t* vertices,
+                                 index_t* firstVertexInLevel,
+                                 dim_t maxLevelWidth);
+
 
 } // namespace paso
 
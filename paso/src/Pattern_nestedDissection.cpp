@@ -0,0 +1,228 @@
+
+/*****************************************************************************
+*
+* Copyright (c) 2003-2018 by The University of Queensland
+* http://www.uq.edu.au
+*
+* Primary Business: Queensland, Australia
+* Licensed under the Apache License, version 2.0
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Development until 2012 by Earth Systems Science Computational Center (ESSCC)
+* Development 2012-2013 by School of Earth Sciences
+* Development from 2014 by Centre for Geoscience Computing (GeoComp)
+*
+*****************************************************************************/
+
+
+/****************************************************************************/
+
+/*   Paso: pattern: nested dissection ordering for the direct solver.   */
+/*   As in reduceBandwidth a level structure is dropped from a pseudo   */
+/*   peripheral vertex. The vertices of the middle level separate the   */
+/*   lower from the upper levels. Both parts are ordered recursively    */
+/*   and the separator is labelled last. Parts which are not connected  */
+/*   are ordered independently.                                         */
+
+/****************************************************************************/
+
+#include "Pattern.h"
+#include "PasoException.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+// parts with at most this number of vertices are not dissected further
+#define PASO_ND_MIN_PART_SIZE 64
+
+namespace paso {
+
+void Pattern::nestedDissection(index_t* oldToNew) const
+{
+    if (numOutput != numInput) {
+        throw PasoException("Pattern::nestedDissection: pattern needs to be for a square matrix.");
+    }
+    const dim_t N = numOutput;
+    if (N == 0)
+        return;
+
+    // adjacency of the symmetrized pattern without the main diagonal
+    index_t* adj_ptr = new index_t[N+1];
+    for (dim_t i = 0; i <= N; ++i)
+        adj_ptr[i] = 0;
+    for (dim_t i = 0; i < N; ++i) {
+        for (index_t iptr = ptr[i]; iptr < ptr[i+1]; ++iptr) {
+            const index_t j = index[iptr];
+            if (j != i) {
+                adj_ptr[i+1]++;
+                adj_ptr[j+1]++;
+            }
+        }
+    }
+    for (dim_t i = 0; i < N; ++i)
+        adj_ptr[i+1] += adj_ptr[i];
+    index_t* adj = new index_t[adj_ptr[N]];
+    {
+        std::vector<index_t> pos(adj_ptr, adj_ptr+N);
+        for (dim_t i = 0; i < N; ++i) {
+            for (index_t iptr = ptr[i]; iptr < ptr[i+1]; ++iptr) {
+                const index_t j = index[iptr];
+                if (j != i) {
+                    adj[pos[i]++] = j;
+                    adj[pos[j]++] = i;
+                }
+            }
+        }
+    }
+    // remove duplicates
+    index_t len = 0;
+    for (dim_t i = 0; i < N; ++i) {
+        index_t* row = &adj[adj_ptr[i]];
+        std::sort(row, &adj[adj_ptr[i+1]]);
+        const index_t deg = std::unique(row, &adj[adj_ptr[i+1]]) - row;
+        adj_ptr[i] = len;
+        for (index_t k = 0; k < deg; ++k)
+            adj[len+k] = row[k];
+        len += deg;
+    }
+    adj_ptr[N] = len;
+
+    index_t* order = new index_t[N];
+    index_t* vertices = new index_t[N];
+    index_t* mark = new index_t[N];
+    index_t* level = new index_t[N];
+    for (dim_t i = 0; i < N; ++i) {
+        order[i] = i;
+        mark[i] = -1;
+        level[i] = -1;
+    }
+    std::vector<index_t> firstVertexInLevel(N+1);
+    // parts [begin, end) of order which still need to be ordered
+    std::vector<std::pair<index_t,index_t> > parts;
+    parts.push_back(std::make_pair(0, N));
+    index_t id = 0;
+
+    while (!parts.empty()) {
+        const index_t begin = parts.back().first;
+        const index_t end = parts.back().second;
+        parts.pop_back();
+        const dim_t n = end-begin;
+        if (n <= PASO_ND_MIN_PART_SIZE)
+            continue;
+
+        id++;
+        index_t root = order[begin];
+        for (index_t p = begin; p < end; ++p) {
+            const index_t v = order[p];
+            mark[v] = id;
+            if (adj_ptr[v+1]-adj_ptr[v] < adj_ptr[root+1]-adj_ptr[root])
+                root = v;
+        }
+
+        // search for a pseudo peripheral root
+        dim_t numLevels = 0;
+        dim_t numInTree = 0;
+        while (true) {
+            for (index_t p = begin; p < end; ++p)
+                level[order[p]] = -1;
+            const dim_t nl = Pattern_dropLevelStructure(root, adj_ptr, adj,
+                                    mark, id, level, vertices,
+                                    &firstVertexInLevel[0], N+1);
+            numInTree = firstVertexInLevel[nl];
+            if (nl <= numLevels || numInTree < n)
+                break;
+            numLevels = nl;
+            // try the vertex in the last level with minimum degree
+            index_t new_root = vertices[firstVertexInLevel[nl-1]];
+            for (index_t i = firstVertexInLevel[nl-1]; i < numInTree; ++i) {
+                const index_t v = vertices[i];
+                if (adj_ptr[v+1]-adj_ptr[v] < adj_ptr[new_root+1]-adj_ptr[new_root])
+                    new_root = v;
+            }
+            if (new_root == root)
+                break;
+            root = new_root;
+        }
+        // make sure level and firstVertexInLevel belong to the last tree
+        for (index_t p = begin; p < end; ++p)
+            level[order[p]] = -1;
+        numLevels = Pattern_dropLevelStructure(root, adj_ptr, adj, mark, id,
+                                    level, vertices, &firstVertexInLevel[0],
+                                    N+1);
+        numInTree = firstVertexInLevel[numLevels];
+
+        if (numInTree < n) {
+            // the part is not connected: the connected component of root
+            // and the rest are ordered independently
+            index_t k = numInTree;
+            for (index_t p = begin; p < end; ++p) {
+                if (level[order[p]] < 0)
+                    vertices[k++] = order[p];
+            }
+            for (index_t i = 0; i < n; ++i)
+                order[begin+i] = vertices[i];
+            parts.push_back(std::make_pair(begin, begin+numInTree));
+            parts.push_back(std::make_pair(begin+numInTree, end));
+            continue;
+        }
+        if (numLevels < 3)
+            continue;
+
+        // the separator is the level holding the median vertex
+        dim_t sep = 1;
+        while (sep < numLevels-2 && firstVertexInLevel[sep+1] <= n/2)
+            sep++;
+
+        // vertices of the separator without a neighbour in the upper part
+        // are moved to the lower part
+        index_t numLower = 0, numUpper = 0;
+        for (index_t i = 0; i < n; ++i) {
+            const index_t v = vertices[i];
+            if (level[v] == sep) {
+                bool separates = false;
+                for (index_t iptr = adj_ptr[v]; iptr < adj_ptr[v+1]; ++iptr) {
+                    const index_t j = adj[iptr];
+                    if (mark[j] == id && level[j] == sep+1) {
+                        separates = true;
+                        break;
+                    }
+                }
+                if (!separates)
+                    level[v] = sep-1;
+            }
+            if (level[v] < sep) {
+                numLower++;
+            } else if (level[v] > sep) {
+                numUpper++;
+            }
+        }
+        index_t lower = begin, upper = begin+numLower;
+        index_t separator = begin+numLower+numUpper;
+        for (index_t i = 0; i < n; ++i) {
+            const index_t v = vertices[i];
+            if (level[v] < sep) {
+                order[lower++] = v;
+            } else if (level[v] > sep) {
+                order[upper++] = v;
+            } else {
+                order[separator++] = v;
+            }
+        }
+        parts.push_back(std::make_pair(begin, begin+numLower));
+        parts.push_back(std::make_pair(begin+numLower, begin+numLower+numUpper));
+    }
+
+    for (dim_t i = 0; i < N; ++i)
+        oldToNew[order[i]] = i;
+
+    delete[] adj_ptr;
+    delete[] adj;
+    delete[] order;
+    delete[] vertices;
+    delete[] mark;
+    delete[] level;
+}
+
+} // namespace paso
+
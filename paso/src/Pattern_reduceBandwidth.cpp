@@ -84,6 +84,39 @@ int comparDegreeAndIdx(const void *arg1, const void *arg2)
     return 0;
 }
 
+dim_t Pattern_dropLevelStructure(index_t root, const index_t* adj_ptr,
+                                 const index_t* adj, const index_t* mark,
+                                 index_t id, index_t* level,
+                                 index_t* vertices,
+                                 index_t* firstVertexInLevel,
+                                 dim_t maxLevelWidth)
+{
+    dim_t numLevels = 0;
+    level[root] = 0;
+    vertices[0] = root;
+    firstVertexInLevel[0] = 0;
+    dim_t top = 1;
+
+    while (firstVertexInLevel[numLevels] < top) {
+        numLevels++;
+        firstVertexInLevel[numLevels] = top;
+        if (firstVertexInLevel[numLevels]-firstVertexInLevel[numLevels-1] >= maxLevelWidth)
+            return -1;
+
+        for (dim_t i=firstVertexInLevel[numLevels-1]; i < firstVertexInLevel[numLevels]; ++i) {
+            const index_t k = vertices[i];
+            for (index_t iptr=adj_ptr[k]; iptr < adj_ptr[k+1]; ++iptr) {
+                const index_t j = adj[iptr];
+                if (level[j] < 0 && (!mark || mark[j] == id)) {
+                    level[j] = numLevels;
+                    vertices[top++] = j;
+                }
+            }
+        }
+    }
+    return numLevels;
+}
+
 /*  dropTree() drops a tree in pattern from root
  *  root                 - on input the starting point of the tree.
  *  AssignedLevel        - array of length numOutput indicating the level
@@ -101,41 +134,18 @@ int comparDegreeAndIdx(const void *arg1, const void *arg2)
  */
 bool dropTree(index_t root, const Pattern* pattern, index_t* AssignedLevel,
               index_t* VerticesInTree, dim_t* numLevels,
-              index_t* firstVertexInLevel, dim_t max_LevelWidth_abort,
-              dim_t N)
+              index_t* firstVertexInLevel, dim_t max_LevelWidth_abort)
 {
 #pragma omp parallel for
     for (dim_t i=0; i < pattern->numInput; ++i)
         AssignedLevel[i]=-1;
 
-    dim_t nlvls = 0;
-    AssignedLevel[root] = 0;
-    VerticesInTree[0] = root;
-    firstVertexInLevel[0]=0;
-    dim_t level_top = firstVertexInLevel[0]+1;
-
-    while (firstVertexInLevel[nlvls] < level_top) {
-        nlvls++;
-        firstVertexInLevel[nlvls] = level_top;
-        if (firstVertexInLevel[nlvls]-firstVertexInLevel[nlvls-1] >= max_LevelWidth_abort)
-            return false;
-
-        for (dim_t i=firstVertexInLevel[nlvls-1]; i < firstVertexInLevel[nlvls]; ++i) {
-            const index_t k = VerticesInTree[i];
-            for (index_t j=pattern->ptr[k]; j<pattern->ptr[k+1]; ++j) {
-                const index_t itest = pattern->index[j];
-                if (AssignedLevel[itest] < 0) {
-#ifdef BOUNDS_CHECK
-                    ESYS_ASSERT(itest >= 0 && itest < N, "BOUNDS_CHECK: itest=" << itest << ", N=" << N);
-                    ESYS_ASSERT(level_top >= 0 && level_top < N, "BOUNDS_CHECK: level_top=" << level_top << ", N=" << N);
-#endif
-                    AssignedLevel[itest] = nlvls;
-                    VerticesInTree[level_top] = itest;
-                    level_top++;
-                }
-            }
-        }
-    }
+    const dim_t nlvls = Pattern_dropLevelStructure(root, pattern->ptr,
+                            pattern->index, NULL, 0, AssignedLevel,
+                            VerticesInTree, firstVertexInLevel,
+                            max_LevelWidth_abort);
+    if (nlvls < 0)
+        return false;
     *numLevels=nlvls;
     return true;
 }
@@ -182,7 +192,7 @@ void Pattern::reduceBandwidth(index_t* oldToNew)
         dim_t max_LevelWidth = N+1;
         dim_t numVerticesInTree = 0;
         while (dropTree(root, this, AssignedLevel, VerticesInTree,
-                        &numLevels, firstVertexInLevel, max_LevelWidth, N)) {
+                        &numLevels, firstVertexInLevel, max_LevelWidth)) {
             // find new maximum level width
             max_LevelWidth=0;
 #ifdef BOUNDS_CHECK
@@ -27,6 +27,7 @@
 
 #include "Preconditioner.h"
 #include "Options.h"
+#include "PasoException.h"
 #include "PasoUtil.h"
 #include "SystemMatrix.h"
 
@@ -37,6 +38,9 @@ void Preconditioner_free(Preconditioner* in)
     if (in!=NULL) {
         Preconditioner_Smoother_free(in->jacobi);
         Preconditioner_Smoother_free(in->gs);
+        Preconditioner_AMG_free(in->amg);
+        Preconditioner_Chebyshev_free(in->chebyshev);
+        Preconditioner_Schwarz_free(in->schwarz);
         Solver_ILU_free(in->ilu);
         Solver_RILU_free(in->rilu);
         delete in;
@@ -48,11 +52,16 @@ Preconditioner* Preconditioner_alloc(SystemMatrix_ptr A, Options* options)
     Preconditioner* prec = new Preconditioner;
     prec->jacobi=NULL;
     prec->gs=NULL;
+    prec->amg=NULL;
+    prec->chebyshev=NULL;
+    prec->schwarz=NULL;
     prec->rilu=NULL;
     prec->ilu=NULL;
 
     if (options->verbose && options->use_local_preconditioner)
         printf("Paso: Applying preconditioner locally only.\n");
+    if (options->verbose && options->mixed_precision)
+        printf("Paso: Preconditioner is stored in single precision where supported.\n");
 
     switch (options->preconditioner) {
         default:
@@ -64,7 +73,7 @@ Preconditioner* Preconditioner_alloc(SystemMatrix_ptr A, Options* options)
                     printf("Preconditioner: Jacobi preconditioner is used.\n");
                 }
             }
-            prec->jacobi=Preconditioner_Smoother_alloc(A, true, options->use_local_preconditioner, options->verbose);
+            prec->jacobi=Preconditioner_Smoother_alloc(A, true, options->use_local_preconditioner, options->mixed_precision, options->verbose);
             prec->type=PASO_JACOBI;
             prec->sweeps=options->sweeps;
             break;
@@ -77,15 +86,55 @@ Preconditioner* Preconditioner_alloc(SystemMatrix_ptr A, Options* options)
                     printf("Preconditioner: Gauss-Seidel preconditioner is used.\n");
                 }
             }
-            prec->gs = Preconditioner_Smoother_alloc(A, false, options->use_local_preconditioner, options->verbose);
+            prec->gs = Preconditioner_Smoother_alloc(A, false, options->use_local_preconditioner, options->mixed_precision, options->verbose);
             prec->type = PASO_GS;
             prec->sweeps = options->sweeps;
             break;
 
+        case PASO_AMG:
+            if (options->verbose)
+                printf("Preconditioner: AMG preconditioner is used.\n");
+            if (A->type & (MATRIX_FORMAT_CSC | MATRIX_FORMAT_OFFSET1))
+                throw PasoException("Preconditioner: AMG requires CSR format with index offset 0.");
+            options->coarsening_selection_time = 0.;
+            options->coarsening_matrix_time = 0.;
+            prec->amg = Preconditioner_AMG_alloc(A, 1, options);
+            prec->type = PASO_AMG;
+            break;
+
+        case PASO_CHEBYSHEV:
+            if (options->verbose)
+                printf("Preconditioner: Chebyshev preconditioner is used.\n");
+            if (A->type & (MATRIX_FORMAT_CSC | MATRIX_FORMAT_OFFSET1))
+                throw PasoException("Preconditioner: Chebyshev requires CSR format with index offset 0.");
+            if (A->row_block_size != A->col_block_size)
+                throw PasoException("Preconditioner: Chebyshev requires square blocks.");
+            {
+                SystemMatrixOperator op(A);
+                prec->chebyshev = Preconditioner_Chebyshev_alloc(&op,
+                        options->chebyshev_degree,
+                        options->symmetric || options->method == PASO_PCG
+                            || options->method == PASO_PIPELINED_PCG,
+                        options->verbose);
+            }
+            prec->type = PASO_CHEBYSHEV;
+            break;
+
+        case PASO_SCHWARZ:
+            if (options->verbose)
+                printf("Preconditioner: additive Schwarz preconditioner is used.\n");
+            if (A->type & (MATRIX_FORMAT_CSC | MATRIX_FORMAT_OFFSET1))
+                throw PasoException("Preconditioner: Schwarz requires CSR format with index offset 0.");
+            if (A->row_block_size != A->col_block_size)
+                throw PasoException("Preconditioner: Schwarz requires square blocks.");
+            prec->schwarz = Preconditioner_Schwarz_alloc(A, options);
+            prec->type = PASO_SCHWARZ;
+            break;
+
         case PASO_ILU0:
             if (options->verbose)
                 printf("Preconditioner: ILU preconditioner is used.\n");
-            prec->ilu = Solver_getILU(A->mainBlock, options->verbose);
+            prec->ilu = Solver_getILU(A->mainBlock, options->mixed_precision, options->verbose);
             prec->type = PASO_ILU0;
             break;
 
@@ -121,6 +170,18 @@ void Preconditioner_solve(Preconditioner* prec, SystemMatrix_ptr A,
         case PASO_GS:
             Preconditioner_Smoother_solve(A, prec->gs, x, b, prec->sweeps, false);
             break;
+        case PASO_AMG:
+            Preconditioner_AMG_solve(A, prec->amg, x, b);
+            break;
+        case PASO_CHEBYSHEV:
+            {
+                SystemMatrixOperator op(A);
+                Preconditioner_Chebyshev_solve(&op, prec->chebyshev, x, b);
+            }
+            break;
+        case PASO_SCHWARZ:
+            Preconditioner_Schwarz_solve(A, prec->schwarz, x, b);
+            break;
         case PASO_ILU0:
             Solver_solveILU(A->mainBlock, prec->ilu, x, b);
             break;
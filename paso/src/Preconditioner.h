@@ -18,8 +18,11 @@
 #define __PASO_PRECONDITIONER_H__
 
 #include "Paso.h"
+#include "Functions.h"
 #include "SystemMatrix.h"
 
+#include <vector>
+
 namespace paso {
 
 struct MergedSolver;
@@ -27,6 +30,9 @@ struct Preconditioner;
 typedef boost::shared_ptr<Preconditioner> Preconditioner_ptr;
 typedef boost::shared_ptr<const Preconditioner> const_Preconditioner_ptr;
 
+struct Preconditioner_AMG;
+struct Preconditioner_Chebyshev;
+struct Preconditioner_Schwarz;
 struct Preconditioner_Smoother;
 struct Solver_ILU;
 struct Solver_RILU;
@@ -40,6 +46,12 @@ struct Preconditioner
     Preconditioner_Smoother* jacobi;
     /// Gauss-Seidel preconditioner
     Preconditioner_Smoother* gs;
+    /// AMG preconditioner
+    Preconditioner_AMG* amg;
+    /// Chebyshev polynomial preconditioner
+    Preconditioner_Chebyshev* chebyshev;
+    /// restricted additive Schwarz preconditioner
+    Preconditioner_Schwarz* schwarz;
     /// ILU preconditioner
     Solver_ILU* ilu;
     /// RILU preconditioner
@@ -56,8 +68,16 @@ struct Preconditioner_LocalSmoother
 {
     bool Jacobi;
     double* diag;
+    /// inverse of the main diagonal blocks in single precision. This is only
+    /// used by the Jacobi smoother in mixed precision mode for block sizes
+    /// up to PASO_BLOCKOPS_MAX_N in which case diag is NULL.
+    float* diag_sp;
     double* buffer;
     index_t* pivot;
+    /// colors of the tiles used by the tiled Gauss-Seidel sweep (NULL for
+    /// the Jacobi smoother)
+    index_t* tile_color;
+    dim_t num_tile_colors;
 };
 
 struct Preconditioner_Smoother
@@ -70,10 +90,11 @@ void Preconditioner_Smoother_free(Preconditioner_Smoother * in);
 void Preconditioner_LocalSmoother_free(Preconditioner_LocalSmoother * in);
 
 Preconditioner_Smoother* Preconditioner_Smoother_alloc(
-        SystemMatrix_ptr A, bool jacobi, bool is_local, bool verbose);
+        SystemMatrix_ptr A, bool jacobi, bool is_local, bool mixed_precision,
+        bool verbose);
 
 Preconditioner_LocalSmoother* Preconditioner_LocalSmoother_alloc(
-        SparseMatrix_ptr A, bool jacobi, bool verbose);
+        SparseMatrix_ptr A, bool jacobi, bool mixed_precision, bool verbose);
 
 void Preconditioner_Smoother_solve(SystemMatrix_ptr A,
         Preconditioner_Smoother* gs, double* x, const double* b,
@@ -100,10 +121,119 @@ void Preconditioner_LocalSmoother_Sweep_tiled(SparseMatrix_ptr A,
 void Preconditioner_LocalSmoother_Sweep_colored(SparseMatrix_ptr A,
         Preconditioner_LocalSmoother* gs, double* x);
 
+/// AMG preconditioner (one level of the hierarchy)
+struct Preconditioner_AMG
+{
+    dim_t level;
+    /// coarse level matrix R*A*P
+    SystemMatrix_ptr A_C;
+    /// prolongation
+    SparseMatrix_ptr P;
+    /// restriction (=P^T)
+    SparseMatrix_ptr R;
+    Preconditioner_Smoother* Smoother;
+    dim_t pre_sweeps;
+    dim_t post_sweeps;
+    double* r;
+    double* x_C;
+    double* b_C;
+    /// next coarser level
+    Preconditioner_AMG* AMG_C;
+    /// matrix factorized by the supernodal solver on the coarsest level
+    /// (single rank only)
+    SparseMatrix_ptr A_direct;
+    /// dense LU factorization on the coarsest level (otherwise NULL)
+    dim_t n_lu;
+    double* lu;
+    index_t* lu_pivot;
+    double* lu_buffer;
+    int* lu_counts;
+    int* lu_offsets;
+};
+
+void Preconditioner_AMG_free(Preconditioner_AMG* in);
+
+Preconditioner_AMG* Preconditioner_AMG_alloc(SystemMatrix_ptr A, dim_t level,
+                                             Options* options);
+
+void Preconditioner_AMG_solve(SystemMatrix_ptr A, Preconditioner_AMG* amg,
+                              double* x, double* b);
+
+/// Chebyshev polynomial preconditioner for the Jacobi scaled operator
+/// D^{-1}*A where D is the main diagonal of A
+struct Preconditioner_Chebyshev
+{
+    dim_t n;
+    /// degree of the polynomial (=number of applications of the operator
+    /// plus one)
+    dim_t degree;
+    /// inverse of the main diagonal
+    double* inv_diag;
+    /// bounds of the eigenvalue interval of D^{-1}*A the polynomial is
+    /// built for
+    double lambda_min;
+    double lambda_max;
+    double* r;
+    double* d;
+};
+
+void Preconditioner_Chebyshev_free(Preconditioner_Chebyshev* in);
+
+Preconditioner_Chebyshev* Preconditioner_Chebyshev_alloc(LinearOperator* A,
+                            dim_t degree, bool symmetric, bool verbose);
+
+void Preconditioner_Chebyshev_solve(LinearOperator* A,
+        Preconditioner_Chebyshev* prec, double* x, const double* b);
+
+/// (restricted) additive Schwarz preconditioner. The local rows are extended
+/// by the rows of neighbouring ranks within 'overlap' layers of couplings.
+struct Preconditioner_Schwarz
+{
+    /// number of local rows and of rows of the overlapping subdomain
+    dim_t n;
+    dim_t n_ext;
+    dim_t block_size;
+    /// if set the values of the overlap are discarded (restricted additive
+    /// Schwarz), otherwise they are added to the values on their owners
+    /// which gives a symmetric preconditioner
+    bool restricted;
+    /// local solver (PASO_ILU0 or PASO_DIRECT)
+    int local_solver;
+    /// matrix of the overlapping subdomain, local rows come first followed
+    /// by the rows of other ranks sorted by global id
+    SparseMatrix_ptr A_ext;
+    /// ILU0 factorization of A_ext
+    Solver_ILU* ilu;
+    /// A_ext in the format required by the direct solver
+    SparseMatrix_ptr A_direct;
+    double* x_ext;
+    double* b_ext;
+    /// ranks owning rows of the overlap and the offsets of their rows
+    /// relative to n
+    std::vector<int> recv_neighbour;
+    std::vector<index_t> recv_offset;
+    /// ranks which require local rows, offsets into send_rows
+    std::vector<int> send_neighbour;
+    std::vector<index_t> send_offset;
+    /// local rows sent to other ranks
+    std::vector<index_t> send_rows;
+    double* send_buffer;
+};
+
+void Preconditioner_Schwarz_free(Preconditioner_Schwarz* in);
+
+Preconditioner_Schwarz* Preconditioner_Schwarz_alloc(SystemMatrix_ptr A,
+                                                     Options* options);
+
+void Preconditioner_Schwarz_solve(SystemMatrix_ptr A,
+        Preconditioner_Schwarz* prec, double* x, const double* b);
+
 /// ILU preconditioner
 struct Solver_ILU
 {
     double* factors;
+    /// factors in single precision (mixed precision mode, factors is NULL)
+    float* factors_sp;
 };
 
 /// RILU preconditioner
@@ -129,7 +259,8 @@ struct Solver_RILU
 };
 
 void Solver_ILU_free(Solver_ILU * in);
-Solver_ILU* Solver_getILU(SparseMatrix_ptr A, bool verbose);
+Solver_ILU* Solver_getILU(SparseMatrix_ptr A, bool mixed_precision,
+                          bool verbose);
 void Solver_solveILU(SparseMatrix_ptr A, Solver_ILU* ilu, double* x, const double* b);
 
 void Solver_RILU_free(Solver_RILU* in);
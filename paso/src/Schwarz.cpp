@@ -0,0 +1,618 @@
+
+/*****************************************************************************
+*
+* Copyright (c) 2003-2018 by The University of Queensland
+* http://www.uq.edu.au
+*
+* Primary Business: Queensland, Australia
+* Licensed under the Apache License, version 2.0
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Development until 2012 by Earth Systems Science Computational Center (ESSCC)
+* Development 2012-2013 by School of Earth Sciences
+* Development from 2014 by Centre for Geoscience Computing (GeoComp)
+*
+*****************************************************************************/
+
+
+/****************************************************************************/
+
+/* Paso: restricted additive Schwarz preconditioner                         */
+
+/*  Each rank extends its rows by the rows of the neighbouring ranks which  */
+/*  are reachable through up to 'overlap' layers of matrix couplings. The   */
+/*  matrix restricted to this overlapping subdomain is factorized locally   */
+/*  (ILU0 or a direct solver). To apply the preconditioner the right hand   */
+/*  side is collected on the overlapping subdomain, the local system is     */
+/*  solved and only the values of the rows owned by the rank are kept       */
+/*  (restricted additive Schwarz, see X.-C. Cai, M. Sarkis: A restricted    */
+/*  additive Schwarz preconditioner for general sparse linear systems,      */
+/*  SIAM J. Sci. Comput. 21 (1999)). The restricted variant is not          */
+/*  symmetric. For PCG and MINRES which require a symmetric preconditioner  */
+/*  the values of the overlap are sent back to their owners and added up    */
+/*  instead (classical additive Schwarz). With overlap 0 or on a single     */
+/*  rank both variants reduce to block Jacobi with the local solver.        */
+
+/****************************************************************************/
+
+#include "Preconditioner.h"
+#include "BlockOps.h"
+#include "MKL.h"
+#include "Options.h"
+#include "PasoException.h"
+#include "PasoUtil.h"
+#include "Supernodal.h"
+#include "UMFPACK.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <set>
+
+namespace paso {
+
+void Preconditioner_Schwarz_free(Preconditioner_Schwarz* in)
+{
+    if (in != NULL) {
+        Solver_ILU_free(in->ilu);
+        delete[] in->x_ext;
+        delete[] in->b_ext;
+        delete[] in->send_buffer;
+        delete in;
+    }
+}
+
+namespace {
+
+/// rows of the matrix in terms of global column ids with full blocks
+struct GlobalRows
+{
+    std::vector<index_t> id;
+    std::vector<index_t> ptr;
+    std::vector<index_t> cols;
+    std::vector<double> vals;
+
+    GlobalRows() : ptr(1, 0) {}
+};
+
+/// appends a block of a matrix with given block size to vals expanding
+/// diagonal blocks to full b x b blocks
+inline void appendBlock(std::vector<double>& vals, const double* v,
+                        dim_t block_size, dim_t b)
+{
+    if (block_size == b*b) {
+        vals.insert(vals.end(), v, v+block_size);
+    } else {
+        for (dim_t ic=0; ic<b; ++ic) {
+            for (dim_t ir=0; ir<b; ++ir)
+                vals.push_back(ir==ic ? v[ir] : 0.);
+        }
+    }
+}
+
+/// appends local row i of A to rows
+void appendLocalRow(GlobalRows& rows, const SystemMatrix& A, index_t i,
+                    index_t offset)
+{
+    const dim_t b = A.row_block_size;
+    const SparseMatrix_ptr main = A.mainBlock;
+    for (index_t iptr=main->pattern->ptr[i]; iptr<main->pattern->ptr[i+1];
+            ++iptr) {
+        rows.cols.push_back(main->pattern->index[iptr]+offset);
+        appendBlock(rows.vals, &main->val[iptr*main->block_size],
+                    main->block_size, b);
+    }
+    const SparseMatrix_ptr couple = A.col_coupleBlock;
+    if (couple && couple->pattern->ptr != NULL) {
+        for (index_t iptr=couple->pattern->ptr[i];
+                iptr<couple->pattern->ptr[i+1]; ++iptr) {
+            rows.cols.push_back(A.global_id[couple->pattern->index[iptr]]);
+            appendBlock(rows.vals, &couple->val[iptr*couple->block_size],
+                        couple->block_size, b);
+        }
+    }
+    rows.ptr.push_back(rows.cols.size());
+}
+
+/// returns the rank owning global row id
+inline int getOwner(const std::vector<index_t>& first_component, index_t id)
+{
+    return std::upper_bound(first_component.begin(), first_component.end(),
+                            id) - first_component.begin() - 1;
+}
+
+#ifdef ESYS_MPI
+/// returns the position of rank in the sorted list of partners
+inline size_t partnerIndex(const std::vector<int>& partners, int rank)
+{
+    std::vector<int>::const_iterator it = std::lower_bound(partners.begin(),
+                                                partners.end(), rank);
+    if (it == partners.end() || *it != rank) {
+        throw PasoException("Preconditioner_Schwarz: row owner is not a "
+                            "communication partner.");
+    }
+    return it-partners.begin();
+}
+
+/// exchanges messages with the ranks in partners. The lengths of the
+/// messages are known on both sides, recvOffset[i] and sendOffset[i] give
+/// the position of the values for partners[i]. Empty messages are skipped.
+template <typename T>
+void exchange(const escript::JMPI& mpi_info, const std::vector<int>& partners,
+              MPI_Datatype type, const T* sendBuf,
+              const std::vector<index_t>& sendOffset, T* recvBuf,
+              const std::vector<index_t>& recvOffset)
+{
+    const size_t np = partners.size();
+    std::vector<MPI_Request> requests(2*np);
+    int numRequests = 0;
+    for (size_t i=0; i<np; ++i) {
+        const int len = recvOffset[i+1]-recvOffset[i];
+        if (len > 0) {
+            MPI_Irecv(&recvBuf[recvOffset[i]], len, type, partners[i],
+                      mpi_info->counter()+partners[i], mpi_info->comm,
+                      &requests[numRequests++]);
+        }
+    }
+    for (size_t i=0; i<np; ++i) {
+        const int len = sendOffset[i+1]-sendOffset[i];
+        if (len > 0) {
+            MPI_Issend(const_cast<T*>(&sendBuf[sendOffset[i]]), len, type,
+                       partners[i], mpi_info->counter()+mpi_info->rank,
+                       mpi_info->comm, &requests[numRequests++]);
+        }
+    }
+    mpi_info->incCounter(mpi_info->size);
+    if (numRequests > 0)
+        MPI_Waitall(numRequests, &requests[0], MPI_STATUSES_IGNORE);
+}
+
+/// exchanges one value with each partner
+inline std::vector<index_t> exchangeCounts(const escript::JMPI& mpi_info,
+                                    const std::vector<int>& partners,
+                                    const std::vector<index_t>& counts)
+{
+    const size_t np = partners.size();
+    std::vector<index_t> offset(np+1), out(np+1);
+    for (size_t i=0; i<=np; ++i)
+        offset[i] = i;
+    exchange(mpi_info, partners, MPI_DIM_T, &counts[0], offset, &out[0],
+             offset);
+    out.pop_back();
+    return out;
+}
+
+/// returns the offsets for the given counts
+inline std::vector<index_t> countsToOffsets(const std::vector<index_t>& counts)
+{
+    std::vector<index_t> offset(counts.size()+1, 0);
+    for (size_t i=0; i<counts.size(); ++i)
+        offset[i+1] = offset[i]+counts[i];
+    return offset;
+}
+
+/// returns the sorted list of ranks sharing values with this rank through
+/// the column coupler of A
+std::vector<int> getNeighbours(const SystemMatrix& A)
+{
+    const_Connector_ptr connector(A.col_coupler->connector);
+    std::vector<int> out(connector->send->neighbour);
+    out.insert(out.end(), connector->recv->neighbour.begin(),
+               connector->recv->neighbour.end());
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+    return out;
+}
+
+/// adds the neighbours of all partners to partners. If partners holds the
+/// ranks within k coupler hops of this rank it holds the ranks within k+1
+/// hops on return, the relation stays symmetric.
+void extendPartners(const escript::JMPI& mpi_info,
+                    const std::vector<int>& neighbours,
+                    std::vector<int>& partners)
+{
+    const size_t np = partners.size();
+    std::vector<index_t> sendCount(np+1, neighbours.size());
+    const std::vector<index_t> recvCount(exchangeCounts(mpi_info, partners,
+                                                        sendCount));
+    sendCount.pop_back();
+    std::vector<index_t> sendOffset(countsToOffsets(sendCount));
+    std::vector<index_t> recvOffset(countsToOffsets(recvCount));
+    std::vector<int> sendBuf(sendOffset[np]+1), recvBuf(recvOffset[np]+1);
+    for (size_t i=0; i<np; ++i)
+        std::copy(neighbours.begin(), neighbours.end(),
+                  &sendBuf[sendOffset[i]]);
+    exchange(mpi_info, partners, MPI_INT, &sendBuf[0], sendOffset,
+             &recvBuf[0], recvOffset);
+    recvBuf.pop_back();
+    partners.insert(partners.end(), recvBuf.begin(), recvBuf.end());
+    std::sort(partners.begin(), partners.end());
+    partners.erase(std::unique(partners.begin(), partners.end()),
+                   partners.end());
+    partners.erase(std::remove(partners.begin(), partners.end(),
+                               mpi_info->rank), partners.end());
+}
+
+/// fetches the rows with the sorted global ids in 'ids' from their owners
+/// and appends them to 'rows'. The owners must be in the sorted list of
+/// partners and all partners must take part in the call.
+void fetchRows(GlobalRows& rows, const SystemMatrix& A,
+               const std::vector<index_t>& ids,
+               const std::vector<int>& partners)
+{
+    const escript::JMPI& mpi_info(A.mpi_info);
+    const size_t np = partners.size();
+    const dim_t bb = A.row_block_size*A.row_block_size;
+    const std::vector<index_t>& dist = A.row_distribution->first_component;
+    const index_t offset = dist[mpi_info->rank];
+
+    // ids are sorted so the requests to a partner are contiguous
+    std::vector<index_t> reqCount(np+1, 0);
+    for (size_t k=0; k<ids.size(); ++k)
+        reqCount[partnerIndex(partners, getOwner(dist, ids[k]))]++;
+    const std::vector<index_t> srvCount(exchangeCounts(mpi_info, partners,
+                                                       reqCount));
+    reqCount.pop_back();
+    const std::vector<index_t> reqOffset(countsToOffsets(reqCount));
+    const std::vector<index_t> srvOffset(countsToOffsets(srvCount));
+    std::vector<index_t> srvIds(srvOffset[np]+1);
+    exchange(mpi_info, partners, MPI_DIM_T, ids.empty() ? NULL : &ids[0],
+             reqOffset, &srvIds[0], srvOffset);
+
+    // collect the requested rows
+    GlobalRows reply;
+    for (index_t k=0; k<srvOffset[np]; ++k)
+        appendLocalRow(reply, A, srvIds[k]-offset, offset);
+    std::vector<index_t> srvLen(srvOffset[np]+1);
+    for (index_t k=0; k<srvOffset[np]; ++k)
+        srvLen[k] = reply.ptr[k+1]-reply.ptr[k];
+    std::vector<index_t> reqLen(reqOffset[np]+1);
+    exchange(mpi_info, partners, MPI_DIM_T, &srvLen[0], srvOffset,
+             &reqLen[0], reqOffset);
+
+    // exchange column ids and values of the rows
+    std::vector<index_t> srvEntryOffset(np+1, 0), reqEntryOffset(np+1, 0);
+    std::vector<index_t> srvValOffset(np+1, 0), reqValOffset(np+1, 0);
+    for (size_t i=0; i<np; ++i) {
+        srvEntryOffset[i+1] = reply.ptr[srvOffset[i+1]];
+        reqEntryOffset[i+1] = reqEntryOffset[i];
+        for (index_t k=reqOffset[i]; k<reqOffset[i+1]; ++k)
+            reqEntryOffset[i+1] += reqLen[k];
+        srvValOffset[i+1] = srvEntryOffset[i+1]*bb;
+        reqValOffset[i+1] = reqEntryOffset[i+1]*bb;
+    }
+    const size_t numCols = rows.cols.size();
+    const size_t numVals = rows.vals.size();
+    rows.cols.resize(numCols+reqEntryOffset[np]+1);
+    rows.vals.resize(numVals+reqValOffset[np]+1);
+    reply.cols.resize(reply.cols.size()+1);
+    reply.vals.resize(reply.vals.size()+1);
+    exchange(mpi_info, partners, MPI_DIM_T, &reply.cols[0], srvEntryOffset,
+             &rows.cols[numCols], reqEntryOffset);
+    exchange(mpi_info, partners, MPI_DOUBLE, &reply.vals[0], srvValOffset,
+             &rows.vals[numVals], reqValOffset);
+    rows.cols.pop_back();
+    rows.vals.pop_back();
+
+    for (size_t k=0; k<ids.size(); ++k) {
+        rows.id.push_back(ids[k]);
+        rows.ptr.push_back(rows.ptr.back()+reqLen[k]);
+    }
+}
+#endif
+
+} // anonymous namespace
+
+Preconditioner_Schwarz* Preconditioner_Schwarz_alloc(SystemMatrix_ptr A,
+                                                     Options* options)
+{
+    const dim_t n = A->mainBlock->numRows;
+    const dim_t b = A->row_block_size;
+    const dim_t bb = b*b;
+    const index_t offset = A->row_distribution->getFirstComponent();
+    const dim_t overlap = (A->mpi_info->size > 1 ? options->schwarz_overlap : 0);
+    const double time0 = escript::gettime();
+
+    if (options->schwarz_local_solver != PASO_DIRECT && b > PASO_BLOCKOPS_MAX_N) {
+        throw PasoException("Preconditioner_Schwarz: ILU0 local solver does "
+                            "not support block size greater than 8.");
+    }
+
+    // collect the rows of the overlapping subdomain layer by layer
+    GlobalRows ghosts;
+#ifdef ESYS_MPI
+    if (A->mpi_info->size > 1) {
+        // global ids of the couple columns are required to identify the
+        // columns of the local rows in the overlapping subdomain
+        const dim_t num_couple_cols = A->col_coupleBlock->numCols;
+        if (A->global_id == NULL) {
+            double* cols = new double[A->mainBlock->numCols];
+#pragma omp parallel for
+            for (index_t i=0; i<A->mainBlock->numCols; ++i)
+                cols[i] = offset + i;
+            Coupler_ptr<real_t> coupler(new Coupler<real_t>(
+                        A->col_coupler->connector, 1, A->mpi_info));
+            coupler->startCollect(cols);
+            coupler->finishCollect();
+            A->global_id = new index_t[num_couple_cols+1];
+#pragma omp parallel for
+            for (index_t i=0; i<num_couple_cols; ++i)
+                A->global_id[i] = coupler->recv_buffer[i];
+            delete[] cols;
+        }
+    }
+    // ranks which can own rows of the overlapping subdomain. Rows of the
+    // k-th layer are owned by ranks within k coupler hops of this rank so
+    // only these are contacted.
+    std::vector<int> partners;
+    if (overlap > 0) {
+        const dim_t num_couple_cols = A->col_coupleBlock->numCols;
+        const std::vector<int> neighbours(getNeighbours(*A));
+        partners = neighbours;
+        std::set<index_t> known;
+        std::vector<index_t> ids(A->global_id, A->global_id+num_couple_cols);
+        for (dim_t level=0; level<overlap; ++level) {
+            if (level > 0)
+                extendPartners(A->mpi_info, neighbours, partners);
+            std::sort(ids.begin(), ids.end());
+            ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+            known.insert(ids.begin(), ids.end());
+            const size_t first = ghosts.id.size();
+            fetchRows(ghosts, *A, ids, partners);
+            ids.clear();
+            for (index_t k=ghosts.ptr[first]; k<ghosts.ptr.back(); ++k) {
+                const index_t col = ghosts.cols[k];
+                if ((col < offset || col >= offset+n) && known.count(col)==0)
+                    ids.push_back(col);
+            }
+        }
+    }
+#endif
+
+    Preconditioner_Schwarz* out = new Preconditioner_Schwarz;
+    out->n = n;
+    out->n_ext = n + ghosts.id.size();
+    out->block_size = b;
+    out->local_solver = options->schwarz_local_solver;
+    // only the conjugate gradient methods and MINRES require a symmetric
+    // preconditioner
+    const int method = Options::getSolver(options->method, PASO_PASO,
+                                          options->symmetric, A->mpi_info);
+    out->restricted = !(method == PASO_PCG || method == PASO_PIPELINED_PCG
+            || method == PASO_MINRES);
+    out->ilu = NULL;
+    out->x_ext = NULL;
+    out->b_ext = NULL;
+    out->send_buffer = NULL;
+
+    // ghost rows are ordered by global id so the rows of a neighbour are
+    // contiguous
+    const dim_t numGhosts = ghosts.id.size();
+    std::vector<std::pair<index_t, index_t> > sorted(numGhosts);
+    for (index_t k=0; k<numGhosts; ++k)
+        sorted[k] = std::make_pair(ghosts.id[k], k);
+    std::sort(sorted.begin(), sorted.end());
+    std::vector<index_t> ghostIds(numGhosts), ghostOrder(numGhosts);
+    for (index_t k=0; k<numGhosts; ++k) {
+        ghostIds[k] = sorted[k].first;
+        ghostOrder[k] = sorted[k].second;
+    }
+
+    // build the matrix of the overlapping subdomain keeping the couplings
+    // within the subdomain only
+    const dim_t n_ext = out->n_ext;
+    index_t* ptr = new index_t[n_ext+1];
+    std::vector<index_t> index;
+    std::vector<double> val;
+    std::vector<std::pair<index_t, index_t> > row;
+    GlobalRows local;
+    ptr[0] = 0;
+    for (index_t i=0; i<n_ext; ++i) {
+        const GlobalRows* src = &ghosts;
+        index_t r;
+        if (i < n) {
+            local.cols.clear();
+            local.vals.clear();
+            local.ptr.assign(1, 0);
+            appendLocalRow(local, *A, i, offset);
+            src = &local;
+            r = 0;
+        } else {
+            r = ghostOrder[i-n];
+        }
+        row.clear();
+        for (index_t k=src->ptr[r]; k<src->ptr[r+1]; ++k) {
+            const index_t col = src->cols[k];
+            index_t j = -1;
+            if (col >= offset && col < offset+n) {
+                j = col-offset;
+            } else {
+                std::vector<index_t>::const_iterator it = std::lower_bound(
+                        ghostIds.begin(), ghostIds.end(), col);
+                if (it != ghostIds.end() && *it == col)
+                    j = n + (it-ghostIds.begin());
+            }
+            if (j >= 0)
+                row.push_back(std::make_pair(j, k));
+        }
+        std::sort(row.begin(), row.end());
+        for (size_t k=0; k<row.size(); ++k) {
+            index.push_back(row[k].first);
+            val.insert(val.end(), &src->vals[row[k].second*bb],
+                       &src->vals[(row[k].second+1)*bb]);
+        }
+        ptr[i+1] = index.size();
+    }
+    index_t* idx = new index_t[index.size()+1];
+    std::copy(index.begin(), index.end(), idx);
+    Pattern_ptr pattern(new Pattern(MATRIX_FORMAT_DEFAULT, n_ext, n_ext, ptr,
+                                    idx));
+    out->A_ext.reset(new SparseMatrix(MATRIX_FORMAT_DEFAULT, pattern, b, b,
+                                      false));
+    if (out->A_ext->row_block_size != b) {
+        Preconditioner_Schwarz_free(out);
+        throw PasoException("Preconditioner_Schwarz: unsupported block size.");
+    }
+    std::copy(val.begin(), val.end(), out->A_ext->val);
+
+    // set up the exchange of right hand side values for the ghost rows
+    out->recv_offset.push_back(0);
+    out->send_offset.push_back(0);
+#ifdef ESYS_MPI
+    if (overlap > 0) {
+        const size_t np = partners.size();
+        const std::vector<index_t>& dist = A->row_distribution->first_component;
+        std::vector<index_t> reqCount(np+1, 0);
+        for (index_t k=0; k<numGhosts; ++k)
+            reqCount[partnerIndex(partners, getOwner(dist, ghostIds[k]))]++;
+        const std::vector<index_t> srvCount(exchangeCounts(A->mpi_info,
+                                                    partners, reqCount));
+        reqCount.pop_back();
+        const std::vector<index_t> reqOffset(countsToOffsets(reqCount));
+        const std::vector<index_t> srvOffset(countsToOffsets(srvCount));
+        out->send_rows.resize(srvOffset[np]+1);
+        ghostIds.push_back(0);
+        exchange(A->mpi_info, partners, MPI_DIM_T, &ghostIds[0], reqOffset,
+                 &out->send_rows[0], srvOffset);
+        out->send_rows.pop_back();
+        for (size_t k=0; k<out->send_rows.size(); ++k)
+            out->send_rows[k] -= offset;
+        for (size_t i=0; i<np; ++i) {
+            if (reqCount[i] > 0) {
+                out->recv_neighbour.push_back(partners[i]);
+                out->recv_offset.push_back(reqOffset[i+1]);
+            }
+            if (srvCount[i] > 0) {
+                out->send_neighbour.push_back(partners[i]);
+                out->send_offset.push_back(srvOffset[i+1]);
+            }
+        }
+    }
+#endif
+    out->x_ext = new double[n_ext*b];
+    out->b_ext = new double[n_ext*b];
+    out->send_buffer = new double[out->send_rows.size()*b+1];
+
+    // factorize the local matrix
+    if (out->local_solver == PASO_DIRECT) {
+#if defined(ESYS_HAVE_MKL)
+        out->A_direct = out->A_ext->unroll(MATRIX_FORMAT_BLK1 +
+                                           MATRIX_FORMAT_OFFSET1);
+#elif defined(ESYS_HAVE_UMFPACK)
+        out->A_direct = out->A_ext->unroll(MATRIX_FORMAT_BLK1 +
+                            MATRIX_FORMAT_CSC + MATRIX_FORMAT_OFFSET1);
+#else
+        out->A_direct = out->A_ext;
+        Supernodal_factorize(out->A_direct, false, options->verbose);
+#endif
+    } else {
+        out->ilu = Solver_getILU(out->A_ext, options->mixed_precision,
+                                 options->verbose);
+    }
+
+    if (options->verbose) {
+        printf("Preconditioner_Schwarz: %s variant, overlap %d, %s local "
+               "solver, %d rows added to the local subdomain of %d rows.\n",
+               out->restricted ? "restricted" : "additive", (int)overlap,
+               Options::name(out->local_solver), (int)numGhosts, (int)n);
+        printf("timing: Schwarz setup: %e\n", escript::gettime()-time0);
+    }
+    return out;
+}
+
+void Preconditioner_Schwarz_solve(SystemMatrix_ptr A,
+        Preconditioner_Schwarz* prec, double* x, const double* b)
+{
+    const dim_t n = prec->n;
+    const dim_t bs = prec->block_size;
+    double* b_ext = prec->b_ext;
+    double* x_ext = prec->x_ext;
+
+    util::copy(n*bs, b_ext, b);
+#ifdef ESYS_MPI
+    const dim_t numRecv = prec->recv_neighbour.size();
+    const dim_t numSend = prec->send_neighbour.size();
+    if (numRecv+numSend > 0) {
+        escript::JMPI mpi_info(A->mpi_info);
+        std::vector<MPI_Request> requests(numRecv+numSend);
+        std::vector<MPI_Status> status(numRecv+numSend);
+        for (dim_t p=0; p<numRecv; ++p) {
+            MPI_Irecv(&b_ext[(n+prec->recv_offset[p])*bs],
+                    (prec->recv_offset[p+1]-prec->recv_offset[p])*bs,
+                    MPI_DOUBLE, prec->recv_neighbour[p],
+                    mpi_info->counter()+prec->recv_neighbour[p],
+                    mpi_info->comm, &requests[p]);
+        }
+        const dim_t numSendRows = prec->send_rows.size();
+        double* send_buffer = prec->send_buffer;
+        const index_t* send_rows = &prec->send_rows[0];
+#pragma omp parallel for
+        for (index_t k=0; k<numSendRows; ++k) {
+            for (dim_t c=0; c<bs; ++c)
+                send_buffer[k*bs+c] = b[send_rows[k]*bs+c];
+        }
+        for (dim_t p=0; p<numSend; ++p) {
+            MPI_Issend(&send_buffer[prec->send_offset[p]*bs],
+                    (prec->send_offset[p+1]-prec->send_offset[p])*bs,
+                    MPI_DOUBLE, prec->send_neighbour[p],
+                    mpi_info->counter()+mpi_info->rank, mpi_info->comm,
+                    &requests[numRecv+p]);
+        }
+        mpi_info->incCounter(mpi_info->size);
+        MPI_Waitall(numRecv+numSend, &requests[0], &status[0]);
+    }
+#endif
+
+    if (prec->local_solver == PASO_DIRECT) {
+#if defined(ESYS_HAVE_MKL)
+        MKL_solve(prec->A_direct, x_ext, b_ext, PASO_DEFAULT, 0, false);
+#elif defined(ESYS_HAVE_UMFPACK)
+        UMFPACK_solve(prec->A_direct, x_ext, b_ext, 0, false);
+#else
+        Supernodal_solve(prec->A_direct, x_ext, b_ext, false, 0, false);
+#endif
+    } else {
+        Solver_solveILU(prec->A_ext, prec->ilu, x_ext, b_ext);
+    }
+    util::copy(n*bs, x, x_ext);
+
+#ifdef ESYS_MPI
+    // the additive variant adds the values of the local solutions on other
+    // ranks for the local rows
+    if (!prec->restricted && numRecv+numSend > 0) {
+        escript::JMPI mpi_info(A->mpi_info);
+        std::vector<MPI_Request> requests(numRecv+numSend);
+        std::vector<MPI_Status> status(numRecv+numSend);
+        double* recv_buffer = prec->send_buffer;
+        for (dim_t p=0; p<numSend; ++p) {
+            MPI_Irecv(&recv_buffer[prec->send_offset[p]*bs],
+                    (prec->send_offset[p+1]-prec->send_offset[p])*bs,
+                    MPI_DOUBLE, prec->send_neighbour[p],
+                    mpi_info->counter()+prec->send_neighbour[p],
+                    mpi_info->comm, &requests[p]);
+        }
+        for (dim_t p=0; p<numRecv; ++p) {
+            MPI_Issend(&x_ext[(n+prec->recv_offset[p])*bs],
+                    (prec->recv_offset[p+1]-prec->recv_offset[p])*bs,
+                    MPI_DOUBLE, prec->recv_neighbour[p],
+                    mpi_info->counter()+mpi_info->rank, mpi_info->comm,
+                    &requests[numSend+p]);
+        }
+        mpi_info->incCounter(mpi_info->size);
+        MPI_Waitall(numRecv+numSend, &requests[0], &status[0]);
+        // a row may be shared with several ranks but appears only once in
+        // the list of each rank
+        const index_t* send_rows = &prec->send_rows[0];
+        for (dim_t p=0; p<numSend; ++p) {
+#pragma omp parallel for
+            for (index_t k=prec->send_offset[p]; k<prec->send_offset[p+1];
+                    ++k) {
+                for (dim_t c=0; c<bs; ++c)
+                    x[send_rows[k]*bs+c] += recv_buffer[k*bs+c];
+            }
+        }
+    }
+#endif
+}
+
+} // namespace paso
+
@@ -29,6 +29,13 @@
 #include "BlockOps.h"
 #include "PasoUtil.h"
 
+#include <algorithm>
+#include <vector>
+
+// number of consecutive rows in a tile of the tiled Gauss-Seidel sweep. The
+// tiles do not depend on the number of threads so neither does the result.
+#define PASO_SMOOTHER_TILE_SIZE 1024
+
 namespace paso {
 
 void Preconditioner_Smoother_free(Preconditioner_Smoother* in)
@@ -42,7 +49,9 @@ void Preconditioner_Smoother_free(Preconditioner_Smoother* in)
 void Preconditioner_LocalSmoother_free(Preconditioner_LocalSmoother* in)
 {
     if (in!=NULL) {
+        delete[] in->tile_color;
         delete[] in->diag;
+        delete[] in->diag_sp;
         delete[] in->pivot;
         delete[] in->buffer;
         delete in;
@@ -50,19 +59,59 @@ void Preconditioner_LocalSmoother_free(Preconditioner_LocalSmoother* in)
 }
 
 
+/// colors the tiles of PASO_SMOOTHER_TILE_SIZE consecutive rows of A such
+/// that tiles of the same color are not coupled
+static index_t* Preconditioner_LocalSmoother_colorTiles(SparseMatrix_ptr A,
+                                                         dim_t* num_colors)
+{
+    const dim_t n=A->numRows;
+    const dim_t num_tiles=(n+PASO_SMOOTHER_TILE_SIZE-1)/PASO_SMOOTHER_TILE_SIZE;
+    std::vector<std::vector<index_t> > neighbours(num_tiles);
+    for (index_t i=0; i<n; ++i) {
+        const index_t t=i/PASO_SMOOTHER_TILE_SIZE;
+        for (index_t iptr=A->pattern->ptr[i]; iptr<A->pattern->ptr[i+1]; ++iptr) {
+            const index_t u=A->pattern->index[iptr]/PASO_SMOOTHER_TILE_SIZE;
+            if (u!=t) {
+                // the pattern may not be symmetric
+                neighbours[t].push_back(u);
+                neighbours[u].push_back(t);
+            }
+        }
+    }
+    index_t* color=new index_t[num_tiles];
+    std::vector<index_t> used;
+    *num_colors=0;
+    for (index_t t=0; t<num_tiles; ++t) {
+        for (size_t j=0; j<neighbours[t].size(); ++j) {
+            const index_t u=neighbours[t][j];
+            if (u<t)
+                used[color[u]]=t;
+        }
+        index_t c=0;
+        while (c<*num_colors && used[c]==t)
+            c++;
+        if (c==*num_colors) {
+            used.push_back(-1);
+            (*num_colors)++;
+        }
+        color[t]=c;
+    }
+    return color;
+}
+
 /// constructs the symmetric Gauss-Seidel preconditioner
 Preconditioner_Smoother* Preconditioner_Smoother_alloc(SystemMatrix_ptr A,
-        bool jacobi, bool is_local, bool verbose)
+        bool jacobi, bool is_local, bool mixed_precision, bool verbose)
 {
     Preconditioner_Smoother* out=new Preconditioner_Smoother;
     out->localSmoother=Preconditioner_LocalSmoother_alloc(A->mainBlock,
-                                                jacobi, verbose);
+                                        jacobi, mixed_precision, verbose);
     out->is_local=is_local;
     return out;
 }
 
 Preconditioner_LocalSmoother* Preconditioner_LocalSmoother_alloc(
-        SparseMatrix_ptr A, bool jacobi, bool verbose)
+        SparseMatrix_ptr A, bool jacobi, bool mixed_precision, bool verbose)
 {
     const dim_t n=A->numRows;
     const dim_t n_block=A->row_block_size;
@@ -72,9 +121,26 @@ Preconditioner_LocalSmoother* Preconditioner_LocalSmoother_alloc(
 
     out->diag=new double[((size_t) n) * ((size_t) block_size)];
     out->pivot=new index_t[ ((size_t) n) * ((size_t)  n_block)];
-    out->buffer=new double[((size_t) n) * ((size_t)  n_block)];
+    out->buffer=util::newVector(n*n_block);
+    out->diag_sp=NULL;
+    out->tile_color=NULL;
+    out->num_tile_colors=0;
     out->Jacobi=jacobi;
     A->invMain(out->diag, out->pivot);
+    if (!jacobi)
+        out->tile_color=Preconditioner_LocalSmoother_colorTiles(A,
+                                                    &out->num_tile_colors);
+    // the Jacobi sweep only needs the (explicit) inverse of the diagonal
+    // blocks which can be kept in single precision
+    if (jacobi && mixed_precision && n_block<=PASO_BLOCKOPS_MAX_N) {
+        const dim_t len=n*block_size;
+        out->diag_sp=new float[len];
+#pragma omp parallel for
+        for (index_t i=0; i<len; ++i)
+            out->diag_sp[i]=static_cast<float>(out->diag[i]);
+        delete[] out->diag;
+        out->diag=NULL;
+    }
     time0=escript::gettime()-time0;
     return out;
 }
@@ -206,11 +272,17 @@ void Preconditioner_LocalSmoother_Sweep(SparseMatrix_ptr A,
 #else
     const dim_t nt=1;
 #endif
-    if (smoother->Jacobi) {
+    if (smoother->diag_sp) {
+        BlockOps_solveAll(A->row_block_size,A->numRows,smoother->diag_sp,x);
+    } else if (smoother->Jacobi) {
         BlockOps_solveAll(A->row_block_size,A->numRows,smoother->diag,smoother->pivot,x);
     } else {
+        const dim_t num_tiles=(A->numRows+PASO_SMOOTHER_TILE_SIZE-1)/PASO_SMOOTHER_TILE_SIZE;
         if (nt < 2) {
             Preconditioner_LocalSmoother_Sweep_sequential(A,smoother,x);
+        } else if (num_tiles >= nt*smoother->num_tile_colors) {
+            // every thread gets at least one tile of each color
+            Preconditioner_LocalSmoother_Sweep_tiled(A,smoother,x);
         } else {
             Preconditioner_LocalSmoother_Sweep_colored(A,smoother,x);
         }
@@ -335,6 +407,197 @@ void Preconditioner_LocalSmoother_Sweep_sequential(SparseMatrix_ptr A,
     }
 }
 
+/*
+  Gauss-Seidel sweep on tiles of PASO_SMOOTHER_TILE_SIZE consecutive rows.
+  The tiles are colored such that tiles of the same color are not coupled.
+  The colors are processed one after the other and the tiles of a color in
+  parallel, each tile being swept sequentially in storage order. This is the
+  Gauss-Seidel sweep for the rows ordered by tile color, so all couplings
+  are kept and the result does not depend on the number of threads. In
+  contrast to the colored sweep x is accessed in storage order.
+*/
+void Preconditioner_LocalSmoother_Sweep_tiled(SparseMatrix_ptr A,
+        Preconditioner_LocalSmoother* smoother, double* x)
+{
+    const dim_t n=A->numRows;
+    if (n==0)
+        return;
+
+    const dim_t n_block=A->row_block_size;
+    double *diag = smoother->diag;
+    index_t* pivot = smoother->pivot;
+    const dim_t block_len=A->block_size;
+    const index_t* ptr_main = A->borrowMainDiagonalPointer();
+    const index_t* tile_color = smoother->tile_color;
+    const dim_t num_colors = smoother->num_tile_colors;
+    const dim_t num_tiles=(n+PASO_SMOOTHER_TILE_SIZE-1)/PASO_SMOOTHER_TILE_SIZE;
+    int failed = 0;
+
+    (void)pivot;                 /* These vars are dropped by some macros*/
+    (void)block_len;
+
+    // forward substitution: rows of tiles with a smaller color and the
+    // preceding rows of the tile are already updated
+    for (index_t color=0; color<num_colors; ++color) {
+#pragma omp parallel for schedule(static) reduction(+:failed)
+        for (index_t t=0; t<num_tiles; ++t) {
+            if (tile_color[t]!=color)
+                continue;
+            const index_t i0=t*PASO_SMOOTHER_TILE_SIZE;
+            const index_t i1=std::min(i0+PASO_SMOOTHER_TILE_SIZE, n);
+            index_t i,k,iptr_ik,mm;
+            double rtmp;
+            if (n_block==1) {
+                for (i = i0; i < i1; ++i) {
+                    mm=ptr_main[i];
+                    rtmp=x[i];
+                    for (iptr_ik=A->pattern->ptr[i];iptr_ik<mm; ++iptr_ik) {
+                        k=A->pattern->index[iptr_ik];
+                        if (k>=i0 || tile_color[k/PASO_SMOOTHER_TILE_SIZE]<color)
+                            rtmp-=A->val[iptr_ik]*x[k];
+                    }
+                    for (iptr_ik=mm+1; iptr_ik < A->pattern->ptr[i+1]; ++iptr_ik) {
+                        k=A->pattern->index[iptr_ik];
+                        if (k>=i1 && tile_color[k/PASO_SMOOTHER_TILE_SIZE]<color)
+                            rtmp-=A->val[iptr_ik]*x[k];
+                    }
+                    x[i]=rtmp*diag[i];
+                }
+            } else if (n_block==2) {
+                for (i = i0; i < i1; ++i) {
+                    mm=ptr_main[i];
+                    for (iptr_ik=A->pattern->ptr[i];iptr_ik<mm; ++iptr_ik) {
+                        k=A->pattern->index[iptr_ik];
+                        if (k>=i0 || tile_color[k/PASO_SMOOTHER_TILE_SIZE]<color)
+                            BlockOps_SMV_2(&x[2*i], &A->val[4*iptr_ik], &x[2*k]);
+                    }
+                    for (iptr_ik=mm+1; iptr_ik < A->pattern->ptr[i+1]; ++iptr_ik) {
+                        k=A->pattern->index[iptr_ik];
+                        if (k>=i1 && tile_color[k/PASO_SMOOTHER_TILE_SIZE]<color)
+                            BlockOps_SMV_2(&x[2*i], &A->val[4*iptr_ik], &x[2*k]);
+                    }
+                    BlockOps_MViP_2(&diag[4*i], &x[2*i]);
+                }
+            } else if (n_block==3) {
+                for (i = i0; i < i1; ++i) {
+                    mm=ptr_main[i];
+                    for (iptr_ik=A->pattern->ptr[i];iptr_ik<mm; ++iptr_ik) {
+                        k=A->pattern->index[iptr_ik];
+                        if (k>=i0 || tile_color[k/PASO_SMOOTHER_TILE_SIZE]<color)
+                            BlockOps_SMV_3(&x[3*i], &A->val[9*iptr_ik], &x[3*k]);
+                    }
+                    for (iptr_ik=mm+1; iptr_ik < A->pattern->ptr[i+1]; ++iptr_ik) {
+                        k=A->pattern->index[iptr_ik];
+                        if (k>=i1 && tile_color[k/PASO_SMOOTHER_TILE_SIZE]<color)
+                            BlockOps_SMV_3(&x[3*i], &A->val[9*iptr_ik], &x[3*k]);
+                    }
+                    BlockOps_MViP_3(&diag[9*i], &x[3*i]);
+                }
+            } else {
+                for (i = i0; i < i1; ++i) {
+                    mm=ptr_main[i];
+                    for (iptr_ik=A->pattern->ptr[i];iptr_ik<mm; ++iptr_ik) {
+                        k=A->pattern->index[iptr_ik];
+                        if (k>=i0 || tile_color[k/PASO_SMOOTHER_TILE_SIZE]<color)
+                            BlockOps_SMV_N(n_block, &x[n_block*i], &A->val[block_len*iptr_ik], &x[n_block*k]);
+                    }
+                    for (iptr_ik=mm+1; iptr_ik < A->pattern->ptr[i+1]; ++iptr_ik) {
+                        k=A->pattern->index[iptr_ik];
+                        if (k>=i1 && tile_color[k/PASO_SMOOTHER_TILE_SIZE]<color)
+                            BlockOps_SMV_N(n_block, &x[n_block*i], &A->val[block_len*iptr_ik], &x[n_block*k]);
+                    }
+                    BlockOps_solve_N(n_block, &x[n_block*i], &diag[block_len*i], &pivot[n_block*i], &failed);
+                }
+            }
+        }
+    }
+
+    // backward substitution in reverse order: rows of tiles with a larger
+    // color and the following rows of the tile are already updated
+    for (index_t color=num_colors-1; color>=0; --color) {
+#pragma omp parallel for schedule(static) reduction(+:failed)
+        for (index_t t=0; t<num_tiles; ++t) {
+            if (tile_color[t]!=color)
+                continue;
+            const index_t i0=t*PASO_SMOOTHER_TILE_SIZE;
+            const index_t i1=std::min(i0+PASO_SMOOTHER_TILE_SIZE, n);
+            index_t i,k,iptr_ik,mm;
+            double rtmp;
+            if (n_block==1) {
+                for (i = i1-1; i >= i0; --i) {
+                    mm=ptr_main[i];
+                    rtmp=x[i]*A->val[mm];
+                    for (iptr_ik=A->pattern->ptr[i];iptr_ik<mm; ++iptr_ik) {
+                        k=A->pattern->index[iptr_ik];
+                        if (k<i0 && tile_color[k/PASO_SMOOTHER_TILE_SIZE]>color)
+                            rtmp-=A->val[iptr_ik]*x[k];
+                    }
+                    for (iptr_ik=mm+1; iptr_ik < A->pattern->ptr[i+1]; ++iptr_ik) {
+                        k=A->pattern->index[iptr_ik];
+                        if (k<i1 || tile_color[k/PASO_SMOOTHER_TILE_SIZE]>color)
+                            rtmp-=A->val[iptr_ik]*x[k];
+                    }
+                    x[i]=diag[i]*rtmp;
+                }
+            } else if (n_block==2) {
+                for (i = i1-1; i >= i0; --i) {
+                    mm=ptr_main[i];
+                    BlockOps_MViP_2(&A->val[4*mm], &x[2*i]);
+                    for (iptr_ik=A->pattern->ptr[i];iptr_ik<mm; ++iptr_ik) {
+                        k=A->pattern->index[iptr_ik];
+                        if (k<i0 && tile_color[k/PASO_SMOOTHER_TILE_SIZE]>color)
+                            BlockOps_SMV_2(&x[2*i], &A->val[4*iptr_ik], &x[2*k]);
+                    }
+                    for (iptr_ik=mm+1; iptr_ik < A->pattern->ptr[i+1]; ++iptr_ik) {
+                        k=A->pattern->index[iptr_ik];
+                        if (k<i1 || tile_color[k/PASO_SMOOTHER_TILE_SIZE]>color)
+                            BlockOps_SMV_2(&x[2*i], &A->val[4*iptr_ik], &x[2*k]);
+                    }
+                    BlockOps_MViP_2(&diag[i*4], &x[2*i]);
+                }
+            } else if (n_block==3) {
+                for (i = i1-1; i >= i0; --i) {
+                    mm=ptr_main[i];
+                    BlockOps_MViP_3(&A->val[9*mm], &x[3*i]);
+                    for (iptr_ik=A->pattern->ptr[i];iptr_ik<mm; ++iptr_ik) {
+                        k=A->pattern->index[iptr_ik];
+                        if (k<i0 && tile_color[k/PASO_SMOOTHER_TILE_SIZE]>color)
+                            BlockOps_SMV_3(&x[3*i], &A->val[9*iptr_ik], &x[3*k]);
+                    }
+                    for (iptr_ik=mm+1; iptr_ik < A->pattern->ptr[i+1]; ++iptr_ik) {
+                        k=A->pattern->index[iptr_ik];
+                        if (k<i1 || tile_color[k/PASO_SMOOTHER_TILE_SIZE]>color)
+                            BlockOps_SMV_3(&x[3*i], &A->val[9*iptr_ik], &x[3*k]);
+                    }
+                    BlockOps_MViP_3(&diag[i*9], &x[3*i]);
+                }
+            } else {
+                double *y=new double[n_block];
+                for (i = i1-1; i >= i0; --i) {
+                    mm=ptr_main[i];
+                    BlockOps_MV_N(n_block, &y[0], &A->val[block_len*mm], &x[n_block*i]);
+                    for (iptr_ik=A->pattern->ptr[i];iptr_ik<mm; ++iptr_ik) {
+                        k=A->pattern->index[iptr_ik];
+                        if (k<i0 && tile_color[k/PASO_SMOOTHER_TILE_SIZE]>color)
+                            BlockOps_SMV_N(n_block, &y[0], &A->val[block_len*iptr_ik], &x[n_block*k]);
+                    }
+                    for (iptr_ik=mm+1; iptr_ik < A->pattern->ptr[i+1]; ++iptr_ik) {
+                        k=A->pattern->index[iptr_ik];
+                        if (k<i1 || tile_color[k/PASO_SMOOTHER_TILE_SIZE]>color)
+                            BlockOps_SMV_N(n_block, &y[0], &A->val[block_len*iptr_ik], &x[n_block*k]);
+                    }
+                    BlockOps_Cpy_N(n_block ,&x[n_block*i], &y[0]);
+                    BlockOps_solve_N(n_block, &x[n_block*i], &diag[i*block_len], &pivot[i*n_block], &failed);
+                }
+                delete[] y;
+            }
+        }
+    }
+    if (failed > 0) {
+        throw PasoException("Preconditioner_LocalSmoother_Sweep_tiled: non-regular main diagonal block.");
+    }
+}
+
 void Preconditioner_LocalSmoother_Sweep_colored(SparseMatrix_ptr A,
         Preconditioner_LocalSmoother* smoother, double* x)
 {
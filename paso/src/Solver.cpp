@@ -27,6 +27,7 @@
 
 #include "Solver.h"
 #include "Options.h"
+#include "PasoUtil.h"
 #include "SystemMatrix.h"
 
 #include <boost/math/special_functions/fpclassify.hpp>  // for isnan
@@ -37,9 +38,40 @@ namespace bm = boost::math;
 
 namespace paso {
 
+namespace {
+
+// Refreshes the values of the sliced ELLPACK copy of the matrix while the
+// solver runs. The structure stays with the matrix for the next solve but the
+// matrix values may change after the call so the copy is marked out of date
+// on every exit, including exceptions.
+class SlicedEllpackCopy
+{
+public:
+    SlicedEllpackCopy(SystemMatrix_ptr A, bool use) : m_A(A), m_use(use)
+    {
+        if (m_use)
+            m_A->setSlicedEllpack();
+        else
+            m_A->freeSlicedEllpack();
+    }
+    ~SlicedEllpackCopy()
+    {
+        if (m_use)
+            m_A->invalidateSlicedEllpack();
+    }
+private:
+    SystemMatrix_ptr m_A;
+    bool m_use;
+};
+
+} // anonymous namespace
+
 void Solver_free(SystemMatrix* A)
 {
     A->freePreconditioner();
+    // the reordered copy of the matrix holds its own preconditioner
+    if (A->reordered_system && A->reordered_system->A)
+        solve_free(A->reordered_system->A.get());
 }
 
 ///  calls the iterative solver
@@ -93,9 +125,17 @@ SolverResult Solver(SystemMatrix_ptr A, double* x, double* b, Options* options,
         return errorCode;
     }
 
-    r = new double[numEqua];
-    x0 = new double[numEqua];
+    // the recycled subspace is kept with the matrix between solves unless
+    // recycling is switched off or not supported by the method
+    const bool recycle = (options->num_recycled_vectors > 0 &&
+                          (method == PASO_PCG || method == PASO_GMRES));
+    if (!recycle)
+        RecycledSubspace_free(A.get());
+
+    r = util::newVector(numEqua);
+    x0 = util::newVector(numEqua);
     A->balance();
+    SlicedEllpackCopy sell(A, options->use_sliced_ellpack);
     options->num_level=0;
     options->num_inner_iter=0;
 
@@ -150,6 +190,9 @@ SolverResult Solver(SystemMatrix_ptr A, double* x, double* b, Options* options,
                 case PASO_PCG:
                     std::cout << "Solver: Iterative method is PCG.\n";
                 break;
+                case PASO_PIPELINED_PCG:
+                    std::cout << "Solver: Iterative method is pipelined PCG.\n";
+                break;
                 case PASO_TFQMR:
                     std::cout << "Solver: Iterative method is TFQMR.\n";
                 break;
@@ -169,6 +212,19 @@ SolverResult Solver(SystemMatrix_ptr A, double* x, double* b, Options* options,
                             << options->truncation << ")." << std::endl;
                     }
                 break;
+                case PASO_CA_GMRES:
+                    std::cout << "Solver: Iterative method is CA-GMRES("
+                        << (options->restart > 0 ? options->restart :
+                                                   options->truncation)
+                        << ") with step size "
+                        << options->ca_gmres_step_size << "." << std::endl;
+                break;
+            }
+            if (recycle) {
+                std::cout << "Solver: Krylov subspace recycling with up to "
+                    << options->num_recycled_vectors << " vectors ("
+                    << (A->recycled_subspace ? A->recycled_subspace->dim : 0)
+                    << " available)." << std::endl;
             }
         }
 
@@ -254,7 +310,16 @@ SolverResult Solver(SystemMatrix_ptr A, double* x, double* b, Options* options,
                             errorCode = Solver_BiCGStab(A, r, x, &cntIter, &tol, pp);
                         break;
                         case PASO_PCG:
-                            errorCode = Solver_PCG(A, r, x, &cntIter, &tol, pp);
+                            if (recycle) {
+                                errorCode = Solver_DeflatedPCG(A, r, x,
+                                        &cntIter, &tol,
+                                        options->num_recycled_vectors, pp);
+                            } else {
+                                errorCode = Solver_PCG(A, r, x, &cntIter, &tol, pp);
+                            }
+                        break;
+                        case PASO_PIPELINED_PCG:
+                            errorCode = Solver_PCG_pipelined(A, r, x, &cntIter, &tol, pp);
                         break;
                         case PASO_TFQMR:
                             tol=tolerance*norm2_of_residual/norm2_of_b;
@@ -272,7 +337,20 @@ SolverResult Solver(SystemMatrix_ptr A, double* x, double* b, Options* options,
                             errorCode = Solver_GMRES(A, r, x, &cntIter, &tol, 5, 20, pp);
                         break;
                         case PASO_GMRES:
-                            errorCode = Solver_GMRES(A, r, x, &cntIter, &tol, options->truncation, options->restart, pp);
+                            if (recycle) {
+                                errorCode = Solver_GCRODR(A, r, x, &cntIter,
+                                        &tol, options->restart > 0 ?
+                                        options->restart : options->truncation,
+                                        options->num_recycled_vectors, pp);
+                            } else {
+                                errorCode = Solver_GMRES(A, r, x, &cntIter, &tol, options->truncation, options->restart, pp);
+                            }
+                        break;
+                        case PASO_CA_GMRES:
+                            errorCode = Solver_CA_GMRES(A, r, x, &cntIter, &tol,
+                                    options->restart > 0 ? options->restart :
+                                                           options->truncation,
+                                    options->ca_gmres_step_size, pp);
                         break;
                     }
 
@@ -23,6 +23,8 @@
 #include "performance.h"
 #include "SystemMatrix.h"
 
+#include <vector>
+
 namespace paso {
 
 #define TOLERANCE_FOR_SCALARS (double)(0.)
@@ -36,9 +38,19 @@ void Solver_free(SystemMatrix*);
 SolverResult Solver_BiCGStab(SystemMatrix_ptr A, double* B, double* X,
                              dim_t* iter, double* tolerance, Performance* pp);
 
+SolverResult Solver_BiCGStab(LinearOperator* A, double* B, double* X,
+                             dim_t* iter, double* tolerance, Performance* pp);
+
 SolverResult Solver_PCG(SystemMatrix_ptr A, double* B, double* X, dim_t* iter,
                         double* tolerance, Performance* pp);
 
+SolverResult Solver_PCG(LinearOperator* A, double* B, double* X, dim_t* iter,
+                        double* tolerance, Performance* pp);
+
+SolverResult Solver_PCG_pipelined(SystemMatrix_ptr A, double* B, double* X,
+                                  dim_t* iter, double* tolerance,
+                                  Performance* pp);
+
 SolverResult Solver_TFQMR(SystemMatrix_ptr A, double* B, double* X, dim_t* iter,
                           double* tolerance, Performance* pp);
 
@@ -50,6 +62,37 @@ SolverResult Solver_GMRES(SystemMatrix_ptr A, double* r, double* x,
                           dim_t length_of_recursion, dim_t restart,
                           Performance* pp);
 
+SolverResult Solver_CA_GMRES(SystemMatrix_ptr A, double* r, double* x,
+                             dim_t* num_iter, double* tolerance,
+                             dim_t restart, dim_t step_size, Performance* pp);
+
+/// approximate invariant subspace of a system matrix which is kept between
+/// solves by the recycling Krylov solvers
+struct RecycledSubspace
+{
+    /// solver method which created the subspace
+    index_t method;
+    /// local length of the vectors
+    dim_t n;
+    /// number of vectors
+    dim_t dim;
+    /// the vectors, stored column by column (n x dim)
+    double* U;
+    /// approximation of M^{-1}*U for the preconditioner M (deflated PCG
+    /// only, NULL otherwise)
+    double* V;
+};
+
+void RecycledSubspace_free(SystemMatrix* A);
+
+SolverResult Solver_DeflatedPCG(SystemMatrix_ptr A, double* r, double* x,
+                                dim_t* iter, double* tolerance,
+                                dim_t num_recycled, Performance* pp);
+
+SolverResult Solver_GCRODR(SystemMatrix_ptr A, double* r, double* x,
+                           dim_t* iter, double* tolerance, dim_t restart,
+                           dim_t num_recycled, Performance* pp);
+
 SolverResult Solver_GMRES2(Function* F, const double* f0, const double* x0,
                            double* x, dim_t* iter, double* tolerance,
                            Performance* pp);
@@ -57,6 +100,37 @@ SolverResult Solver_GMRES2(Function* F, const double* f0, const double* x0,
 SolverResult Solver_NewtonGMRES(Function* F, double* x, Options* options,
                                 Performance* pp);
 
+SolverResult Solver_MultipleRHS(SystemMatrix_ptr A, double** x, double** b,
+                                dim_t numRHS, Options* options,
+                                Performance* pp);
+
+SolverResult Solver_MatrixFree(LinearOperator* A, double* x, const double* b,
+                               Options* options, Performance* pp);
+
+/// copy of a system matrix with the local unknowns relabelled by the reverse
+/// of Pattern::reduceBandwidth to improve the memory locality of the
+/// iterative solvers. The labelling only depends on the pattern and is kept
+/// with the matrix while its values change.
+struct ReorderedSystem
+{
+    /// new label of each local row (empty if the labelling is kept)
+    std::vector<index_t> oldToNew;
+    /// positions of the entries of the main, column couple and row couple
+    /// blocks of the matrix in the reordered matrix
+    std::vector<index_t> main_pos;
+    std::vector<index_t> col_couple_pos;
+    std::vector<index_t> row_couple_pos;
+    /// the reordered matrix (empty if the labelling is kept)
+    SystemMatrix_ptr A;
+};
+
+void ReorderedSystem_free(SystemMatrix* A);
+
+SystemMatrix_ptr ReorderedSystem_update(SystemMatrix_ptr A);
+
+void ReorderedSystem_permute(const SystemMatrix* A, double* out,
+                             const double* in, bool toNew);
+
 } // namespace paso
 
 #endif // __PASO_SOLVER_H__
@@ -0,0 +1,206 @@
+
+/*****************************************************************************
+*
+* Copyright (c) 2003-2018 by The University of Queensland
+* http://www.uq.edu.au
+*
+* Primary Business: Queensland, Australia
+* Licensed under the Apache License, version 2.0
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Development until 2012 by Earth Systems Science Computational Center (ESSCC)
+* Development 2012-2013 by School of Earth Sciences
+* Development from 2014 by Centre for Geoscience Computing (GeoComp)
+*
+*****************************************************************************/
+
+
+/****************************************************************************/
+
+/* Paso: iterative solvers for matrix-free linear operators                 */
+
+/*  Solves A*x=b where A is only available through its action on a vector  */
+/*  and its main diagonal. Solver_PCG is used for symmetric problems and    */
+/*  Solver_BiCGStab otherwise, preconditioned by Jacobi or a Chebyshev      */
+/*  polynomial in D^{-1}*A. The convergence test is                         */
+/*  norm(b-A*x) <= tolerance*norm(b).                                       */
+
+/****************************************************************************/
+
+#include "Solver.h"
+#include "Options.h"
+#include "PasoUtil.h"
+#include "Preconditioner.h"
+
+#include <boost/math/special_functions/fpclassify.hpp>  // for isnan
+
+#include <iostream>
+
+namespace bm = boost::math;
+
+namespace paso {
+
+namespace {
+
+/// adds a Jacobi, Chebyshev or no preconditioner to a matrix-free operator
+/// so it can be passed to the Krylov solvers
+struct PreconditionedOperator : public LinearOperator
+{
+    PreconditionedOperator(LinearOperator* op, Options* options) :
+        LinearOperator(op->mpi_info),
+        A(op),
+        n(op->getLen()),
+        type(options->preconditioner),
+        inv_diag(NULL),
+        chebyshev(NULL)
+    {
+        switch (type) {
+            case PASO_NO_PRECONDITIONER:
+                if (options->verbose)
+                    std::cout << "Solver_MatrixFree: no preconditioner is "
+                        "applied." << std::endl;
+                break;
+            case PASO_CHEBYSHEV:
+                if (options->verbose)
+                    std::cout << "Solver_MatrixFree: Chebyshev preconditioner"
+                        " is used." << std::endl;
+                chebyshev = Preconditioner_Chebyshev_alloc(A,
+                        options->chebyshev_degree,
+                        options->symmetric || options->method == PASO_PCG,
+                        options->verbose);
+                break;
+            default:
+                if (options->verbose)
+                    std::cout << "Solver_MatrixFree: Jacobi preconditioner is"
+                        " used." << std::endl;
+                type = PASO_JACOBI;
+                inv_diag = new double[n];
+                A->getDiagonal(inv_diag);
+#pragma omp parallel for schedule(static)
+                for (index_t i=0; i<n; ++i) {
+                    const double a = inv_diag[i];
+                    inv_diag[i] = (std::abs(a) > 0.) ? 1./a : 1.;
+                }
+                break;
+        }
+    }
+
+    ~PreconditionedOperator()
+    {
+        delete[] inv_diag;
+        Preconditioner_Chebyshev_free(chebyshev);
+    }
+
+    virtual void matrixVector(double alpha, const double* x, double beta,
+                              double* y)
+    {
+        A->matrixVector(alpha, x, beta, y);
+    }
+
+    virtual void getDiagonal(double* diag) { A->getDiagonal(diag); }
+
+    virtual dim_t getLen() { return n; }
+
+    /// sets x = M^{-1}*b
+    virtual void solvePreconditioner(double* x, double* b)
+    {
+        switch (type) {
+            case PASO_NO_PRECONDITIONER:
+                util::copy(n, x, b);
+                break;
+            case PASO_CHEBYSHEV:
+                Preconditioner_Chebyshev_solve(A, chebyshev, x, b);
+                break;
+            default:
+#pragma omp parallel for schedule(static)
+                for (index_t i=0; i<n; ++i)
+                    x[i] = inv_diag[i]*b[i];
+                break;
+        }
+    }
+
+    LinearOperator* A;
+    dim_t n;
+    int type;
+    double* inv_diag;
+    Preconditioner_Chebyshev* chebyshev;
+};
+
+} // anonymous namespace
+
+SolverResult Solver_MatrixFree(LinearOperator* A, double* x, const double* b,
+                               Options* options, Performance* pp)
+{
+    const real_t EPSILON = escript::DataTypes::real_t_eps();
+    const dim_t n = A->getLen();
+    const double tolerance = options->tolerance;
+    if (tolerance < 100.*EPSILON) {
+        throw PasoException("Solver_MatrixFree: Tolerance is too small.");
+    }
+    if (tolerance > 1.) {
+        throw PasoException("Solver_MatrixFree: Tolerance must be less than one.");
+    }
+    const int method = Options::getSolver(options->method, PASO_PASO,
+                                          options->symmetric, A->mpi_info);
+    if (method != PASO_PCG && method != PASO_BICGSTAB) {
+        throw PasoException("Solver_MatrixFree: only the PCG and BiCGStab "
+                            "solvers support matrix-free operators.");
+    }
+    options->num_iter = 0;
+    options->num_level = 0;
+    options->num_inner_iter = 0;
+    options->converged = false;
+    options->residual_norm = 0.;
+    const double time0 = escript::gettime();
+    SolverResult status = NoError;
+
+    Performance_startMonitor(pp, PERFORMANCE_ALL);
+    const double norm_of_b = util::l2(n, b, A->mpi_info);
+    if (bm::isnan(norm_of_b)) {
+        throw PasoException("Solver_MatrixFree: right hand side contains undefined values.");
+    } else if (norm_of_b <= 0.) {
+        util::zeroes(n, x);
+        options->converged = true;
+        if (options->verbose)
+            std::cout << "right hand side is identical to zero." << std::endl;
+    } else {
+        Performance_startMonitor(pp, PERFORMANCE_PRECONDITIONER_INIT);
+        PreconditionedOperator M(A, options);
+        Performance_stopMonitor(pp, PERFORMANCE_PRECONDITIONER_INIT);
+        options->set_up_time = escript::gettime()-time0;
+        const double net_time_start = escript::gettime();
+
+        // r = b - A*x
+        double* r = new double[n];
+        util::copy(n, r, b);
+        Performance_startMonitor(pp, PERFORMANCE_MVM);
+        A->matrixVector(-PASO_ONE, x, PASO_ONE, r);
+        Performance_stopMonitor(pp, PERFORMANCE_MVM);
+
+        double tol = std::max(tolerance*norm_of_b,
+                              options->absolute_tolerance);
+        dim_t num_iter = options->iter_max;
+        if (options->verbose) {
+            std::cout << "Solver_MatrixFree: l2-norm of right hand side is "
+                << norm_of_b << ", stopping criterion is " << tol << "."
+                << std::endl << "Solver_MatrixFree: Iterative method is "
+                << (method == PASO_PCG ? "PCG." : "BiCGStab.") << std::endl;
+        }
+        if (method == PASO_PCG) {
+            status = Solver_PCG(&M, r, x, &num_iter, &tol, pp);
+        } else {
+            status = Solver_BiCGStab(&M, r, x, &num_iter, &tol, pp);
+        }
+        delete[] r;
+        options->num_iter = num_iter;
+        options->residual_norm = tol;
+        options->converged = (status == NoError);
+        options->net_time = escript::gettime()-net_time_start;
+    }
+    Performance_stopMonitor(pp, PERFORMANCE_ALL);
+    options->time = escript::gettime()-time0;
+    return status;
+}
+
+} // namespace paso
+
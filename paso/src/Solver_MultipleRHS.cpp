@@ -0,0 +1,786 @@
+
+/*****************************************************************************
+*
+* Copyright (c) 2003-2018 by The University of Queensland
+* http://www.uq.edu.au
+*
+* Primary Business: Queensland, Australia
+* Licensed under the Apache License, version 2.0
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Development until 2012 by Earth Systems Science Computational Center (ESSCC)
+* Development 2012-2013 by School of Earth Sciences
+* Development from 2014 by Centre for Geoscience Computing (GeoComp)
+*
+*****************************************************************************/
+
+
+/****************************************************************************/
+
+/* Paso: PCG and GMRES for several right hand sides                         */
+
+/*  Solves A*x_j=b_j for j=0,...,numRHS-1. The vectors of all systems are   */
+/*  stored interleaved so that each pass over the matrix, each exchange of  */
+/*  overlap values and each global reduction serves all right hand sides.  */
+/*  Every system keeps its own Krylov recursion. Systems which have         */
+/*  converged are removed from the batch. A PCG system which breaks down    */
+/*  is paused and then restarted on its own with Solver_PCG.                */
+
+/****************************************************************************/
+
+#include "Solver.h"
+#include "Options.h"
+#include "PasoUtil.h"
+
+#include <boost/math/special_functions/fpclassify.hpp>  // for isnan
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+namespace bm = boost::math;
+
+namespace paso {
+
+namespace {
+
+/// the systems currently being solved. Entry i of system j is stored at
+/// position i*numVec+j of B (right hand side), X (solution) and R (residual).
+/// All vectors are in the balanced space of A.
+struct MultiVectorSystem
+{
+    MultiVectorSystem(SystemMatrix_ptr matrix, double** x, dim_t numRHS) :
+        A(matrix),
+        n(matrix->getTotalNumRows()),
+        numVec(numRHS),
+        x_out(x)
+    {
+        column = new index_t[numVec];
+        tol = new double[numVec];
+        B = new double[n*numVec];
+        X = new double[n*numVec];
+        R = new double[n*numVec];
+        buf_in = new double[n*numVec];
+        buf_out = new double[n*numVec];
+        for (dim_t j=0; j<numVec; ++j)
+            column[j] = j;
+        setCoupler();
+    }
+
+    ~MultiVectorSystem()
+    {
+        delete[] column;
+        delete[] tol;
+        delete[] B;
+        delete[] X;
+        delete[] R;
+        delete[] buf_in;
+        delete[] buf_out;
+    }
+
+    /// the overlap values of all systems are exchanged in one message
+    void setCoupler()
+    {
+        if (numVec > 0) {
+            coupler.reset(new Coupler<real_t>(A->col_coupler->connector,
+                                    A->col_block_size*numVec, A->mpi_info, true));
+        }
+    }
+
+    /// out = alpha*A*in + beta*out
+    void matrixVector(double alpha, const double* in, double beta,
+                      double* out) const
+    {
+        A->MatrixMultiVector_CSR_OFFSET0(alpha, numVec, in, beta, out,
+                                         coupler);
+    }
+
+    /// z = M^{-1}*r for all systems j with skip[j] not set. The vectors are
+    /// transposed in one pass each way as the preconditioner works on
+    /// contiguous vectors.
+    void solvePreconditioner(double* z, const double* r, const bool* skip)
+    {
+        const dim_t k = numVec;
+#pragma omp parallel for schedule(static)
+        for (index_t i=0; i<n; ++i) {
+            for (dim_t j=0; j<k; ++j)
+                buf_in[j*n+i] = r[i*k+j];
+        }
+        for (dim_t j=0; j<k; ++j) {
+            if (!(skip && skip[j]))
+                A->solvePreconditioner(&buf_out[j*n], &buf_in[j*n]);
+        }
+#pragma omp parallel for schedule(static)
+        for (index_t i=0; i<n; ++i) {
+            for (dim_t j=0; j<k; ++j) {
+                if (!(skip && skip[j]))
+                    z[i*k+j] = buf_out[j*n+i];
+            }
+        }
+    }
+
+    /// out[l*numVec+j] = <a[l]_j, b[l]_j> for l=0,...,numPairs-1 using a
+    /// single global reduction
+    void innerProducts(dim_t numPairs, const double* const* a,
+                       const double* const* b, double* out) const
+    {
+        const dim_t len = numPairs*numVec;
+        for (dim_t l=0; l<len; ++l)
+            out[l] = 0.;
+#pragma omp parallel
+        {
+            double* local = new double[len];
+            for (dim_t l=0; l<len; ++l)
+                local[l] = 0.;
+#pragma omp for schedule(static)
+            for (index_t i=0; i<n; ++i) {
+                for (dim_t l=0; l<numPairs; ++l) {
+                    const double* x = &a[l][i*numVec];
+                    const double* y = &b[l][i*numVec];
+                    double* s = &local[l*numVec];
+                    #pragma ivdep
+                    for (dim_t j=0; j<numVec; ++j)
+                        s[j] += x[j]*y[j];
+                }
+            }
+#pragma omp critical
+            {
+                for (dim_t l=0; l<len; ++l)
+                    out[l] += local[l];
+            }
+            delete[] local;
+        }
+#ifdef ESYS_MPI
+        double* loc = new double[len];
+        for (dim_t l=0; l<len; ++l)
+            loc[l] = out[l];
+        MPI_Allreduce(loc, out, len, MPI_DOUBLE, MPI_SUM, A->mpi_info->comm);
+        delete[] loc;
+#endif
+    }
+
+    /// l2 and lmax norm of each system's vector in v
+    void norms(const double* v, double* norm2, double* norm_max) const
+    {
+        innerProducts(1, &v, &v, norm2);
+        for (dim_t j=0; j<numVec; ++j) {
+            norm2[j] = sqrt(norm2[j]);
+            norm_max[j] = 0.;
+        }
+#pragma omp parallel
+        {
+            double* local = new double[numVec];
+            for (dim_t j=0; j<numVec; ++j)
+                local[j] = 0.;
+#pragma omp for schedule(static)
+            for (index_t i=0; i<n; ++i) {
+                for (dim_t j=0; j<numVec; ++j)
+                    local[j] = std::max(std::abs(v[i*numVec+j]), local[j]);
+            }
+#pragma omp critical
+            {
+                for (dim_t j=0; j<numVec; ++j)
+                    norm_max[j] = std::max(local[j], norm_max[j]);
+            }
+            delete[] local;
+        }
+#ifdef ESYS_MPI
+        double* loc = new double[numVec];
+        for (dim_t j=0; j<numVec; ++j)
+            loc[j] = norm_max[j];
+        MPI_Allreduce(loc, norm_max, numVec, MPI_DOUBLE, MPI_MAX,
+                      A->mpi_info->comm);
+        delete[] loc;
+#endif
+    }
+
+    /// returns a copy of the len-vector v without the systems marked done
+    double* compact(dim_t len, dim_t newNumVec,
+                    const std::vector<bool>& done, const double* v) const
+    {
+        double* out = new double[len*newNumVec];
+#pragma omp parallel for schedule(static)
+        for (index_t i=0; i<len; ++i) {
+            dim_t k = 0;
+            for (dim_t j=0; j<numVec; ++j) {
+                if (!done[j])
+                    out[i*newNumVec+k++] = v[i*numVec+j];
+            }
+        }
+        return out;
+    }
+
+    /// stores the solution of the systems marked done and removes them from
+    /// the batch. The given scalars (one per system) are compacted as well.
+    void release(const std::vector<bool>& done, dim_t numScalars,
+                 double** scalars)
+    {
+        dim_t newNumVec = 0;
+        for (dim_t j=0; j<numVec; ++j) {
+            if (done[j]) {
+                double* x = x_out[column[j]];
+#pragma omp parallel for schedule(static)
+                for (index_t i=0; i<n; ++i)
+                    x[i] = X[i*numVec+j];
+                A->applyBalanceInPlace(x, false);
+            } else {
+                newNumVec++;
+            }
+        }
+        if (newNumVec == numVec)
+            return;
+
+        double** vectors[3] = { &B, &X, &R };
+        for (int l=0; l<3; ++l) {
+            double* v = compact(n, newNumVec, done, *vectors[l]);
+            delete[] *vectors[l];
+            *vectors[l] = v;
+        }
+        for (dim_t l=0; l<numScalars; ++l) {
+            double* v = compact(1, newNumVec, done, scalars[l]);
+            for (dim_t j=0; j<newNumVec; ++j)
+                scalars[l][j] = v[j];
+            delete[] v;
+        }
+        dim_t k = 0;
+        for (dim_t j=0; j<numVec; ++j) {
+            if (!done[j]) {
+                column[k] = column[j];
+                tol[k] = tol[j];
+                k++;
+            }
+        }
+        numVec = newNumVec;
+        setCoupler();
+    }
+
+    SystemMatrix_ptr A;
+    dim_t n;
+    /// number of systems in the batch
+    dim_t numVec;
+    /// solution arrays of the caller
+    double** x_out;
+    /// index of each system in x_out
+    index_t* column;
+    /// stopping tolerance for the l2-norm of the residual of each system
+    double* tol;
+    double* B;
+    double* X;
+    double* R;
+    double* buf_in;
+    double* buf_out;
+    Coupler_ptr<real_t> coupler;
+};
+
+/// PCG for all systems in S starting from the residual S.R. A system which
+/// has converged is paused, i.e. its search direction is set to zero, until
+/// all systems have converged. A system which breaks down is paused as well
+/// and marked in brokenDown so the other systems can continue.
+SolverResult MultiRHS_PCG(MultiVectorSystem& S, dim_t* iter,
+                          std::vector<bool>& brokenDown, Performance* pp)
+{
+    const dim_t n = S.n;
+    const dim_t k = S.numVec;
+    const dim_t maxit = *iter;
+    SolverResult status = NoError;
+    dim_t num_iter = 0, numPaused = 0;
+
+    double* z = new double[n*k];
+    double* p = new double[n*k];
+    double* q = new double[n*k];
+    double* rr = new double[2*k]; // holds <r,r> followed by <r,z>
+    double* rz = new double[k];
+    double* pq = new double[k];
+    double* alpha = new double[k];
+    double* beta = new double[k];
+    double* zeta = new double[k];
+    bool* paused = new bool[k];
+    const double* va[2] = { S.R, S.R };
+    const double* vb[2] = { S.R, z };
+
+    for (dim_t j=0; j<k; ++j) {
+        paused[j] = false;
+        brokenDown[j] = false;
+    }
+    Performance_startMonitor(pp, PERFORMANCE_PRECONDITIONER);
+    S.solvePreconditioner(z, S.R, paused);
+    Performance_stopMonitor(pp, PERFORMANCE_PRECONDITIONER);
+    Performance_startMonitor(pp, PERFORMANCE_SOLVER);
+    util::copy(n*k, p, z);
+    S.innerProducts(2, va, vb, rr);
+    for (dim_t j=0; j<k; ++j)
+        rz[j] = rr[k+j];
+    Performance_stopMonitor(pp, PERFORMANCE_SOLVER);
+
+    while (numPaused < k) {
+        if (num_iter >= maxit) {
+            status = MaxIterReached;
+            break;
+        }
+        ++num_iter;
+        Performance_startMonitor(pp, PERFORMANCE_MVM);
+        S.matrixVector(PASO_ONE, p, PASO_ZERO, q);
+        Performance_stopMonitor(pp, PERFORMANCE_MVM);
+        Performance_startMonitor(pp, PERFORMANCE_SOLVER);
+        S.innerProducts(1, &p, &q, pq);
+        for (dim_t j=0; j<k; ++j) {
+            if (paused[j]) {
+                alpha[j] = 0.;
+            } else if (!(std::abs(pq[j]) > TOLERANCE_FOR_SCALARS)) {
+                alpha[j] = 0.;
+                paused[j] = true;
+                brokenDown[j] = true;
+                numPaused++;
+            } else {
+                alpha[j] = rz[j]/pq[j];
+            }
+        }
+#pragma omp parallel for schedule(static)
+        for (index_t i=0; i<n; ++i) {
+            #pragma ivdep
+            for (dim_t j=0; j<k; ++j) {
+                S.X[i*k+j] += alpha[j]*p[i*k+j];
+                S.R[i*k+j] -= alpha[j]*q[i*k+j];
+            }
+        }
+        Performance_stopMonitor(pp, PERFORMANCE_SOLVER);
+        Performance_startMonitor(pp, PERFORMANCE_PRECONDITIONER);
+        S.solvePreconditioner(z, S.R, paused);
+        Performance_stopMonitor(pp, PERFORMANCE_PRECONDITIONER);
+        Performance_startMonitor(pp, PERFORMANCE_SOLVER);
+        S.innerProducts(2, va, vb, rr);
+        for (dim_t j=0; j<k; ++j) {
+            if (paused[j]) {
+                // p stays zero for paused systems
+                zeta[j] = 0.;
+                beta[j] = 0.;
+            } else if (sqrt(rr[j]) <= S.tol[j]) {
+                paused[j] = true;
+                numPaused++;
+                zeta[j] = 0.;
+                beta[j] = 0.;
+            } else {
+                zeta[j] = 1.;
+                beta[j] = rr[k+j]/rz[j];
+                rz[j] = rr[k+j];
+            }
+        }
+        // p = z + beta*p
+#pragma omp parallel for schedule(static)
+        for (index_t i=0; i<n; ++i) {
+            #pragma ivdep
+            for (dim_t j=0; j<k; ++j)
+                p[i*k+j] = zeta[j]*z[i*k+j] + beta[j]*p[i*k+j];
+        }
+        Performance_stopMonitor(pp, PERFORMANCE_SOLVER);
+    }
+    delete[] z;
+    delete[] p;
+    delete[] q;
+    delete[] rr;
+    delete[] rz;
+    delete[] pq;
+    delete[] alpha;
+    delete[] beta;
+    delete[] zeta;
+    delete[] paused;
+    *iter = num_iter;
+    return status;
+}
+
+/// restarts the systems of S marked in brokenDown one by one with Solver_PCG
+/// from their current approximation. On input iter is the maximum number of
+/// iterations for each system, on output the largest number used.
+SolverResult MultiRHS_restartPCG(MultiVectorSystem& S,
+                                 const std::vector<bool>& brokenDown,
+                                 dim_t* iter, Performance* pp)
+{
+    const dim_t n = S.n;
+    const dim_t k = S.numVec;
+    const dim_t maxit = *iter;
+    SolverResult status = NoError;
+    double* r = new double[n];
+    double* x = new double[n];
+    *iter = 0;
+    for (dim_t j=0; j<k; ++j) {
+        if (!brokenDown[j])
+            continue;
+#pragma omp parallel for schedule(static)
+        for (index_t i=0; i<n; ++i) {
+            x[i] = S.X[i*k+j];
+            r[i] = S.B[i*k+j];
+        }
+        S.A->MatrixVector_CSR_OFFSET0(-PASO_ONE, x, PASO_ONE, r);
+        dim_t cntIter = maxit;
+        double tol = S.tol[j];
+        const SolverResult res = Solver_PCG(S.A, r, x, &cntIter, &tol, pp);
+        if (res != NoError)
+            status = res;
+        *iter = std::max(*iter, cntIter);
+#pragma omp parallel for schedule(static)
+        for (index_t i=0; i<n; ++i)
+            S.X[i*k+j] = x[i];
+    }
+    delete[] r;
+    delete[] x;
+    return status;
+}
+
+/// one cycle of right preconditioned GMRES(m) for all systems in S starting
+/// from the residual S.R. Only S.X is updated. The Arnoldi vectors are
+/// orthogonalized by classical Gram-Schmidt with reorthogonalization so
+/// that each step needs three global reductions for all systems together.
+SolverResult MultiRHS_GMRES(MultiVectorSystem& S, dim_t* iter, dim_t m,
+                            Performance* pp)
+{
+    const dim_t n = S.n;
+    const dim_t k = S.numVec;
+    const dim_t maxit = *iter;
+    const dim_t ld = m+1;
+    SolverResult status = NoError;
+    dim_t num_iter = 0, numPaused = 0;
+
+    double** V = new double*[m+1];
+    for (dim_t l=0; l<=m; ++l)
+        V[l] = new double[n*k];
+    double* w = new double[n*k];
+    double* z = new double[n*k];
+    double* H = new double[k*ld*m];
+    double* cs = new double[k*m];
+    double* sn = new double[k*m];
+    double* g = new double[k*ld];
+    double* y = new double[k*m];
+    double* h = new double[ld*k];
+    double* h2 = new double[ld*k];
+    double* scale = new double[k];
+    dim_t* steps = new dim_t[k];
+    bool* paused = new bool[k];
+    const double** W = new const double*[m];
+    for (dim_t l=0; l<m; ++l)
+        W[l] = w;
+
+    Performance_startMonitor(pp, PERFORMANCE_SOLVER);
+    S.innerProducts(1, &S.R, &S.R, h);
+    for (dim_t j=0; j<k; ++j) {
+        g[j*ld] = sqrt(h[j]);
+        scale[j] = (g[j*ld] > 0.) ? 1./g[j*ld] : 0.;
+        steps[j] = 0;
+        paused[j] = !(g[j*ld] > S.tol[j]);
+        if (paused[j])
+            numPaused++;
+    }
+#pragma omp parallel for schedule(static)
+    for (index_t i=0; i<n; ++i) {
+        for (dim_t j=0; j<k; ++j)
+            V[0][i*k+j] = scale[j]*S.R[i*k+j];
+    }
+    Performance_stopMonitor(pp, PERFORMANCE_SOLVER);
+
+    for (dim_t c=0; c<m && numPaused<k; ++c) {
+        if (num_iter >= maxit) {
+            status = MaxIterReached;
+            break;
+        }
+        ++num_iter;
+        Performance_startMonitor(pp, PERFORMANCE_PRECONDITIONER);
+        S.solvePreconditioner(z, V[c], paused);
+        Performance_stopMonitor(pp, PERFORMANCE_PRECONDITIONER);
+        Performance_startMonitor(pp, PERFORMANCE_MVM);
+        S.matrixVector(PASO_ONE, z, PASO_ZERO, w);
+        Performance_stopMonitor(pp, PERFORMANCE_MVM);
+        Performance_startMonitor(pp, PERFORMANCE_SOLVER);
+        // w = w - V*(V^T*w) twice
+        for (int pass=0; pass<2; ++pass) {
+            double* hp = (pass == 0 ? h : h2);
+            S.innerProducts(c+1, V, W, hp);
+#pragma omp parallel for schedule(static)
+            for (index_t i=0; i<n; ++i) {
+                for (dim_t l=0; l<=c; ++l) {
+                    #pragma ivdep
+                    for (dim_t j=0; j<k; ++j)
+                        w[i*k+j] -= hp[l*k+j]*V[l][i*k+j];
+                }
+            }
+        }
+        for (dim_t l=0; l<(c+1)*k; ++l)
+            h[l] += h2[l];
+        S.innerProducts(1, W, W, h2);
+        for (dim_t j=0; j<k; ++j) {
+            const double hn = sqrt(h2[j]);
+            scale[j] = (!paused[j] && hn > 0.) ? 1./hn : 0.;
+            if (paused[j])
+                continue;
+            // new column of the Hessenberg matrix, apply previous rotations
+            double* hc = &H[j*ld*m+ld*c];
+            for (dim_t l=0; l<=c; ++l)
+                hc[l] = h[l*k+j];
+            hc[c+1] = hn;
+            double* cj = &cs[j*m];
+            double* sj = &sn[j*m];
+            double* gj = &g[j*ld];
+            for (dim_t l=0; l<c; ++l) {
+                const double t = cj[l]*hc[l] + sj[l]*hc[l+1];
+                hc[l+1] = -sj[l]*hc[l] + cj[l]*hc[l+1];
+                hc[l] = t;
+            }
+            const double d = sqrt(hc[c]*hc[c] + hc[c+1]*hc[c+1]);
+            if (d > 0.) {
+                cj[c] = hc[c]/d;
+                sj[c] = hc[c+1]/d;
+            } else {
+                cj[c] = 1.;
+                sj[c] = 0.;
+            }
+            hc[c] = d;
+            hc[c+1] = 0.;
+            gj[c+1] = -sj[c]*gj[c];
+            gj[c] = cj[c]*gj[c];
+            steps[j] = c+1;
+            if (std::abs(gj[c+1]) <= S.tol[j] || !(hn > 0.)) {
+                paused[j] = true;
+                numPaused++;
+            }
+        }
+#pragma omp parallel for schedule(static)
+        for (index_t i=0; i<n; ++i) {
+            #pragma ivdep
+            for (dim_t j=0; j<k; ++j)
+                V[c+1][i*k+j] = scale[j]*w[i*k+j];
+        }
+        Performance_stopMonitor(pp, PERFORMANCE_SOLVER);
+    }
+
+    // solve the triangular systems and update x += M*V*y
+    Performance_startMonitor(pp, PERFORMANCE_SOLVER);
+    for (dim_t j=0; j<k; ++j) {
+        const double* Hj = &H[j*ld*m];
+        double* yj = &y[j*m];
+        for (dim_t l=steps[j]-1; l>=0; --l) {
+            double t = g[j*ld+l];
+            for (dim_t a=l+1; a<steps[j]; ++a)
+                t -= Hj[l+ld*a]*yj[a];
+            yj[l] = (Hj[l+ld*l] != 0.) ? t/Hj[l+ld*l] : 0.;
+        }
+    }
+#pragma omp parallel for schedule(static)
+    for (index_t i=0; i<n; ++i) {
+        for (dim_t j=0; j<k; ++j) {
+            double t = 0.;
+            for (dim_t l=0; l<steps[j]; ++l)
+                t += V[l][i*k+j]*y[j*m+l];
+            w[i*k+j] = t;
+        }
+    }
+    Performance_stopMonitor(pp, PERFORMANCE_SOLVER);
+    Performance_startMonitor(pp, PERFORMANCE_PRECONDITIONER);
+    S.solvePreconditioner(z, w, NULL);
+    Performance_stopMonitor(pp, PERFORMANCE_PRECONDITIONER);
+    Performance_startMonitor(pp, PERFORMANCE_SOLVER);
+    util::AXPY(n*k, S.X, PASO_ONE, z);
+    Performance_stopMonitor(pp, PERFORMANCE_SOLVER);
+
+    for (dim_t l=0; l<=m; ++l)
+        delete[] V[l];
+    delete[] V;
+    delete[] W;
+    delete[] w;
+    delete[] z;
+    delete[] H;
+    delete[] cs;
+    delete[] sn;
+    delete[] g;
+    delete[] y;
+    delete[] h;
+    delete[] h2;
+    delete[] scale;
+    delete[] steps;
+    delete[] paused;
+    *iter = num_iter;
+    return status;
+}
+
+} // anonymous namespace
+
+SolverResult Solver_MultipleRHS(SystemMatrix_ptr A, double** x, double** b,
+                                dim_t numRHS, Options* options,
+                                Performance* pp)
+{
+    const real_t EPSILON = escript::DataTypes::real_t_eps();
+    const double tolerance = options->tolerance;
+    if (tolerance < 100.*EPSILON) {
+        throw PasoException("Solver: Tolerance is too small.");
+    }
+    if (tolerance > 1.) {
+        throw PasoException("Solver: Tolerance must be less than one.");
+    }
+    const int method = Options::getSolver(options->method, PASO_PASO,
+                                          options->symmetric, A->mpi_info);
+    if (method != PASO_PCG && method != PASO_GMRES) {
+        throw PasoException("Solver_MultipleRHS: only the PCG and GMRES "
+                            "solvers support multiple right hand sides.");
+    }
+    if ((A->type & MATRIX_FORMAT_CSC) || (A->type & MATRIX_FORMAT_OFFSET1)) {
+        throw PasoException("Solver: Iterative solver requires CSR format with unsymmetric storage scheme and index offset 0.");
+    }
+    if (A->col_block_size != A->row_block_size) {
+        throw PasoException("Solver: Iterative solver requires row and column block sizes to be equal.");
+    }
+    if (A->getGlobalNumCols() != A->getGlobalNumRows()) {
+        throw PasoException("Solver: Iterative solver requires a square matrix.");
+    }
+    const dim_t m = (options->restart > 0 ? options->restart :
+                                            options->truncation);
+    const double time0 = escript::gettime();
+    options->num_iter = 0;
+    options->num_level = 0;
+    options->num_inner_iter = 0;
+    options->converged = false;
+    options->residual_norm = 0.;
+    SolverResult status = NoError;
+
+    A->balance();
+    Performance_startMonitor(pp, PERFORMANCE_ALL);
+    MultiVectorSystem S(A, x, numRHS);
+    const dim_t n = S.n;
+    for (dim_t j=0; j<numRHS; ++j) {
+        A->applyBalance(S.buf_in, b[j], true);
+#pragma omp parallel for schedule(static)
+        for (index_t i=0; i<n; ++i) {
+            S.B[i*numRHS+j] = S.buf_in[i];
+            S.X[i*numRHS+j] = 0.;
+        }
+    }
+    std::vector<double> norm2(numRHS), norm_max(numRHS);
+    std::vector<double> last_norm2(numRHS), last_norm_max(numRHS);
+    std::vector<bool> done(numRHS), brokenDown(numRHS);
+    // result of the systems which were restarted on their own
+    SolverResult separateStatus = NoError;
+    S.norms(S.B, &norm2[0], &norm_max[0]);
+    for (dim_t j=0; j<numRHS; ++j) {
+        if (bm::isnan(norm2[j]) || bm::isnan(norm_max[j])) {
+            throw PasoException("Solver: Matrix or right hand side contains undefined values.");
+        }
+        // systems with zero right hand side are solved by x=0
+        done[j] = !(norm2[j] > 0.);
+        S.tol[j] = tolerance*norm2[j];
+        last_norm2[j] = norm2[j];
+        last_norm_max[j] = norm_max[j];
+    }
+    if (options->verbose) {
+        std::cout << "Solver: solving " << numRHS
+            << " right hand sides together." << std::endl;
+        if (method == PASO_PCG) {
+            std::cout << "Solver: Iterative method is PCG." << std::endl;
+        } else {
+            std::cout << "Solver: Iterative method is GMRES(" << m << ")."
+                << std::endl;
+        }
+    }
+    double* scalars[2] = { &last_norm2[0], &last_norm_max[0] };
+    S.release(done, 2, scalars);
+
+    if (S.numVec > 0) {
+        Performance_startMonitor(pp, PERFORMANCE_PRECONDITIONER_INIT);
+        A->setPreconditioner(options);
+        Performance_stopMonitor(pp, PERFORMANCE_PRECONDITIONER_INIT);
+        options->set_up_time = escript::gettime()-time0;
+        const double net_time_start = escript::gettime();
+        // get an initial guess by evaluating the preconditioner
+        S.solvePreconditioner(S.X, S.B, NULL);
+
+        dim_t totIter = 1;
+        while (S.numVec > 0) {
+            const dim_t k = S.numVec;
+            // r = b - A*x
+            util::copy(n*k, S.R, S.B);
+            Performance_startMonitor(pp, PERFORMANCE_MVM);
+            S.matrixVector(-PASO_ONE, S.X, PASO_ONE, S.R);
+            Performance_stopMonitor(pp, PERFORMANCE_MVM);
+            S.norms(S.R, &norm2[0], &norm_max[0]);
+            double largest = 0.;
+            for (dim_t j=0; j<k; ++j) {
+                done[j] = (norm2[j] <= S.tol[j]);
+                largest = std::max(largest, norm2[j]);
+                if (!done[j] && totIter > 1 && norm2[j] >= last_norm2[j]
+                        && norm_max[j] >= last_norm_max[j]) {
+                    status = Divergence;
+                }
+                last_norm2[j] = norm2[j];
+                last_norm_max[j] = norm_max[j];
+            }
+            options->residual_norm = largest;
+            if (options->verbose) {
+                std::cout << "Solver: Step " << totIter
+                    << ": largest l2-norm of residual is " << largest
+                    << " (" << k << " systems).";
+                if (status == Divergence)
+                    std::cout << " divergence!";
+                std::cout << std::endl;
+            }
+            if (status != NoError)
+                break;
+            S.release(done, 2, scalars);
+            if (S.numVec == 0)
+                break;
+
+            dim_t cntIter = options->iter_max - totIter;
+            if (method == PASO_PCG) {
+                status = MultiRHS_PCG(S, &cntIter, brokenDown, pp);
+            } else {
+                status = MultiRHS_GMRES(S, &cntIter, m, pp);
+            }
+            totIter += cntIter;
+            if (method == PASO_PCG && status == NoError &&
+                    std::find(brokenDown.begin(), brokenDown.begin()+k,
+                              true) != brokenDown.begin()+k) {
+                // systems which broke down are solved separately and do not
+                // stop the others
+                if (options->verbose) {
+                    std::cout << "Solver: break down, restarting the "
+                        "affected systems separately." << std::endl;
+                }
+                dim_t sepIter = options->iter_max - totIter;
+                const SolverResult res = MultiRHS_restartPCG(S, brokenDown,
+                                                             &sepIter, pp);
+                if (res != NoError)
+                    separateStatus = res;
+                totIter += sepIter;
+                S.release(brokenDown, 2, scalars);
+                if (S.numVec == 0)
+                    break;
+            }
+            if (status != NoError) {
+                if (options->verbose) {
+                    if (status == MaxIterReached) {
+                        std::cout << "Solver: Maximum number of iterations "
+                            "reached." << std::endl;
+                    } else {
+                        std::cout << "Solver: Uncurable break down!"
+                            << std::endl;
+                    }
+                }
+                break;
+            }
+        }
+        if (S.numVec > 0) {
+            // return the current approximations of the remaining systems
+            for (dim_t j=0; j<S.numVec; ++j)
+                done[j] = true;
+            S.release(done, 0, NULL);
+        } else if (separateStatus != NoError) {
+            status = separateStatus;
+        } else {
+            options->converged = true;
+            if (options->verbose)
+                std::cout << "Solver: convergence!" << std::endl;
+        }
+        options->net_time = escript::gettime()-net_time_start;
+        options->num_iter = totIter;
+    }
+    Performance_stopMonitor(pp, PERFORMANCE_ALL);
+    options->time = escript::gettime()-time0;
+    return status;
+}
+
+} // namespace paso
+
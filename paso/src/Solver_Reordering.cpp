@@ -0,0 +1,217 @@
+
+/*****************************************************************************
+*
+* Copyright (c) 2003-2018 by The University of Queensland
+* http://www.uq.edu.au
+*
+* Primary Business: Queensland, Australia
+* Licensed under the Apache License, version 2.0
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Development until 2012 by Earth Systems Science Computational Center (ESSCC)
+* Development 2012-2013 by School of Earth Sciences
+* Development from 2014 by Centre for Geoscience Computing (GeoComp)
+*
+*****************************************************************************/
+
+
+/****************************************************************************/
+
+/* Paso: reordering of the local unknowns for the iterative solvers.
+
+   Meshes with a poor node numbering lead to a system matrix with a large
+   bandwidth which makes matrix-vector products and the ILU type
+   preconditioners suffer from cache misses. The local unknowns of each rank
+   are relabelled by the reverse of the labelling of Pattern::reduceBandwidth
+   (reverse Cuthill-McKee). The reordered matrix is kept with the system
+   matrix and its values are refreshed before each solve. Unknowns shared
+   with other ranks are relabelled in the connector so the distribution
+   of the matrix is not changed.
+*/
+
+/****************************************************************************/
+
+#include "Solver.h"
+#include "PasoException.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace paso {
+
+namespace {
+
+/// returns the pattern with rows and columns relabelled (NULL to keep the
+/// labels). pos returns the position of each entry in the new pattern.
+Pattern_ptr permutePattern(const_Pattern_ptr pattern, const index_t* newToOld,
+                           const index_t* oldToNew, std::vector<index_t>& pos)
+{
+    const dim_t n = pattern->numOutput;
+    index_t* ptr = new index_t[n+1];
+    ptr[0] = 0;
+    for (index_t i = 0; i < n; ++i) {
+        const index_t r = (newToOld ? newToOld[i] : i);
+        ptr[i+1] = ptr[i] + pattern->ptr[r+1] - pattern->ptr[r];
+    }
+    index_t* index = new index_t[ptr[n]];
+    pos.resize(ptr[n]);
+#pragma omp parallel
+    {
+        std::vector<std::pair<index_t,index_t> > row;
+#pragma omp for
+        for (index_t i = 0; i < n; ++i) {
+            const index_t r = (newToOld ? newToOld[i] : i);
+            row.clear();
+            for (index_t iptr = pattern->ptr[r]; iptr < pattern->ptr[r+1]; ++iptr) {
+                const index_t j = pattern->index[iptr];
+                row.push_back(std::make_pair(oldToNew ? oldToNew[j] : j, iptr));
+            }
+            std::sort(row.begin(), row.end());
+            for (size_t k = 0; k < row.size(); ++k) {
+                index[ptr[i]+k] = row[k].first;
+                pos[row[k].second] = ptr[i]+k;
+            }
+        }
+    }
+    return Pattern_ptr(new Pattern(pattern->type, n, pattern->numInput, ptr,
+                                   index));
+}
+
+/// returns the connector with the local components relabelled
+Connector_ptr permuteConnector(const_Connector_ptr connector,
+                               const std::vector<index_t>& oldToNew)
+{
+    const_SharedComponents_ptr send(connector->send);
+    std::vector<index_t> shared(send->numSharedComponents+1);
+    for (dim_t i = 0; i < send->numSharedComponents; ++i)
+        shared[i] = oldToNew[send->shared[i]];
+    SharedComponents_ptr new_send(new SharedComponents(send->local_length,
+                send->neighbour, &shared[0], send->offsetInShared));
+    // received values are stored after the local components
+    return Connector_ptr(new Connector(new_send, connector->recv));
+}
+
+/// copies the values of a block into the reordered block
+void copyValues(const_SparseMatrix_ptr in, SparseMatrix_ptr out,
+                const std::vector<index_t>& pos)
+{
+    const dim_t block_size = in->block_size;
+    const dim_t len = pos.size();
+#pragma omp parallel for
+    for (index_t iptr = 0; iptr < len; ++iptr) {
+        for (dim_t k = 0; k < block_size; ++k)
+            out->val[pos[iptr]*block_size+k] = in->val[iptr*block_size+k];
+    }
+}
+
+} // anonymous namespace
+
+void ReorderedSystem_free(SystemMatrix* A)
+{
+    if (A && A->reordered_system) {
+        delete A->reordered_system;
+        A->reordered_system = NULL;
+    }
+}
+
+/// returns the reordered copy of A holding the current values of A. An
+/// empty pointer is returned if the labelling of A is kept.
+SystemMatrix_ptr ReorderedSystem_update(SystemMatrix_ptr A)
+{
+    if ((A->type & MATRIX_FORMAT_CSC) || (A->type & MATRIX_FORMAT_OFFSET1)) {
+        throw PasoException("ReorderedSystem: CSR format with index offset 0 required.");
+    }
+    ReorderedSystem* rs = A->reordered_system;
+    if (rs == NULL) {
+        rs = new ReorderedSystem;
+        A->reordered_system = rs;
+        const_SystemMatrixPattern_ptr pattern(A->pattern);
+        const dim_t n = pattern->mainPattern->numOutput;
+        if (n > 0) {
+            std::vector<index_t> label(n);
+            pattern->mainPattern->reduceBandwidth(&label[0]);
+            bool changed = false;
+            for (index_t i = 0; i < n; ++i) {
+                if (label[i] != i) {
+                    changed = true;
+                    break;
+                }
+            }
+            if (changed) {
+                rs->oldToNew.resize(n);
+                for (index_t i = 0; i < n; ++i)
+                    rs->oldToNew[i] = n-1-label[i];
+            }
+        }
+        if (!rs->oldToNew.empty()) {
+            const index_t* oldToNew = &rs->oldToNew[0];
+            std::vector<index_t> newToOld(n);
+            for (index_t i = 0; i < n; ++i)
+                newToOld[oldToNew[i]] = i;
+            Pattern_ptr mainPattern(permutePattern(pattern->mainPattern,
+                                &newToOld[0], oldToNew, rs->main_pos));
+            Pattern_ptr col_couplePattern(pattern->col_couplePattern);
+            if (col_couplePattern->ptr != NULL) {
+                col_couplePattern = permutePattern(col_couplePattern,
+                                &newToOld[0], NULL, rs->col_couple_pos);
+            }
+            Pattern_ptr row_couplePattern(pattern->row_couplePattern);
+            if (row_couplePattern->ptr != NULL) {
+                row_couplePattern = permutePattern(row_couplePattern, NULL,
+                                oldToNew, rs->row_couple_pos);
+            }
+            Connector_ptr col_connector(permuteConnector(
+                                pattern->col_connector, rs->oldToNew));
+            Connector_ptr row_connector(col_connector);
+            if (pattern->row_connector != pattern->col_connector) {
+                row_connector = permuteConnector(pattern->row_connector,
+                                                 rs->oldToNew);
+            }
+            SystemMatrixPattern_ptr new_pattern(new SystemMatrixPattern(
+                    pattern->type, pattern->output_distribution,
+                    pattern->input_distribution, mainPattern,
+                    col_couplePattern, row_couplePattern, col_connector,
+                    row_connector));
+            rs->A.reset(new SystemMatrix(A->type, new_pattern,
+                    A->row_block_size, A->col_block_size, false,
+                    A->getRowFunctionSpace(), A->getColumnFunctionSpace()));
+        }
+    }
+    if (rs->A) {
+        copyValues(A->mainBlock, rs->A->mainBlock, rs->main_pos);
+        copyValues(A->col_coupleBlock, rs->A->col_coupleBlock,
+                   rs->col_couple_pos);
+        copyValues(A->row_coupleBlock, rs->A->row_coupleBlock,
+                   rs->row_couple_pos);
+        // A may have been balanced by an earlier solve without reordering
+        rs->A->is_balanced = A->is_balanced;
+        if (A->is_balanced) {
+            ReorderedSystem_permute(A.get(), rs->A->balance_vector,
+                                    A->balance_vector, true);
+        }
+    }
+    return rs->A;
+}
+
+/// permutes a vector into the labels of the reordered matrix (toNew) or back
+void ReorderedSystem_permute(const SystemMatrix* A, double* out,
+                             const double* in, bool toNew)
+{
+    const std::vector<index_t>& oldToNew(A->reordered_system->oldToNew);
+    const dim_t n = oldToNew.size();
+    const dim_t b = A->row_block_size;
+#pragma omp parallel for
+    for (index_t i = 0; i < n; ++i) {
+        const index_t k = oldToNew[i];
+        for (dim_t j = 0; j < b; ++j) {
+            if (toNew) {
+                out[k*b+j] = in[i*b+j];
+            } else {
+                out[i*b+j] = in[k*b+j];
+            }
+        }
+    }
+}
+
+} // namespace paso
+
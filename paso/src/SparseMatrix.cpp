@@ -31,6 +31,7 @@
 #include "Options.h"
 #include "PasoUtil.h"
 #include "Preconditioner.h"
+#include "Supernodal.h"
 #include "UMFPACK.h"
 #include "mmio.h"
 
@@ -110,7 +111,8 @@ SparseMatrix::SparseMatrix(SparseMatrixType ntype, Pattern_ptr npattern,
     type(ntype),
     val(NULL),
     solver_package(PASO_PASO),
-    solver_p(NULL)
+    solver_p(NULL),
+    sell(NULL)
 {
     if (patternIsUnrolled) {
         if ((ntype & MATRIX_FORMAT_OFFSET1) != (npattern->type & MATRIX_FORMAT_OFFSET1)) {
@@ -122,8 +124,8 @@ SparseMatrix::SparseMatrix(SparseMatrixType ntype, Pattern_ptr npattern,
           // we don't like non-square blocks
         = (rowBlockSize != colBlockSize)
 #ifndef ESYS_HAVE_LAPACK
-          // or any block size bigger than 3
-          || (colBlockSize > 3)
+          // or any block size without a templated kernel
+          || (colBlockSize > PASO_BLOCKOPS_MAX_N)
 #endif
           // or if block size one requested and the block size is not 1
           || ((ntype & MATRIX_FORMAT_BLK1) && (colBlockSize > 1))
@@ -177,6 +179,8 @@ SparseMatrix::SparseMatrix(SparseMatrixType ntype, Pattern_ptr npattern,
     }
     len = (size_t)(pattern->len)*(size_t)(block_size);
 
+    // setValues touches the values first by row stripes in the same way as
+    // the matrix-vector product so the pages end up on the right NUMA node
     val=new double[len];
     setValues(0.);
 }
@@ -195,7 +199,12 @@ SparseMatrix::~SparseMatrix()
         case PASO_UMFPACK:
             UMFPACK_free(this);
             break;
+
+        case PASO_DIRECT:
+            Supernodal_free(this);
+            break;
     }
+    delete sell;
     delete[] val;
 }
 
@@ -478,7 +487,7 @@ void SparseMatrix::setValues(double value)
     const index_t index_offset=(type & MATRIX_FORMAT_OFFSET1 ? 1:0);
     if (!pattern->isEmpty()) {
         const dim_t nOut = pattern->numOutput;
-#pragma omp parallel for
+#pragma omp parallel for schedule(static)
         for (dim_t i=0; i < nOut; ++i) {
             for (index_t iptr=pattern->ptr[i]-index_offset; iptr < pattern->ptr[i+1]-index_offset; ++iptr) {
                 for (dim_t j=0; j<block_size; ++j)
@@ -38,6 +38,38 @@ typedef boost::shared_ptr<const SparseMatrix> const_SparseMatrix_ptr;
 
 typedef int SparseMatrixType;
 
+/// sliced ELLPACK (SELL-C-sigma) copy of a CSR matrix with offset 0 used by
+/// the matrix-vector product. Within windows of sigma rows the rows are
+/// sorted by decreasing length and grouped into chunks of C rows. Each chunk
+/// is padded to the length of its longest row and stored column by column so
+/// that the C rows of a chunk are processed in SIMD lanes.
+struct SparseMatrix_SELL
+{
+    SparseMatrix_SELL(const SparseMatrix* A);
+
+    ~SparseMatrix_SELL();
+
+    /// copies the values of A into the sliced storage and marks the copy as
+    /// up to date
+    void updateValues(const SparseMatrix* A);
+
+    /// pattern the copy was built for. The copy needs to be rebuilt if the
+    /// pattern of the matrix is replaced.
+    Pattern_ptr pattern;
+    /// true while the values match the CSR values. Only then the copy is used
+    /// by the matrix-vector product.
+    bool upToDate;
+    dim_t numChunks;
+    /// offset of the first slot of each chunk (numChunks+1 entries)
+    index_t* chunk_ptr;
+    /// row of A processed by each lane of each chunk (-1 for padding lanes)
+    index_t* row;
+    /// column index for each slot
+    index_t* index;
+    /// values for each slot. The entries of a block are C values apart.
+    double* val;
+};
+
 // this struct holds a sparse matrix
 struct SparseMatrix : boost::enable_shared_from_this<SparseMatrix>
 {
@@ -173,6 +205,9 @@ struct SparseMatrix : boost::enable_shared_from_this<SparseMatrix>
 
     /// pointer to data needed by a solver
     void* solver_p;
+
+    /// sliced ELLPACK copy for the matrix-vector product (may be NULL)
+    SparseMatrix_SELL* sell;
 };
 
 //  interfaces:
@@ -202,6 +237,18 @@ void SparseMatrix_MatrixVector_CSR_OFFSET0_DIAG(const double alpha,
                                                 const double* in,
                                                 const double beta, double* out);
 
+void SparseMatrix_MatrixMultiVector_CSR_OFFSET0(const double alpha,
+                                                const_SparseMatrix_ptr A,
+                                                const dim_t numVec,
+                                                const double* in,
+                                                const double beta,
+                                                double* out);
+
+void SparseMatrix_MatrixVector_SELL(const double alpha,
+                                    const_SparseMatrix_ptr A,
+                                    const double* in,
+                                    const double beta, double* out);
+
 SparseMatrix_ptr SparseMatrix_MatrixMatrix(const_SparseMatrix_ptr A,
                                            const_SparseMatrix_ptr B);
 
@@ -327,6 +327,33 @@ void SparseMatrix_MatrixVector_CSR_OFFSET0(double alpha,
 #endif // scheduling
 }
 
+/* CSR format with offset 0 for square blocks of size N known at compile
+   time. The row block is accumulated in registers and the loop over the
+   rows of a block column vectorizes. */
+template <int N>
+void SparseMatrix_MatrixVector_CSR_OFFSET0_stripe_block(double alpha,
+        dim_t nRows, const index_t* ptr, const index_t* index,
+        const double* val, const double* in, double* out)
+{
+    for (index_t ir=0; ir < nRows; ir++) {
+        double reg[N];
+        for (int irb=0; irb < N; irb++)
+            reg[irb]=0.;
+        for (index_t iptr=ptr[ir]; iptr < ptr[ir+1]; iptr++) {
+            const double* A=&val[iptr*N*N];
+            const double* x=&in[N*index[iptr]];
+            for (int icb=0; icb < N; icb++) {
+                const double S=x[icb];
+                #pragma ivdep
+                for (int irb=0; irb < N; irb++)
+                    reg[irb] += A[irb+N*icb] * S;
+            }
+        }
+        for (int irb=0; irb < N; irb++)
+            out[irb+N*ir] += alpha * reg[irb];
+    }
+}
+
 /* CSR format with offset 0 */
 void SparseMatrix_MatrixVector_CSR_OFFSET0_stripe(double alpha, dim_t nRows,
         dim_t row_block_size, dim_t col_block_size, const index_t* ptr,
@@ -402,7 +429,17 @@ void SparseMatrix_MatrixVector_CSR_OFFSET0_stripe(double alpha, dim_t nRows,
                 out[1+3*ir] += alpha * reg2;
                 out[2+3*ir] += alpha * reg3;
             }
-        } else { // blocksizes > 3
+        } else if (col_block_size==4 && row_block_size==4) {
+            SparseMatrix_MatrixVector_CSR_OFFSET0_stripe_block<4>(alpha, nRows, ptr, index, val, in, out);
+        } else if (col_block_size==5 && row_block_size==5) {
+            SparseMatrix_MatrixVector_CSR_OFFSET0_stripe_block<5>(alpha, nRows, ptr, index, val, in, out);
+        } else if (col_block_size==6 && row_block_size==6) {
+            SparseMatrix_MatrixVector_CSR_OFFSET0_stripe_block<6>(alpha, nRows, ptr, index, val, in, out);
+        } else if (col_block_size==7 && row_block_size==7) {
+            SparseMatrix_MatrixVector_CSR_OFFSET0_stripe_block<7>(alpha, nRows, ptr, index, val, in, out);
+        } else if (col_block_size==8 && row_block_size==8) {
+            SparseMatrix_MatrixVector_CSR_OFFSET0_stripe_block<8>(alpha, nRows, ptr, index, val, in, out);
+        } else { // non-square blocks or blocksizes > 8
             const dim_t block_size=col_block_size*row_block_size;
             for (index_t ir=0; ir < nRows; ir++) {
                 for (index_t iptr=ptr[ir]; iptr < ptr[ir+1]; iptr++) {
@@ -422,6 +459,83 @@ void SparseMatrix_MatrixVector_CSR_OFFSET0_stripe(double alpha, dim_t nRows,
     }
 }
 
+/* CSR format with offset 0 applied to numVec vectors at once. The vectors
+   are stored interleaved, i.e. entry i of vector j is in[i*numVec+j], so each
+   matrix entry is loaded once for all vectors */
+void SparseMatrix_MatrixMultiVector_CSR_OFFSET0(double alpha,
+                                                const_SparseMatrix_ptr A,
+                                                dim_t numVec,
+                                                const double* in,
+                                                double beta, double* out)
+{
+    if (numVec == 1) {
+        if (A->type & MATRIX_FORMAT_DIAGONAL_BLOCK) {
+            SparseMatrix_MatrixVector_CSR_OFFSET0_DIAG(alpha, A, in, beta, out);
+        } else {
+            SparseMatrix_MatrixVector_CSR_OFFSET0(alpha, A, in, beta, out);
+        }
+        return;
+    }
+    const dim_t nRows = A->numRows;
+    const dim_t row_block_size = A->row_block_size;
+    const dim_t col_block_size = A->col_block_size;
+    const dim_t block_size = A->block_size;
+    const bool diagonalBlocks = (A->type & MATRIX_FORMAT_DIAGONAL_BLOCK);
+    const dim_t rowLen = row_block_size*numVec;
+    const index_t* ptr = A->pattern->ptr;
+    const index_t* index = A->pattern->index;
+    const double* val = A->val;
+
+#pragma omp parallel
+    {
+        double* reg = new double[rowLen];
+#pragma omp for schedule(static)
+        for (index_t ir=0; ir < nRows; ir++) {
+            for (dim_t l=0; l < rowLen; l++)
+                reg[l] = 0.;
+            for (index_t iptr=ptr[ir]; iptr < ptr[ir+1]; iptr++) {
+                const index_t ic = index[iptr];
+                if (row_block_size == 1 && col_block_size == 1) {
+                    const double a = val[iptr];
+                    const double* x = &in[ic*numVec];
+                    #pragma ivdep
+                    for (dim_t j=0; j < numVec; j++)
+                        reg[j] += a * x[j];
+                } else if (diagonalBlocks) {
+                    for (dim_t ib=0; ib < block_size; ib++) {
+                        const double a = val[iptr*block_size+ib];
+                        const double* x = &in[(ic*col_block_size+ib)*numVec];
+                        double* y = &reg[ib*numVec];
+                        #pragma ivdep
+                        for (dim_t j=0; j < numVec; j++)
+                            y[j] += a * x[j];
+                    }
+                } else {
+                    for (dim_t icb=0; icb < col_block_size; icb++) {
+                        const double* x = &in[(ic*col_block_size+icb)*numVec];
+                        for (dim_t irb=0; irb < row_block_size; irb++) {
+                            const double a = val[iptr*block_size+irb+row_block_size*icb];
+                            double* y = &reg[irb*numVec];
+                            #pragma ivdep
+                            for (dim_t j=0; j < numVec; j++)
+                                y[j] += a * x[j];
+                        }
+                    }
+                }
+            }
+            double* y = &out[ir*rowLen];
+            if (std::abs(beta) > 0) {
+                for (dim_t l=0; l < rowLen; l++)
+                    y[l] = beta * y[l] + alpha * reg[l];
+            } else {
+                for (dim_t l=0; l < rowLen; l++)
+                    y[l] = alpha * reg[l];
+            }
+        }
+        delete[] reg;
+    }
+}
+
 /* CSR format with offset 0 (diagonal only) */
 void SparseMatrix_MatrixVector_CSR_OFFSET0_DIAG(double alpha,
                                                 const_SparseMatrix_ptr A,
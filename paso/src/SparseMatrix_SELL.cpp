@@ -0,0 +1,306 @@
+
+/*****************************************************************************
+*
+* Copyright (c) 2003-2018 by The University of Queensland
+* http://www.uq.edu.au
+*
+* Primary Business: Queensland, Australia
+* Licensed under the Apache License, version 2.0
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Development until 2012 by Earth Systems Science Computational Center (ESSCC)
+* Development 2012-2013 by School of Earth Sciences
+* Development from 2014 by Centre for Geoscience Computing (GeoComp)
+*
+*****************************************************************************/
+
+
+/****************************************************************************
+ *
+ * Paso: sliced ELLPACK (SELL-C-sigma) storage of a CSR matrix and the
+ *       raw scaled vector update operation:
+ *                  out = alpha * A * in + beta * out
+ ****************************************************************************/
+
+#include "SparseMatrix.h"
+#include "PasoException.h"
+#include "PasoUtil.h"
+
+#include <algorithm>
+
+// number of rows in a chunk (= number of SIMD lanes used)
+#define PASO_SELL_CHUNK_SIZE 8
+
+// rows are sorted by length within windows of this many rows. This needs
+// to be a multiple of PASO_SELL_CHUNK_SIZE.
+#define PASO_SELL_SIGMA 256
+
+namespace paso {
+
+namespace {
+
+/// orders rows by decreasing length
+struct RowLengthCompare
+{
+    RowLengthCompare(const index_t* ptr) : ptr(ptr) {}
+
+    bool operator()(index_t a, index_t b) const
+    {
+        return ptr[a+1]-ptr[a] > ptr[b+1]-ptr[b];
+    }
+
+    const index_t* ptr;
+};
+
+/// stores out[i] = alpha*reg + beta*out[i] for the rows of a chunk
+inline void SELL_store(double alpha, const double* reg, double beta,
+                       double* out, const index_t* row, dim_t n_block)
+{
+    const dim_t C = PASO_SELL_CHUNK_SIZE;
+    for (dim_t r=0; r<C; ++r) {
+        if (row[r] < 0)
+            continue;
+        for (dim_t ib=0; ib<n_block; ++ib) {
+            const index_t irow = n_block*row[r]+ib;
+            if (std::abs(beta) > 0) {
+                out[irow] = alpha*reg[ib*C+r] + beta*out[irow];
+            } else {
+                out[irow] = alpha*reg[ib*C+r];
+            }
+        }
+    }
+}
+
+/// kernel for square blocks of size NB stored in full
+template <int NB>
+void SELL_MV_block(double alpha, const SparseMatrix_SELL* S,
+                   const double* in, double beta, double* out)
+{
+    const dim_t C = PASO_SELL_CHUNK_SIZE;
+    const dim_t block_len = NB*NB;
+#pragma omp parallel for schedule(static)
+    for (index_t c=0; c<S->numChunks; ++c) {
+        double reg[PASO_SELL_CHUNK_SIZE*NB];
+        for (dim_t r=0; r<C*NB; ++r)
+            reg[r] = 0.;
+        for (index_t s0=S->chunk_ptr[c]; s0<S->chunk_ptr[c+1]; s0+=C) {
+            const index_t* idx = &S->index[s0];
+            const double* v = &S->val[s0*block_len];
+            for (dim_t icb=0; icb<NB; ++icb) {
+                for (dim_t irb=0; irb<NB; ++irb) {
+                    const double* ve = &v[(irb+NB*icb)*C];
+                    #pragma ivdep
+                    for (dim_t r=0; r<C; ++r)
+                        reg[irb*C+r] += ve[r] * in[NB*idx[r]+icb];
+                }
+            }
+        }
+        SELL_store(alpha, reg, beta, out, &S->row[c*C], NB);
+    }
+}
+
+/// kernel for diagonal blocks of size NB
+template <int NB>
+void SELL_MV_diag(double alpha, const SparseMatrix_SELL* S,
+                  const double* in, double beta, double* out)
+{
+    const dim_t C = PASO_SELL_CHUNK_SIZE;
+#pragma omp parallel for schedule(static)
+    for (index_t c=0; c<S->numChunks; ++c) {
+        double reg[PASO_SELL_CHUNK_SIZE*NB];
+        for (dim_t r=0; r<C*NB; ++r)
+            reg[r] = 0.;
+        for (index_t s0=S->chunk_ptr[c]; s0<S->chunk_ptr[c+1]; s0+=C) {
+            const index_t* idx = &S->index[s0];
+            const double* v = &S->val[s0*NB];
+            for (dim_t ib=0; ib<NB; ++ib) {
+                #pragma ivdep
+                for (dim_t r=0; r<C; ++r)
+                    reg[ib*C+r] += v[ib*C+r] * in[NB*idx[r]+ib];
+            }
+        }
+        SELL_store(alpha, reg, beta, out, &S->row[c*C], NB);
+    }
+}
+
+/// kernel for general block sizes
+void SELL_MV_general(double alpha, const SparseMatrix* A,
+                     const double* in, double beta, double* out)
+{
+    const SparseMatrix_SELL* S = A->sell;
+    const dim_t C = PASO_SELL_CHUNK_SIZE;
+    const dim_t row_block_size = A->row_block_size;
+    const dim_t col_block_size = A->col_block_size;
+    const dim_t block_len = A->block_size;
+    const bool diagonal = (A->type & MATRIX_FORMAT_DIAGONAL_BLOCK);
+#pragma omp parallel
+    {
+        double* reg = new double[C*row_block_size];
+#pragma omp for schedule(static)
+        for (index_t c=0; c<S->numChunks; ++c) {
+            for (dim_t r=0; r<C*row_block_size; ++r)
+                reg[r] = 0.;
+            for (index_t s0=S->chunk_ptr[c]; s0<S->chunk_ptr[c+1]; s0+=C) {
+                const index_t* idx = &S->index[s0];
+                const double* v = &S->val[s0*block_len];
+                if (diagonal) {
+                    for (dim_t ib=0; ib<block_len; ++ib) {
+                        #pragma ivdep
+                        for (dim_t r=0; r<C; ++r)
+                            reg[ib*C+r] += v[ib*C+r] * in[col_block_size*idx[r]+ib];
+                    }
+                } else {
+                    for (dim_t icb=0; icb<col_block_size; ++icb) {
+                        for (dim_t irb=0; irb<row_block_size; ++irb) {
+                            const double* ve = &v[(irb+row_block_size*icb)*C];
+                            #pragma ivdep
+                            for (dim_t r=0; r<C; ++r)
+                                reg[irb*C+r] += ve[r] * in[col_block_size*idx[r]+icb];
+                        }
+                    }
+                }
+            }
+            SELL_store(alpha, reg, beta, out, &S->row[c*C], row_block_size);
+        }
+        delete[] reg;
+    }
+}
+
+} // anonymous namespace
+
+SparseMatrix_SELL::SparseMatrix_SELL(const SparseMatrix* A) :
+    pattern(A->pattern),
+    upToDate(false),
+    numChunks(0),
+    chunk_ptr(NULL),
+    row(NULL),
+    index(NULL),
+    val(NULL)
+{
+    if (A->type & (MATRIX_FORMAT_CSC | MATRIX_FORMAT_OFFSET1)) {
+        throw PasoException("SparseMatrix_SELL: CSR format with index offset 0 is required.");
+    }
+    const dim_t C = PASO_SELL_CHUNK_SIZE;
+    const dim_t n = A->numRows;
+    const index_t* ptr = A->pattern->ptr;
+    numChunks = (n+C-1)/C;
+    const dim_t numWindows = (n+PASO_SELL_SIGMA-1)/PASO_SELL_SIGMA;
+
+    // sort the rows by decreasing length within each window
+    row = new index_t[numChunks*C];
+#pragma omp parallel for schedule(static)
+    for (index_t i=0; i<numChunks*C; ++i)
+        row[i] = (i<n) ? i : -1;
+#pragma omp parallel for schedule(static)
+    for (index_t w=0; w<numWindows; ++w) {
+        const index_t start = w*PASO_SELL_SIGMA;
+        const index_t end = std::min(start+PASO_SELL_SIGMA, n);
+        std::stable_sort(&row[start], &row[end], RowLengthCompare(ptr));
+    }
+
+    // each chunk is as wide as its longest row which is the first one
+    chunk_ptr = new index_t[numChunks+1];
+#pragma omp parallel for schedule(static)
+    for (index_t c=0; c<numChunks; ++c)
+        chunk_ptr[c] = C*(ptr[row[c*C]+1]-ptr[row[c*C]]);
+    chunk_ptr[numChunks] = util::cumsum(numChunks, chunk_ptr);
+
+    // padding slots point to column 0 and hold a zero value
+    index = new index_t[chunk_ptr[numChunks]];
+    val = new double[(size_t)chunk_ptr[numChunks]*A->block_size];
+#pragma omp parallel for schedule(static)
+    for (index_t c=0; c<numChunks; ++c) {
+        for (dim_t r=0; r<C; ++r) {
+            const index_t irow = row[c*C+r];
+            const index_t len = (irow<0) ? 0 : ptr[irow+1]-ptr[irow];
+            index_t j=0;
+            for (index_t s=chunk_ptr[c]+r; s<chunk_ptr[c+1]; s+=C, ++j)
+                index[s] = (j<len) ? A->pattern->index[ptr[irow]+j] : 0;
+        }
+    }
+    updateValues(A);
+}
+
+SparseMatrix_SELL::~SparseMatrix_SELL()
+{
+    delete[] chunk_ptr;
+    delete[] row;
+    delete[] index;
+    delete[] val;
+}
+
+void SparseMatrix_SELL::updateValues(const SparseMatrix* A)
+{
+    const dim_t C = PASO_SELL_CHUNK_SIZE;
+    const dim_t block_len = A->block_size;
+    const index_t* ptr = A->pattern->ptr;
+#pragma omp parallel for schedule(static)
+    for (index_t c=0; c<numChunks; ++c) {
+        for (dim_t r=0; r<C; ++r) {
+            const index_t irow = row[c*C+r];
+            const index_t len = (irow<0) ? 0 : ptr[irow+1]-ptr[irow];
+            index_t j=0;
+            for (index_t s0=chunk_ptr[c]; s0<chunk_ptr[c+1]; s0+=C, ++j) {
+                double* v = &val[s0*block_len+r];
+                if (j<len) {
+                    const double* a = &A->val[(ptr[irow]+j)*block_len];
+                    for (dim_t ib=0; ib<block_len; ++ib)
+                        v[ib*C] = a[ib];
+                } else {
+                    for (dim_t ib=0; ib<block_len; ++ib)
+                        v[ib*C] = 0.;
+                }
+            }
+        }
+    }
+    upToDate = true;
+}
+
+/* SELL-C-sigma format, uses A->sell which needs to be up to date */
+void SparseMatrix_MatrixVector_SELL(double alpha, const_SparseMatrix_ptr A,
+                                    const double* in, double beta,
+                                    double* out)
+{
+    const SparseMatrix_SELL* S = A->sell;
+    if (std::abs(alpha) > 0) {
+        const bool diagonal = (A->type & MATRIX_FORMAT_DIAGONAL_BLOCK);
+        const bool square = (A->row_block_size == A->col_block_size);
+        if (square && A->row_block_size == 1) {
+            SELL_MV_block<1>(alpha, S, in, beta, out);
+        } else if (square && diagonal && A->row_block_size == 2) {
+            SELL_MV_diag<2>(alpha, S, in, beta, out);
+        } else if (square && diagonal && A->row_block_size == 3) {
+            SELL_MV_diag<3>(alpha, S, in, beta, out);
+        } else if (square && !diagonal && A->row_block_size == 2) {
+            SELL_MV_block<2>(alpha, S, in, beta, out);
+        } else if (square && !diagonal && A->row_block_size == 3) {
+            SELL_MV_block<3>(alpha, S, in, beta, out);
+        } else if (square && !diagonal && A->row_block_size == 4) {
+            SELL_MV_block<4>(alpha, S, in, beta, out);
+        } else if (square && !diagonal && A->row_block_size == 5) {
+            SELL_MV_block<5>(alpha, S, in, beta, out);
+        } else if (square && !diagonal && A->row_block_size == 6) {
+            SELL_MV_block<6>(alpha, S, in, beta, out);
+        } else if (square && !diagonal && A->row_block_size == 7) {
+            SELL_MV_block<7>(alpha, S, in, beta, out);
+        } else if (square && !diagonal && A->row_block_size == 8) {
+            SELL_MV_block<8>(alpha, S, in, beta, out);
+        } else {
+            SELL_MV_general(alpha, A.get(), in, beta, out);
+        }
+    } else {
+        const dim_t totalRowSize = A->numRows * A->row_block_size;
+        if (std::abs(beta) > 0) {
+#pragma omp parallel for schedule(static)
+            for (index_t irow=0; irow < totalRowSize; irow++)
+                out[irow] *= beta;
+        } else {
+#pragma omp parallel for schedule(static)
+            for (index_t irow=0; irow < totalRowSize; irow++)
+                out[irow] = 0;
+        }
+    }
+}
+
+} // namespace paso
+
@@ -0,0 +1,926 @@
+
+/*****************************************************************************
+*
+* Copyright (c) 2003-2018 by The University of Queensland
+* http://www.uq.edu.au
+*
+* Primary Business: Queensland, Australia
+* Licensed under the Apache License, version 2.0
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Development until 2012 by Earth Systems Science Computational Center (ESSCC)
+* Development 2012-2013 by School of Earth Sciences
+* Development from 2014 by Centre for Geoscience Computing (GeoComp)
+*
+*****************************************************************************/
+
+
+/****************************************************************************/
+
+/* Paso: native supernodal sparse direct solver.
+
+   The nodes are ordered by nested dissection and relabelled in a postorder
+   of the elimination tree of the symmetrized pattern. Chains of nodes with
+   nested structure are grouped into supernodes, small supernodes are merged
+   with their parent if few zeros are introduced. Each supernode is
+   factorized as a dense front holding its own nodes and the nodes below
+   them (multifrontal method): the matrix entries and the update matrices of
+   the children are assembled, the nodes of the supernode are eliminated
+   and the remaining Schur complement is passed on to the parent.
+   For the LU factorization partial pivoting is applied within the rows of
+   the supernode. Pivots which are too small are perturbed (static pivoting)
+   and the error is reduced by iterative refinement.
+*/
+
+/****************************************************************************/
+
+#include "Paso.h"
+#include "Supernodal.h"
+#include "Options.h"
+#include "PasoException.h"
+#include "PasoUtil.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring> // memcmp
+#include <iostream>
+
+// number of columns of a front which are eliminated before the remaining
+// columns are updated
+#define PASO_SUPERNODAL_PANEL_SIZE 32
+
+namespace paso {
+
+namespace {
+
+/// adjacency of the symmetrized pattern without the main diagonal using the
+/// labels oldToNew. Entries may appear twice.
+void getAdjacency(const_Pattern_ptr pattern, const index_t* oldToNew,
+                  std::vector<index_t>& adj_ptr, std::vector<index_t>& adj)
+{
+    const dim_t n = pattern->numOutput;
+    adj_ptr.assign(n+1, 0);
+    for (index_t i = 0; i < n; ++i) {
+        for (index_t iptr = pattern->ptr[i]; iptr < pattern->ptr[i+1]; ++iptr) {
+            const index_t j = pattern->index[iptr];
+            if (j != i) {
+                adj_ptr[oldToNew[i]+1]++;
+                adj_ptr[oldToNew[j]+1]++;
+            }
+        }
+    }
+    for (index_t i = 0; i < n; ++i)
+        adj_ptr[i+1] += adj_ptr[i];
+    adj.resize(adj_ptr[n]);
+    std::vector<index_t> pos(adj_ptr.begin(), adj_ptr.end()-1);
+    for (index_t i = 0; i < n; ++i) {
+        for (index_t iptr = pattern->ptr[i]; iptr < pattern->ptr[i+1]; ++iptr) {
+            const index_t j = pattern->index[iptr];
+            if (j != i) {
+                adj[pos[oldToNew[i]]++] = oldToNew[j];
+                adj[pos[oldToNew[j]]++] = oldToNew[i];
+            }
+        }
+    }
+}
+
+/// elimination tree of the symmetrized pattern (parent[i]==-1 for roots)
+void getEliminationTree(const std::vector<index_t>& adj_ptr,
+                        const std::vector<index_t>& adj,
+                        std::vector<index_t>& parent)
+{
+    const dim_t n = adj_ptr.size()-1;
+    std::vector<index_t> ancestor(n, -1);
+    parent.assign(n, -1);
+    for (index_t i = 0; i < n; ++i) {
+        for (index_t iptr = adj_ptr[i]; iptr < adj_ptr[i+1]; ++iptr) {
+            index_t r = adj[iptr];
+            if (r >= i)
+                continue;
+            while (ancestor[r] != -1 && ancestor[r] != i) {
+                const index_t t = ancestor[r];
+                ancestor[r] = i;
+                r = t;
+            }
+            if (ancestor[r] == -1) {
+                ancestor[r] = i;
+                parent[r] = i;
+            }
+        }
+    }
+}
+
+/// returns the nodes of a tree in postorder
+void getPostorder(const std::vector<index_t>& parent,
+                  std::vector<index_t>& post)
+{
+    const dim_t n = parent.size();
+    std::vector<index_t> head(n, -1), next(n, -1);
+    for (index_t j = n-1; j >= 0; --j) {
+        if (parent[j] >= 0) {
+            next[j] = head[parent[j]];
+            head[parent[j]] = j;
+        }
+    }
+    std::vector<index_t> stack;
+    post.clear();
+    post.reserve(n);
+    for (index_t j = 0; j < n; ++j) {
+        if (parent[j] >= 0)
+            continue;
+        stack.push_back(j);
+        while (!stack.empty()) {
+            const index_t p = stack.back();
+            const index_t c = head[p];
+            if (c == -1) {
+                stack.pop_back();
+                post.push_back(p);
+            } else {
+                head[p] = next[c];
+                stack.push_back(c);
+            }
+        }
+    }
+}
+
+/// position of node i (new label) in the front of supernode s
+inline index_t getFrontPosition(const Supernodal_Handler* h, index_t s,
+                                index_t i)
+{
+    if (i >= h->first[s] && i < h->first[s+1])
+        return i - h->first[s];
+    const index_t* begin = &h->rows[0] + h->row_ptr[s];
+    const index_t* end = &h->rows[0] + h->row_ptr[s+1];
+    const index_t* p = std::lower_bound(begin, end, i);
+    if (p == end || *p != i) {
+        throw PasoException("Supernodal: inconsistent symbolic factorization.");
+    }
+    return h->first[s+1] - h->first[s] + (p-begin);
+}
+
+/// ordering, supernodes and assembly information for the pattern of A
+Supernodal_Handler* analyse(const_SparseMatrix_ptr A, bool symmetric)
+{
+    const_Pattern_ptr pattern(A->pattern);
+    const dim_t n = A->numRows;
+    const dim_t nb = A->row_block_size;
+    Supernodal_Handler* h = new Supernodal_Handler;
+    h->pattern = pattern;
+    h->symmetric = symmetric;
+    h->n = n;
+    h->block_size = nb;
+    h->factor = NULL;
+    h->pivot = NULL;
+    h->numPerturbedPivots = 0;
+    h->oldToNew.resize(n);
+    h->newToOld.resize(n);
+    if (n > 0)
+        pattern->nestedDissection(&h->oldToNew[0]);
+
+    // relabel in a postorder of the elimination tree so the nodes of a
+    // subtree are numbered consecutively
+    std::vector<index_t> adj_ptr, adj, parent, post;
+    getAdjacency(pattern, &h->oldToNew[0], adj_ptr, adj);
+    getEliminationTree(adj_ptr, adj, parent);
+    getPostorder(parent, post);
+    std::vector<index_t> label(n);
+    for (index_t k = 0; k < n; ++k)
+        label[post[k]] = k;
+    for (index_t i = 0; i < n; ++i)
+        h->oldToNew[i] = label[h->oldToNew[i]];
+    for (index_t i = 0; i < n; ++i)
+        h->newToOld[h->oldToNew[i]] = i;
+    getAdjacency(pattern, &h->oldToNew[0], adj_ptr, adj);
+    getEliminationTree(adj_ptr, adj, parent);
+
+    // number of entries in the columns of L from the row subtrees
+    std::vector<index_t> colCount(n, 1), mark(n, -1);
+    for (index_t i = 0; i < n; ++i) {
+        mark[i] = i;
+        for (index_t iptr = adj_ptr[i]; iptr < adj_ptr[i+1]; ++iptr) {
+            index_t j = adj[iptr];
+            if (j > i)
+                continue;
+            while (mark[j] != i) {
+                colCount[j]++;
+                mark[j] = i;
+                j = parent[j];
+            }
+        }
+    }
+
+    // fundamental supernodes: chains of nodes with nested structure
+    std::vector<index_t> numChildren(n, 0);
+    for (index_t j = 0; j < n; ++j) {
+        if (parent[j] >= 0)
+            numChildren[parent[j]]++;
+    }
+    std::vector<index_t> start, finish;
+    for (index_t j = 0; j < n; ++j) {
+        if (j == 0 || parent[j-1] != j || colCount[j-1] != colCount[j]+1
+                || numChildren[j] != 1) {
+            if (j > 0)
+                finish.push_back(j);
+            start.push_back(j);
+        }
+    }
+    if (n > 0)
+        finish.push_back(n);
+    const dim_t ns = start.size();
+    std::vector<index_t> supernode(n);
+    for (index_t s = 0; s < ns; ++s) {
+        for (index_t j = start[s]; j < finish[s]; ++j)
+            supernode[j] = s;
+    }
+    std::vector<index_t> snParent(ns, -1);
+    std::vector<std::vector<index_t> > snChildren(ns);
+    for (index_t s = 0; s < ns; ++s) {
+        const index_t p = parent[finish[s]-1];
+        if (p >= 0) {
+            snParent[s] = supernode[p];
+            snChildren[supernode[p]].push_back(s);
+        }
+    }
+
+    // nodes below the supernodes
+    std::vector<std::vector<index_t> > snRows(ns);
+    mark.assign(n, -1);
+    for (index_t s = 0; s < ns; ++s) {
+        std::vector<index_t>& rows = snRows[s];
+        for (index_t j = start[s]; j < finish[s]; ++j) {
+            for (index_t iptr = adj_ptr[j]; iptr < adj_ptr[j+1]; ++iptr) {
+                const index_t k = adj[iptr];
+                if (k >= finish[s] && mark[k] != s) {
+                    mark[k] = s;
+                    rows.push_back(k);
+                }
+            }
+        }
+        for (size_t c = 0; c < snChildren[s].size(); ++c) {
+            const std::vector<index_t>& childRows = snRows[snChildren[s][c]];
+            for (size_t r = 0; r < childRows.size(); ++r) {
+                const index_t k = childRows[r];
+                if (k >= finish[s] && mark[k] != s) {
+                    mark[k] = s;
+                    rows.push_back(k);
+                }
+            }
+        }
+        std::sort(rows.begin(), rows.end());
+    }
+
+    // relaxed amalgamation: a supernode is merged with its parent if it
+    // directly precedes the parent and not too many zeros are introduced
+    std::vector<index_t> mergedInto(ns, -1);
+    std::vector<double> zeros(ns, 0.);
+    for (index_t s = 0; s < ns; ++s) {
+        const index_t p = snParent[s];
+        if (p < 0 || finish[s] != start[p])
+            continue;
+        const double ncols_s = finish[s]-start[s];
+        const double ncols = finish[p]-start[s];
+        const double nrows_p = snRows[p].size();
+        const double newZeros = ncols_s*(ncols-ncols_s+nrows_p-snRows[s].size());
+        const double z = zeros[s]+zeros[p]+newZeros;
+        const double total = ncols*(ncols+1)/2 + ncols*nrows_p;
+        if (ncols <= 4 || (ncols <= 16 && z < 0.8*total)
+                || (ncols <= 48 && z < 0.1*total) || z < 0.05*total) {
+            start[p] = start[s];
+            zeros[p] = z;
+            mergedInto[s] = p;
+        }
+    }
+
+    // collect the remaining supernodes
+    std::vector<index_t> newId(ns, -1);
+    dim_t numSupernodes = 0;
+    for (index_t s = 0; s < ns; ++s) {
+        if (mergedInto[s] < 0)
+            newId[s] = numSupernodes++;
+    }
+    h->numSupernodes = numSupernodes;
+    h->first.resize(numSupernodes+1);
+    h->parent.resize(numSupernodes);
+    h->row_ptr.resize(numSupernodes+1);
+    h->row_ptr[0] = 0;
+    for (index_t s = 0; s < ns; ++s) {
+        if (mergedInto[s] >= 0)
+            continue;
+        const index_t k = newId[s];
+        h->first[k] = start[s];
+        index_t p = snParent[s];
+        while (p >= 0 && mergedInto[p] >= 0)
+            p = mergedInto[p];
+        h->parent[k] = (p < 0 ? -1 : newId[p]);
+        h->row_ptr[k+1] = h->row_ptr[k] + snRows[s].size();
+    }
+    h->first[numSupernodes] = n;
+    h->rows.resize(h->row_ptr[numSupernodes]);
+    for (index_t s = 0; s < ns; ++s) {
+        if (mergedInto[s] < 0) {
+            std::copy(snRows[s].begin(), snRows[s].end(),
+                      h->rows.begin() + h->row_ptr[newId[s]]);
+        }
+    }
+    for (index_t k = 0; k < numSupernodes; ++k) {
+        for (index_t j = h->first[k]; j < h->first[k+1]; ++j)
+            supernode[j] = k;
+    }
+
+    // children and positions of the rows in the front of the parent
+    h->child_ptr.assign(numSupernodes+1, 0);
+    for (index_t k = 0; k < numSupernodes; ++k) {
+        if (h->parent[k] >= 0)
+            h->child_ptr[h->parent[k]+1]++;
+    }
+    for (index_t k = 0; k < numSupernodes; ++k)
+        h->child_ptr[k+1] += h->child_ptr[k];
+    h->children.resize(h->child_ptr[numSupernodes]);
+    {
+        std::vector<index_t> pos(h->child_ptr.begin(), h->child_ptr.end()-1);
+        for (index_t k = 0; k < numSupernodes; ++k) {
+            if (h->parent[k] >= 0)
+                h->children[pos[h->parent[k]]++] = k;
+        }
+    }
+    h->parent_pos.resize(h->rows.size());
+    for (index_t k = 0; k < numSupernodes; ++k) {
+        const index_t p = h->parent[k];
+        for (index_t r = h->row_ptr[k]; r < h->row_ptr[k+1]; ++r) {
+            h->parent_pos[r] = (p < 0 ? -1 : getFrontPosition(h, p, h->rows[r]));
+        }
+    }
+
+    // entries of A by supernode. An entry belongs to the supernode of its
+    // smaller label. For LDL^T the upper triangle is not used.
+    h->entry_ptr.assign(numSupernodes+1, 0);
+    for (index_t i = 0; i < n; ++i) {
+        for (index_t iptr = pattern->ptr[i]; iptr < pattern->ptr[i+1]; ++iptr) {
+            const index_t ii = h->oldToNew[i];
+            const index_t jj = h->oldToNew[pattern->index[iptr]];
+            if (symmetric && ii < jj)
+                continue;
+            h->entry_ptr[supernode[std::min(ii, jj)]+1]++;
+        }
+    }
+    for (index_t k = 0; k < numSupernodes; ++k)
+        h->entry_ptr[k+1] += h->entry_ptr[k];
+    h->entries.resize(h->entry_ptr[numSupernodes]);
+    h->entry_pos.resize(2*h->entries.size());
+    {
+        std::vector<index_t> pos(h->entry_ptr.begin(), h->entry_ptr.end()-1);
+        for (index_t i = 0; i < n; ++i) {
+            for (index_t iptr = pattern->ptr[i]; iptr < pattern->ptr[i+1]; ++iptr) {
+                const index_t ii = h->oldToNew[i];
+                const index_t jj = h->oldToNew[pattern->index[iptr]];
+                if (symmetric && ii < jj)
+                    continue;
+                const index_t k = supernode[std::min(ii, jj)];
+                const index_t e = pos[k]++;
+                h->entries[e] = iptr;
+                h->entry_pos[2*e] = getFrontPosition(h, k, ii);
+                h->entry_pos[2*e+1] = getFrontPosition(h, k, jj);
+            }
+        }
+    }
+
+    // levels of the assembly tree: a supernode is processed after all its
+    // children
+    std::vector<index_t> level(numSupernodes, 0);
+    dim_t numLevels = (numSupernodes > 0 ? 1 : 0);
+    for (index_t k = 0; k < numSupernodes; ++k) {
+        const index_t p = h->parent[k];
+        if (p >= 0) {
+            level[p] = std::max(level[p], level[k]+1);
+            numLevels = std::max(numLevels, level[p]+1);
+        }
+    }
+    h->level_ptr.assign(numLevels+1, 0);
+    for (index_t k = 0; k < numSupernodes; ++k)
+        h->level_ptr[level[k]+1]++;
+    for (index_t l = 0; l < numLevels; ++l)
+        h->level_ptr[l+1] += h->level_ptr[l];
+    h->level_nodes.resize(numSupernodes);
+    {
+        std::vector<index_t> pos(h->level_ptr.begin(), h->level_ptr.end()-1);
+        for (index_t k = 0; k < numSupernodes; ++k)
+            h->level_nodes[pos[level[k]]++] = k;
+    }
+
+    // storage of the factors: the columns of the front belonging to the
+    // supernode and for LU the rows of the supernode right of them
+    h->factor_ptr.resize(numSupernodes+1);
+    h->factor_ptr[0] = 0;
+    for (index_t k = 0; k < numSupernodes; ++k) {
+        const size_t nc = (h->first[k+1]-h->first[k])*nb;
+        const size_t m = (h->row_ptr[k+1]-h->row_ptr[k])*nb;
+        h->factor_ptr[k+1] = h->factor_ptr[k] + (nc+m)*nc + (symmetric ? 0 : nc*m);
+    }
+    return h;
+}
+
+/// LU factorization of the first nc columns of the front a (F x F, column
+/// major) with row interchanges within the first nc rows. The remaining
+/// block is replaced by its Schur complement.
+dim_t factorizeFrontLU(double* a, dim_t F, dim_t nc, index_t* piv,
+                       double tiny, bool parallel)
+{
+    dim_t numPerturbed = 0;
+    for (dim_t kb = 0; kb < nc; kb += PASO_SUPERNODAL_PANEL_SIZE) {
+        const dim_t ke = std::min(kb+PASO_SUPERNODAL_PANEL_SIZE, nc);
+        for (dim_t k = kb; k < ke; ++k) {
+            double* col_k = &a[((size_t)F)*k];
+            for (dim_t k2 = kb; k2 < k; ++k2) {
+                const double* col_k2 = &a[((size_t)F)*k2];
+                const double s = col_k[k2];
+                if (s != 0.) {
+                    for (dim_t i = k2+1; i < F; ++i)
+                        col_k[i] -= col_k2[i]*s;
+                }
+            }
+            dim_t p = k;
+            for (dim_t i = k+1; i < nc; ++i) {
+                if (std::abs(col_k[i]) > std::abs(col_k[p]))
+                    p = i;
+            }
+            piv[k] = p;
+            if (p != k) {
+                for (dim_t j = 0; j < F; ++j)
+                    std::swap(a[k+((size_t)F)*j], a[p+((size_t)F)*j]);
+            }
+            if (std::abs(col_k[k]) <= tiny) {
+                col_k[k] = (col_k[k] < 0 ? -tiny : tiny);
+                numPerturbed++;
+            }
+            const double inv_pivot = 1./col_k[k];
+            for (dim_t i = k+1; i < F; ++i)
+                col_k[i] *= inv_pivot;
+        }
+#pragma omp parallel for if(parallel)
+        for (index_t j = ke; j < F; ++j) {
+            double* col_j = &a[((size_t)F)*j];
+            for (dim_t k = kb; k < ke; ++k) {
+                const double s = col_j[k];
+                if (s != 0.) {
+                    const double* col_k = &a[((size_t)F)*k];
+                    for (dim_t i = k+1; i < F; ++i)
+                        col_j[i] -= col_k[i]*s;
+                }
+            }
+        }
+    }
+    return numPerturbed;
+}
+
+/// LDL^T factorization of the first nc columns of the lower triangle of the
+/// front a (F x F, column major). D is stored on the main diagonal.
+dim_t factorizeFrontLDLT(double* a, dim_t F, dim_t nc, double tiny,
+                         bool parallel)
+{
+    dim_t numPerturbed = 0;
+    for (dim_t kb = 0; kb < nc; kb += PASO_SUPERNODAL_PANEL_SIZE) {
+        const dim_t ke = std::min(kb+PASO_SUPERNODAL_PANEL_SIZE, nc);
+        for (dim_t k = kb; k < ke; ++k) {
+            double* col_k = &a[((size_t)F)*k];
+            for (dim_t k2 = kb; k2 < k; ++k2) {
+                const double* col_k2 = &a[((size_t)F)*k2];
+                const double s = col_k2[k]*col_k2[k2];
+                if (s != 0.) {
+                    for (dim_t i = k; i < F; ++i)
+                        col_k[i] -= col_k2[i]*s;
+                }
+            }
+            if (std::abs(col_k[k]) <= tiny) {
+                col_k[k] = (col_k[k] < 0 ? -tiny : tiny);
+                numPerturbed++;
+            }
+            const double inv_pivot = 1./col_k[k];
+            for (dim_t i = k+1; i < F; ++i)
+                col_k[i] *= inv_pivot;
+        }
+#pragma omp parallel for schedule(dynamic, 8) if(parallel)
+        for (index_t j = ke; j < F; ++j) {
+            double* col_j = &a[((size_t)F)*j];
+            for (dim_t k = kb; k < ke; ++k) {
+                const double* col_k = &a[((size_t)F)*k];
+                const double s = col_k[j]*col_k[k];
+                if (s != 0.) {
+                    for (dim_t i = j; i < F; ++i)
+                        col_j[i] -= col_k[i]*s;
+                }
+            }
+        }
+    }
+    return numPerturbed;
+}
+
+/// assembles and factorizes the front of supernode s. The update matrices
+/// of the children are released and the update matrix of s is returned in
+/// contrib[s].
+dim_t factorizeSupernode(const Supernodal_Handler* h, const SparseMatrix* A,
+                         index_t s, std::vector<double*>& contrib,
+                         double tiny, bool parallel)
+{
+    const dim_t nb = h->block_size;
+    const bool symmetric = h->symmetric;
+    const bool diagonalBlocks = (A->type & MATRIX_FORMAT_DIAGONAL_BLOCK);
+    const dim_t nc = (h->first[s+1]-h->first[s])*nb;
+    const dim_t m = (h->row_ptr[s+1]-h->row_ptr[s])*nb;
+    const dim_t F = nc+m;
+    double* front = new double[((size_t)F)*F];
+#pragma omp parallel for if(parallel)
+    for (index_t j = 0; j < F; ++j) {
+        for (dim_t i = 0; i < F; ++i)
+            front[i+((size_t)F)*j] = 0.;
+    }
+
+    // matrix entries
+    for (index_t e = h->entry_ptr[s]; e < h->entry_ptr[s+1]; ++e) {
+        const index_t iptr = h->entries[e];
+        const index_t R0 = h->entry_pos[2*e]*nb;
+        const index_t C0 = h->entry_pos[2*e+1]*nb;
+        if (diagonalBlocks) {
+            for (dim_t r = 0; r < nb; ++r)
+                front[R0+r+((size_t)F)*(C0+r)] += A->val[iptr*nb+r];
+        } else {
+            const double* block = &A->val[iptr*nb*nb];
+            for (dim_t c = 0; c < nb; ++c) {
+                for (dim_t r = 0; r < nb; ++r) {
+                    if (!symmetric || R0+r >= C0+c)
+                        front[R0+r+((size_t)F)*(C0+c)] += block[r+nb*c];
+                }
+            }
+        }
+    }
+    // update matrices of the children
+    for (index_t ic = h->child_ptr[s]; ic < h->child_ptr[s+1]; ++ic) {
+        const index_t c = h->children[ic];
+        const dim_t mc = (h->row_ptr[c+1]-h->row_ptr[c])*nb;
+        const index_t* pos = &h->parent_pos[h->row_ptr[c]];
+        const double* U = contrib[c];
+        for (index_t jc = 0; jc < mc; ++jc) {
+            const index_t C = pos[jc/nb]*nb + jc%nb;
+            for (index_t ir = (symmetric ? jc : 0); ir < mc; ++ir) {
+                const index_t R = pos[ir/nb]*nb + ir%nb;
+                front[R+((size_t)F)*C] += U[ir+((size_t)mc)*jc];
+            }
+        }
+        delete[] contrib[c];
+        contrib[c] = NULL;
+    }
+
+    dim_t numPerturbed;
+    if (symmetric) {
+        numPerturbed = factorizeFrontLDLT(front, F, nc, tiny, parallel);
+    } else {
+        numPerturbed = factorizeFrontLU(front, F, nc,
+                                        &h->pivot[h->first[s]*nb], tiny,
+                                        parallel);
+    }
+
+    double* L = &h->factor[h->factor_ptr[s]];
+    std::copy(front, front+((size_t)F)*nc, L);
+    if (!symmetric) {
+        double* U12 = L + ((size_t)F)*nc;
+        for (index_t j = 0; j < m; ++j) {
+            for (index_t i = 0; i < nc; ++i)
+                U12[i+((size_t)nc)*j] = front[i+((size_t)F)*(nc+j)];
+        }
+    }
+    if (m > 0) {
+        double* U = new double[((size_t)m)*m];
+        for (index_t j = 0; j < m; ++j) {
+            for (index_t i = (symmetric ? j : 0); i < m; ++i)
+                U[i+((size_t)m)*j] = front[nc+i+((size_t)F)*(nc+j)];
+        }
+        contrib[s] = U;
+    }
+    delete[] front;
+    return numPerturbed;
+}
+
+/// solves with the factorization, x is in the new labels
+void solveFactorized(const Supernodal_Handler* h, double* x)
+{
+    const dim_t nb = h->block_size;
+    const bool symmetric = h->symmetric;
+
+    // forward substitution
+    for (index_t s = 0; s < h->numSupernodes; ++s) {
+        const index_t f = h->first[s]*nb;
+        const dim_t nc = (h->first[s+1]-h->first[s])*nb;
+        const dim_t m = (h->row_ptr[s+1]-h->row_ptr[s])*nb;
+        const dim_t F = nc+m;
+        const index_t* rows = &h->rows[h->row_ptr[s]];
+        const double* L = &h->factor[h->factor_ptr[s]];
+        if (!symmetric) {
+            for (dim_t k = 0; k < nc; ++k) {
+                const index_t p = h->pivot[f+k];
+                if (p != k)
+                    std::swap(x[f+k], x[f+p]);
+            }
+        }
+        for (dim_t k = 0; k < nc; ++k) {
+            const double xk = x[f+k];
+            if (xk != 0.) {
+                const double* col = &L[((size_t)F)*k];
+                for (dim_t i = k+1; i < nc; ++i)
+                    x[f+i] -= col[i]*xk;
+                for (dim_t i = 0; i < m; ++i)
+                    x[rows[i/nb]*nb+i%nb] -= col[nc+i]*xk;
+            }
+        }
+        if (symmetric) {
+            for (dim_t k = 0; k < nc; ++k)
+                x[f+k] /= L[k+((size_t)F)*k];
+        }
+    }
+
+    // backward substitution
+    for (index_t s = h->numSupernodes-1; s >= 0; --s) {
+        const index_t f = h->first[s]*nb;
+        const dim_t nc = (h->first[s+1]-h->first[s])*nb;
+        const dim_t m = (h->row_ptr[s+1]-h->row_ptr[s])*nb;
+        const dim_t F = nc+m;
+        const index_t* rows = &h->rows[h->row_ptr[s]];
+        const double* L = &h->factor[h->factor_ptr[s]];
+        if (symmetric) {
+            for (dim_t k = nc-1; k >= 0; --k) {
+                const double* col = &L[((size_t)F)*k];
+                double sum = x[f+k];
+                for (dim_t i = k+1; i < nc; ++i)
+                    sum -= col[i]*x[f+i];
+                for (dim_t i = 0; i < m; ++i)
+                    sum -= col[nc+i]*x[rows[i/nb]*nb+i%nb];
+                x[f+k] = sum;
+            }
+        } else {
+            const double* U12 = L + ((size_t)F)*nc;
+            for (dim_t j = 0; j < m; ++j) {
+                const double xj = x[rows[j/nb]*nb+j%nb];
+                if (xj != 0.) {
+                    for (dim_t i = 0; i < nc; ++i)
+                        x[f+i] -= U12[i+((size_t)nc)*j]*xj;
+                }
+            }
+            for (dim_t k = nc-1; k >= 0; --k) {
+                const double* col = &L[((size_t)F)*k];
+                x[f+k] /= col[k];
+                const double xk = x[f+k];
+                for (dim_t i = 0; i < k; ++i)
+                    x[f+i] -= col[i]*xk;
+            }
+        }
+    }
+}
+
+} // anonymous namespace
+
+/// frees any data of the supernodal solver from the matrix
+void Supernodal_free(SparseMatrix* A)
+{
+    if (A && A->solver_p && A->solver_package == PASO_DIRECT) {
+        Supernodal_freeNumeric(A);
+        delete reinterpret_cast<Supernodal_Handler*>(A->solver_p);
+        A->solver_p = NULL;
+    }
+}
+
+/// frees the numeric factorization only. The ordering and the symbolic
+/// factorization only depend on the pattern and are kept.
+void Supernodal_freeNumeric(SparseMatrix* A)
+{
+    if (A && A->solver_p && A->solver_package == PASO_DIRECT) {
+        Supernodal_Handler* h = reinterpret_cast<Supernodal_Handler*>(A->solver_p);
+        delete[] h->factor;
+        delete[] h->pivot;
+        h->factor = NULL;
+        h->pivot = NULL;
+    }
+}
+
+/// computes the factorization of A unless it is already available
+void Supernodal_factorize(SparseMatrix_ptr A, bool symmetric, bool verbose)
+{
+    if (A->type & (MATRIX_FORMAT_CSC | MATRIX_FORMAT_OFFSET1)) {
+        throw PasoException("Paso: the supernodal direct solver requires CSR format with index offset 0.");
+    }
+    if (A->numRows != A->numCols || A->row_block_size != A->col_block_size) {
+        throw PasoException("Paso: the supernodal direct solver requires a square matrix.");
+    }
+    Supernodal_Handler* h = reinterpret_cast<Supernodal_Handler*>(A->solver_p);
+    // a symbolic factorization for another pattern cannot be reused
+    if (h != NULL && (h->pattern != A->pattern || h->symmetric != symmetric)) {
+        Supernodal_free(A.get());
+        h = NULL;
+    }
+    if (h == NULL) {
+        const double time0 = escript::gettime();
+        h = analyse(A, symmetric);
+        A->solver_p = (void*) h;
+        A->solver_package = PASO_DIRECT;
+        if (verbose) {
+            std::cout << "Supernodal: symbolic factorization completed (time = "
+                << escript::gettime()-time0 << ", " << h->numSupernodes
+                << " supernodes, " << h->factor_ptr[h->numSupernodes]
+                << " entries in the factors)." << std::endl;
+        }
+    }
+
+    if (h->factor == NULL) {
+        const double time0 = escript::gettime();
+        const dim_t numSupernodes = h->numSupernodes;
+        const size_t len = ((size_t)A->pattern->len)*A->block_size;
+        double norm = 0.;
+#pragma omp parallel
+        {
+            double norm_loc = 0.;
+#pragma omp for
+            for (index_t i = 0; i < len; ++i)
+                norm_loc = std::max(norm_loc, std::abs(A->val[i]));
+#pragma omp critical
+            {
+                norm = std::max(norm, norm_loc);
+            }
+        }
+        const double tiny = std::sqrt(escript::DataTypes::real_t_eps()) *
+                                (norm > 0. ? norm : 1.);
+        h->factor = new double[h->factor_ptr[numSupernodes]];
+        if (!symmetric)
+            h->pivot = new index_t[h->n*h->block_size];
+        h->numPerturbedPivots = 0;
+
+        std::vector<double*> contrib(numSupernodes, (double*)NULL);
+        const int numThreads = omp_get_max_threads();
+        dim_t numPerturbed = 0;
+        for (index_t l = 0; l < (index_t)h->level_ptr.size()-1; ++l) {
+            const index_t begin = h->level_ptr[l];
+            const index_t end = h->level_ptr[l+1];
+            if (end-begin >= numThreads) {
+                // enough independent supernodes for all threads
+#pragma omp parallel
+                {
+                    dim_t perturbed_loc = 0;
+#pragma omp for schedule(dynamic)
+                    for (index_t k = begin; k < end; ++k) {
+                        perturbed_loc += factorizeSupernode(h, A.get(),
+                                h->level_nodes[k], contrib, tiny, false);
+                    }
+#pragma omp critical
+                    {
+                        numPerturbed += perturbed_loc;
+                    }
+                }
+            } else {
+                // the dense operations in the fronts are parallelized
+                for (index_t k = begin; k < end; ++k) {
+                    numPerturbed += factorizeSupernode(h, A.get(),
+                                h->level_nodes[k], contrib, tiny, true);
+                }
+            }
+        }
+        h->numPerturbedPivots = numPerturbed;
+        if (verbose) {
+            std::cout << "Supernodal: " << (symmetric ? "LDL^T" : "LU")
+                << " factorization completed (time = "
+                << escript::gettime()-time0 << ", " << numPerturbed
+                << " perturbed pivots)." << std::endl;
+        }
+    }
+}
+
+/// solves A*out=in. The factorization of A is computed if required.
+void Supernodal_solve(SparseMatrix_ptr A, double* out, double* in,
+                      bool symmetric, dim_t numRefinements, bool verbose)
+{
+    Supernodal_factorize(A, symmetric, verbose);
+    const Supernodal_Handler* h = reinterpret_cast<Supernodal_Handler*>(A->solver_p);
+    const dim_t n = h->n;
+    const dim_t nb = h->block_size;
+    const double time0 = escript::gettime();
+    double* x = new double[n*nb];
+
+#pragma omp parallel for
+    for (index_t i = 0; i < n; ++i) {
+        const index_t ii = h->oldToNew[i];
+        for (dim_t r = 0; r < nb; ++r)
+            x[ii*nb+r] = in[i*nb+r];
+    }
+    solveFactorized(h, x);
+#pragma omp parallel for
+    for (index_t i = 0; i < n; ++i) {
+        const index_t ii = h->oldToNew[i];
+        for (dim_t r = 0; r < nb; ++r)
+            out[i*nb+r] = x[ii*nb+r];
+    }
+
+    // iterative refinement reduces the error from perturbed pivots
+    if (numRefinements > 0) {
+        double* res = new double[n*nb];
+        for (dim_t step = 0; step < numRefinements; ++step) {
+            util::copy(n*nb, res, in);
+            SparseMatrix_MatrixMultiVector_CSR_OFFSET0(-1., A, 1, out, 1., res);
+#pragma omp parallel for
+            for (index_t i = 0; i < n; ++i) {
+                const index_t ii = h->oldToNew[i];
+                for (dim_t r = 0; r < nb; ++r)
+                    x[ii*nb+r] = res[i*nb+r];
+            }
+            solveFactorized(h, x);
+#pragma omp parallel for
+            for (index_t i = 0; i < n; ++i) {
+                const index_t ii = h->oldToNew[i];
+                for (dim_t r = 0; r < nb; ++r)
+                    out[i*nb+r] += x[ii*nb+r];
+            }
+        }
+        delete[] res;
+    }
+    delete[] x;
+    if (verbose) {
+        std::cout << "Supernodal: forward/backward substitution completed "
+            "(time = " << escript::gettime()-time0 << ")." << std::endl;
+    }
+}
+
+/// the matrix merged on rank 0 for Supernodal_solveMerged
+struct Supernodal_Merged
+{
+    /// merged matrix (rank 0 only)
+    SparseMatrix_ptr A;
+    /// set if the values of the distributed matrix have changed
+    bool changed;
+};
+
+void Supernodal_solveMerged(SystemMatrix_ptr A, double* out, double* in,
+                            bool symmetric, dim_t numRefinements, bool verbose)
+{
+#ifdef ESYS_MPI
+    Supernodal_Merged* m = reinterpret_cast<Supernodal_Merged*>(A->solver_p);
+    if (m == NULL) {
+        m = new Supernodal_Merged;
+        m->A = A->mergeSystemMatrix();
+        m->changed = false;
+        A->solver_p = (void*) m;
+    } else if (m->changed) {
+        SparseMatrix_ptr merged(A->mergeSystemMatrix());
+        if (m->A) {
+            // the pattern is normally unchanged so only the values are
+            // replaced and the symbolic factorization is kept
+            const Pattern& p = *m->A->pattern;
+            const Pattern& q = *merged->pattern;
+            if (p.numOutput == q.numOutput && p.len == q.len &&
+                    !memcmp(p.ptr, q.ptr, (p.numOutput+1)*sizeof(index_t)) &&
+                    !memcmp(p.index, q.index, p.len*sizeof(index_t))) {
+                util::copy(p.len*m->A->block_size, m->A->val, merged->val);
+            } else {
+                m->A = merged;
+            }
+        }
+        m->changed = false;
+    }
+    const int size = A->mpi_info->size;
+    const int rank = A->mpi_info->rank;
+    const dim_t nb = A->row_block_size;
+    std::vector<int> counts(size), offsets(size);
+    for (int p = 0; p < size; ++p) {
+        offsets[p] = A->row_distribution->first_component[p]*nb;
+        counts[p] = A->row_distribution->first_component[p+1]*nb - offsets[p];
+    }
+    const dim_t n = (rank == 0 ? A->getGlobalNumRows()*nb : 0);
+    // the receive and send buffers are only significant on rank 0
+    std::vector<double> b(n), x(n);
+    double* b_p = (n > 0 ? &b[0] : NULL);
+    double* x_p = (n > 0 ? &x[0] : NULL);
+    MPI_Gatherv(in, counts[rank], MPI_DOUBLE, b_p, &counts[0],
+                &offsets[0], MPI_DOUBLE, 0, A->mpi_info->comm);
+    if (rank == 0) {
+        Supernodal_solve(m->A, x_p, b_p, symmetric, numRefinements, verbose);
+    }
+    MPI_Scatterv(x_p, &counts[0], &offsets[0], MPI_DOUBLE, out,
+                 counts[rank], MPI_DOUBLE, 0, A->mpi_info->comm);
+#else
+    throw PasoException("Supernodal_solveMerged: MPI is not available.");
+#endif
+}
+
+void Supernodal_freeMergedNumeric(SystemMatrix* A)
+{
+    if (A && A->solver_p && A->solver_package == PASO_DIRECT) {
+        Supernodal_Merged* m = reinterpret_cast<Supernodal_Merged*>(A->solver_p);
+        if (m->A)
+            Supernodal_freeNumeric(m->A.get());
+        m->changed = true;
+    }
+}
+
+void Supernodal_freeMerged(SystemMatrix* A)
+{
+    if (A && A->solver_p && A->solver_package == PASO_DIRECT) {
+        delete reinterpret_cast<Supernodal_Merged*>(A->solver_p);
+        A->solver_p = NULL;
+    }
+}
+
+} // namespace paso
+
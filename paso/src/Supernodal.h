@@ -0,0 +1,101 @@
+
+/*****************************************************************************
+*
+* Copyright (c) 2003-2018 by The University of Queensland
+* http://www.uq.edu.au
+*
+* Primary Business: Queensland, Australia
+* Licensed under the Apache License, version 2.0
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Development until 2012 by Earth Systems Science Computational Center (ESSCC)
+* Development 2012-2013 by School of Earth Sciences
+* Development from 2014 by Centre for Geoscience Computing (GeoComp)
+*
+*****************************************************************************/
+
+
+/****************************************************************************/
+
+/* Paso: native supernodal sparse direct solver */
+
+/****************************************************************************/
+
+#ifndef __PASO_SUPERNODAL_H__
+#define __PASO_SUPERNODAL_H__
+
+#include "SparseMatrix.h"
+#include "SystemMatrix.h"
+
+#include <vector>
+
+namespace paso {
+
+/// multifrontal LU (or LDL^T) factorization of a SparseMatrix in CSR format
+/// with index offset 0. The nodes (block rows) are ordered by nested
+/// dissection and grouped into supernodes which are factorized as dense
+/// fronts. Supernodes on the same level of the assembly tree are
+/// factorized in parallel.
+struct Supernodal_Handler
+{
+    /// the pattern the symbolic factorization was computed for
+    const_Pattern_ptr pattern;
+    /// LDL^T factorization if set, LU factorization with partial pivoting
+    /// within the supernodes otherwise
+    bool symmetric;
+    /// number of nodes and block size
+    dim_t n;
+    dim_t block_size;
+    /// new label of a node and node of a new label
+    std::vector<index_t> oldToNew;
+    std::vector<index_t> newToOld;
+    /// supernode s holds the nodes first[s] to first[s+1]-1 (new labels)
+    dim_t numSupernodes;
+    std::vector<index_t> first;
+    std::vector<index_t> parent;
+    std::vector<index_t> child_ptr;
+    std::vector<index_t> children;
+    /// nodes of the front of supernode s below its own nodes (sorted)
+    std::vector<index_t> row_ptr;
+    std::vector<index_t> rows;
+    /// position of these nodes in the front of the parent
+    std::vector<index_t> parent_pos;
+    /// entries of the matrix assembled into supernode s and their node
+    /// positions (row, column) in its front
+    std::vector<index_t> entry_ptr;
+    std::vector<index_t> entries;
+    std::vector<index_t> entry_pos;
+    /// supernodes by level of the assembly tree, leaves first
+    std::vector<index_t> level_ptr;
+    std::vector<index_t> level_nodes;
+    /// offsets of the factors of the supernodes
+    std::vector<size_t> factor_ptr;
+    /// numeric factorization (NULL if not available)
+    double* factor;
+    /// local row interchanges within the supernodes (LU only)
+    index_t* pivot;
+    /// number of pivots which have been perturbed as they were too small
+    dim_t numPerturbedPivots;
+};
+
+void Supernodal_free(SparseMatrix* A);
+void Supernodal_freeNumeric(SparseMatrix* A);
+void Supernodal_factorize(SparseMatrix_ptr A, bool symmetric, bool verbose);
+void Supernodal_solve(SparseMatrix_ptr A, double* out, double* in,
+                      bool symmetric, dim_t numRefinements, bool verbose);
+
+/// solves with the matrix A distributed over several ranks. A is merged on
+/// rank 0 which factorizes and solves. The merged matrix is kept with A
+/// and its symbolic factorization is reused when the values of A change.
+void Supernodal_solveMerged(SystemMatrix_ptr A, double* out, double* in,
+                            bool symmetric, dim_t numRefinements, bool verbose);
+/// frees the factorization of the merged matrix, which is updated on the
+/// next solve as the values of A have changed
+void Supernodal_freeMergedNumeric(SystemMatrix* A);
+/// frees the merged matrix
+void Supernodal_freeMerged(SystemMatrix* A);
+
+} // namespace paso
+
+#endif // __PASO_SUPERNODAL_H__
+
@@ -26,10 +26,12 @@
 /****************************************************************************/
 
 #include "SystemMatrix.h"
+#include "BlockOps.h"
 #include "Options.h"
 #include "PasoException.h"
 #include "Preconditioner.h"
 #include "Solver.h"
+#include "Supernodal.h"
 
 #include <escript/Data.h>
 
@@ -61,7 +63,9 @@ SystemMatrix::SystemMatrix(SystemMatrixType ntype,
     balance_vector(NULL),
     global_id(NULL),
     solver_package(PASO_PASO),
-    solver_p(NULL)
+    solver_p(NULL),
+    recycled_subspace(NULL),
+    reordered_system(NULL)
 {
     if (patternIsUnrolled) {
         if ((ntype & MATRIX_FORMAT_OFFSET1) != (npattern->type & MATRIX_FORMAT_OFFSET1)) {
@@ -73,8 +77,8 @@ SystemMatrix::SystemMatrix(SystemMatrixType ntype,
           // we don't like non-square blocks
         = (rowBlockSize != colBlockSize)
 #ifndef ESYS_HAVE_LAPACK
-          // or any block size bigger than 3
-          || (colBlockSize > 3)
+          // or any block size without a templated kernel
+          || (colBlockSize > PASO_BLOCKOPS_MAX_N)
 #endif
           // or if block size one requested and the block size is not 1
           || ((ntype & MATRIX_FORMAT_BLK1) && colBlockSize > 1)
@@ -126,14 +130,14 @@ SystemMatrix::SystemMatrix(SystemMatrixType ntype,
     } else {
         block_size = row_block_size*col_block_size;
     }
-    col_coupler.reset(new Coupler<real_t>(pattern->col_connector, col_block_size, mpi_info));
-    row_coupler.reset(new Coupler<real_t>(pattern->row_connector, row_block_size, mpi_info));
+    col_coupler.reset(new Coupler<real_t>(pattern->col_connector, col_block_size, mpi_info, true));
+    row_coupler.reset(new Coupler<real_t>(pattern->row_connector, row_block_size, mpi_info, true));
     mainBlock.reset(new SparseMatrix(type, pattern->mainPattern, row_block_size, col_block_size, true));
     col_coupleBlock.reset(new SparseMatrix(type, pattern->col_couplePattern, row_block_size, col_block_size, true));
     row_coupleBlock.reset(new SparseMatrix(type, pattern->row_couplePattern, row_block_size, col_block_size, true));
     const dim_t n_norm = std::max(mainBlock->numCols*col_block_size, mainBlock->numRows*row_block_size);
     balance_vector = new double[n_norm];
-#pragma omp parallel for
+#pragma omp parallel for schedule(static)
     for (dim_t i=0; i<n_norm; ++i)
         balance_vector[i] = 1.;
 }
@@ -142,6 +146,10 @@ SystemMatrix::SystemMatrix(SystemMatrixType ntype,
 SystemMatrix::~SystemMatrix()
 {
     solve_free(this);
+    // solve_free keeps the matrix merged for the direct solver
+    Supernodal_freeMerged(this);
+    RecycledSubspace_free(this);
+    ReorderedSystem_free(this);
     delete[] balance_vector;
     delete[] global_id;
 }
@@ -168,6 +176,44 @@ void SystemMatrix::freePreconditioner()
     solver_p = NULL;
 }
 
+void SystemMatrix::setSlicedEllpack()
+{
+    if (type & (MATRIX_FORMAT_CSC | MATRIX_FORMAT_OFFSET1)) {
+        throw PasoException("SystemMatrix::setSlicedEllpack: CSR format with index offset 0 is required.");
+    }
+    // the structure is kept between calls, only the values are refreshed
+    if (mainBlock->sell && mainBlock->sell->pattern == mainBlock->pattern) {
+        mainBlock->sell->updateValues(mainBlock.get());
+    } else {
+        delete mainBlock->sell;
+        mainBlock->sell = new SparseMatrix_SELL(mainBlock.get());
+    }
+    if (col_coupleBlock->pattern->ptr != NULL) {
+        if (col_coupleBlock->sell && col_coupleBlock->sell->pattern == col_coupleBlock->pattern) {
+            col_coupleBlock->sell->updateValues(col_coupleBlock.get());
+        } else {
+            delete col_coupleBlock->sell;
+            col_coupleBlock->sell = new SparseMatrix_SELL(col_coupleBlock.get());
+        }
+    }
+}
+
+void SystemMatrix::invalidateSlicedEllpack()
+{
+    if (mainBlock->sell)
+        mainBlock->sell->upToDate = false;
+    if (col_coupleBlock->sell)
+        col_coupleBlock->sell->upToDate = false;
+}
+
+void SystemMatrix::freeSlicedEllpack()
+{
+    delete mainBlock->sell;
+    mainBlock->sell = NULL;
+    delete col_coupleBlock->sell;
+    col_coupleBlock->sell = NULL;
+}
+
 double SystemMatrix::getGlobalSize() const
 {
     double global_size=0;
@@ -338,6 +384,40 @@ void SystemMatrix::setToSolution(escript::Data& out, escript::Data& in,
     paso_options.updateEscriptDiagnostics(options);
 }
 
+void SystemMatrix::setToSolutions(std::vector<escript::Data>& out,
+                                  std::vector<escript::Data>& in,
+                                  boost::python::object& options) const
+{
+    const dim_t numRHS = in.size();
+    for (dim_t i = 0; i < numRHS; i++) {
+        if (in[i].isComplex() || out[i].isComplex()) {
+            throw PasoException("SystemMatrix::setToSolutions: complex arguments not supported.");
+        } else if (out[i].getDataPointSize() != getColumnBlockSize()) {
+            throw PasoException("solve: column block size does not match the number of components of solution.");
+        } else if (in[i].getDataPointSize() != getRowBlockSize()) {
+            throw PasoException("solve: row block size does not match the number of components of  right hand side.");
+        } else if (out[i].getFunctionSpace() != getColumnFunctionSpace()) {
+            throw PasoException("solve: column function space and function space of solution don't match.");
+        } else if (in[i].getFunctionSpace() != getRowFunctionSpace()) {
+            throw PasoException("solve: row function space and function space of right hand side don't match.");
+        }
+    }
+    options.attr("resetDiagnostics")();
+    Options paso_options(options);
+    std::vector<double*> out_dp(numRHS);
+    std::vector<double*> in_dp(numRHS);
+    for (dim_t i = 0; i < numRHS; i++) {
+        out[i].expand();
+        in[i].expand();
+        out[i].requireWrite();
+        in[i].requireWrite();
+        out_dp[i] = out[i].getExpandedVectorReference(static_cast<escript::DataTypes::real_t>(0)).data();
+        in_dp[i] = in[i].getExpandedVectorReference(static_cast<escript::DataTypes::real_t>(0)).data();
+    }
+    solveMultiple(&out_dp[0], &in_dp[0], numRHS, &paso_options);
+    paso_options.updateEscriptDiagnostics(options);
+}
+
 void SystemMatrix::ypAx(escript::Data& y, escript::Data& x) const 
 {
     if (x.isComplex() || y.isComplex())
@@ -445,13 +525,13 @@ void SystemMatrix::applyBalanceInPlace(double* x, const bool RHS) const
     if (is_balanced) {
         if (RHS) {
             const dim_t nrow = getTotalNumRows();
-#pragma omp parallel for
+#pragma omp parallel for schedule(static)
             for (index_t i=0; i<nrow; ++i) {
                 x[i] *= balance_vector[i];
             }
         } else {
             const dim_t ncol = getTotalNumCols();
-#pragma omp parallel for
+#pragma omp parallel for schedule(static)
             for (index_t i=0; i<ncol; ++i) {
                 x[i] *= balance_vector[i];
             }
@@ -464,13 +544,13 @@ void SystemMatrix::applyBalance(double* x_out, const double* x, bool RHS) const
     if (is_balanced) {
         if (RHS) {
             const dim_t nrow = getTotalNumRows();
-#pragma omp parallel for
+#pragma omp parallel for schedule(static)
             for (index_t i=0; i<nrow; ++i) {
                 x_out[i] = x[i] * balance_vector[i];
             }
         } else {
             const dim_t ncol = getTotalNumCols();
-#pragma omp parallel for
+#pragma omp parallel for schedule(static)
             for (index_t i=0; i<ncol; ++i) {
                 x_out[i] = x[i] * balance_vector[i];
             }
@@ -37,6 +37,8 @@
 namespace paso {
 
 struct Options;
+struct RecycledSubspace;
+struct ReorderedSystem;
 class SystemMatrix;
 typedef boost::shared_ptr<SystemMatrix> SystemMatrix_ptr;
 typedef boost::shared_ptr<const SystemMatrix> const_SystemMatrix_ptr;
@@ -149,6 +151,19 @@ public:
 
     void freePreconditioner();
 
+    /// creates the sliced ELLPACK copies of the main and column couple blocks
+    /// which are then used by MatrixVector_CSR_OFFSET0. The copies are kept
+    /// with the matrix so further calls only refresh the values unless the
+    /// pattern of a block has been replaced.
+    void setSlicedEllpack();
+
+    /// marks the sliced ELLPACK copies as out of date so that the CSR values
+    /// are used until setSlicedEllpack() is called again. This needs to be
+    /// called before the matrix values are changed.
+    void invalidateSlicedEllpack();
+
+    void freeSlicedEllpack();
+
     index_t* borrowMainDiagonalPointer() const;
 
     inline void startCollect(const double* in) const
@@ -298,6 +313,14 @@ public:
     void MatrixVector_CSR_OFFSET0(double alpha, const double* in, double beta,
                                   double* out) const;
 
+    /// out = alpha*A*in + beta*out for numVec vectors stored interleaved,
+    /// i.e. entry i of vector j is at position i*numVec+j. The coupler
+    /// needs to have block size col_block_size*numVec.
+    void MatrixMultiVector_CSR_OFFSET0(double alpha, dim_t numVec,
+                                       const double* in, double beta,
+                                       double* out,
+                                       Coupler_ptr<real_t> coupler) const;
+
     static SystemMatrix_ptr loadMM_toCSR(const char* filename);
 
     static SystemMatrix_ptr loadMM_toCSC(const char* filename);
@@ -350,13 +373,29 @@ public:
     /// pointer to data needed by a solver
     void* solver_p;
 
+    /// approximate invariant subspace used by the recycling Krylov solvers.
+    /// Unlike solver_p it is kept when the matrix values are reset so that
+    /// it can be reused for the next system of a sequence.
+    RecycledSubspace* recycled_subspace;
+
+    /// copy of the matrix with locality improving labels of the local
+    /// unknowns used by the iterative solvers (NULL if not used)
+    ReorderedSystem* reordered_system;
+
 private:
     virtual void setToSolution(escript::Data& out, escript::Data& in,
                                boost::python::object& options) const;
 
     virtual void ypAx(escript::Data& y, escript::Data& x) const;
 
+    virtual void setToSolutions(std::vector<escript::Data>& out,
+                                std::vector<escript::Data>& in,
+                                boost::python::object& options) const;
+
     void solve(double* out, double* in, Options* options) const;
+
+    void solveMultiple(double** out, double** in, dim_t numRHS,
+                       Options* options) const;
 };
 
 
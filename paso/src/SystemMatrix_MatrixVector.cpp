@@ -66,7 +66,9 @@ void SystemMatrix::MatrixVector_CSR_OFFSET0(double alpha, const double* in,
     // start exchange
     startCollect(in);
     // process main block
-    if (type & MATRIX_FORMAT_DIAGONAL_BLOCK) {
+    if (mainBlock->sell && mainBlock->sell->upToDate) {
+        SparseMatrix_MatrixVector_SELL(alpha, mainBlock, in, beta, out);
+    } else if (type & MATRIX_FORMAT_DIAGONAL_BLOCK) {
         SparseMatrix_MatrixVector_CSR_OFFSET0_DIAG(alpha, mainBlock, in, beta, out);
     } else {
         SparseMatrix_MatrixVector_CSR_OFFSET0(alpha, mainBlock, in, beta, out);
@@ -75,7 +77,9 @@ void SystemMatrix::MatrixVector_CSR_OFFSET0(double alpha, const double* in,
     double* remote_values = finishCollect();
     // process couple block
     if (col_coupleBlock->pattern->ptr != NULL) {
-        if (type & MATRIX_FORMAT_DIAGONAL_BLOCK) {
+        if (col_coupleBlock->sell && col_coupleBlock->sell->upToDate) {
+            SparseMatrix_MatrixVector_SELL(alpha, col_coupleBlock, remote_values, 1., out);
+        } else if (type & MATRIX_FORMAT_DIAGONAL_BLOCK) {
             SparseMatrix_MatrixVector_CSR_OFFSET0_DIAG(alpha, col_coupleBlock, remote_values, 1., out);
         } else {
             SparseMatrix_MatrixVector_CSR_OFFSET0(alpha, col_coupleBlock, remote_values, 1., out);
@@ -83,5 +87,24 @@ void SystemMatrix::MatrixVector_CSR_OFFSET0(double alpha, const double* in,
     }
 }
 
+void SystemMatrix::MatrixMultiVector_CSR_OFFSET0(double alpha, dim_t numVec,
+                                                 const double* in, double beta,
+                                                 double* out,
+                                                 Coupler_ptr<real_t> coupler) const
+{
+    // start exchange
+    coupler->startCollect(in);
+    // process main block
+    SparseMatrix_MatrixMultiVector_CSR_OFFSET0(alpha, mainBlock, numVec, in,
+                                               beta, out);
+    // finish exchange
+    double* remote_values = coupler->finishCollect();
+    // process couple block
+    if (col_coupleBlock->pattern->ptr != NULL) {
+        SparseMatrix_MatrixMultiVector_CSR_OFFSET0(alpha, col_coupleBlock,
+                                          numVec, remote_values, 1., out);
+    }
+}
+
 } // namespace paso
 
@@ -121,6 +121,8 @@ SolverResult Solver_TFQMR(SystemMatrix_ptr A, double* r, double* x, dim_t* iter,
     rho = tau * tau;
     norm_of_residual=tau;
 
+    // the vector updates are fused with the norms and inner products which
+    // depend on them so that each vector is streamed as few times as possible
     while (!(convergeFlag || maxIterFlag || breakFlag || (status!=NoError) )) {
         sigma = util::innerProduct(n,res,v,A->mpi_info);
         if (! (breakFlag = (std::abs(sigma) == 0.))) {
@@ -146,29 +148,28 @@ SolverResult Solver_TFQMR(SystemMatrix_ptr A, double* r, double* x, dim_t* iter,
                 }
                 m = 2 * (num_iter+1) - 2 + (j+1);
 
+                const double dscale = theta * theta * eta / alpha;
                 if (j==0) {
                     // w = w - alpha * u1
-                    util::update(n, 1., w, -alpha, u1);
-                    // d = (theta * theta * eta / alpha)*d + y1
-                    util::update(n, (theta * theta * eta / alpha), d, 1., y1);
-                } else if (j==1) {
-                    // w = w - -alpha * u2
-                    util::update(n, 1., w, -alpha, u2);
-                    // d = (theta * theta * eta / alpha)*d + y2
-                    util::update(n, (theta * theta * eta / alpha), d, 1., y2);
+                    theta = sqrt(util::updateAndInnerProduct(n, 1., w, -alpha,
+                                                u1, w, A->mpi_info)) / tau;
+                } else {
+                    // w = w - alpha * u2 together with rhon = res'*w
+                    double dots[2];
+                    util::updateAndInnerProducts(n, 1., w, -alpha, u2, w, res,
+                                                 dots, A->mpi_info);
+                    theta = sqrt(dots[0]) / tau;
+                    rhon = dots[1];
                 }
-
-                theta =util::l2(n,w,A->mpi_info)/tau;
-                //printf("tau = %e, %e %e\n",tau, util::l2(n,w,A->mpi_info)/tau, theta);
                 c = PASO_ONE / sqrt(PASO_ONE + theta * theta);
                 tau = tau * theta * c;
                 eta = c * c * alpha;
-                util::update(n,1.,x,eta,d);
+                // d = (theta * theta * eta / alpha)*d + y, x = x + eta*d
+                util::updateAndAXPY(n, dscale, d, 1., (j==0 ? y1 : y2), x, eta);
             }
 
             breakFlag = (std::abs(rho) == 0);
 
-            rhon = util::innerProduct(n, res, w, A->mpi_info);
             beta = rhon / rho;
             rho = rhon;
 
@@ -186,10 +187,8 @@ SolverResult Solver_TFQMR(SystemMatrix_ptr A, double* r, double* x, dim_t* iter,
             Performance_startMonitor(pp, PERFORMANCE_SOLVER);
             //  u1 = P^{-1} * A y1
 
-            // t = u2 + beta * v
-            util::linearCombination(n,temp_vector,PASO_ONE,u2,beta,v);
-            // v = u1 + beta * t
-            util::linearCombination(n,v,PASO_ONE,u1,beta,temp_vector);
+            // v = u1 + beta * (u2 + beta * v)
+            util::linearCombination(n, v, PASO_ONE, u1, beta, u2, beta*beta, v);
         }
         maxIterFlag = (num_iter > maxit);
         norm_of_residual = tau*sqrt((double)(m + 1));
@@ -26,6 +26,7 @@
 /****************************************************************************/
 
 #include "Transport.h"
+#include "FCT_Solver.h"
 #include "PasoUtil.h"
 #include "Preconditioner.h"
 #include "Solver.h" // only for resetting
@@ -46,6 +47,7 @@ TransportProblem::TransportProblem(SystemMatrixPattern_ptr pattern,
                                    int block_size,
                                    const escript::FunctionSpace& functionspace) :
     AbstractTransportProblem(block_size, functionspace),
+    fct_solver(NULL),
     valid_matrices(false),
     dt_max_R(LARGE_POSITIVE_FLOAT),
     dt_max_T(LARGE_POSITIVE_FLOAT),
@@ -55,8 +57,9 @@ TransportProblem::TransportProblem(SystemMatrixPattern_ptr pattern,
     reactive_matrix(NULL),
     main_diagonal_mass_matrix(NULL)
 {
-    // at the moment only block size 1 is supported
-    SystemMatrixType matrix_type = MATRIX_FORMAT_DEFAULT+MATRIX_FORMAT_BLK1;
+    // the components are kept in blocks so the FCT solver can advance all
+    // of them in one sweep over the matrix
+    SystemMatrixType matrix_type = MATRIX_FORMAT_DEFAULT;
 
     transport_matrix.reset(new SystemMatrix(matrix_type, pattern, block_size,
                                             block_size, false,
@@ -84,6 +87,7 @@ TransportProblem::TransportProblem(SystemMatrixPattern_ptr pattern,
 
 TransportProblem::~TransportProblem()
 {
+    delete fct_solver;
     delete[] constraint_mask;
     delete[] reactive_matrix;
     delete[] main_diagonal_mass_matrix;
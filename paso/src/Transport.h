@@ -28,6 +28,7 @@
 
 namespace paso {
 
+struct FCT_Solver;
 class TransportProblem;
 typedef boost::shared_ptr<TransportProblem> TransportProblem_ptr;
 typedef boost::shared_ptr<const TransportProblem> const_TransportProblem_ptr;
@@ -56,9 +57,10 @@ public:
 
     void setUpConstraint(const double* q);
 
+    /// returns the number of solution components
     inline dim_t getBlockSize() const
     {
-        return transport_matrix->row_block_size;
+        return transport_matrix->logical_row_block_size;
     }
 
     inline SystemMatrix_ptr borrowTransportMatrix() const
@@ -95,12 +97,15 @@ public:
                                 int package, bool symmetry,
                                 const escript::JMPI& mpi_info)
     {
-        return MATRIX_FORMAT_DEFAULT + MATRIX_FORMAT_BLK1;
+        return MATRIX_FORMAT_DEFAULT;
     }
 
     SystemMatrix_ptr transport_matrix;
     SystemMatrix_ptr mass_matrix;
     SystemMatrix_ptr iteration_matrix;
+    /// FCT solver kept between calls of solve. It is rebuilt if the
+    /// integration scheme changes.
+    FCT_Solver* fct_solver;
 
     mutable bool valid_matrices;
     /// safe time step size for reactive part
@@ -47,6 +47,46 @@
 
 namespace paso {
 
+/// returns true if an entry of A outside the diagonals of the blocks is not
+/// zero, i.e. if A couples the components
+static bool componentsAreCoupled(const_SystemMatrix_ptr A)
+{
+    const dim_t nb = A->row_block_size;
+    if (nb == 1)
+        return false;
+
+    const SparseMatrix* blocks[2] = { A->mainBlock.get(),
+                                      A->col_coupleBlock.get() };
+    int coupled = 0;
+    for (int b = 0; b < 2; b++) {
+        const double* val = blocks[b]->val;
+        const dim_t numEntries = blocks[b]->pattern->len;
+#pragma omp parallel
+        {
+            int coupled_loc = 0;
+#pragma omp for
+            for (index_t iptr = 0; iptr < numEntries; ++iptr) {
+                const double* block = &val[iptr*nb*nb];
+                for (dim_t ic = 0; ic < nb; ++ic) {
+                    for (dim_t ir = 0; ir < nb; ++ir) {
+                        if (ir != ic && block[ir+nb*ic] != 0.)
+                            coupled_loc = 1;
+                    }
+                }
+            }
+            #pragma omp critical
+            {
+                coupled = std::max(coupled, coupled_loc);
+            }
+        }
+    }
+#ifdef ESYS_MPI
+    int coupled_loc = coupled;
+    MPI_Allreduce(&coupled_loc, &coupled, 1, MPI_INT, MPI_MAX, A->mpi_info->comm);
+#endif
+    return coupled > 0;
+}
+
 void TransportProblem::solve(double* u, double dt, double* u0, double* q,
                              Options* options)
 {
@@ -57,7 +97,6 @@ void TransportProblem::solve(double* u, double dt, double* u0, double* q,
 
     Performance pp;
     ReactiveSolver* rsolver=NULL;
-    FCT_Solver* fctsolver=NULL;
 
     dim_t i_substeps=0, n_substeps=1, num_failures=0;
     double *u_save=NULL, *u2=NULL;
@@ -69,9 +108,10 @@ void TransportProblem::solve(double* u, double dt, double* u0, double* q,
 
     if (dt <= 0.) {
         throw PasoException("TransportProblem::solve: dt must be positive.");
-    } else if (getBlockSize() > 1) {
-        throw PasoException("TransportProblem::solve: block size >1 "
-                            "is not supported.");
+    } else if (transport_matrix->row_block_size != getBlockSize()) {
+        // the matrix has been unrolled
+        throw PasoException("TransportProblem::solve: block sizes > 8 "
+                            "require LAPACK.");
     }
     if (options->verbose) {
         if (options->ode_solver == PASO_BACKWARD_EULER) {
@@ -86,7 +126,11 @@ void TransportProblem::solve(double* u, double dt, double* u0, double* q,
     }
     getSafeTimeStepSize();
     // allocate memory
-    fctsolver = new FCT_Solver(shared_from_this(), options);
+    if (fct_solver == NULL || fct_solver->method != options->ode_solver) {
+        delete fct_solver;
+        fct_solver = NULL;
+        fct_solver = new FCT_Solver(shared_from_this(), options);
+    }
     rsolver = new ReactiveSolver(shared_from_this());
     u_save = new double[n];
     u2 = new double[n];
@@ -118,7 +162,7 @@ void TransportProblem::solve(double* u, double dt, double* u0, double* q,
                     << std::endl;
             }
             // initialize the iteration matrix
-            fctsolver->initialize(dt3, options, &pp);
+            fct_solver->initialize(dt3, options, &pp);
             rsolver->initialize(dt3/2, options);
             errorCode = NoError;
 
@@ -140,7 +184,7 @@ void TransportProblem::solve(double* u, double dt, double* u0, double* q,
 
                 // Mv_t=Lv   v(0)=u(dt/2)
                 if (errorCode == NoError) {
-                    errorCode = fctsolver->update(u, u2, options, &pp);
+                    errorCode = fct_solver->update(u, u2, options, &pp);
 
                 }
                 // Mu_t=Du+q u(dt/2)=v(dt/2)
@@ -184,7 +228,6 @@ void TransportProblem::solve(double* u, double dt, double* u0, double* q,
         }
     } // end of time loop
 
-    delete fctsolver;
     delete rsolver;
     delete[] u_save;
     delete[] u2;
@@ -196,6 +239,12 @@ double TransportProblem::getSafeTimeStepSize() const
     const dim_t n = transport_matrix->getTotalNumRows();
 
     if (!valid_matrices) {
+        // the flux limiter treats the components independently
+        if (componentsAreCoupled(transport_matrix) ||
+                componentsAreCoupled(mass_matrix))
+            throw PasoException("TransportProblem::getSafeTimeStepSize: "
+                    "transport and mass matrix must not couple the solution "
+                    "components.");
         // set row-sum of mass_matrix
         mass_matrix->rowSum(lumped_mass_matrix);
         // check for positive entries in lumped_mass_matrix and set
@@ -233,6 +282,8 @@ double TransportProblem::getSafeTimeStepSize() const
 
         const double dt_R = ReactiveSolver::getSafeTimeStepSize(shared_from_this());
         const double dt_T = FCT_Solver::getSafeTimeStepSize(shared_from_this());
+        if (fct_solver != NULL)
+            fct_solver->setMatrices();
         dt_max_R = dt_R;
         dt_max_T = dt_T;
         valid_matrices = true;
@@ -50,6 +50,24 @@ void UMFPACK_free(SparseMatrix* A)
     }
 }
 
+/// frees the numeric factorization only. The symbolic factorization is kept
+/// as it only depends on the pattern of the matrix and can be reused when
+/// the values change.
+void UMFPACK_freeNumeric(SparseMatrix* A)
+{
+    if (A && A->solver_p) {
+        UMFPACK_Handler* pt = reinterpret_cast<UMFPACK_Handler*>(A->solver_p);
+#ifdef ESYS_HAVE_UMFPACK
+#ifdef ESYS_INDEXTYPE_LONG
+        umfpack_dl_free_numeric(&pt->numeric);
+#else
+        umfpack_di_free_numeric(&pt->numeric);
+#endif // ESYS_INDEXTYPE_LONG
+#endif
+        pt->numeric = NULL;
+    }
+}
+
 
 /// calls the solver
 void UMFPACK_solve(SparseMatrix_ptr A, double* out, double* in,
@@ -72,9 +90,17 @@ void UMFPACK_solve(SparseMatrix_ptr A, double* out, double* in,
 #endif
     double time0;
     int error;
+    // a symbolic factorization for another pattern cannot be reused
+    if (pt != NULL && pt->pattern != A->pattern) {
+        UMFPACK_free(A.get());
+        pt = NULL;
+    }
     if (pt == NULL) {
         int n = A->numRows;
         pt = new UMFPACK_Handler;
+        pt->symbolic = NULL;
+        pt->numeric = NULL;
+        pt->pattern = A->pattern;
         A->solver_p = (void*) pt;
         A->solver_package = PASO_UMFPACK;
         time0=escript::gettime();
@@ -109,9 +135,17 @@ void UMFPACK_solve(SparseMatrix_ptr A, double* out, double* in,
             }
             if (verbose)
                 std::cout << message.c_str() << std::endl;
+            UMFPACK_free(A.get());
             throw PasoException(message);
         }
+        if (verbose) {
+            std::cout << "UMFPACK: symbolic factorization completed (time = "
+                << escript::gettime()-time0 << ")." << std::endl;
+        }
+    } // pt==NULL
 
+    if (pt->numeric == NULL) {
+        time0=escript::gettime();
         // call LDU factorization:
 #ifdef ESYS_INDEXTYPE_LONG
         error = umfpack_dl_numeric(A->pattern->ptr, A->pattern->index,
@@ -153,7 +187,7 @@ void UMFPACK_solve(SparseMatrix_ptr A, double* out, double* in,
             }
             throw PasoException("UMFPACK: factorization failed.");
         }
-    } // pt==NULL
+    } // pt->numeric==NULL
 
     // call forward backward substitution
     control[UMFPACK_IRSTEP] = numRefinements; // number of refinement steps
@@ -40,9 +40,12 @@ namespace paso {
 struct UMFPACK_Handler {
     void *symbolic;
     void *numeric;
+    /// the pattern the symbolic factorization was computed for
+    const_Pattern_ptr pattern;
 };
 
 void UMFPACK_free(SparseMatrix* A);
+void UMFPACK_freeNumeric(SparseMatrix* A);
 void UMFPACK_solve(SparseMatrix_ptr A, double* out, double* in,
                    dim_t numRefinements, bool verbose);
 
@@ -32,10 +32,82 @@
 #include "Preconditioner.h"
 #include "Solver.h"
 #include "MKL.h"
+#include "Supernodal.h"
 #include "UMFPACK.h"
 
 namespace paso {
 
+namespace {
+
+/// translates the result of an iterative solver into an exception
+void checkSolverResult(SolverResult res, const Options* options)
+{
+    if (res == Divergence) {
+        // cancel divergence errors
+        if (options->accept_failed_convergence) {
+            if (options->verbose)
+                printf("paso: failed convergence error has been canceled as requested.\n");
+        } else {
+            throw PasoException("Solver: No improvement during iteration. Iterative solver gives up.");
+        }
+    } else if (res == MaxIterReached) {
+        // cancel divergence errors
+        if (options->accept_failed_convergence) {
+            if (options->verbose)
+                printf("paso: failed convergence error has been canceled as requested.\n");
+        } else {
+            throw PasoException("Solver: maximum number of iteration steps reached.\nReturned solution does not fulfil stopping criterion.");
+        }
+    } else if (res == InputError) {
+        throw PasoException("Solver: illegal dimension in iterative solver.");
+    } else if (res == NegativeNormError) {
+        throw PasoException("Solver: negative energy norm (try other solver or preconditioner).");
+    } else if (res == Breakdown) {
+        throw PasoException("Solver: fatal break down in iterative solver.");
+    } else if (res != NoError) {
+        throw PasoException("Solver: Generic error in solver.");
+    }
+}
+
+/// solves with the supernodal direct solver of paso. With MPI the matrix is
+/// merged on rank 0 which carries out the factorization.
+void solveDirect(SystemMatrix_ptr A, double* out, double* in,
+                 Options* options, Performance* pp)
+{
+    const bool symmetric = (Options::getSolver(options->method, PASO_PASO,
+                options->symmetric, A->mpi_info) == PASO_CHOLEVSKY);
+    if (A->solver_package != PASO_DIRECT)
+        solve_free(A.get());
+    options->converged = false;
+    options->time = escript::gettime();
+    Performance_startMonitor(pp, PERFORMANCE_ALL);
+    if (A->mpi_info->size == 1) {
+        Supernodal_solve(A->mainBlock, out, in, symmetric,
+                         options->refinements, options->verbose);
+    } else {
+        Supernodal_solveMerged(A, out, in, symmetric, options->refinements,
+                               options->verbose);
+    }
+    A->solver_package = PASO_DIRECT;
+    Performance_stopMonitor(pp, PERFORMANCE_ALL);
+    options->time = escript::gettime()-options->time;
+    options->set_up_time = 0;
+    options->residual_norm = 0.;
+    options->num_iter = 0;
+    options->converged = true;
+}
+
+/// frees the data of the direct solver before another solver is used
+void freeDirect(SystemMatrix* A)
+{
+    if (A->solver_package == PASO_DIRECT) {
+        solve_free(A);
+        Supernodal_freeMerged(A);
+    }
+}
+
+} // anonymous namespace
+
 void SystemMatrix::solve(double* out, double* in, Options* options) const
 {
     Performance pp;
@@ -50,11 +122,35 @@ void SystemMatrix::solve(double* out, double* in, Options* options) const
     SolverResult res = NoError;
 
     switch (package) {
-        case PASO_PASO:
-            res = Solver(boost::const_pointer_cast<SystemMatrix>(
-                    boost::dynamic_pointer_cast<const SystemMatrix>(getPtr())),
-                    out, in, options, &pp);
-            solver_package = PASO_PASO;
+        case PASO_PASO: {
+            SystemMatrix_ptr A(boost::const_pointer_cast<SystemMatrix>(
+                    boost::dynamic_pointer_cast<const SystemMatrix>(getPtr())));
+            const int method = Options::getSolver(options->method, PASO_PASO,
+                                                  options->symmetric, mpi_info);
+            if (method == PASO_DIRECT || method == PASO_CHOLEVSKY) {
+                solveDirect(A, out, in, options, &pp);
+            } else {
+                freeDirect(A.get());
+                SystemMatrix_ptr R;
+                if (options->reordering == PASO_REVERSE_CUTHILL_MCKEE) {
+                    R = ReorderedSystem_update(A);
+                } else {
+                    ReorderedSystem_free(A.get());
+                }
+                if (R) {
+                    // solve in the labels of the reordered matrix
+                    const dim_t n = getTotalNumRows();
+                    std::vector<double> b(n), x(n);
+                    ReorderedSystem_permute(this, &b[0], in, true);
+                    ReorderedSystem_permute(this, &x[0], out, true);
+                    res = Solver(R, &x[0], &b[0], options, &pp);
+                    ReorderedSystem_permute(this, out, &x[0], false);
+                } else {
+                    res = Solver(A, out, in, options, &pp);
+                }
+                solver_package = PASO_PASO;
+            }
+        }
         break;
 
         case PASO_MKL:
@@ -97,31 +193,59 @@ void SystemMatrix::solve(double* out, double* in, Options* options) const
         break;
     }
 
-    if (res == Divergence) {
-        // cancel divergence errors
-        if (options->accept_failed_convergence) {
-            if (options->verbose)
-                printf("paso: failed convergence error has been canceled as requested.\n");
-        } else {
-            throw PasoException("Solver: No improvement during iteration. Iterative solver gives up.");
-        }
-    } else if (res == MaxIterReached) {
-        // cancel divergence errors
-        if (options->accept_failed_convergence) {
-            if (options->verbose)
-                printf("paso: failed convergence error has been canceled as requested.\n");
-        } else {
-            throw PasoException("Solver: maximum number of iteration steps reached.\nReturned solution does not fulfil stopping criterion.");
+    checkSolverResult(res, options);
+    Performance_close(&pp, options->verbose);
+}
+
+void SystemMatrix::solveMultiple(double** out, double** in, dim_t numRHS,
+                                 Options* options) const
+{
+    const index_t package = Options::getPackage(options->method,
+                        options->package, options->symmetric, mpi_info);
+    const index_t method = (package == PASO_PASO ? Options::getSolver(
+                options->method, PASO_PASO, options->symmetric, mpi_info) : -1);
+    // only PCG and GMRES have a multiple right hand side version. Everything
+    // else solves the systems one after the other.
+    if (numRHS < 2 || (method != PASO_PCG && method != PASO_GMRES)
+            || (type & MATRIX_FORMAT_CSC) || (type & MATRIX_FORMAT_OFFSET1)) {
+        for (dim_t i = 0; i < numRHS; i++)
+            solve(out[i], in[i], options);
+        return;
+    }
+    if (getGlobalNumCols() != getGlobalNumRows()
+                    || col_block_size != row_block_size) {
+        throw PasoException("solve: matrix has to be a square matrix.");
+    }
+    Performance pp;
+    Performance_open(&pp, options->verbose);
+    SystemMatrix_ptr A(boost::const_pointer_cast<SystemMatrix>(
+                boost::dynamic_pointer_cast<const SystemMatrix>(getPtr())));
+    freeDirect(A.get());
+    SystemMatrix_ptr R;
+    if (options->reordering == PASO_REVERSE_CUTHILL_MCKEE) {
+        R = ReorderedSystem_update(A);
+    } else {
+        ReorderedSystem_free(A.get());
+    }
+    SolverResult res;
+    if (R) {
+        // solve in the labels of the reordered matrix
+        const dim_t n = getTotalNumRows();
+        std::vector<double> bbuf(numRHS*n), xbuf(numRHS*n);
+        std::vector<double*> b(numRHS), x(numRHS);
+        for (dim_t i = 0; i < numRHS; i++) {
+            b[i] = &bbuf[i*n];
+            x[i] = &xbuf[i*n];
+            ReorderedSystem_permute(this, b[i], in[i], true);
         }
-    } else if (res == InputError) {
-        throw PasoException("Solver: illegal dimension in iterative solver.");
-    } else if (res == NegativeNormError) {
-        throw PasoException("Solver: negative energy norm (try other solver or preconditioner).");
-    } else if (res == Breakdown) {
-        throw PasoException("Solver: fatal break down in iterative solver.");
-    } else if (res != NoError) {
-        throw PasoException("Solver: Generic error in solver.");
+        res = Solver_MultipleRHS(R, &x[0], &b[0], numRHS, options, &pp);
+        for (dim_t i = 0; i < numRHS; i++)
+            ReorderedSystem_permute(this, out[i], x[i], false);
+    } else {
+        res = Solver_MultipleRHS(A, out, in, numRHS, options, &pp);
     }
+    solver_package = PASO_PASO;
+    checkSolverResult(res, options);
     Performance_close(&pp, options->verbose);
 }
 
@@ -138,12 +262,22 @@ void solve_free(SystemMatrix* in)
             Preconditioner_Smoother_free((Preconditioner_Smoother*) in->solver_p);
             break;
 
+        // the symbolic factorizations of the direct solvers only depend on
+        // the pattern and are kept until the main block is destroyed
         case PASO_MKL:
-            MKL_free(in->mainBlock.get());
+            MKL_freeNumeric(in->mainBlock.get());
             break;
 
         case PASO_UMFPACK:
-            UMFPACK_free(in->mainBlock.get());
+            UMFPACK_freeNumeric(in->mainBlock.get());
+            break;
+
+        case PASO_DIRECT:
+            if (in->mpi_info->size == 1) {
+                Supernodal_freeNumeric(in->mainBlock.get());
+            } else {
+                Supernodal_freeMergedNumeric(in);
+            }
             break;
    }
 }
@@ -0,0 +1,323 @@
+
+/*****************************************************************************
+*
+* Copyright (c) 2003-2018 by The University of Queensland
+* http://www.uq.edu.au
+*
+* Primary Business: Queensland, Australia
+* Licensed under the Apache License, version 2.0
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Development until 2012 by Earth Systems Science Computational Center (ESSCC)
+* Development 2012-2013 by School of Earth Sciences
+* Development from 2014 by Centre for Geoscience Computing (GeoComp)
+*
+*****************************************************************************/
+
+#include <ripley/MatrixFreeOperator.h>
+#include <ripley/RipleyException.h>
+
+#include <escript/index.h>
+
+#include <paso/Options.h>
+#include <paso/PasoException.h>
+#include <paso/Solver.h>
+
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+
+namespace ripley {
+
+namespace {
+
+/// exposes a MatrixFreeOperator to the paso solvers
+struct MatrixFreeLinearOperator : public paso::LinearOperator
+{
+    MatrixFreeLinearOperator(const MatrixFreeOperator* op) :
+        paso::LinearOperator(op->getMPI()),
+        mfo(op)
+    {}
+
+    virtual void matrixVector(double alpha, const double* x, double beta,
+                              double* y)
+    {
+        mfo->matrixVector(alpha, x, beta, y);
+    }
+
+    virtual void getDiagonal(double* diag) { mfo->getDiagonal(diag); }
+
+    virtual dim_t getLen() { return mfo->getNumDOF()*mfo->getBlockSize(); }
+
+    const MatrixFreeOperator* mfo;
+};
+
+/// adds the indices i with mask[i]>0 to the sorted index list 'list'
+void addMaskedIndices(IndexVector& list, const double* mask, dim_t n)
+{
+    for (index_t i = 0; i < n; i++) {
+        if (mask[i] > 0.)
+            list.push_back(i);
+    }
+    std::sort(list.begin(), list.end());
+    list.erase(std::unique(list.begin(), list.end()), list.end());
+}
+
+} // anonymous namespace
+
+MatrixFreeOperator::MatrixFreeOperator(const RipleyDomain* domain,
+                                       escript::JMPI mpiInfo, int blocksize,
+                                       const escript::FunctionSpace& fs,
+                                       dim_t numDOF,
+                                       paso::Connector_ptr connector) :
+    AbstractSystemMatrix(blocksize, fs, blocksize, fs),
+    m_domain(domain),
+    m_mpiInfo(mpiInfo),
+    m_numDOF(numDOF),
+    m_mainDiagonalValue(1.),
+    m_xRemote(NULL),
+    m_addDiagonal(false)
+{
+    m_coupler.reset(new paso::Coupler<real_t>(connector, blocksize, mpiInfo,
+                                              true));
+}
+
+void MatrixFreeOperator::nullifyRowsAndCols(escript::Data& row_q,
+                                            escript::Data& col_q,
+                                            double mdv)
+{
+    if (row_q.isComplex() || col_q.isComplex()) {
+        throw RipleyException("nullifyRowsAndCols: complex arguments not "
+                              "supported by matrix-free operators.");
+    } else if (col_q.getDataPointSize() != getColumnBlockSize()) {
+        throw RipleyException("nullifyRowsAndCols: column block size does "
+                "not match the number of components of column mask.");
+    } else if (row_q.getDataPointSize() != getRowBlockSize()) {
+        throw RipleyException("nullifyRowsAndCols: row block size does not "
+                "match the number of components of row mask.");
+    } else if (col_q.getFunctionSpace() != getColumnFunctionSpace()) {
+        throw RipleyException("nullifyRowsAndCols: column function space "
+                "and function space of column mask don't match.");
+    } else if (row_q.getFunctionSpace() != getRowFunctionSpace()) {
+        throw RipleyException("nullifyRowsAndCols: row function space and "
+                "function space of row mask don't match.");
+    }
+    row_q.expand();
+    col_q.expand();
+    const dim_t n = m_numDOF*getBlockSize();
+    const double* mask_row = row_q.getExpandedVectorReference(
+                                            static_cast<real_t>(0)).data();
+    const double* mask_col = col_q.getExpandedVectorReference(
+                                            static_cast<real_t>(0)).data();
+    addMaskedIndices(m_nullRows, mask_row, n);
+    addMaskedIndices(m_nullCols, mask_col, n);
+    m_nullDiag.clear();
+    std::set_union(m_nullRows.begin(), m_nullRows.end(), m_nullCols.begin(),
+                   m_nullCols.end(), std::back_inserter(m_nullDiag));
+    m_mainDiagonalValue = mdv;
+}
+
+void MatrixFreeOperator::resetValues(bool preserveSolverData)
+{
+    m_coefficients.clear();
+    m_nullRows.clear();
+    m_nullCols.clear();
+    m_nullDiag.clear();
+    m_mainDiagonalValue = 1.;
+    m_diagonal.clear();
+}
+
+void MatrixFreeOperator::addCoefficients(const DataMap& coefs,
+                                         Assembler_ptr assembler)
+{
+    m_coefficients.push_back(std::make_pair(coefs, assembler));
+    m_diagonal.clear();
+}
+
+void MatrixFreeOperator::add(const IndexVector& rowIndex,
+                             const std::vector<double>& array)
+{
+    // the assemblers colour the elements so that elements processed at the
+    // same time by different threads do not share degrees of freedom
+    const dim_t numEq = getBlockSize();
+    const dim_t numNodes = rowIndex.size();
+    for (dim_t k_Eq = 0; k_Eq < numNodes; k_Eq++) {
+        const index_t row = rowIndex[k_Eq];
+        if (row >= m_numDOF)
+            continue;
+        if (m_addDiagonal) {
+            for (dim_t i_Eq = 0; i_Eq < numEq; i_Eq++) {
+                m_diagonal[INDEX2(i_Eq, row, numEq)] +=
+                    array[INDEX4(i_Eq, i_Eq, k_Eq, k_Eq, numEq, numEq,
+                                 numNodes)];
+            }
+            continue;
+        }
+        double* yi = &m_y[INDEX2(0, row, numEq)];
+        for (dim_t k_Sol = 0; k_Sol < numNodes; k_Sol++) {
+            const index_t col = rowIndex[k_Sol];
+            const double* xc = (col < m_numDOF ?
+                    &m_x[INDEX2(0, col, numEq)] :
+                    &m_xRemote[INDEX2(0, col-m_numDOF, numEq)]);
+            for (dim_t i_Eq = 0; i_Eq < numEq; i_Eq++) {
+                double sum = 0.;
+                for (dim_t i_Sol = 0; i_Sol < numEq; i_Sol++) {
+                    sum += array[INDEX4(i_Eq, i_Sol, k_Eq, k_Sol, numEq,
+                                        numEq, numNodes)]*xc[i_Sol];
+                }
+                yi[i_Eq] += sum;
+            }
+        }
+    }
+}
+
+void MatrixFreeOperator::assemble() const
+{
+    std::vector<std::pair<DataMap, Assembler_ptr> >::const_iterator it;
+    for (it = m_coefficients.begin(); it != m_coefficients.end(); it++) {
+        m_domain->assembleMatrixFree(
+                const_cast<MatrixFreeOperator*>(this), it->first, it->second);
+    }
+}
+
+void MatrixFreeOperator::matrixVector(double alpha, const double* x,
+                                      double beta, double* y) const
+{
+    const dim_t n = m_numDOF*getBlockSize();
+    // columns which have been nullified do not contribute to A*x
+    m_x.assign(x, x+n);
+    for (size_t i = 0; i < m_nullCols.size(); i++)
+        m_x[m_nullCols[i]] = 0.;
+    m_coupler->startCollect(&m_x[0]);
+    m_xRemote = m_coupler->finishCollect();
+
+    m_y.assign(n, 0.);
+    assemble();
+    m_xRemote = NULL;
+
+    for (size_t i = 0; i < m_nullRows.size(); i++)
+        m_y[m_nullRows[i]] = 0.;
+    for (size_t i = 0; i < m_nullDiag.size(); i++)
+        m_y[m_nullDiag[i]] += m_mainDiagonalValue*x[m_nullDiag[i]];
+
+    if (beta == 0.) {
+#pragma omp parallel for
+        for (index_t i = 0; i < n; i++)
+            y[i] = alpha*m_y[i];
+    } else {
+#pragma omp parallel for
+        for (index_t i = 0; i < n; i++)
+            y[i] = alpha*m_y[i] + beta*y[i];
+    }
+}
+
+void MatrixFreeOperator::getDiagonal(double* diag) const
+{
+    const dim_t n = m_numDOF*getBlockSize();
+    if (m_diagonal.empty() && n > 0) {
+        m_diagonal.assign(n, 0.);
+        m_addDiagonal = true;
+        try {
+            assemble();
+        } catch (...) {
+            m_addDiagonal = false;
+            m_diagonal.clear();
+            throw;
+        }
+        m_addDiagonal = false;
+    }
+    std::copy(m_diagonal.begin(), m_diagonal.end(), diag);
+    for (size_t i = 0; i < m_nullDiag.size(); i++)
+        diag[m_nullDiag[i]] = m_mainDiagonalValue;
+}
+
+void MatrixFreeOperator::setToSolution(escript::Data& out, escript::Data& in,
+                                       boost::python::object& options) const
+{
+    if (in.isComplex() || out.isComplex()) {
+        throw RipleyException("setToSolution: complex arguments not "
+                              "supported by matrix-free operators.");
+    }
+    options.attr("resetDiagnostics")();
+    paso::Options paso_options(options);
+    if (out.getDataPointSize() != getColumnBlockSize()) {
+        throw RipleyException("solve: column block size does not match the "
+                              "number of components of solution.");
+    } else if (in.getDataPointSize() != getRowBlockSize()) {
+        throw RipleyException("solve: row block size does not match the "
+                              "number of components of right hand side.");
+    } else if (out.getFunctionSpace() != getColumnFunctionSpace()) {
+        throw RipleyException("solve: column function space and function "
+                              "space of solution don't match.");
+    } else if (in.getFunctionSpace() != getRowFunctionSpace()) {
+        throw RipleyException("solve: row function space and function space "
+                              "of right hand side don't match.");
+    }
+    out.expand();
+    in.expand();
+    out.requireWrite();
+    in.requireWrite();
+    double* out_dp = out.getExpandedVectorReference(
+                                        static_cast<real_t>(0)).data();
+    double* in_dp = in.getExpandedVectorReference(
+                                        static_cast<real_t>(0)).data();
+
+    paso::Performance pp;
+    paso::Performance_open(&pp, paso_options.verbose);
+    MatrixFreeLinearOperator op(this);
+    paso::SolverResult res = paso::Solver_MatrixFree(&op, out_dp, in_dp,
+                                                     &paso_options, &pp);
+    paso::Performance_close(&pp, paso_options.verbose);
+    paso_options.updateEscriptDiagnostics(options);
+
+    if (res == paso::MaxIterReached) {
+        if (paso_options.accept_failed_convergence) {
+            if (paso_options.verbose)
+                std::cout << "MatrixFreeOperator: failed convergence error "
+                    "has been canceled as requested." << std::endl;
+        } else {
+            throw RipleyException("Solver: maximum number of iteration steps "
+                    "reached.\nReturned solution does not fulfil stopping "
+                    "criterion.");
+        }
+    } else if (res == paso::NegativeNormError) {
+        throw RipleyException("Solver: negative energy norm (try other "
+                              "solver or preconditioner).");
+    } else if (res == paso::Breakdown) {
+        throw RipleyException("Solver: fatal break down in iterative solver.");
+    } else if (res != paso::NoError) {
+        throw RipleyException("Solver: Generic error in solver.");
+    }
+}
+
+void MatrixFreeOperator::ypAx(escript::Data& y, escript::Data& x) const
+{
+    if (x.isComplex() || y.isComplex()) {
+        throw RipleyException("ypAx: complex arguments not supported by "
+                              "matrix-free operators.");
+    } else if (x.getDataPointSize() != getColumnBlockSize()) {
+        throw RipleyException("matrix vector product: column block size "
+                "does not match the number of components in input.");
+    } else if (y.getDataPointSize() != getRowBlockSize()) {
+        throw RipleyException("matrix vector product: row block size does "
+                "not match the number of components in output.");
+    } else if (x.getFunctionSpace() != getColumnFunctionSpace()) {
+        throw RipleyException("matrix vector product: column function space "
+                "and function space of input don't match.");
+    } else if (y.getFunctionSpace() != getRowFunctionSpace()) {
+        throw RipleyException("matrix vector product: row function space and "
+                "function space of output don't match.");
+    }
+    x.expand();
+    y.expand();
+    x.requireWrite();
+    y.requireWrite();
+    const double* x_dp = x.getExpandedVectorReference(
+                                        static_cast<real_t>(0)).data();
+    double* y_dp = y.getExpandedVectorReference(
+                                        static_cast<real_t>(0)).data();
+    matrixVector(1., x_dp, 1., y_dp);
+}
+
+} // namespace ripley
+
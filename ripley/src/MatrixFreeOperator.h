@@ -0,0 +1,113 @@
+
+/*****************************************************************************
+*
+* Copyright (c) 2003-2018 by The University of Queensland
+* http://www.uq.edu.au
+*
+* Primary Business: Queensland, Australia
+* Licensed under the Apache License, version 2.0
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Development until 2012 by Earth Systems Science Computational Center (ESSCC)
+* Development 2012-2013 by School of Earth Sciences
+* Development from 2014 by Centre for Geoscience Computing (GeoComp)
+*
+*****************************************************************************/
+
+#ifndef __RIPLEY_MATRIXFREEOPERATOR_H__
+#define __RIPLEY_MATRIXFREEOPERATOR_H__
+
+#include <ripley/RipleyDomain.h>
+
+#include <escript/AbstractSystemMatrix.h>
+#include <escript/FunctionSpace.h>
+
+#include <paso/Coupler.h>
+
+namespace ripley {
+
+/**
+   \brief
+   A system matrix which does not store a global matrix or element matrices.
+   The operator coefficients passed to addToSystem are kept together with
+   their assembler. Whenever the operator is applied the assemblers evaluate
+   the element contributions from the coefficients at the quadrature points
+   and these are applied element by element. Only the main diagonal is kept
+   between applications. Linear systems are solved with paso's Krylov solvers
+   using the Jacobi or Chebyshev preconditioner.
+*/
+class MatrixFreeOperator : public escript::AbstractSystemMatrix
+{
+public:
+    MatrixFreeOperator(const RipleyDomain* domain, escript::JMPI mpiInfo,
+                       int blocksize, const escript::FunctionSpace& fs,
+                       dim_t numDOF, paso::Connector_ptr connector);
+
+    virtual ~MatrixFreeOperator() {}
+
+    virtual void nullifyRowsAndCols(escript::Data& row_q,
+                                    escript::Data& col_q,
+                                    double mdv);
+
+    virtual void resetValues(bool preserveSolverData = false);
+
+    /// stores the operator coefficients in 'coefs' which are evaluated by
+    /// 'assembler' whenever the operator is applied
+    void addCoefficients(const DataMap& coefs, Assembler_ptr assembler);
+
+    /// applies the element matrix 'array' for the degrees of freedom in
+    /// 'rowIndex' to the current input vector, or adds its main diagonal
+    /// while the diagonal is computed. This is called by the assemblers.
+    void add(const IndexVector& rowIndex, const std::vector<double>& array);
+
+    /// sets y = alpha*A*x + beta*y for local vectors x and y
+    void matrixVector(double alpha, const double* x, double beta,
+                      double* y) const;
+
+    /// copies the main diagonal of the operator into diag
+    void getDiagonal(double* diag) const;
+
+    inline int getBlockSize() const { return getRowBlockSize(); }
+
+    /// returns the local number of degrees of freedom
+    inline dim_t getNumDOF() const { return m_numDOF; }
+
+    inline escript::JMPI getMPI() const { return m_mpiInfo; }
+
+private:
+    virtual void setToSolution(escript::Data& out, escript::Data& in,
+                               boost::python::object& options) const;
+
+    virtual void ypAx(escript::Data& y, escript::Data& x) const;
+
+    /// runs the assemblers of all coefficients which pass their element
+    /// matrices to add()
+    void assemble() const;
+
+    const RipleyDomain* m_domain;
+    escript::JMPI m_mpiInfo;
+    dim_t m_numDOF;
+    /// operator coefficients and the assemblers evaluating them
+    std::vector<std::pair<DataMap, Assembler_ptr> > m_coefficients;
+    /// nullified rows and columns and the union of both
+    IndexVector m_nullRows;
+    IndexVector m_nullCols;
+    IndexVector m_nullDiag;
+    double m_mainDiagonalValue;
+    paso::Coupler_ptr<real_t> m_coupler;
+    /// local and remote values of the input vector of the current
+    /// application
+    mutable DoubleVector m_x;
+    mutable const double* m_xRemote;
+    /// result of the current application
+    mutable DoubleVector m_y;
+    /// true while add() collects the main diagonal
+    mutable bool m_addDiagonal;
+    /// main diagonal of the element contributions (empty if not computed
+    /// yet)
+    mutable DoubleVector m_diagonal;
+};
+
+} // namespace ripley
+
+#endif // __RIPLEY_MATRIXFREEOPERATOR_H__
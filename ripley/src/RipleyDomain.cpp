@@ -30,6 +30,8 @@
 #endif
 
 #ifdef ESYS_HAVE_PASO
+#include <ripley/MatrixFreeOperator.h>
+#include <paso/PasoUtil.h>
 #include <paso/SystemMatrix.h>
 #include <paso/Transport.h>
 #endif
@@ -863,6 +865,10 @@ int RipleyDomain::getSystemMatrixTypeId(const bp::object& options) const
 #ifdef ESYS_HAVE_TRILINOS
     bool isDirect = escript::isDirectSolver(method);
 #endif
+    if (sb.useMatrixFree() && escript::isDirectSolver(method)) {
+        throw ValueError("getSystemMatrixTypeId: direct solvers require an "
+                         "assembled matrix and cannot be used matrix-free");
+    }
 
     // use CUSP for single rank and supported solvers+preconditioners if CUDA
     // is available, PASO or Trilinos otherwise
@@ -945,6 +951,8 @@ int RipleyDomain::getSystemMatrixTypeId(const bp::object& options) const
     if (sb.isComplex()) {
         throw NotImplementedError("Paso does not support complex-valued matrices");
     }
+    if (sb.useMatrixFree())
+        return (int)SMT_MATRIXFREE;
     // in all other cases we use PASO
     return (int)SMT_PASO | paso::SystemMatrix::getSystemMatrixTypeId(
             method, sb.getPreconditioner(), sb.getPackage(),
@@ -1021,6 +1029,19 @@ escript::ASM_ptr RipleyDomain::newSystemMatrix(int row_blocksize,
 #else
         throw RipleyException("newSystemMatrix: ripley was not compiled with "
                "Trilinos support so the Trilinos solver stack cannot be used.");
+#endif
+    } else if (type & (int)SMT_MATRIXFREE) {
+#ifdef ESYS_HAVE_PASO
+        if (reduceRowOrder)
+            throw NotImplementedError("newSystemMatrix: reduced order not "
+                                      "supported by matrix-free operators");
+        escript::ASM_ptr sm(new MatrixFreeOperator(this, m_mpiInfo,
+                    row_blocksize, row_functionspace, getNumDOF(),
+                    getPasoConnector()));
+        return sm;
+#else
+        throw RipleyException("newSystemMatrix: ripley was not compiled with "
+               "Paso support so matrix-free operators are not available.");
 #endif
     } else if (type & (int)SMT_PASO) {
 #ifdef ESYS_HAVE_PASO
@@ -1048,11 +1069,41 @@ void RipleyDomain::addToSystem(escript::AbstractSystemMatrix& mat,
         throw ValueError(
                     "addToSystem: Ripley does not support contact elements");
 
+#ifdef ESYS_HAVE_PASO
+    MatrixFreeOperator* mfo = dynamic_cast<MatrixFreeOperator*>(&mat);
+    if (mfo) {
+        // operator coefficients are kept by the operator and evaluated on
+        // application, the right hand side is assembled as usual
+        DataMap opCoefs, rhsCoefs;
+        for (DataMap::const_iterator it = coefs.begin(); it != coefs.end(); it++) {
+            if (it->first == "X" || it->first == "Y" || it->first == "y"
+                    || it->first == "y_dirac" || it->first == "du") {
+                rhsCoefs[it->first] = it->second;
+            } else {
+                opCoefs[it->first] = it->second;
+            }
+        }
+        mfo->addCoefficients(opCoefs, assembler);
+        addToRHS(rhs, rhsCoefs, assembler);
+        return;
+    }
+#endif
+
     assemblePDE(&mat, rhs, coefs, assembler);
     assemblePDEBoundary(&mat, rhs, coefs, assembler);
     assemblePDEDirac(&mat, rhs, coefs, assembler);
 }
 
+void RipleyDomain::assembleMatrixFree(escript::AbstractSystemMatrix* mat,
+                                      const DataMap& coefs,
+                                      Assembler_ptr assembler) const
+{
+    escript::Data rhs;
+    assemblePDE(mat, rhs, coefs, assembler);
+    assemblePDEBoundary(mat, rhs, coefs, assembler);
+    assemblePDEDirac(mat, rhs, coefs, assembler);
+}
+
 void RipleyDomain::addToSystemFromPython(escript::AbstractSystemMatrix& mat,
                                          escript::Data& rhs,
                                          const bp::list& data,
@@ -1383,17 +1434,18 @@ void RipleyDomain::createPasoConnector(const RankVector& neighbour,
 paso::Pattern_ptr RipleyDomain::createPasoPattern(
                             const vector<IndexVector>& indices, dim_t N) const
 {
-    // paso will manage the memory
+    // paso will manage the memory. Both arrays are first touched by row
+    // stripes so that their pages are placed on the NUMA node of the thread
+    // working on the rows in paso
     const dim_t M = indices.size();
-    index_t* ptr = new index_t[M+1];
-    ptr[0] = 0;
+    index_t* ptr = paso::util::newIndexVector(M+1);
     for (index_t i=0; i < M; i++) {
         ptr[i+1] = ptr[i]+indices[i].size();
     }
 
     index_t* index = new index_t[ptr[M]];
 
-#pragma omp parallel for
+#pragma omp parallel for schedule(static)
     for (index_t i=0; i < M; i++) {
         copy(indices[i].begin(), indices[i].end(), &index[ptr[i]]);
     }
@@ -1459,6 +1511,11 @@ void RipleyDomain::addToSystemMatrix<real_t>(escript::AbstractSystemMatrix* mat,
         addToPasoMatrix(psm, nodes, numEq, array);
         return;
     }
+    MatrixFreeOperator* mfo = dynamic_cast<MatrixFreeOperator*>(mat);
+    if (mfo) {
+        mfo->add(nodes, array);
+        return;
+    }
 #endif
 #ifdef ESYS_HAVE_CUDA
     SystemMatrix* rsm = dynamic_cast<SystemMatrix*>(mat);
@@ -50,6 +50,7 @@ enum SystemMatrixType {
     SMT_PASO = 1<<8,
     SMT_CUSP = 1<<9,
     SMT_TRILINOS = 1<<10,
+    SMT_MATRIXFREE = 1<<11,
     SMT_SYMMETRIC = 1<<15,
     SMT_COMPLEX = 1<<16,
     SMT_UNROLL = 1<<17
@@ -508,6 +509,16 @@ public:
                              escript::Data& rhs, const DataMap& data,
                              Assembler_ptr assembler) const;
 
+    /**
+       \brief
+       assembles the operator coefficients 'coefs' into the matrix-free
+       operator mat, i.e. applies the operator to the current input vector
+       of mat. Used by MatrixFreeOperator.
+    */
+    void assembleMatrixFree(escript::AbstractSystemMatrix* mat,
+                            const DataMap& coefs,
+                            Assembler_ptr assembler) const;
+
     /**
        \brief
        a wrapper for addToSystem that allows calling from Python
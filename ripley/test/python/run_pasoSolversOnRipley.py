@@ -31,9 +31,11 @@ from test_simplesolve import SimpleSolveTestCase
 import esys.escriptcore.utestselect as unittest
 from esys.escriptcore.testing import *
 
-from esys.escript import getMPISizeWorld, hasFeature, sqrt
+from esys.escript import getMPISizeWorld, hasFeature, sqrt, inner, kronecker, \
+                         whereZero, Lsup
 from esys.ripley import Rectangle, Brick
-from esys.escript.linearPDEs import SolverOptions
+from esys.escript.linearPDEs import LinearPDE, SolverOptions
+import numpy
 
 HAVE_PASO = hasFeature('paso')
 
@@ -139,6 +141,178 @@ class Test_SimpleSolveRipley3D_Paso_TFQMR_RILU(SimpleSolveOnPaso):
     def tearDown(self):
         del self.domain
 
+class Test_SimpleSolveRipley2D_Paso_PCG_Chebyshev(SimpleSolveOnPaso):
+    def setUp(self):
+        self.domain = Rectangle(n0=NE0*NX-1, n1=NE1*NY-1, d0=NX, d1=NY)
+        self.package = SolverOptions.PASO
+        self.method = SolverOptions.PCG
+        self.preconditioner = SolverOptions.CHEBYSHEV
+
+    def _setSolverOptions(self, so):
+        so.setNumSweeps(4)
+
+    def tearDown(self):
+        del self.domain
+
+class Test_SimpleSolveRipley3D_Paso_BICGSTAB_Chebyshev(SimpleSolveOnPaso):
+    def setUp(self):
+        self.domain = Brick(n0=NE0*NXb-1, n1=NE1*NYb-1, n2=NE2*NZb-1, d0=NXb, d1=NYb, d2=NZb)
+        self.package = SolverOptions.PASO
+        self.method = SolverOptions.BICGSTAB
+        self.preconditioner = SolverOptions.CHEBYSHEV
+
+    def tearDown(self):
+        del self.domain
+
+class Test_SimpleSolveRipley2D_Paso_BICGSTAB_Schwarz(SimpleSolveOnPaso):
+    def setUp(self):
+        self.domain = Rectangle(n0=NE0*NX-1, n1=NE1*NY-1, d0=NX, d1=NY)
+        self.package = SolverOptions.PASO
+        self.method = SolverOptions.BICGSTAB
+        self.preconditioner = SolverOptions.SCHWARZ
+
+    def tearDown(self):
+        del self.domain
+
+class Test_SimpleSolveRipley3D_Paso_GMRES_Schwarz(SimpleSolveOnPaso):
+    def setUp(self):
+        self.domain = Brick(n0=NE0*NXb-1, n1=NE1*NYb-1, n2=NE2*NZb-1, d0=NXb, d1=NYb, d2=NZb)
+        self.package = SolverOptions.PASO
+        self.method = SolverOptions.GMRES
+        self.preconditioner = SolverOptions.SCHWARZ
+
+    def _setSolverOptions(self, so):
+        so.setSchwarzOverlap(2)
+
+    def tearDown(self):
+        del self.domain
+
+class Test_SimpleSolveRipley2D_Paso_Direct(SimpleSolveOnPaso):
+    def setUp(self):
+        self.domain = Rectangle(n0=NE0*NX-1, n1=NE1*NY-1, d0=NX, d1=NY)
+        self.package = SolverOptions.PASO
+        self.method = SolverOptions.DIRECT
+        self.preconditioner = SolverOptions.JACOBI
+
+    def tearDown(self):
+        del self.domain
+
+class Test_SimpleSolveRipley3D_Paso_Direct(SimpleSolveOnPaso):
+    def setUp(self):
+        self.domain = Brick(n0=NE0*NXb-1, n1=NE1*NYb-1, n2=NE2*NZb-1, d0=NXb, d1=NYb, d2=NZb)
+        self.package = SolverOptions.PASO
+        self.method = SolverOptions.DIRECT
+        self.preconditioner = SolverOptions.JACOBI
+
+    def tearDown(self):
+        del self.domain
+
+class Test_SimpleSolveRipley2D_Paso_BICGSTAB_Jacobi_MatrixFree(SimpleSolveOnPaso):
+    def setUp(self):
+        self.domain = Rectangle(n0=NE0*NX-1, n1=NE1*NY-1, d0=NX, d1=NY)
+        self.package = SolverOptions.PASO
+        self.method = SolverOptions.BICGSTAB
+        self.preconditioner = SolverOptions.JACOBI
+
+    def _setSolverOptions(self, so):
+        so.setUseMatrixFree(True)
+
+    def tearDown(self):
+        del self.domain
+
+class Test_SimpleSolveRipley2D_Paso_PCG_Jacobi_MatrixFree(SimpleSolveOnPaso):
+    def setUp(self):
+        self.domain = Rectangle(n0=NE0*NX-1, n1=NE1*NY-1, d0=NX, d1=NY)
+        self.package = SolverOptions.PASO
+        self.method = SolverOptions.PCG
+        self.preconditioner = SolverOptions.JACOBI
+
+    def _setSolverOptions(self, so):
+        so.setUseMatrixFree(True)
+
+    def tearDown(self):
+        del self.domain
+
+class Test_SimpleSolveRipley3D_Paso_PCG_Chebyshev_MatrixFree(SimpleSolveOnPaso):
+    def setUp(self):
+        self.domain = Brick(n0=NE0*NXb-1, n1=NE1*NYb-1, n2=NE2*NZb-1, d0=NXb, d1=NYb, d2=NZb)
+        self.package = SolverOptions.PASO
+        self.method = SolverOptions.PCG
+        self.preconditioner = SolverOptions.CHEBYSHEV
+
+    def _setSolverOptions(self, so):
+        so.setUseMatrixFree(True)
+        so.setNumSweeps(3)
+
+    def tearDown(self):
+        del self.domain
+
+@unittest.skipIf(not HAVE_PASO, "PASO not available")
+@unittest.skipIf(mpiSize < 2, "Schwarz overlap requires more than one rank")
+class Test_SchwarzOverlapOnRipley(unittest.TestCase):
+    def _solve(self, domain, overlap):
+        x = domain.getX()
+        u_ex = 1.+2.*x[0]+3.*x[1]+4.*x[2]
+        pde = LinearPDE(domain, numEquations=1)
+        pde.setValue(A=kronecker(domain), q=whereZero(x[0]), r=u_ex,
+                     y=inner(numpy.array([2.,3.,4.]), domain.getNormal()))
+        so = pde.getSolverOptions()
+        so.setPackage(SolverOptions.PASO)
+        so.setSolverMethod(SolverOptions.BICGSTAB)
+        so.setPreconditioner(SolverOptions.SCHWARZ)
+        so.setSchwarzLocalSolver(SolverOptions.DIRECT)
+        so.setSchwarzOverlap(overlap)
+        so.setTolerance(1.e-8)
+        u = pde.getSolution()
+        self.assertLess(Lsup(u-u_ex), 1.e-6*Lsup(u_ex))
+        return so.getDiagnostics("num_iter")
+
+    def test_overlapReducesIterations(self):
+        domain = Brick(n0=NE0*NXb-1, n1=NE1*NYb-1, n2=NE2*NZb-1, d0=NXb, d1=NYb, d2=NZb)
+        iter0 = self._solve(domain, 0)
+        iter2 = self._solve(domain, 2)
+        self.assertLess(iter2, iter0,
+                "overlap 2 needs %d iterations, overlap 0 needs %d"%(iter2, iter0))
+
+@unittest.skipIf(not HAVE_PASO, "PASO not available")
+@unittest.skipIf(mpiSize > 1, "Paso AMG test disabled on more than 1 MPI rank")
+class Test_AMGOnRipley(unittest.TestCase):
+    def _solve(self, refinement):
+        domain = Rectangle(n0=refinement*NE0*NX-1, n1=refinement*NE1*NY-1,
+                           d0=NX, d1=NY)
+        x = domain.getX()
+        u_ex = 1.+2.*x[0]+3.*x[1]
+        pde = LinearPDE(domain, numEquations=1)
+        pde.setValue(A=kronecker(domain), q=whereZero(x[0]), r=u_ex,
+                     y=inner(numpy.array([2.,3.]), domain.getNormal()))
+        so = pde.getSolverOptions()
+        so.setPackage(SolverOptions.PASO)
+        so.setSolverMethod(SolverOptions.PCG)
+        so.setPreconditioner(SolverOptions.AMG)
+        so.setTolerance(1.e-8)
+        u = pde.getSolution()
+        self.assertLess(Lsup(u-u_ex), 1.e-6*Lsup(u_ex))
+        return so.getDiagnostics("num_iter")
+
+    def test_iterationsMeshIndependent(self):
+        # Jacobi would need about twice the iterations on the finer mesh
+        iter4 = self._solve(4)
+        iter8 = self._solve(8)
+        self.assertLessEqual(iter8, 1.5*iter4,
+                "%d iterations on the fine mesh, %d on the coarse mesh"%(iter8, iter4))
+
+@unittest.skipIf(not HAVE_PASO, "PASO not available")
+class Test_MatrixFreeDirectOnRipley(unittest.TestCase):
+    def test_directRejected(self):
+        domain = Rectangle(n0=NE0*NX-1, n1=NE1*NY-1, d0=NX, d1=NY)
+        pde = LinearPDE(domain, numEquations=1)
+        pde.setValue(A=kronecker(domain), Y=1.,
+                     q=whereZero(domain.getX()[0]))
+        so = pde.getSolverOptions()
+        so.setPackage(SolverOptions.PASO)
+        so.setSolverMethod(SolverOptions.DIRECT)
+        so.setUseMatrixFree(True)
+        self.assertRaises(ValueError, pde.getSolution)
 
 if __name__ == '__main__':
    run_tests(__name__, exit_on_failure=True)
@@ -85,6 +85,28 @@ class Test_Util_SpatialFunctionsOnRipley3D(Test_Util_SpatialFunctions_noGradOnBo
         del self.order
         del self.domain
 
+class Test_LazyIntegrateOnRipley(unittest.TestCase):
+    TOL=1e-12
+    def check(self, domain):
+        x=Function(domain).getX()
+        a=(sin(x)+2.).delay()
+        res=a*exp(x[0]*a)+length(a)
+        ref=a*exp(x[0]*a)+length(a)
+        ref.resolve()
+        self.assertTrue(res.isLazy())
+        self.assertEqual(res.getFunctionSpace(), Function(domain))
+        s=integrate(res)
+        sref=integrate(ref)
+        self.assertTrue(Lsup(s-sref) <= self.TOL*Lsup(sref), "lazy integral")
+        # integrate streams the samples so res is still lazy
+        self.assertTrue(res.isLazy())
+
+    def test_Rectangle(self):
+        self.check(Rectangle(n0=NE*NX-1, n1=NE*NY-1, l0=1., l1=1., d0=NX, d1=NY))
+
+    def test_Brick(self):
+        self.check(Brick(n0=NE*NXb-1, n1=NE*NYb-1, n2=NE*NZb-1, l0=1., l1=1., l2=1., d0=NXb, d1=NYb, d2=NZb))
+
 if __name__ == '__main__':
     run_tests(__name__, exit_on_failure=True)
 
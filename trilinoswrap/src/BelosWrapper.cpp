@@ -63,6 +63,7 @@ RCP<SolverType<ST> > createSolver(const escript::SolverBuddy& sb)
             solver = factory.create("BICGSTAB", solverParams);
             break;
         case escript::SO_METHOD_PCG:
+        case escript::SO_METHOD_PIPELINED_PCG:
             solver = factory.create("CG", solverParams);
             break;
         case escript::SO_METHOD_PRES20:
@@ -71,6 +72,7 @@ RCP<SolverType<ST> > createSolver(const escript::SolverBuddy& sb)
             solver = factory.create("GMRES", solverParams);
             break;
         case escript::SO_METHOD_GMRES:
+        case escript::SO_METHOD_CA_GMRES:
             extractParamIfSet<int>("Num Blocks", pyParams, *solverParams);
             extractParamIfSet<int>("Maximum Restarts", pyParams, *solverParams);
             extractParamIfSet<std::string>("Orthogonalization", pyParams, *solverParams);
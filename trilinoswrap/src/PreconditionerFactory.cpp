@@ -132,6 +132,14 @@ RCP<OpType<ST> > createPreconditioner(RCP<const MatrixType<ST> > mat,
             extractParamIfSet<ST>("fact: absolute threshold", pyParams, *params);
             extractParamIfSet<ST>("fact: relative threshold", pyParams, *params);
             break;
+        case escript::SO_PRECONDITIONER_CHEBYSHEV:
+            ifprec = factory.create<const Matrix>("CHEBYSHEV", mat);
+            params->set("chebyshev: degree", sb.getNumSweeps());
+            // override if set explicitly for trilinos
+            extractParamIfSet<int>("chebyshev: degree", pyParams, *params);
+            extractParamIfSet<ST>("chebyshev: ratio eigenvalue", pyParams, *params);
+            extractParamIfSet<int>("chebyshev: eigenvalue max iterations", pyParams, *params);
+            break;
         case escript::SO_PRECONDITIONER_GAUSS_SEIDEL:
         case escript::SO_PRECONDITIONER_JACOBI:
           {
@@ -168,6 +176,20 @@ RCP<OpType<ST> > createPreconditioner(RCP<const MatrixType<ST> > mat,
             extractParamIfSet<ST>("fact: absolute threshold", pyParams, *params);
             extractParamIfSet<ST>("fact: relative threshold", pyParams, *params);
             break;
+        case escript::SO_PRECONDITIONER_SCHWARZ:
+            ifprec = factory.create<const Matrix>("SCHWARZ", mat);
+            params->set("schwarz: overlap level", sb.getSchwarzOverlap());
+            params->set("schwarz: combine mode", "Zero");
+            if (sb.getSchwarzLocalSolver() == escript::SO_METHOD_DIRECT) {
+                params->set("inner preconditioner name", "AMESOS2");
+            } else {
+                params->set("inner preconditioner name", "RILUK");
+            }
+            // override if set explicitly for trilinos
+            extractParamIfSet<int>("schwarz: overlap level", pyParams, *params);
+            extractParamIfSet<std::string>("schwarz: combine mode", pyParams, *params);
+            extractParamIfSet<std::string>("inner preconditioner name", pyParams, *params);
+            break;
         default:
             throw escript::ValueError("Unsupported preconditioner requested.");
     }